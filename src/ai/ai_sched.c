@@ -0,0 +1,372 @@
+/**
+ * @file ai_sched.c
+ * @brief 多数の試合の AI 探索を共有ワーカーで実行するスケジューラの実装
+ *
+ * 主な機能:
+ *   - 期限を鍵とする2つの二分ヒープ (割り当て内/割り当て超過)
+ *   - 期間の切り替わりでの割り当て超過のタスクの戻し
+ *   - スレッドの CPU 時間による使用量の計上と探索ノード数の調整
+ *
+ * 設計思想:
+ *   - 実行待ちの操作は1回の実行 (約1ms) ごとに数回のみのため、1つのミューテックスで守る
+ *   - 探索そのものはロックの外で行い、ワーカー間で共有する状態に触れない
+ *   - 状態は release で書き、呼び出し側は acquire で読んでから探索の結果を読む
+ */
+
+#define _GNU_SOURCE // clock_gettime と CLOCK_THREAD_CPUTIME_ID
+
+#include "ai_sched.h"
+#include <pthread.h>
+#include <stdlib.h>
+#include <time.h>
+
+/**
+ * @brief 期限を鍵とする二分ヒープ
+ */
+typedef struct {
+    AiTask** items;              /**< タスク */
+    int size;                    /**< 要素数 */
+} AiHeap;
+
+/**
+ * @brief スケジューラ
+ */
+struct AiSched {
+    pthread_mutex_t lock;        /**< 実行待ちとクライアントの使用量を守る */
+    pthread_cond_t wake;         /**< 実行待ちの追加と停止の通知 */
+    AiHeap ready;                /**< 割り当て内の実行待ち */
+    AiHeap throttled;            /**< 割り当て超過の実行待ち */
+    int max_tasks;               /**< 実行待ちの上限 (2つの合計) */
+    uint32_t period;             /**< 現在の期間の番号 */
+    int stop;                    /**< 停止の要求 */
+    int worker_count;            /**< ワーカー数 */
+    pthread_t workers[AI_SCHED_MAX_WORKERS]; /**< ワーカー */
+    AiWorkerInit init;           /**< ワーカー起動時のフック */
+    void* user;                  /**< フックに渡すデータ */
+    _Atomic int next_worker;     /**< 次に起動するワーカーの番号 */
+};
+
+/**
+ * @brief 期限に使う現在時刻を取得する
+ */
+uint64_t ai_sched_now_us(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000u + (uint64_t)ts.tv_nsec / 1000u;
+}
+
+static uint64_t thread_cpu_us(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return (uint64_t)ts.tv_sec * 1000000u + (uint64_t)ts.tv_nsec / 1000u;
+}
+
+static uint32_t current_period(void) {
+    return (uint32_t)(ai_sched_now_us() / AI_SCHED_PERIOD_US);
+}
+
+static void heap_swap(AiHeap *heap, int a, int b) {
+    AiTask *t = heap->items[a];
+    heap->items[a] = heap->items[b];
+    heap->items[b] = t;
+    heap->items[a]->heap_index = a;
+    heap->items[b]->heap_index = b;
+}
+
+static void heap_up(AiHeap *heap, int i) {
+    while (i > 0) {
+        int parent = (i - 1) / 2;
+        if (heap->items[parent]->deadline_us <= heap->items[i]->deadline_us) {
+            break;
+        }
+        heap_swap(heap, i, parent);
+        i = parent;
+    }
+}
+
+static void heap_down(AiHeap *heap, int i) {
+    for (;;) {
+        int left = 2 * i + 1;
+        int best = i;
+        if (left < heap->size && heap->items[left]->deadline_us < heap->items[best]->deadline_us) {
+            best = left;
+        }
+        if (left + 1 < heap->size && heap->items[left + 1]->deadline_us < heap->items[best]->deadline_us) {
+            best = left + 1;
+        }
+        if (best == i) {
+            return;
+        }
+        heap_swap(heap, i, best);
+        i = best;
+    }
+}
+
+static void heap_push(AiHeap *heap, AiTask *task) {
+    task->heap_index = heap->size;
+    heap->items[heap->size++] = task;
+    heap_up(heap, task->heap_index);
+}
+
+static void heap_remove(AiHeap *heap, AiTask *task) {
+    int i = task->heap_index;
+    heap->size--;
+    if (i != heap->size) {
+        heap->items[i] = heap->items[heap->size];
+        heap->items[i]->heap_index = i;
+        heap_down(heap, i);
+        heap_up(heap, heap->items[i]->heap_index);
+    }
+    task->heap_index = -1;
+}
+
+/**
+ * @brief クライアントの使用量を現在の期間に合わせる
+ */
+static void client_roll(AiClient *client, uint32_t period) {
+    if (client->period != period) {
+        client->period = period;
+        client->used_us = 0;
+    }
+}
+
+static int client_over_quota(const AiClient *client) {
+    return client->used_us >= client->quota_us;
+}
+
+/**
+ * @brief タスクを割り当ての状況に応じた実行待ちへ入れる (ロック中)
+ */
+static void enqueue(AiSched *sched, AiTask *task) {
+    client_roll(task->client, sched->period);
+    task->throttled = (uint8_t)client_over_quota(task->client);
+    heap_push(task->throttled ? &sched->throttled : &sched->ready, task);
+    atomic_store_explicit(&task->status, AI_TASK_QUEUED, memory_order_release);
+}
+
+/**
+ * @brief 期間が切り替わっていれば割り当て超過のタスクを戻す (ロック中)
+ */
+static void roll_period(AiSched *sched) {
+    uint32_t period = current_period();
+    if (period == sched->period) {
+        return;
+    }
+    sched->period = period;
+    while (sched->throttled.size > 0) {
+        AiTask *task = sched->throttled.items[0];
+        heap_remove(&sched->throttled, task);
+        enqueue(sched, task);
+    }
+}
+
+/**
+ * @brief 次に実行するタスクを取り出す (割り当て内を優先、ロック中)
+ */
+static AiTask* pop_next(AiSched *sched) {
+    AiHeap *heap = sched->ready.size > 0 ? &sched->ready : &sched->throttled;
+    if (heap->size == 0) {
+        return NULL;
+    }
+    AiTask *task = heap->items[0];
+    heap_remove(heap, task);
+    return task;
+}
+
+/**
+ * @brief 探索ノード数を1回の実行時間の目安に近づける
+ */
+static void adapt_slice(AiTask *task, uint64_t spent_us) {
+    if (spent_us < AI_SCHED_SLICE_US / 2 && task->slice_nodes < (UINT32_MAX >> 1)) {
+        task->slice_nodes *= 2;
+    } else if (spent_us > AI_SCHED_SLICE_US * 2 && task->slice_nodes > 1) {
+        task->slice_nodes /= 2;
+    }
+}
+
+static void* worker_main(void *arg) {
+    AiSched *sched = (AiSched*)arg;
+    int worker = atomic_fetch_add_explicit(&sched->next_worker, 1, memory_order_relaxed);
+    if (sched->init) {
+        sched->init(worker, sched->user);
+    }
+
+    pthread_mutex_lock(&sched->lock);
+    while (!sched->stop) {
+        roll_period(sched);
+        AiTask *task = pop_next(sched);
+        if (!task) {
+            pthread_cond_wait(&sched->wake, &sched->lock);
+            continue;
+        }
+        if (atomic_load_explicit(&task->cancel, memory_order_relaxed)) {
+            atomic_store_explicit(&task->status, AI_TASK_CANCELLED, memory_order_release);
+            continue;
+        }
+        if (ai_sched_now_us() >= task->deadline_us) {
+            atomic_store_explicit(&task->status, AI_TASK_EXPIRED, memory_order_release);
+            continue;
+        }
+        atomic_store_explicit(&task->status, AI_TASK_RUNNING, memory_order_relaxed);
+        pthread_mutex_unlock(&sched->lock);
+
+        uint64_t start = thread_cpu_us();
+        int done = task->step(task, task->slice_nodes);
+        uint64_t spent = thread_cpu_us() - start;
+        adapt_slice(task, spent);
+
+        pthread_mutex_lock(&sched->lock);
+        AiClient *client = task->client;
+        client_roll(client, sched->period);
+        client->used_us = (uint32_t)(client->used_us + spent);
+        client->total_us += spent;
+        if (done) {
+            atomic_store_explicit(&task->status, AI_TASK_DONE, memory_order_release);
+        } else if (atomic_load_explicit(&task->cancel, memory_order_relaxed)) {
+            atomic_store_explicit(&task->status, AI_TASK_CANCELLED, memory_order_release);
+        } else if (ai_sched_now_us() >= task->deadline_us) {
+            atomic_store_explicit(&task->status, AI_TASK_EXPIRED, memory_order_release);
+        } else {
+            enqueue(sched, task); // 期限の早い他のタスクに譲る
+        }
+    }
+    pthread_mutex_unlock(&sched->lock);
+    return NULL;
+}
+
+/**
+ * @brief スケジューラを作成してワーカーを起動する
+ */
+AiSched* ai_sched_create(int workers, int max_tasks, AiWorkerInit init, void *user) {
+    if (workers <= 0 || workers > AI_SCHED_MAX_WORKERS || max_tasks <= 0) {
+        return NULL;
+    }
+    AiSched *sched = (AiSched*)calloc(1, sizeof(AiSched));
+    if (!sched) {
+        return NULL;
+    }
+    sched->ready.items = (AiTask**)malloc(sizeof(AiTask*) * (size_t)max_tasks);
+    sched->throttled.items = (AiTask**)malloc(sizeof(AiTask*) * (size_t)max_tasks);
+    if (!sched->ready.items || !sched->throttled.items) {
+        free(sched->ready.items);
+        free(sched->throttled.items);
+        free(sched);
+        return NULL;
+    }
+    sched->max_tasks = max_tasks;
+    sched->period = current_period();
+    sched->init = init;
+    sched->user = user;
+    atomic_init(&sched->next_worker, 0);
+    pthread_mutex_init(&sched->lock, NULL);
+    pthread_cond_init(&sched->wake, NULL);
+
+    for (int i = 0; i < workers; i++) {
+        if (pthread_create(&sched->workers[i], NULL, worker_main, sched) != 0) {
+            ai_sched_destroy(sched);
+            return NULL;
+        }
+        sched->worker_count++;
+    }
+    return sched;
+}
+
+/**
+ * @brief ワーカーを停止してスケジューラを解放する
+ */
+void ai_sched_destroy(AiSched *sched) {
+    if (!sched) {
+        return;
+    }
+    pthread_mutex_lock(&sched->lock);
+    sched->stop = 1;
+    pthread_cond_broadcast(&sched->wake);
+    pthread_mutex_unlock(&sched->lock);
+    for (int i = 0; i < sched->worker_count; i++) {
+        pthread_join(sched->workers[i], NULL);
+    }
+
+    AiTask *task;
+    while ((task = pop_next(sched)) != NULL) {
+        atomic_store_explicit(&task->status, AI_TASK_CANCELLED, memory_order_release);
+    }
+    pthread_cond_destroy(&sched->wake);
+    pthread_mutex_destroy(&sched->lock);
+    free(sched->ready.items);
+    free(sched->throttled.items);
+    free(sched);
+}
+
+/**
+ * @brief クライアントを初期化する
+ */
+void ai_client_init(AiClient *client, uint32_t quota_us) {
+    client->quota_us = quota_us;
+    client->used_us = 0;
+    client->period = 0;
+    client->total_us = 0;
+}
+
+/**
+ * @brief タスクを初期化する
+ */
+void ai_task_init(AiTask *task) {
+    task->client = NULL;
+    task->step = NULL;
+    task->deadline_us = 0;
+    task->slice_nodes = AI_SCHED_INITIAL_NODES;
+    task->heap_index = -1;
+    task->throttled = 0;
+    atomic_init(&task->status, AI_TASK_IDLE);
+    atomic_init(&task->cancel, 0);
+}
+
+/**
+ * @brief タスクを投入する
+ */
+int ai_sched_submit(AiSched *sched, AiTask *task, AiClient *client, AiTaskStep step, uint64_t deadline_us) {
+    if (!ai_task_finished(task)) {
+        return 0;
+    }
+    pthread_mutex_lock(&sched->lock);
+    if (sched->ready.size + sched->throttled.size >= sched->max_tasks) {
+        pthread_mutex_unlock(&sched->lock);
+        return 0;
+    }
+    task->client = client;
+    task->step = step;
+    task->deadline_us = deadline_us;
+    atomic_store_explicit(&task->cancel, 0, memory_order_relaxed);
+    enqueue(sched, task);
+    pthread_cond_signal(&sched->wake);
+    pthread_mutex_unlock(&sched->lock);
+    return 1;
+}
+
+/**
+ * @brief タスクを取り消す
+ */
+void ai_sched_cancel(AiSched *sched, AiTask *task) {
+    pthread_mutex_lock(&sched->lock);
+    atomic_store_explicit(&task->cancel, 1, memory_order_relaxed);
+    if (task->heap_index >= 0) {
+        heap_remove(task->throttled ? &sched->throttled : &sched->ready, task);
+        atomic_store_explicit(&task->status, AI_TASK_CANCELLED, memory_order_release);
+    }
+    pthread_mutex_unlock(&sched->lock);
+}
+
+/**
+ * @brief タスクの状態を取得する
+ */
+AiTaskStatus ai_task_status(const AiTask *task) {
+    return (AiTaskStatus)atomic_load_explicit(&((AiTask*)task)->status, memory_order_acquire);
+}
+
+/**
+ * @brief タスクが実行待ちでも実行中でもないか判定する
+ */
+int ai_task_finished(const AiTask *task) {
+    AiTaskStatus status = ai_task_status(task);
+    return status != AI_TASK_QUEUED && status != AI_TASK_RUNNING;
+}
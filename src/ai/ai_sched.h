@@ -0,0 +1,161 @@
+/**
+ * @file ai_sched.h
+ * @brief 多数の試合の AI 探索を共有ワーカーで実行するスケジューラの宣言
+ *
+ * このファイルは同じホスト上の全試合の AI 対戦相手の探索を、固定数のワーカースレッドで
+ * 期限順かつ試合ごとの CPU 時間の割り当てを守って実行するスケジューラを宣言します。
+ * 主な機能:
+ *   - 探索タスクの投入、取り消し、状態の取得 (呼び出し側はティックごとに状態を確認する)
+ *   - 期限 (重力による次の落下時刻) の早いタスクから実行する EDF
+ *   - 試合 (クライアント) ごとの1期間あたりの CPU 時間の割り当て
+ *   - 探索の小分け実行 (1回の実行時間を目安に収まるよう探索ノード数を自動調整)
+ *   - ワーカー起動時のフック (CPU 固定などに使用)
+ *
+ * 設計思想:
+ *   - 試合ごとのスレッドプールを持たず、ワーカー数はホストの AI 用 CPU 数に固定する
+ *   - 割り当てを使い切った試合のタスクは、割り当て内のタスクが無い場合のみ実行する
+ *     (重い AI が他の試合を飢えさせず、空いている CPU は無駄にしない)
+ *   - 探索は小分けに実行し、実行のたびに期限の早いタスクへ譲る
+ *   - 期限を過ぎたタスクはそこで打ち切り、探索の途中結果を使わせる
+ *   - タスクとクライアントは呼び出し側の構造体に埋め込み、投入時の動的確保をしない
+ */
+
+#ifndef AI_SCHED_H
+#define AI_SCHED_H
+
+#include <stdatomic.h>
+#include <stdint.h>
+
+#define AI_SCHED_PERIOD_US     100000 /**< CPU 時間の割り当てを数える期間 (us) */
+#define AI_SCHED_SLICE_US      1000   /**< 1回の実行時間の目安 (us) */
+#define AI_SCHED_INITIAL_NODES 256    /**< 1回の実行の探索ノード数の初期値 */
+#define AI_SCHED_MAX_WORKERS   64     /**< ワーカー数の上限 */
+
+/* タスクの状態の列挙型 */
+typedef enum {
+    AI_TASK_IDLE,                /**< 未投入 */
+    AI_TASK_QUEUED,              /**< 実行待ち */
+    AI_TASK_RUNNING,             /**< 実行中 */
+    AI_TASK_DONE,                /**< 探索が完了した */
+    AI_TASK_EXPIRED,             /**< 期限で打ち切った (途中結果は有効) */
+    AI_TASK_CANCELLED            /**< 取り消した */
+} AiTaskStatus;
+
+typedef struct AiSched AiSched;
+typedef struct AiTask AiTask;
+
+/**
+ * @brief 探索を小分けに進める関数
+ * @param task 対象のタスク (呼び出し側の構造体に埋め込まれている)
+ * @param nodes 今回の実行で調べる探索ノード数の目安
+ * @return 探索が完了した場合1、続きがある場合0
+ */
+typedef int (*AiTaskStep)(AiTask *task, uint32_t nodes);
+
+/**
+ * @brief ワーカー起動時のフック (ワーカーのスレッドで呼び出す)
+ * @param worker ワーカー番号
+ * @param user 呼び出し側のデータ
+ */
+typedef void (*AiWorkerInit)(int worker, void *user);
+
+/**
+ * @brief CPU 時間の割り当ての単位 (試合ごとに1つ)
+ */
+typedef struct {
+    uint32_t quota_us;           /**< 1期間あたりの CPU 時間の割り当て (us) */
+    uint32_t used_us;            /**< 現在の期間の使用量 (us) */
+    uint32_t period;             /**< 使用量を数えている期間の番号 */
+    uint64_t total_us;           /**< 累計の使用量 (us) */
+} AiClient;
+
+/**
+ * @brief 探索タスク (呼び出し側の構造体に埋め込む)
+ */
+struct AiTask {
+    AiClient* client;            /**< 割り当ての単位 */
+    AiTaskStep step;             /**< 探索を進める関数 */
+    uint64_t deadline_us;        /**< 期限 (ai_sched_now_us の時刻) */
+    uint32_t slice_nodes;        /**< 1回の実行の探索ノード数 (自動調整) */
+    int heap_index;              /**< 実行待ちの位置 (-1: 実行待ちでない) */
+    uint8_t throttled;           /**< 割り当て超過の実行待ちにある */
+    _Atomic int status;          /**< タスクの状態 (AiTaskStatus) */
+    _Atomic int cancel;          /**< 取り消しの要求 */
+};
+
+/**
+ * @brief 期限に使う現在時刻を取得する
+ * @return 単調増加の時刻 (us)
+ */
+uint64_t ai_sched_now_us(void);
+
+/**
+ * @brief スケジューラを作成してワーカーを起動する
+ * @param workers ワーカー数 (AI_SCHED_MAX_WORKERS 以下)
+ * @param max_tasks 同時に実行待ちにできるタスク数
+ * @param init ワーカー起動時のフック (NULL可)
+ * @param user フックに渡すデータ
+ * @return 作成したスケジューラ (失敗時はNULL)
+ */
+AiSched* ai_sched_create(int workers, int max_tasks, AiWorkerInit init, void *user);
+
+/**
+ * @brief ワーカーを停止してスケジューラを解放する (実行待ちのタスクは取り消す)
+ * @param sched 解放するスケジューラ (NULL可)
+ */
+void ai_sched_destroy(AiSched *sched);
+
+/**
+ * @brief クライアントを初期化する
+ * @param client 対象のクライアント
+ * @param quota_us 1期間 (AI_SCHED_PERIOD_US) あたりの CPU 時間の割り当て (us)
+ */
+void ai_client_init(AiClient *client, uint32_t quota_us);
+
+/**
+ * @brief タスクを初期化する
+ * @param task 対象のタスク
+ */
+void ai_task_init(AiTask *task);
+
+/**
+ * @brief タスクを投入する
+ *
+ * 探索の状態 (盤面や途中結果) はタスクを埋め込んだ構造体に置き、完了するまで
+ * 呼び出し側は触れないでください。完了は ai_task_status で確認します。
+ *
+ * @param sched 対象のスケジューラ
+ * @param task 投入するタスク (未投入または完了済み)
+ * @param client 割り当ての単位
+ * @param step 探索を進める関数
+ * @param deadline_us 期限 (ai_sched_now_us の時刻)
+ * @return 成功時1、実行待ちが満杯またはタスクが実行中の場合0
+ */
+int ai_sched_submit(AiSched *sched, AiTask *task, AiClient *client, AiTaskStep step, uint64_t deadline_us);
+
+/**
+ * @brief タスクを取り消す
+ *
+ * 実行中の場合は今回の実行の後に取り消します。タスクを解放する前に
+ * ai_task_finished で完了を確認してください。
+ *
+ * @param sched 対象のスケジューラ
+ * @param task 取り消すタスク
+ */
+void ai_sched_cancel(AiSched *sched, AiTask *task);
+
+/**
+ * @brief タスクの状態を取得する (どのスレッドからでもよい)
+ * @param task 対象のタスク
+ * @return タスクの状態 (完了を確認した後は探索の結果を読んでよい)
+ */
+AiTaskStatus ai_task_status(const AiTask *task);
+
+/**
+ * @brief タスクが実行待ちでも実行中でもないか判定する
+ * @param task 対象のタスク
+ * @return 完了、打ち切り、取り消し、未投入の場合1
+ */
+int ai_task_finished(const AiTask *task);
+
+#endif /* AI_SCHED_H */
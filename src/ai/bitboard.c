@@ -0,0 +1,295 @@
+/**
+ * @file bitboard.c
+ * @brief ビットボードによるヘッドレスゲームエンジン実装
+ *
+ * 主な機能:
+ *   - 形状マスクテーブルの生成
+ *   - 行単位のビット演算による衝突判定
+ *   - ハードドロップ、ライン消去、ムーブ生成
+ *   - おじゃまラインのせり上げと穴の数え上げ
+ *
+ * 設計思想:
+ *   - 4x4マトリックスの走査を初期化時の一度だけに限定 (pthread_once で複数スレッドからも安全)
+ *   - ライン消去は1パスの行詰め
+ *   - ムーブ生成は占有セルのキーで重複を除去
+ */
+
+#include "bitboard.h"
+#include "../game/piece.h"
+#include <pthread.h>
+#include <string.h>
+
+/**
+ * @brief 1回転分の形状マスク
+ */
+typedef struct {
+    uint16_t rows[TETROMINO_SIZE]; /**< 各行のマスク (ビット0がマトリックスの列0) */
+    int8_t min_col;                /**< 最左ブロックの列 */
+    int8_t max_col;                /**< 最右ブロックの列 */
+    int8_t min_row;                /**< 最上ブロックの行 */
+    int8_t max_row;                /**< 最下ブロックの行 */
+} ShapeMask;
+
+static ShapeMask shape_masks[TETROMINO_COUNT][4];
+static pthread_once_t shape_masks_once = PTHREAD_ONCE_INIT;
+
+/**
+ * @brief 形状マスクテーブルを生成する (pthread_once から一度だけ呼ばれる)
+ */
+static void build_shape_masks(void) {
+    for (int t = 0; t < TETROMINO_COUNT; t++) {
+        for (int r = 0; r < 4; r++) {
+            ShapeMask *m = &shape_masks[t][r];
+            m->min_col = TETROMINO_SIZE;
+            m->max_col = -1;
+            m->min_row = TETROMINO_SIZE;
+            m->max_row = -1;
+            for (int y = 0; y < TETROMINO_SIZE; y++) {
+                m->rows[y] = 0;
+                for (int x = 0; x < TETROMINO_SIZE; x++) {
+                    if (!TETROMINO_SHAPES[t][r][y][x]) {
+                        continue;
+                    }
+                    m->rows[y] |= (uint16_t)(1u << x);
+                    if (x < m->min_col) m->min_col = (int8_t)x;
+                    if (x > m->max_col) m->max_col = (int8_t)x;
+                    if (y < m->min_row) m->min_row = (int8_t)y;
+                    if (y > m->max_row) m->max_row = (int8_t)y;
+                }
+            }
+        }
+    }
+}
+
+/**
+ * @brief 形状マスクテーブルを初期化する
+ */
+void bitboard_init(void) {
+    // 探索中のスレッドから遅延で呼ばれても、生成途中のテーブルを読ませない
+    pthread_once(&shape_masks_once, build_shape_masks);
+}
+
+/**
+ * @brief 形状マスクの行を列位置に合わせてシフトする
+ */
+static inline uint16_t shift_row(uint16_t mask, int x) {
+    return (uint16_t)(x >= 0 ? (mask << x) : (mask >> -x));
+}
+
+/**
+ * @brief Board からビットボードを生成する
+ */
+void bitboard_from_board(BitBoard *dest, const Board *board) {
+    memset(dest, 0, sizeof(*dest));
+    int height = board->height < BOARD_HEIGHT ? board->height : BOARD_HEIGHT;
+    int width = board->width < BOARD_WIDTH ? board->width : BOARD_WIDTH;
+    int offset = BOARD_HEIGHT - height; // 下詰めで揃える
+    for (int y = 0; y < height; y++) {
+        uint16_t bits = 0;
+        for (int x = 0; x < width; x++) {
+            if (board->grid[y * board->width + x]) {
+                bits |= (uint16_t)(1u << x);
+            }
+        }
+        dest->rows[offset + y] = bits;
+    }
+}
+
+/**
+ * @brief ビットボードを Board に書き出す
+ */
+void bitboard_to_board(Board *board, const BitBoard *src, uint8_t cell_value) {
+    for (int y = 0; y < board->height && y < BOARD_HEIGHT; y++) {
+        for (int x = 0; x < board->width && x < BOARD_WIDTH; x++) {
+            board->grid[y * board->width + x] = (src->rows[y] >> x) & 1u ? cell_value : 0;
+        }
+    }
+}
+
+/**
+ * @brief 指定位置にテトリミノが置けるか判定する
+ */
+int bitboard_collides(const BitBoard *board, TetrominoType type, int rotation, int x, int y) {
+    const ShapeMask *m = &shape_masks[type][rotation & 3];
+    if (x + m->min_col < 0 || x + m->max_col >= BOARD_WIDTH) {
+        return 1;
+    }
+    for (int r = m->min_row; r <= m->max_row; r++) {
+        int by = y + r;
+        if (by < 0) {
+            continue; // ボード上端より上は空きとして扱う
+        }
+        if (by >= BOARD_HEIGHT || (board->rows[by] & shift_row(m->rows[r], x))) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+/**
+ * @brief 指定した回転と列でハードドロップした位置を求める
+ */
+int bitboard_drop(const BitBoard *board, TetrominoType type, int rotation, int x,
+                  BitPlacement *out) {
+    const ShapeMask *m = &shape_masks[type][rotation & 3];
+    int y = -m->min_row; // 最上ブロックを最上段に合わせる
+    if (bitboard_collides(board, type, rotation, x, y)) {
+        return 0;
+    }
+    while (!bitboard_collides(board, type, rotation, x, y + 1)) {
+        y++;
+    }
+    out->type = (uint8_t)type;
+    out->rotation = (uint8_t)(rotation & 3);
+    out->x = (int8_t)x;
+    out->y = (int8_t)y;
+    return 1;
+}
+
+/**
+ * @brief 配置を適用し、揃ったラインを消去する
+ */
+int bitboard_apply(BitBoard *board, const BitPlacement *placement) {
+    const ShapeMask *m = &shape_masks[placement->type][placement->rotation & 3];
+    for (int r = m->min_row; r <= m->max_row; r++) {
+        int by = placement->y + r;
+        if (by >= 0 && by < BOARD_HEIGHT) {
+            board->rows[by] |= shift_row(m->rows[r], placement->x);
+        }
+    }
+
+    // 下から行を詰めながら揃った行を取り除く
+    int write = BOARD_HEIGHT - 1;
+    for (int read = BOARD_HEIGHT - 1; read >= 0; read--) {
+        if (board->rows[read] != BITBOARD_FULL_ROW) {
+            board->rows[write--] = board->rows[read];
+        }
+    }
+    int cleared = write + 1;
+    for (; write >= 0; write--) {
+        board->rows[write] = 0;
+    }
+    return cleared;
+}
+
+/**
+ * @brief 配置の占有セルを一意なキーに変換する
+ */
+static uint64_t placement_key(const BitPlacement *p) {
+    const ShapeMask *m = &shape_masks[p->type][p->rotation];
+    uint64_t key = (uint64_t)(p->y + m->min_row + TETROMINO_SIZE) << 40;
+    for (int r = m->min_row; r <= m->max_row; r++) {
+        key |= (uint64_t)shift_row(m->rows[r], p->x) << ((r - m->min_row) * BOARD_WIDTH);
+    }
+    return key;
+}
+
+/**
+ * @brief ハードドロップで到達できる全配置を列挙する
+ */
+int bitboard_generate(const BitBoard *board, TetrominoType type,
+                      BitPlacement out[BITBOARD_MAX_PLACEMENTS]) {
+    uint64_t keys[BITBOARD_MAX_PLACEMENTS];
+    int count = 0;
+
+    for (int rot = 0; rot < 4; rot++) {
+        const ShapeMask *m = &shape_masks[type][rot];
+        for (int x = -m->min_col; x + m->max_col < BOARD_WIDTH; x++) {
+            BitPlacement p;
+            if (!bitboard_drop(board, type, rot, x, &p)) {
+                continue;
+            }
+            uint64_t key = placement_key(&p);
+            int duplicate = 0;
+            for (int i = 0; i < count; i++) {
+                if (keys[i] == key) {
+                    duplicate = 1;
+                    break;
+                }
+            }
+            if (!duplicate) {
+                keys[count] = key;
+                out[count++] = p;
+            }
+        }
+    }
+    return count;
+}
+
+/**
+ * @brief 占有セル数を数える
+ */
+int bitboard_cell_count(const BitBoard *board) {
+    int count = 0;
+    for (int y = 0; y < BOARD_HEIGHT; y++) {
+        count += __builtin_popcount(board->rows[y]);
+    }
+    return count;
+}
+
+/**
+ * @brief 最上段の占有行から最下段までの高さを求める
+ */
+int bitboard_height(const BitBoard *board) {
+    for (int y = 0; y < BOARD_HEIGHT; y++) {
+        if (board->rows[y]) {
+            return BOARD_HEIGHT - y;
+        }
+    }
+    return 0;
+}
+
+/**
+ * @brief 各列の高さを求める
+ */
+void bitboard_column_heights(const BitBoard *board, int heights[BOARD_WIDTH]) {
+    uint16_t seen = 0;
+    for (int x = 0; x < BOARD_WIDTH; x++) {
+        heights[x] = 0;
+    }
+    for (int y = 0; y < BOARD_HEIGHT && seen != BITBOARD_FULL_ROW; y++) {
+        uint16_t fresh = board->rows[y] & (uint16_t)~seen;
+        while (fresh) {
+            int x = __builtin_ctz(fresh);
+            heights[x] = BOARD_HEIGHT - y;
+            fresh &= (uint16_t)(fresh - 1);
+        }
+        seen |= board->rows[y];
+    }
+}
+
+/**
+ * @brief おじゃまラインを下からせり上げる
+ */
+int bitboard_add_garbage(BitBoard *board, int lines, int hole_column) {
+    if (lines <= 0) {
+        return 0;
+    }
+    if (lines > BOARD_HEIGHT) {
+        lines = BOARD_HEIGHT;
+    }
+    int overflow = 0;
+    for (int y = 0; y < lines; y++) {
+        overflow |= board->rows[y] != 0;
+    }
+    memmove(board->rows, board->rows + lines, sizeof(uint16_t) * (size_t)(BOARD_HEIGHT - lines));
+    int hole = ((hole_column % BOARD_WIDTH) + BOARD_WIDTH) % BOARD_WIDTH; // 負の列も盤面内に収める
+    uint16_t row = (uint16_t)(BITBOARD_FULL_ROW & ~(1u << hole));
+    for (int y = BOARD_HEIGHT - lines; y < BOARD_HEIGHT; y++) {
+        board->rows[y] = row;
+    }
+    return overflow;
+}
+
+/**
+ * @brief 穴 (上を塞がれた空きセル) の数を数える
+ */
+int bitboard_hole_count(const BitBoard *board) {
+    uint16_t covered = 0;
+    int holes = 0;
+    for (int y = 0; y < BOARD_HEIGHT; y++) {
+        holes += __builtin_popcount(covered & (uint16_t)~board->rows[y]);
+        covered |= board->rows[y];
+    }
+    return holes;
+}
@@ -0,0 +1,150 @@
+/**
+ * @file bitboard.h
+ * @brief ビットボードによるヘッドレスゲームエンジンの宣言
+ *
+ * このファイルは描画や入力を伴わない高速な盤面シミュレーションを宣言します。
+ * AI探索、パズル生成、ソルバーなど大量の局面を評価する処理で使用します。
+ * 主な機能:
+ *   - Board とビットボードの相互変換
+ *   - テトリミノのハードドロップ配置とライン消去
+ *   - 全配置の列挙 (ムーブ生成)
+ *   - おじゃまラインのせり上げ (対戦 AI の先読み用)
+ *
+ * 設計思想:
+ *   - 1行を16ビットで表現し、衝突判定を行単位のビット演算で行う
+ *   - 形状マスクは TETROMINO_SHAPES から一度だけ生成
+ *   - 値渡し可能な小さな構造体でスレッド間共有を不要にする
+ *   - 配置はハードドロップのみ (ソフトドロップによる潜り込みは対象外)
+ */
+
+#ifndef BITBOARD_H
+#define BITBOARD_H
+
+#include "../game/game_defs.h"
+
+#define BITBOARD_FULL_ROW       ((uint16_t)((1u << BOARD_WIDTH) - 1)) /**< 全て埋まった行 */
+#define BITBOARD_MAX_PLACEMENTS 40 /**< 1種類のテトリミノの配置数の上限 (4回転 x 10列) */
+
+/**
+ * @brief ビットボード構造体
+ *
+ * rows[0] が最上段、ビットxが列xに対応します。
+ */
+typedef struct {
+    uint16_t rows[BOARD_HEIGHT]; /**< 各行の占有ビット */
+} BitBoard;
+
+/**
+ * @brief テトリミノの配置
+ */
+typedef struct {
+    uint8_t type;                /**< テトリミノのタイプ */
+    uint8_t rotation;            /**< 回転状態 (0-3) */
+    int8_t x;                    /**< 4x4マトリックス左上のX位置 */
+    int8_t y;                    /**< 4x4マトリックス左上のY位置 */
+} BitPlacement;
+
+/**
+ * @brief 形状マスクテーブルを初期化する
+ *
+ * 複数回、複数のスレッドから同時に呼び出し可能です (テーブルの生成は一度だけ)。
+ */
+void bitboard_init(void);
+
+/**
+ * @brief Board からビットボードを生成する
+ * @param dest 出力先
+ * @param board 変換元のボード
+ */
+void bitboard_from_board(BitBoard *dest, const Board *board);
+
+/**
+ * @brief ビットボードを Board に書き出す
+ * @param board 出力先のボード (占有セルには cell_value を書き込む)
+ * @param src 変換元
+ * @param cell_value 占有セルの値
+ */
+void bitboard_to_board(Board *board, const BitBoard *src, uint8_t cell_value);
+
+/**
+ * @brief 指定位置にテトリミノが置けるか判定する
+ * @param board 対象のビットボード
+ * @param type テトリミノのタイプ
+ * @param rotation 回転状態
+ * @param x X位置
+ * @param y Y位置
+ * @return 衝突する場合1、置ける場合0
+ */
+int bitboard_collides(const BitBoard *board, TetrominoType type, int rotation, int x, int y);
+
+/**
+ * @brief 指定した回転と列でハードドロップした位置を求める
+ * @param board 対象のビットボード
+ * @param type テトリミノのタイプ
+ * @param rotation 回転状態
+ * @param x X位置
+ * @param out 配置の出力先
+ * @return 配置可能な場合1、列が範囲外または出現位置で衝突する場合0
+ */
+int bitboard_drop(const BitBoard *board, TetrominoType type, int rotation, int x,
+                  BitPlacement *out);
+
+/**
+ * @brief 配置を適用し、揃ったラインを消去する
+ * @param board 対象のビットボード
+ * @param placement 適用する配置
+ * @return 消去したライン数
+ */
+int bitboard_apply(BitBoard *board, const BitPlacement *placement);
+
+/**
+ * @brief ハードドロップで到達できる全配置を列挙する
+ *
+ * 占有セルが同一になる配置 (S/Z/Iの対称回転など) は1つにまとめます。
+ *
+ * @param board 対象のビットボード
+ * @param type テトリミノのタイプ
+ * @param out 配置の出力先 (BITBOARD_MAX_PLACEMENTS 要素)
+ * @return 配置数
+ */
+int bitboard_generate(const BitBoard *board, TetrominoType type,
+                      BitPlacement out[BITBOARD_MAX_PLACEMENTS]);
+
+/**
+ * @brief 占有セル数を数える
+ * @param board 対象のビットボード
+ * @return 占有セル数
+ */
+int bitboard_cell_count(const BitBoard *board);
+
+/**
+ * @brief 最上段の占有行から最下段までの高さを求める
+ * @param board 対象のビットボード
+ * @return 高さ (空の場合0)
+ */
+int bitboard_height(const BitBoard *board);
+
+/**
+ * @brief 各列の高さを求める
+ * @param board 対象のビットボード
+ * @param heights 出力先 (BOARD_WIDTH 要素)
+ */
+void bitboard_column_heights(const BitBoard *board, int heights[BOARD_WIDTH]);
+
+/**
+ * @brief おじゃまラインを下からせり上げる
+ * @param board 対象のビットボード
+ * @param lines せり上げるライン数
+ * @param hole_column 穴の列 (BOARD_WIDTH で剰余を取る。負の値も可)
+ * @return 占有セルが最上段から押し出された (ゲームオーバー) 場合1
+ */
+int bitboard_add_garbage(BitBoard *board, int lines, int hole_column);
+
+/**
+ * @brief 穴 (上を塞がれた空きセル) の数を数える
+ * @param board 対象のビットボード
+ * @return 穴の数
+ */
+int bitboard_hole_count(const BitBoard *board);
+
+#endif /* BITBOARD_H */
@@ -0,0 +1,125 @@
+/**
+ * @file hostile.c
+ * @brief プレイヤーに最も不利なテトリミノを配る敵対的な生成器の実装
+ *
+ * 主な機能:
+ *   - 最も長く配っていない順での種類の評価
+ *   - 種類ごとのプレイヤーの最善の配置の評価 (高さ、穴、凹凸、消去ライン数)
+ *   - 評価値が最も低い種類の選択
+ *
+ * 設計思想:
+ *   - 評価は整数のみで行い、実行環境で選ぶテトリミノが変わらない
+ *   - 置けない種類はゲームオーバーを意味するため、評価値を最小にする
+ */
+
+#include "hostile.h"
+#include <limits.h>
+
+#define HOSTILE_DEAD_SCORE (INT32_MIN / 2) /**< 置けない種類の評価値 */
+
+#define HOSTILE_W_HEIGHT 5  /**< 列の高さの合計の重み */
+#define HOSTILE_W_HOLES  40 /**< 穴の数の重み */
+#define HOSTILE_W_BUMP   3  /**< 隣接列の高さの差の重み */
+#define HOSTILE_W_MAX    8  /**< 最大の高さの重み */
+#define HOSTILE_W_LINES  30 /**< 消去ライン数の重み */
+
+/**
+ * @brief 生成器を初期化する
+ */
+void hostile_init(HostileRandomizer *hr, uint32_t node_budget) {
+    hr->node_budget = node_budget;
+    hr->dealt = 0;
+    hr->nodes = 0;
+    hr->evaluated = 0;
+    for (int t = 0; t < TETROMINO_COUNT; t++) {
+        hr->last_dealt[t] = 0;
+        hr->scores[t] = 0;
+    }
+}
+
+/**
+ * @brief 盤面をプレイヤー側から評価する
+ */
+int32_t hostile_evaluate(const BitBoard *board, int lines) {
+    int heights[BOARD_WIDTH];
+    bitboard_column_heights(board, heights);
+    int total = 0;
+    int max_height = 0;
+    int bumpiness = 0;
+    for (int x = 0; x < BOARD_WIDTH; x++) {
+        total += heights[x];
+        if (heights[x] > max_height) {
+            max_height = heights[x];
+        }
+        if (x > 0) {
+            int d = heights[x] - heights[x - 1];
+            bumpiness += d < 0 ? -d : d;
+        }
+    }
+    return -HOSTILE_W_HEIGHT * total - HOSTILE_W_HOLES * bitboard_hole_count(board) -
+           HOSTILE_W_BUMP * bumpiness - HOSTILE_W_MAX * max_height + HOSTILE_W_LINES * lines;
+}
+
+/**
+ * @brief 種類を最も長く配っていない順に並べる
+ */
+static void order_types(const HostileRandomizer *hr, TetrominoType order[TETROMINO_COUNT]) {
+    for (int t = 0; t < TETROMINO_COUNT; t++) {
+        int i = t;
+        while (i > 0 && hr->last_dealt[order[i - 1]] > hr->last_dealt[t]) {
+            order[i] = order[i - 1];
+            i--;
+        }
+        order[i] = (TetrominoType)t;
+    }
+}
+
+/**
+ * @brief 種類ごとのプレイヤーの最善の評価値を求める
+ */
+static int32_t best_reply(const BitBoard *board, TetrominoType type, uint32_t *nodes) {
+    BitPlacement moves[BITBOARD_MAX_PLACEMENTS];
+    int count = bitboard_generate(board, type, moves);
+    int32_t best = HOSTILE_DEAD_SCORE;
+    for (int i = 0; i < count; i++) {
+        BitBoard next = *board;
+        int lines = bitboard_apply(&next, &moves[i]);
+        int32_t score = hostile_evaluate(&next, lines);
+        if (score > best) {
+            best = score;
+        }
+    }
+    *nodes += (uint32_t)(count > 0 ? count : 1);
+    return best;
+}
+
+/**
+ * @brief 次に配るテトリミノを選ぶ
+ */
+TetrominoType hostile_next(HostileRandomizer *hr, const BitBoard *board) {
+    TetrominoType order[TETROMINO_COUNT];
+    order_types(hr, order);
+
+    hr->nodes = 0;
+    hr->evaluated = 0;
+    TetrominoType worst = order[0];
+    int32_t worst_score = INT32_MAX;
+    for (int i = 0; i < TETROMINO_COUNT; i++) {
+        // 次の種類を評価しきれない場合は打ち切る (最初の1種類は必ず評価する)
+        if (i > 0 && hr->nodes + BITBOARD_MAX_PLACEMENTS > hr->node_budget) {
+            break;
+        }
+        TetrominoType type = order[i];
+        int32_t score = best_reply(board, type, &hr->nodes);
+        hr->scores[type] = score;
+        hr->evaluated++;
+        // 同点は先に評価した (長く配っていない) 種類を優先
+        if (score < worst_score) {
+            worst_score = score;
+            worst = type;
+        }
+    }
+
+    hr->last_dealt[worst] = ++hr->dealt;
+    return worst;
+}
@@ -0,0 +1,65 @@
+/**
+ * @file hostile.h
+ * @brief プレイヤーに最も不利なテトリミノを配る敵対的な生成器の宣言
+ *
+ * このファイルはチャレンジ用のサーバーや AI の負荷試験で使う、乱数の代わりに
+ * 盤面を探索して最悪のテトリミノを選ぶ生成器を宣言します。
+ * 主な機能:
+ *   - テトリミノの種類ごとに、プレイヤーの最善の配置を1手読みで評価
+ *   - 最善の配置でも評価が最も低い種類の選択 (置けない種類は最優先)
+ *   - 1回の選択で評価する配置数の上限 (フレームの予算内に収める)
+ *   - 同点の場合は最も長く配っていない種類を選ぶ
+ *
+ * 設計思想:
+ *   - 1回の選択は最大でも 7種類 x 40配置の評価で、ヘッドレスエンジン上では1フレームより十分短い
+ *   - 予算で打ち切る場合に備え、最も長く配っていない種類から評価する
+ *     (打ち切っても同じ種類ばかりにならない)
+ *   - 乱数を使わず、同じ盤面と履歴からは同じテトリミノを配る (リプレイで再現できる)
+ */
+
+#ifndef HOSTILE_H
+#define HOSTILE_H
+
+#include "bitboard.h"
+
+#define HOSTILE_FRAME_NODES (TETROMINO_COUNT * BITBOARD_MAX_PLACEMENTS) /**< 全種類を評価できる配置数 */
+
+/**
+ * @brief 敵対的な生成器の状態 (プレイヤーごとに1つ)
+ */
+typedef struct {
+    uint32_t node_budget;        /**< 1回の選択で評価する配置数の上限 */
+    uint32_t dealt;              /**< 配ったテトリミノの数 */
+    uint32_t last_dealt[TETROMINO_COUNT]; /**< 種類ごとに最後に配った番号 (0: 未配布) */
+    uint32_t nodes;              /**< 直前の選択で評価した配置数 */
+    int evaluated;               /**< 直前の選択で評価を終えた種類の数 */
+    int32_t scores[TETROMINO_COUNT]; /**< 直前の選択での種類ごとのプレイヤーの最善評価値 */
+} HostileRandomizer;
+
+/**
+ * @brief 生成器を初期化する (形状マスクテーブルは bitboard_init 済みであること)
+ * @param hr 対象の生成器
+ * @param node_budget 1回の選択で評価する配置数の上限 (HOSTILE_FRAME_NODES で全種類を評価)
+ */
+void hostile_init(HostileRandomizer *hr, uint32_t node_budget);
+
+/**
+ * @brief 次に配るテトリミノを選ぶ
+ *
+ * 予算を使い切った場合は、評価を終えた種類の中から選びます (少なくとも1種類は評価します)。
+ *
+ * @param hr 対象の生成器
+ * @param board プレイヤーの現在の盤面 (操作中のテトリミノを設置した後)
+ * @return 配るテトリミノ
+ */
+TetrominoType hostile_next(HostileRandomizer *hr, const BitBoard *board);
+
+/**
+ * @brief 盤面をプレイヤー側から評価する (大きいほどプレイヤーに有利)
+ * @param board 評価する盤面
+ * @param lines 直前の設置で消去したライン数
+ * @return 評価値
+ */
+int32_t hostile_evaluate(const BitBoard *board, int lines);
+
+#endif /* HOSTILE_H */
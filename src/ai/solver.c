@@ -0,0 +1,85 @@
+/**
+ * @file solver.c
+ * @brief ビットボードによるパーフェクトクリアソルバー実装
+ *
+ * 主な機能:
+ *   - 深さ優先探索による解の数え上げ
+ *   - 必要条件による枝刈り
+ *
+ * 設計思想:
+ *   - 残りセル数 (盤面 + 4 x 残りテトリミノ) が盤面幅で割り切れない場合は即座に不可能
+ *   - 占有高さの全行を消すのに必要なセル数が残りセル数を超える配置は探索しない
+ *   - 探索状態は値渡しのビットボードのみで、共有状態を持たない
+ */
+
+#include "solver.h"
+
+/**
+ * @brief 探索の状態
+ */
+typedef struct {
+    const TetrominoType *pieces; /**< テトリミノ列 */
+    int count;                   /**< テトリミノ列の長さ */
+    int limit;                   /**< 解の数の上限 */
+    int found;                   /**< 見つかった解の数 */
+    BitPlacement path[SOLVER_MAX_PIECES]; /**< 現在の手順 */
+    BitPlacement* solution;      /**< 最初の解の出力先 */
+} SolverState;
+
+/**
+ * @brief depth 手目以降を探索する
+ */
+static void solver_search(SolverState *state, const BitBoard *board, int depth) {
+    int cells = bitboard_cell_count(board);
+    if (depth == state->count) {
+        if (cells == 0) {
+            if (state->found == 0 && state->solution) {
+                for (int i = 0; i < state->count; i++) {
+                    state->solution[i] = state->path[i];
+                }
+            }
+            state->found++;
+        }
+        return;
+    }
+
+    // 残りセルで消せる行数を超える高さには積めない
+    int budget_rows = (cells + 4 * (state->count - depth)) / BOARD_WIDTH;
+
+    BitPlacement moves[BITBOARD_MAX_PLACEMENTS];
+    int n = bitboard_generate(board, state->pieces[depth], moves);
+    for (int i = 0; i < n && state->found < state->limit; i++) {
+        BitBoard next = *board;
+        int cleared = bitboard_apply(&next, &moves[i]);
+        if (bitboard_height(&next) > budget_rows - cleared) {
+            continue;
+        }
+        state->path[depth] = moves[i];
+        solver_search(state, &next, depth + 1);
+    }
+}
+
+/**
+ * @brief 指定順のテトリミノで盤面を全消しする手順を数える
+ */
+int solver_count_perfect_clears(const BitBoard *board, const TetrominoType *pieces, int count,
+                                int limit, BitPlacement *solution) {
+    if (!board || !pieces || count <= 0 || count > SOLVER_MAX_PIECES || limit <= 0) {
+        return -1;
+    }
+
+    int total = bitboard_cell_count(board) + 4 * count;
+    if (total % BOARD_WIDTH != 0 || bitboard_height(board) * BOARD_WIDTH > total) {
+        return 0;
+    }
+
+    bitboard_init();
+    SolverState state;
+    state.pieces = pieces;
+    state.count = count;
+    state.limit = limit;
+    state.found = 0;
+    state.solution = solution;
+    solver_search(&state, board, 0);
+    return state.found;
+}
@@ -0,0 +1,40 @@
+/**
+ * @file solver.h
+ * @brief ビットボードによるパーフェクトクリアソルバーの宣言
+ *
+ * このファイルは「指定されたテトリミノで盤面を全て消す」問題の探索を宣言します。
+ * 主な機能:
+ *   - 解の存在判定
+ *   - 解の個数の数え上げ (上限付き、唯一解の検証用)
+ *   - 最初に見つかった解の手順の取得
+ *
+ * 設計思想:
+ *   - ヘッドレスエンジン (bitboard.h) のみに依存し、スレッドセーフ
+ *   - セル数と高さによる枝刈りで探索空間を削減
+ *   - 呼び出し側のスタックのみを使用し、動的確保なし
+ */
+
+#ifndef SOLVER_H
+#define SOLVER_H
+
+#include "bitboard.h"
+
+#define SOLVER_MAX_PIECES 10 /**< 探索するテトリミノ列の最大長 */
+
+/**
+ * @brief 指定順のテトリミノで盤面を全消しする手順を数える
+ *
+ * 配置はハードドロップのみを対象とし、ホールドは使用しません。
+ * 占有セルが同一の配置は同じ手として扱います。
+ *
+ * @param board 初期盤面
+ * @param pieces 使用するテトリミノ列
+ * @param count テトリミノ列の長さ (SOLVER_MAX_PIECES 以下)
+ * @param limit 数え上げを打ち切る解の数 (唯一性の検証には2を指定)
+ * @param solution 最初に見つかった解の出力先 (count 要素、NULL可)
+ * @return 見つかった解の数 (limit 以下)、引数が不正な場合-1
+ */
+int solver_count_perfect_clears(const BitBoard *board, const TetrominoType *pieces, int count,
+                                int limit, BitPlacement *solution);
+
+#endif /* SOLVER_H */
@@ -0,0 +1,330 @@
+/**
+ * @file versus_ai.c
+ * @brief おじゃまラインと相手の攻撃を先読みする対戦 AI の実装
+ *
+ * 主な機能:
+ *   - 設置の再現: ライン消去、攻撃ライン数、待ち行列の相殺、未消去時のせり上げ
+ *   - 相手の貪欲な2手の再現による攻撃の予測
+ *   - 方針ごとの重みによる盤面の評価 (高さ、穴、凹凸、危険度、攻撃、相殺、井戸)
+ *   - 1手目ごとに2手目の全配置を評価する小分け実行
+ *
+ * 設計思想:
+ *   - 予測した相手の1手目の攻撃は自分の1手目の後に待ち行列へ加え、2手目の設置に効かせる
+ *   - 2手目の後に届く予測攻撃は危険度として評価する
+ *   - 評価値は整数で計算し、スレッドや実行環境で結果が変わらない
+ */
+
+#include "versus_ai.h"
+#include "../game/stats.h"
+#include <limits.h>
+#include <string.h>
+
+#define VERSUS_DEAD_SCORE (INT32_MIN / 2) /**< ゲームオーバーになる局面の評価値 */
+#define VERSUS_WELL_MAX   4               /**< 井戸の深さを評価する上限 */
+
+/**
+ * @brief 評価の重み
+ */
+typedef struct {
+    int32_t height;              /**< 列の高さの合計 */
+    int32_t holes;               /**< 穴の数 */
+    int32_t bumpiness;           /**< 隣接列の高さの差の合計 */
+    int32_t danger;              /**< 危険度 (最大の高さ + 受けるライン数) の2乗 */
+    int32_t sent;                /**< 送った攻撃ライン数 */
+    int32_t cancelled;           /**< 相殺したライン数 */
+    int32_t cleared;             /**< 消去したライン数 */
+    int32_t landed;              /**< せり上がったライン数 */
+    int32_t well;                /**< 井戸の深さ */
+} VersusWeights;
+
+static const VersusWeights PLAN_WEIGHTS[] = {
+    [VERSUS_PLAN_DOWNSTACK] = {4, 40, 3, 2, 10, 15, 20, 30, 0},
+    [VERSUS_PLAN_ATTACK]    = {3, 35, 3, 1, 60, 20, 0, 40, 8},
+    [VERSUS_PLAN_DEFEND]    = {6, 25, 2, 8, 20, 40, 30, 60, 0}
+};
+
+/**
+ * @brief 先読み中の一方のプレイヤーの状態
+ */
+typedef struct {
+    VersusSide side;             /**< 局面 */
+    int sent;                    /**< 送った攻撃ライン数 */
+    int cancelled;               /**< 相殺したライン数 */
+    int cleared;                 /**< 消去したライン数 */
+    int landed;                  /**< せり上がったライン数 */
+    int dead;                    /**< ゲームオーバー */
+} VersusSim;
+
+/**
+ * @brief 方針の名前を取得する
+ */
+const char* versus_plan_name(VersusPlan plan) {
+    switch (plan) {
+        case VERSUS_PLAN_DOWNSTACK: return "downstack";
+        case VERSUS_PLAN_ATTACK:    return "attack";
+        case VERSUS_PLAN_DEFEND:    return "defend";
+        default:                    return "unknown";
+    }
+}
+
+static int incoming_lines(const VersusSide *side) {
+    int lines = 0;
+    for (int i = 0; i < side->incoming_count; i++) {
+        lines += side->incoming[i].lines;
+    }
+    return lines;
+}
+
+/**
+ * @brief 待ち行列の末尾におじゃまラインを加える (満杯なら末尾に合算)
+ */
+static void push_garbage(VersusSide *side, int lines, int hole_column) {
+    if (lines <= 0) {
+        return;
+    }
+    if (side->incoming_count < VERSUS_AI_MAX_GARBAGE) {
+        side->incoming[side->incoming_count].lines = (uint8_t)(lines < UINT8_MAX ? lines : UINT8_MAX);
+        side->incoming[side->incoming_count].hole_column = (uint8_t)hole_column;
+        side->incoming_count++;
+    } else {
+        VersusGarbage *last = &side->incoming[VERSUS_AI_MAX_GARBAGE - 1];
+        int total = last->lines + lines;
+        last->lines = (uint8_t)(total < UINT8_MAX ? total : UINT8_MAX);
+    }
+}
+
+/**
+ * @brief 配置を設置し、攻撃、相殺、せり上げを再現する
+ * @return 送った (相殺後の) 攻撃ライン数
+ */
+static int sim_lock(VersusSim *sim, const BitPlacement *placement) {
+    VersusSide *side = &sim->side;
+    int lines = bitboard_apply(&side->board, placement);
+    if (lines == 0) {
+        // 消去しなかった設置の後、待ち行列のおじゃまラインがすべてせり上がる
+        side->combo = 0;
+        for (int i = 0; i < side->incoming_count; i++) {
+            sim->dead |= bitboard_add_garbage(&side->board, side->incoming[i].lines, side->incoming[i].hole_column);
+            sim->landed += side->incoming[i].lines;
+        }
+        side->incoming_count = 0;
+        return 0;
+    }
+
+    side->combo++;
+    sim->cleared += lines;
+    int attack = stats_attack_for_clear(lines, side->combo);
+    int head = 0;
+    while (attack > 0 && head < side->incoming_count) {
+        int cancel = attack < side->incoming[head].lines ? attack : side->incoming[head].lines;
+        side->incoming[head].lines = (uint8_t)(side->incoming[head].lines - cancel);
+        attack -= cancel;
+        sim->cancelled += cancel;
+        if (side->incoming[head].lines == 0) {
+            head++;
+        }
+    }
+    if (head > 0) {
+        memmove(side->incoming, side->incoming + head, sizeof(VersusGarbage) * (size_t)(side->incoming_count - head));
+        side->incoming_count -= head;
+    }
+    sim->sent += attack;
+    return attack;
+}
+
+/**
+ * @brief 最も深い井戸 (両隣より低い列) の深さを求める
+ */
+static int well_depth(const int heights[BOARD_WIDTH]) {
+    int best = 0;
+    for (int x = 0; x < BOARD_WIDTH; x++) {
+        int left = x > 0 ? heights[x - 1] : BOARD_HEIGHT;
+        int right = x < BOARD_WIDTH - 1 ? heights[x + 1] : BOARD_HEIGHT;
+        int depth = (left < right ? left : right) - heights[x];
+        if (depth > best) {
+            best = depth;
+        }
+    }
+    return best < VERSUS_WELL_MAX ? best : VERSUS_WELL_MAX;
+}
+
+/**
+ * @brief 先読みの末端の局面を評価する
+ */
+static int32_t evaluate(const VersusSim *sim, int pending_threat, const VersusWeights *w) {
+    if (sim->dead) {
+        return VERSUS_DEAD_SCORE;
+    }
+    int heights[BOARD_WIDTH];
+    bitboard_column_heights(&sim->side.board, heights);
+    int total = 0;
+    int max_height = 0;
+    int bumpiness = 0;
+    for (int x = 0; x < BOARD_WIDTH; x++) {
+        total += heights[x];
+        if (heights[x] > max_height) {
+            max_height = heights[x];
+        }
+        if (x > 0) {
+            int d = heights[x] - heights[x - 1];
+            bumpiness += d < 0 ? -d : d;
+        }
+    }
+    int danger = max_height + incoming_lines(&sim->side) + pending_threat;
+    if (danger >= BOARD_HEIGHT) {
+        danger = BOARD_HEIGHT;
+    }
+    return -w->height * total - w->holes * bitboard_hole_count(&sim->side.board) - w->bumpiness * bumpiness -
+           w->danger * danger * danger + w->sent * sim->sent + w->cancelled * sim->cancelled +
+           w->cleared * sim->cleared - w->landed * sim->landed + w->well * well_depth(heights);
+}
+
+/**
+ * @brief 相手の次の2手を貪欲に再現して攻撃を予測する
+ *
+ * 相手は各手で送る攻撃ライン数が最大の配置 (同数なら盤面の評価が良い配置) を選ぶと仮定します。
+ */
+static void predict_opponent(const VersusSide *opponent, int threat[VERSUS_AI_PREVIEW]) {
+    const VersusWeights *w = &PLAN_WEIGHTS[VERSUS_PLAN_DOWNSTACK];
+    VersusSim sim;
+    memset(&sim, 0, sizeof(sim));
+    sim.side = *opponent;
+
+    for (int ply = 0; ply < VERSUS_AI_PREVIEW; ply++) {
+        threat[ply] = 0;
+        BitPlacement moves[BITBOARD_MAX_PLACEMENTS];
+        int count = sim.dead ? 0 : bitboard_generate(&sim.side.board, opponent->pieces[ply], moves);
+        if (count == 0) {
+            for (; ply < VERSUS_AI_PREVIEW; ply++) {
+                threat[ply] = 0;
+            }
+            return;
+        }
+        VersusSim best_sim = sim;
+        int best_attack = -1;
+        int32_t best_score = INT32_MIN;
+        for (int i = 0; i < count; i++) {
+            VersusSim next = sim;
+            int attack = sim_lock(&next, &moves[i]);
+            int32_t score = evaluate(&next, 0, w);
+            if (attack > best_attack || (attack == best_attack && score > best_score)) {
+                best_attack = attack;
+                best_score = score;
+                best_sim = next;
+            }
+        }
+        threat[ply] = best_attack;
+        sim = best_sim;
+    }
+}
+
+/**
+ * @brief 局面から方針を選ぶ
+ */
+static VersusPlan choose_plan(const VersusSide *self, const VersusSide *opponent, const int threat[VERSUS_AI_PREVIEW]) {
+    int danger = bitboard_height(&self->board) + incoming_lines(self);
+    for (int i = 0; i < VERSUS_AI_PREVIEW; i++) {
+        danger += threat[i];
+    }
+    if (danger >= VERSUS_AI_DEFEND_DANGER) {
+        return VERSUS_PLAN_DEFEND;
+    }
+    if (bitboard_height(&opponent->board) >= VERSUS_AI_PRESSURE_HEIGHT) {
+        return VERSUS_PLAN_ATTACK; // 押し切れる相手には穴を残してでも攻める
+    }
+    return bitboard_hole_count(&self->board) > VERSUS_AI_DIG_HOLES ? VERSUS_PLAN_DOWNSTACK : VERSUS_PLAN_ATTACK;
+}
+
+/**
+ * @brief 予測攻撃の穴の列 (待ち行列の最後の穴、無ければ0列)
+ */
+static int threat_hole(const VersusSide *side) {
+    return side->incoming_count > 0 ? side->incoming[side->incoming_count - 1].hole_column : 0;
+}
+
+/**
+ * @brief 探索を準備する
+ */
+void versus_ai_prepare(VersusSearch *search, const VersusSide *self, const VersusSide *opponent,
+                       uint32_t node_budget) {
+    ai_task_init(&search->task);
+    search->self = *self;
+    search->opponent = *opponent;
+    search->node_budget = node_budget;
+    search->nodes = 0;
+    search->first_index = -1;
+    search->first_count = 0;
+    search->plan = VERSUS_PLAN_DOWNSTACK;
+    search->found = 0;
+    search->best_score = INT32_MIN;
+    memset(&search->best, 0, sizeof(search->best));
+}
+
+/**
+ * @brief 相手の予測、方針の選択、1手目の列挙を行う
+ */
+static void begin(VersusSearch *search) {
+    predict_opponent(&search->opponent, search->threat);
+    search->plan = choose_plan(&search->self, &search->opponent, search->threat);
+    search->first_count = bitboard_generate(&search->self.board, search->self.pieces[0], search->first);
+    search->first_index = 0;
+    search->nodes += (uint32_t)(search->first_count + BITBOARD_MAX_PLACEMENTS * VERSUS_AI_PREVIEW);
+}
+
+/**
+ * @brief 1手目を1つ調べる (2手目の全配置を評価する)
+ */
+static void expand_first(VersusSearch *search, const BitPlacement *first) {
+    const VersusWeights *w = &PLAN_WEIGHTS[search->plan];
+    VersusSim sim;
+    memset(&sim, 0, sizeof(sim));
+    sim.side = search->self;
+    sim_lock(&sim, first);
+    // 相手の1手目の攻撃は自分の2手目の設置の前に届く
+    push_garbage(&sim.side, search->threat[0], threat_hole(&search->self));
+
+    int32_t best = VERSUS_DEAD_SCORE;
+    BitPlacement moves[BITBOARD_MAX_PLACEMENTS];
+    int count = sim.dead ? 0 : bitboard_generate(&sim.side.board, search->self.pieces[1], moves);
+    for (int i = 0; i < count; i++) {
+        VersusSim leaf = sim;
+        sim_lock(&leaf, &moves[i]);
+        int32_t score = evaluate(&leaf, search->threat[1], w);
+        if (score > best) {
+            best = score;
+        }
+    }
+    search->nodes += (uint32_t)(count > 0 ? count : 1);
+
+    if (!search->found || best > search->best_score) {
+        search->found = 1;
+        search->best_score = best;
+        search->best = *first;
+    }
+}
+
+/**
+ * @brief 探索を小分けに進める
+ */
+int versus_ai_step(AiTask *task, uint32_t nodes) {
+    VersusSearch *search = (VersusSearch*)task; // task は先頭のメンバ
+    uint32_t limit = search->nodes + nodes;
+    if (search->first_index < 0) {
+        begin(search);
+    }
+    // 予算が準備だけで尽きても、置ける配置があれば少なくとも1手目を1つは調べる
+    while (search->first_index < search->first_count &&
+           (search->first_index == 0 || (search->nodes < search->node_budget && search->nodes < limit))) {
+        expand_first(search, &search->first[search->first_index++]);
+    }
+    return search->first_index >= search->first_count || search->nodes >= search->node_budget;
+}
+
+/**
+ * @brief 探索を最後まで実行する
+ */
+int versus_ai_search(VersusSearch *search) {
+    while (!versus_ai_step(&search->task, UINT32_MAX - search->nodes)) {
+    }
+    return search->found;
+}
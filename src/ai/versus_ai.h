@@ -0,0 +1,109 @@
+/**
+ * @file versus_ai.h
+ * @brief おじゃまラインと相手の攻撃を先読みする対戦 AI の宣言
+ *
+ * このファイルは対戦で、受けているおじゃまラインの待ち行列と相手の次の攻撃を
+ * ヘッドレスエンジン上で再現しながら、自分の配置を選ぶ探索を宣言します。
+ * 主な機能:
+ *   - 相手の盤面と既知のテトリミノによる、相手の次の2手の攻撃の予測 (貪欲法)
+ *   - 危険度と盤面の状態による方針の選択 (掘り進める / 攻撃 / 防御)
+ *   - 現在と次のテトリミノの2手読み (消去による相殺、未相殺分のせり上げ、予測攻撃の到着を含む)
+ *   - AI スケジューラのタスクとしての小分け実行と、評価局面数の上限
+ *
+ * 設計思想:
+ *   - 相手の予測は1手あたり配置数 (最大40) の評価のみで、自分の探索 (最大1600局面) の数%に収める
+ *   - 方針は探索の前に一度決め、評価の重みを切り替えるだけにする (探索の形は同じ)
+ *   - おじゃまラインは「消去しなかった設置の後に待ち行列の全てがせり上がる」規則で扱う
+ *   - 盤面はすべて値渡しのビットボードで、探索中に共有状態へ触れない
+ */
+
+#ifndef VERSUS_AI_H
+#define VERSUS_AI_H
+
+#include "ai_sched.h"
+#include "bitboard.h"
+
+#define VERSUS_AI_PREVIEW        2  /**< 読む手数 (現在と次のテトリミノ) */
+#define VERSUS_AI_MAX_GARBAGE    8  /**< おじゃまラインの待ち行列の長さ */
+#define VERSUS_AI_DEFEND_DANGER  12 /**< 防御に切り替える危険度 (高さ + 受けるライン数) */
+#define VERSUS_AI_DIG_HOLES      3  /**< 掘り進めを優先する穴の数 */
+#define VERSUS_AI_PRESSURE_HEIGHT 10 /**< 相手がこの高さ以上なら攻撃を優先する */
+
+/* 探索の方針の列挙型 */
+typedef enum {
+    VERSUS_PLAN_DOWNSTACK,       /**< 穴とおじゃまラインを掘り進める */
+    VERSUS_PLAN_ATTACK,          /**< 攻撃ライン数を優先する */
+    VERSUS_PLAN_DEFEND           /**< 消去による相殺と高さの抑制を優先する */
+} VersusPlan;
+
+/**
+ * @brief 待ち行列のおじゃまライン
+ */
+typedef struct {
+    uint8_t lines;               /**< ライン数 */
+    uint8_t hole_column;         /**< 穴の列 */
+} VersusGarbage;
+
+/**
+ * @brief 一方のプレイヤーの局面
+ */
+typedef struct {
+    BitBoard board;              /**< 盤面 */
+    TetrominoType pieces[VERSUS_AI_PREVIEW]; /**< 現在と次のテトリミノ */
+    int combo;                   /**< 現在のコンボ数 */
+    VersusGarbage incoming[VERSUS_AI_MAX_GARBAGE]; /**< 受けているおじゃまライン (古い順) */
+    int incoming_count;          /**< 待ち行列の要素数 */
+} VersusSide;
+
+/**
+ * @brief 探索 (AI スケジューラのタスクを埋め込む)
+ */
+typedef struct {
+    AiTask task;                 /**< スケジューラのタスク */
+    VersusSide self;             /**< 自分の局面 (投入後は変更しない) */
+    VersusSide opponent;         /**< 相手の局面 (投入後は変更しない) */
+    uint32_t node_budget;        /**< 評価する局面数の上限 */
+    uint32_t nodes;              /**< 評価した局面数 */
+    int first_index;             /**< 次に調べる1手目 (-1: 準備前) */
+    int first_count;             /**< 1手目の配置数 */
+    BitPlacement first[BITBOARD_MAX_PLACEMENTS]; /**< 1手目の配置 */
+    VersusPlan plan;             /**< 選んだ方針 */
+    int threat[VERSUS_AI_PREVIEW]; /**< 相手の予測攻撃ライン数 (手ごと) */
+    int found;                   /**< 配置が見つかった */
+    int32_t best_score;          /**< 最良の評価値 */
+    BitPlacement best;           /**< 最良の1手目 */
+} VersusSearch;
+
+/**
+ * @brief 探索を準備する (形状マスクテーブルは bitboard_init 済みであること)
+ * @param search 対象の探索
+ * @param self 自分の局面
+ * @param opponent 相手の局面 (盤面と既知のテトリミノ、自分が送ったおじゃまライン)
+ * @param node_budget 評価する局面数の上限 (サーバーでは shard_ai_budget で絞る)
+ */
+void versus_ai_prepare(VersusSearch *search, const VersusSide *self, const VersusSide *opponent,
+                       uint32_t node_budget);
+
+/**
+ * @brief 探索を小分けに進める (ai_sched_submit に渡す)
+ * @param task 探索に埋め込まれたタスク
+ * @param nodes 今回評価する局面数の目安
+ * @return 探索が完了した場合1、続きがある場合0
+ */
+int versus_ai_step(AiTask *task, uint32_t nodes);
+
+/**
+ * @brief 探索を最後まで実行する (スケジューラを使わない場合)
+ * @param search versus_ai_prepare 済みの探索
+ * @return 配置が見つかった場合1、どこにも置けない場合0
+ */
+int versus_ai_search(VersusSearch *search);
+
+/**
+ * @brief 方針の名前を取得する (ログ用)
+ * @param plan 方針
+ * @return 名前
+ */
+const char* versus_plan_name(VersusPlan plan);
+
+#endif /* VERSUS_AI_H */
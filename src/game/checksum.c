@@ -0,0 +1,97 @@
+/**
+ * @file checksum.c
+ * @brief ゲーム状態のチェックサム実装
+ *
+ * 主な機能:
+ *   - 盤面バイト列の並列混合ハッシュ
+ *   - テトリミノとスコアの混合と最終攪拌
+ *
+ * 設計思想:
+ *   - 盤面200バイトは25語。4系列に振り分け、乗算の連鎖を7段程度に抑える
+ *   - ビッグエンディアン環境では語を反転し、リトルエンディアンと同じ値にする
+ */
+
+#include "checksum.h"
+#include <string.h>
+
+#define CHECKSUM_K1 0x9e3779b97f4a7c15ull
+#define CHECKSUM_K2 0xc2b2ae3d27d4eb4full
+#define CHECKSUM_K3 0x165667b19e3779f9ull
+#define CHECKSUM_K4 0x85ebca77c2b2ae63ull
+
+static inline uint64_t load64(const uint8_t *p) {
+    uint64_t v;
+    memcpy(&v, p, sizeof(v));
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    v = __builtin_bswap64(v);
+#endif
+    return v;
+}
+
+static inline uint64_t mix(uint64_t h, uint64_t v, uint64_t k) {
+    h = (h ^ v) * k;
+    return h ^ (h >> 31);
+}
+
+/**
+ * @brief 盤面のバイト列を混合する
+ */
+static uint64_t hash_grid(const uint8_t *grid, size_t len) {
+    uint64_t h0 = CHECKSUM_K1, h1 = CHECKSUM_K2, h2 = CHECKSUM_K3, h3 = CHECKSUM_K4;
+    size_t i = 0;
+    for (; i + 32 <= len; i += 32) {
+        h0 = mix(h0, load64(grid + i), CHECKSUM_K1);
+        h1 = mix(h1, load64(grid + i + 8), CHECKSUM_K2);
+        h2 = mix(h2, load64(grid + i + 16), CHECKSUM_K3);
+        h3 = mix(h3, load64(grid + i + 24), CHECKSUM_K4);
+    }
+    for (; i + 8 <= len; i += 8) {
+        h0 = mix(h0, load64(grid + i), CHECKSUM_K2);
+    }
+    if (i < len) {
+        uint8_t tail[8] = {0};
+        memcpy(tail, grid + i, len - i);
+        h1 = mix(h1, load64(tail), CHECKSUM_K3);
+    }
+    return h0 ^ (h1 << 1 | h1 >> 63) ^ (h2 << 2 | h2 >> 62) ^ (h3 << 3 | h3 >> 61);
+}
+
+/**
+ * @brief テトリミノの位置と回転を1語に詰める
+ */
+static inline uint64_t pack_piece(const Piece *piece) {
+    return (uint64_t)(uint8_t)piece->type | (uint64_t)(uint8_t)piece->x << 8 |
+           (uint64_t)(uint8_t)piece->y << 16 | (uint64_t)(uint8_t)piece->rotation << 24;
+}
+
+/**
+ * @brief 盤面以外の状態を混合して32ビットに縮める
+ */
+static uint32_t finish(uint64_t h, const Piece *current, const Piece *next, const ScoreCtx *score) {
+    h = mix(h, pack_piece(current) | pack_piece(next) << 32, CHECKSUM_K1);
+    h = mix(h, (uint64_t)(uint32_t)score->score | (uint64_t)(uint32_t)score->lines_cleared << 32, CHECKSUM_K2);
+    h = mix(h, (uint64_t)(uint32_t)score->level | (uint64_t)(uint32_t)score->combo_count << 32, CHECKSUM_K3);
+    h = mix(h, (uint64_t)(uint32_t)score->lines_since_last_level |
+               (uint64_t)(uint32_t)score->last_clear_type << 32, CHECKSUM_K4);
+    return (uint32_t)(h ^ (h >> 32));
+}
+
+/**
+ * @brief 現在の状態のチェックサムを計算する
+ */
+uint32_t checksum_gameplay(const GamePlayContext *gameplay) {
+    static const uint8_t empty[BOARD_SIZE];
+    const Board *board = gameplay->board;
+    const uint8_t *grid = (board && board->grid && board->width * board->height == BOARD_SIZE)
+                              ? board->grid : empty;
+    return finish(hash_grid(grid, BOARD_SIZE),
+                  &gameplay->current_piece, &gameplay->next_piece, &gameplay->score);
+}
+
+/**
+ * @brief スナップショットのチェックサムを計算する
+ */
+uint32_t checksum_snapshot(const GameSnapshot *snapshot) {
+    return finish(hash_grid(snapshot->grid, BOARD_SIZE),
+                  &snapshot->current_piece, &snapshot->next_piece, &snapshot->score);
+}
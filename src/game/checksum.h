@@ -0,0 +1,37 @@
+/**
+ * @file checksum.h
+ * @brief ゲーム状態のチェックサムの宣言
+ *
+ * このファイルは対戦相手との非同期 (desync) を検出するための
+ * 軽量なチェックサム関数を宣言します。
+ * 主な機能:
+ *   - GamePlayContext のチェックサム (盤面、テトリミノ、スコア)
+ *   - スナップショットのチェックサム (同じ状態なら同じ値)
+ *
+ * 設計思想:
+ *   - 盤面は64ビット単位で4系列並行に混合し、乗算の依存連鎖を短くする
+ *   - 暗号学的強度は不要。偶然の一致は32ビットで十分に稀
+ *   - バイト順に依存しない値を返し、異なるマシン間で比較できる
+ */
+
+#ifndef CHECKSUM_H
+#define CHECKSUM_H
+
+#include "game_defs.h"
+#include "snapshot.h"
+
+/**
+ * @brief 現在の状態のチェックサムを計算する
+ * @param gameplay 対象のコンテキスト
+ * @return チェックサム
+ */
+uint32_t checksum_gameplay(const GamePlayContext *gameplay);
+
+/**
+ * @brief スナップショットのチェックサムを計算する
+ * @param snapshot 対象のスナップショット
+ * @return 保存元の状態に対する checksum_gameplay と同じ値
+ */
+uint32_t checksum_snapshot(const GameSnapshot *snapshot);
+
+#endif /* CHECKSUM_H */
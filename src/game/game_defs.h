@@ -29,6 +29,7 @@ typedef enum {
     GAME_STATE_PAUSED,      /**< 一時停止中 */
     GAME_STATE_GAME_OVER,   /**< ゲームオーバー */
     GAME_STATE_NETWORKING,  /**< ネットワーク接続中 */
+    GAME_STATE_ANALYSIS,    /**< 解析モード (配置の巻き戻し/やり直し) */
     GAME_STATE_EXIT         /**< ゲーム終了 */
 } GameState;
 
@@ -67,7 +68,9 @@ typedef enum {
 #define KEY_HOLD         'C' /**< ホールドキー */
 #define KEY_PAUSE        'P' /**< 一時停止キー */
 #define KEY_QUIT         'X' /**< 終了キー */
-#define KEY_COUNT        9   /**< キーの総数 */
+#define KEY_UNDO         'Z' /**< 解析モード: 1手戻すキー */
+#define KEY_REDO         'Y' /**< 解析モード: 1手進めるキー */
+#define KEY_COUNT        11  /**< キーの総数 */
 
 /* ゲームボードの定数 */
 #define BOARD_WIDTH      10  /**< ボードの幅 (ブロック数) */
@@ -90,6 +93,10 @@ typedef enum {
 #define SCORE_HARD_DROP   2   /**< ハードドロップ1ブロックごとのスコア */
 #define SCORE_COMBO_BONUS 50  /**< コンボボーナス (連続ライン消去ごと) */
 
+/* プレイ統計の定数 */
+#define STATS_WINDOW_BUCKETS 16   /**< スライディングウィンドウのバケット数 */
+#define STATS_BUCKET_MS      1000 /**< 1バケットの時間幅 (ms) */
+
 /* テトリミノ形状定義 */
 #define TETROMINO_SIZE 4 /**< テトリミノのマトリックスサイズ (4x4) */
 
@@ -131,6 +138,39 @@ typedef struct {
     int last_clear_type;         /**< 最後に消去したライン数 */
 } ScoreCtx;
 
+/**
+ * @brief プレイ統計のスライディングウィンドウ1区間
+ */
+typedef struct {
+    uint16_t pieces;             /**< 区間内の設置数 */
+    uint16_t keys;               /**< 区間内のキー入力数 */
+    uint16_t attack;             /**< 区間内の攻撃ライン数 */
+} StatsBucket;
+
+/**
+ * @brief プレイ統計構造体
+ *
+ * PPS/APM/KPP、フィネスミス、消去種別の分布、最大コンボを逐次集計します。
+ * イベントごとの記録は保持せず、固定サイズの累積値とウィンドウのみを持ちます。
+ */
+typedef struct {
+    uint32_t start_ms;           /**< 計測開始時刻 (ms) */
+    uint32_t pieces;             /**< 設置数 */
+    uint32_t keys;               /**< キー入力数 */
+    uint32_t attack;             /**< 攻撃ライン数 */
+    uint32_t finesse_faults;     /**< フィネスミス数 */
+    uint32_t clears[5];          /**< 消去ライン数ごとの設置数 (0-4ライン) */
+    uint16_t combo;              /**< 現在のコンボ数 */
+    uint16_t max_combo;          /**< 最大コンボ数 */
+    uint16_t keys_this_piece;    /**< 現在のテトリミノに対するキー入力数 */
+    uint16_t bucket_index;       /**< 現在のバケット */
+    uint32_t bucket_start_ms;    /**< 現在のバケットの開始時刻 (ms) */
+    uint32_t window_pieces;      /**< ウィンドウ内の設置数 */
+    uint32_t window_keys;        /**< ウィンドウ内のキー入力数 */
+    uint32_t window_attack;      /**< ウィンドウ内の攻撃ライン数 */
+    StatsBucket buckets[STATS_WINDOW_BUCKETS]; /**< ウィンドウのバケット */
+} PlayerStats;
+
 /**
  * @brief プレイヤー入力構造体
  * 
@@ -141,6 +181,9 @@ typedef struct {
     uint8_t prev_keys[KEY_COUNT];/**< 前フレームのキー状態 */
 } PlayerInput;
 
+/* 解析モード用の盤面履歴 (history.h で定義) */
+typedef struct History History;
+
 /**
  * @brief ゲームコンテキストのサブコンポーネント
  */
@@ -149,7 +192,9 @@ typedef struct {
     Piece current_piece;        /**< 現在操作中のテトリミノ */
     Piece next_piece;           /**< 次のテトリミノ */
     ScoreCtx score;             /**< スコア管理コンテキスト */
+    PlayerStats stats;          /**< プレイ統計 */
     Timer timer;                /**< ゲームタイマー */
+    History* history;           /**< 解析モード用の盤面履歴 (未使用時はNULL) */
 } GamePlayContext;
 
 typedef struct {
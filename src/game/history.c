@@ -0,0 +1,501 @@
+/**
+ * @file history.c
+ * @brief 解析モード用の盤面履歴実装
+ *
+ * 主な機能:
+ *   - 行プールによる盤面行のインターン化 (参照カウント付き)
+ *   - 親/子/兄弟リンクによる分岐ツリー
+ *   - O(1) のアンドゥ/リドゥ/分岐切り替え
+ *   - 容量超過時の古い局面の一括回収
+ *
+ * 設計思想:
+ *   - 配置で変化する行は最大4行のため、1手あたりの新規行は通常最大4つ
+ *     (おじゃまラインなどで盤面が大きく変わった手に備え、空き行が1盤面分を切ったら回収する)
+ *   - ライン消去は行IDの並べ替えのみで表現でき、行データのコピーは不要
+ *   - 親と同じ内容の行はハッシュ検索せずにIDを共有する高速経路
+ *   - 回収は容量の1/4をまとめて行い、記録1回あたりのコストを償却O(1)に保つ
+ */
+
+#include "history.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define HISTORY_NONE     0xFFFF /**< 無効なノード/行ID */
+#define HISTORY_EMPTY_ROW 0     /**< 空行のID (常駐) */
+#define HISTORY_NO_PIECE 0xFF   /**< 起点ノードの配置テトリミノ */
+
+/**
+ * @brief インターン化された盤面の1行
+ */
+typedef struct {
+    uint8_t cells[BOARD_WIDTH];  /**< セルデータ */
+    uint16_t hash_next;          /**< ハッシュチェーン/空きリストの次の行 */
+    uint32_t refcount;           /**< 参照しているスナップショット数 */
+} HistoryRow;
+
+/**
+ * @brief 1手分のスナップショット
+ */
+typedef struct {
+    uint16_t rows[BOARD_HEIGHT]; /**< 各行の行ID (上から下) */
+    uint16_t parent;             /**< 親ノード */
+    uint16_t first_child;        /**< 最初の子ノード (最新の分岐) */
+    uint16_t next_sibling;       /**< 次の兄弟ノード / 空きリストの次 */
+    uint16_t redo_child;         /**< リドゥで進む子ノード */
+    uint32_t ply;                /**< リセットからの手数 */
+    int32_t score;               /**< スコア */
+    uint16_t lines_cleared;      /**< 消去ライン数 */
+    uint8_t level;               /**< レベル */
+    uint8_t combo_count;         /**< コンボ数 */
+    uint8_t last_clear_type;     /**< 最後に消去したライン数 */
+    uint8_t next_type;           /**< 次のテトリミノ */
+    uint8_t piece_type;          /**< 配置したテトリミノ (起点はHISTORY_NO_PIECE) */
+    uint8_t piece_rotation;      /**< 配置したテトリミノの回転状態 */
+    int8_t piece_x;              /**< 配置したテトリミノのX位置 */
+    int8_t piece_y;              /**< 配置したテトリミノのY位置 */
+} HistoryNode;
+
+struct History {
+    HistoryNode* nodes;          /**< ノードプール */
+    HistoryRow* rows;            /**< 行プール */
+    uint16_t* buckets;           /**< 行ハッシュテーブル */
+    uint16_t* scratch;           /**< 回収処理用の作業領域 */
+    int capacity;                /**< ノード数の上限 */
+    int row_capacity;            /**< 行数の上限 */
+    int bucket_mask;             /**< ハッシュテーブルのマスク */
+    int node_count;              /**< 使用中のノード数 */
+    int free_rows;               /**< 空き行の数 */
+    uint16_t free_node;          /**< 空きノードリストの先頭 */
+    uint16_t free_row;           /**< 空き行リストの先頭 */
+    uint16_t root;               /**< 最も古い局面 */
+    uint16_t current;            /**< 現在の局面 */
+};
+
+/**
+ * @brief 行データのハッシュ値を計算する (FNV-1a)
+ */
+static uint32_t row_hash(const uint8_t *cells) {
+    uint32_t h = 2166136261u;
+    for (int x = 0; x < BOARD_WIDTH; x++) {
+        h = (h ^ cells[x]) * 16777619u;
+    }
+    return h;
+}
+
+/**
+ * @brief 行をインターン化し、その行IDを返す
+ */
+static uint16_t row_intern(History *history, const uint8_t *cells) {
+    uint32_t bucket = row_hash(cells) & (uint32_t)history->bucket_mask;
+
+    for (uint16_t id = history->buckets[bucket]; id != HISTORY_NONE;
+         id = history->rows[id].hash_next) {
+        if (memcmp(history->rows[id].cells, cells, BOARD_WIDTH) == 0) {
+            history->rows[id].refcount++;
+            return id;
+        }
+    }
+
+    // 新しい行を確保 (記録の前に1盤面分の空きを確保しているため枯渇しない)
+    uint16_t id = history->free_row;
+    HistoryRow *row = &history->rows[id];
+    history->free_row = row->hash_next;
+    history->free_rows--;
+    memcpy(row->cells, cells, BOARD_WIDTH);
+    row->refcount = 1;
+    row->hash_next = history->buckets[bucket];
+    history->buckets[bucket] = id;
+    return id;
+}
+
+/**
+ * @brief 行の参照を解放する
+ */
+static void row_release(History *history, uint16_t id) {
+    HistoryRow *row = &history->rows[id];
+    if (--row->refcount > 0 || id == HISTORY_EMPTY_ROW) {
+        return;
+    }
+
+    // ハッシュチェーンから外して空きリストへ戻す
+    uint32_t bucket = row_hash(row->cells) & (uint32_t)history->bucket_mask;
+    uint16_t *link = &history->buckets[bucket];
+    while (*link != id) {
+        link = &history->rows[*link].hash_next;
+    }
+    *link = row->hash_next;
+    row->hash_next = history->free_row;
+    history->free_row = id;
+    history->free_rows++;
+}
+
+/**
+ * @brief ノードを解放する (子や兄弟のリンクは呼び出し側で処理)
+ */
+static void node_free(History *history, uint16_t id) {
+    HistoryNode *node = &history->nodes[id];
+    for (int y = 0; y < BOARD_HEIGHT; y++) {
+        row_release(history, node->rows[y]);
+    }
+    node->next_sibling = history->free_node;
+    history->free_node = id;
+    history->node_count--;
+}
+
+/**
+ * @brief 部分木をまとめて解放する
+ */
+static void subtree_free(History *history, uint16_t top) {
+    uint16_t *stack = history->scratch;
+    int sp = 0;
+    stack[sp++] = top;
+    while (sp > 0) {
+        uint16_t id = stack[--sp];
+        for (uint16_t c = history->nodes[id].first_child; c != HISTORY_NONE;
+             c = history->nodes[c].next_sibling) {
+            stack[sp++] = c;
+        }
+        node_free(history, id);
+    }
+}
+
+/**
+ * @brief 次の局面を記録する空きが足りないか判定する
+ *
+ * 盤面の全行が新規でも足りるよう、空き行は1盤面分 (BOARD_HEIGHT) を要求します。
+ */
+static int history_full(const History *history) {
+    return history->node_count == history->capacity || history->free_rows < BOARD_HEIGHT;
+}
+
+/**
+ * @brief 現在のラインから外れた古い局面を回収する
+ */
+static void history_reclaim(History *history) {
+    int target = history->capacity / 4;
+    if (target < 1) {
+        target = 1;
+    }
+
+    // 現在の局面から起点までの経路を記録 (path[0]が現在、path[n-1]が起点)
+    uint16_t *path = history->scratch + history->capacity;
+    int n = 0;
+    for (uint16_t id = history->current; id != HISTORY_NONE;
+         id = history->nodes[id].parent) {
+        path[n++] = id;
+    }
+
+    // 起点を経路に沿って進め、経路外の分岐ごと古い局面を解放
+    while ((history->capacity - history->node_count < target || history->free_rows < BOARD_HEIGHT) && n > 1) {
+        uint16_t old_root = path[--n];
+        uint16_t keep = path[n - 1];
+        uint16_t c = history->nodes[old_root].first_child;
+        while (c != HISTORY_NONE) {
+            uint16_t next = history->nodes[c].next_sibling;
+            if (c != keep) {
+                subtree_free(history, c);
+            }
+            c = next;
+        }
+        node_free(history, old_root);
+        history->nodes[keep].parent = HISTORY_NONE;
+        history->nodes[keep].next_sibling = HISTORY_NONE;
+        history->root = keep;
+    }
+
+    // 起点まで戻っている場合はリドゥ側の分岐を破棄するしかない
+    if (history_full(history)) {
+        HistoryNode *cur = &history->nodes[history->current];
+        uint16_t c = cur->first_child;
+        while (c != HISTORY_NONE) {
+            uint16_t next = history->nodes[c].next_sibling;
+            subtree_free(history, c);
+            c = next;
+        }
+        cur->first_child = HISTORY_NONE;
+        cur->redo_child = HISTORY_NONE;
+    }
+}
+
+/**
+ * @brief 新しいノードを確保し、盤面とスコアを記録する
+ */
+static uint16_t node_record(History *history, uint16_t parent, const Board *board,
+                            const ScoreCtx *score, TetrominoType next_type) {
+    uint16_t id = history->free_node;
+    HistoryNode *node = &history->nodes[id];
+    history->free_node = node->next_sibling;
+    history->node_count++;
+
+    const HistoryNode *pnode = (parent != HISTORY_NONE) ? &history->nodes[parent] : NULL;
+    for (int y = 0; y < BOARD_HEIGHT; y++) {
+        const uint8_t *cells = board->grid + y * BOARD_WIDTH;
+        // 親の同じ行と一致すればハッシュ検索なしで共有
+        if (pnode && memcmp(history->rows[pnode->rows[y]].cells, cells, BOARD_WIDTH) == 0) {
+            node->rows[y] = pnode->rows[y];
+            history->rows[node->rows[y]].refcount++;
+        } else {
+            node->rows[y] = row_intern(history, cells);
+        }
+    }
+
+    node->parent = parent;
+    node->first_child = HISTORY_NONE;
+    node->next_sibling = HISTORY_NONE;
+    node->redo_child = HISTORY_NONE;
+    node->ply = pnode ? pnode->ply + 1 : 0;
+    node->score = score->score;
+    node->lines_cleared = (uint16_t)score->lines_cleared;
+    node->level = (uint8_t)score->level;
+    node->combo_count = (uint8_t)score->combo_count;
+    node->last_clear_type = (uint8_t)score->last_clear_type;
+    node->next_type = (uint8_t)next_type;
+    node->piece_type = HISTORY_NO_PIECE;
+    node->piece_rotation = 0;
+    node->piece_x = 0;
+    node->piece_y = 0;
+    return id;
+}
+
+/**
+ * @brief 全ノードと行を空きリストに戻す
+ */
+static void history_clear(History *history) {
+    for (int i = 0; i < history->capacity; i++) {
+        history->nodes[i].next_sibling = (i + 1 < history->capacity) ? (uint16_t)(i + 1) : HISTORY_NONE;
+    }
+    for (int i = 0; i < history->row_capacity; i++) {
+        history->rows[i].hash_next = (i + 1 < history->row_capacity) ? (uint16_t)(i + 1) : HISTORY_NONE;
+        history->rows[i].refcount = 0;
+    }
+    for (int i = 0; i <= history->bucket_mask; i++) {
+        history->buckets[i] = HISTORY_NONE;
+    }
+    history->free_node = 0;
+    history->node_count = 0;
+    history->root = HISTORY_NONE;
+    history->current = HISTORY_NONE;
+
+    // 空行は常駐させる
+    static const uint8_t empty[BOARD_WIDTH] = {0};
+    history->free_row = 0;
+    history->free_rows = history->row_capacity;
+    row_intern(history, empty);
+}
+
+/**
+ * @brief 履歴を作成する
+ */
+History* history_create(int capacity) {
+    if (capacity <= 0) {
+        capacity = HISTORY_DEFAULT_CAPACITY;
+    }
+    if (capacity < 2) {
+        capacity = 2; // 起点と最新の局面を最低限保持
+    }
+    if (capacity > HISTORY_MAX_CAPACITY) {
+        capacity = HISTORY_MAX_CAPACITY;
+    }
+
+    History *history = (History*)calloc(1, sizeof(History));
+    if (!history) {
+        return NULL;
+    }
+
+    history->capacity = capacity;
+    // 1手あたり4行を基本に、回収し尽くしても現在と次の局面が全行新規で収まる分 (2盤面) と常駐の空行
+    history->row_capacity = capacity * 4 + BOARD_HEIGHT * 2 + 1;
+    int buckets = 1;
+    while (buckets < history->row_capacity) {
+        buckets <<= 1;
+    }
+    history->bucket_mask = buckets - 1;
+
+    history->nodes = (HistoryNode*)malloc(sizeof(HistoryNode) * (size_t)capacity);
+    history->rows = (HistoryRow*)malloc(sizeof(HistoryRow) * (size_t)history->row_capacity);
+    history->buckets = (uint16_t*)malloc(sizeof(uint16_t) * (size_t)buckets);
+    history->scratch = (uint16_t*)malloc(sizeof(uint16_t) * (size_t)capacity * 2);
+    if (!history->nodes || !history->rows || !history->buckets || !history->scratch) {
+        history_destroy(history);
+        return NULL;
+    }
+
+    history_clear(history);
+    return history;
+}
+
+/**
+ * @brief 履歴を解放する
+ */
+void history_destroy(History *history) {
+    if (!history) {
+        return;
+    }
+    free(history->nodes);
+    free(history->rows);
+    free(history->buckets);
+    free(history->scratch);
+    free(history);
+}
+
+/**
+ * @brief 履歴を破棄し、現在の局面を新しい起点として記録する
+ */
+int history_reset(History *history, const Board *board, const ScoreCtx *score,
+                  TetrominoType next_type) {
+    if (!history || !board || !score ||
+        board->width != BOARD_WIDTH || board->height != BOARD_HEIGHT) {
+        return 0;
+    }
+
+    history_clear(history);
+    history->root = node_record(history, HISTORY_NONE, board, score, next_type);
+    history->current = history->root;
+    return 1;
+}
+
+/**
+ * @brief 配置後の局面を現在の局面の子として記録する
+ */
+int history_commit(History *history, const Board *board, const ScoreCtx *score,
+                   const Piece *placed, TetrominoType next_type) {
+    if (!history || !board || !score ||
+        board->width != BOARD_WIDTH || board->height != BOARD_HEIGHT) {
+        return 0;
+    }
+    if (history->current == HISTORY_NONE) {
+        return history_reset(history, board, score, next_type);
+    }
+
+    if (history_full(history)) {
+        history_reclaim(history);
+        if (history_full(history)) {
+            return 0;
+        }
+    }
+
+    uint16_t parent = history->current;
+    uint16_t id = node_record(history, parent, board, score, next_type);
+    HistoryNode *node = &history->nodes[id];
+    if (placed) {
+        node->piece_type = (uint8_t)placed->type;
+        node->piece_rotation = (uint8_t)placed->rotation;
+        node->piece_x = (int8_t)placed->x;
+        node->piece_y = (int8_t)placed->y;
+    }
+
+    // 最新の分岐を先頭に繋ぎ、リドゥ先とする
+    HistoryNode *pnode = &history->nodes[parent];
+    node->next_sibling = pnode->first_child;
+    pnode->first_child = id;
+    pnode->redo_child = id;
+    history->current = id;
+    return 1;
+}
+
+/**
+ * @brief 1手戻す
+ */
+int history_undo(History *history) {
+    if (!history || history->current == HISTORY_NONE) {
+        return 0;
+    }
+    uint16_t parent = history->nodes[history->current].parent;
+    if (parent == HISTORY_NONE) {
+        return 0;
+    }
+    history->nodes[parent].redo_child = history->current;
+    history->current = parent;
+    return 1;
+}
+
+/**
+ * @brief 直前に辿ったラインに沿って1手進める
+ */
+int history_redo(History *history) {
+    if (!history || history->current == HISTORY_NONE) {
+        return 0;
+    }
+    uint16_t next = history->nodes[history->current].redo_child;
+    if (next == HISTORY_NONE) {
+        return 0;
+    }
+    history->current = next;
+    return 1;
+}
+
+/**
+ * @brief 同じ親を持つ次の分岐に切り替える
+ */
+int history_next_branch(History *history) {
+    if (!history || history->current == HISTORY_NONE) {
+        return 0;
+    }
+    HistoryNode *node = &history->nodes[history->current];
+    if (node->parent == HISTORY_NONE) {
+        return 0;
+    }
+    HistoryNode *pnode = &history->nodes[node->parent];
+    uint16_t next = (node->next_sibling != HISTORY_NONE) ? node->next_sibling : pnode->first_child;
+    if (next == history->current) {
+        return 0;
+    }
+    pnode->redo_child = next;
+    history->current = next;
+    return 1;
+}
+
+/**
+ * @brief 現在の局面をボードとスコアに書き戻す
+ */
+int history_restore(const History *history, Board *board, ScoreCtx *score,
+                    Piece *placed, TetrominoType *next_type) {
+    if (!history || history->current == HISTORY_NONE || !board || !score ||
+        board->width != BOARD_WIDTH || board->height != BOARD_HEIGHT) {
+        return 0;
+    }
+
+    const HistoryNode *node = &history->nodes[history->current];
+    for (int y = 0; y < BOARD_HEIGHT; y++) {
+        memcpy(board->grid + y * BOARD_WIDTH, history->rows[node->rows[y]].cells, BOARD_WIDTH);
+    }
+
+    score->score = node->score;
+    score->level = node->level;
+    score->lines_cleared = node->lines_cleared;
+    score->lines_since_last_level = node->lines_cleared % LINES_PER_LEVEL;
+    score->combo_count = node->combo_count;
+    score->last_clear_type = node->last_clear_type;
+
+    if (placed) {
+        if (node->piece_type == HISTORY_NO_PIECE) {
+            placed->type = TETROMINO_COUNT;
+        } else {
+            placed->type = (TetrominoType)node->piece_type;
+            placed->rotation = node->piece_rotation;
+            placed->x = node->piece_x;
+            placed->y = node->piece_y;
+        }
+    }
+    if (next_type) {
+        *next_type = (TetrominoType)node->next_type;
+    }
+    return 1;
+}
+
+/**
+ * @brief 起点から現在の局面までの手数を取得する
+ */
+int history_depth(const History *history) {
+    if (!history || history->current == HISTORY_NONE) {
+        return 0;
+    }
+    return (int)(history->nodes[history->current].ply - history->nodes[history->root].ply);
+}
+
+/**
+ * @brief 保持しているスナップショット数を取得する
+ */
+int history_count(const History *history) {
+    return history ? history->node_count : 0;
+}
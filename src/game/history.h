@@ -0,0 +1,114 @@
+/**
+ * @file history.h
+ * @brief 解析モード用の盤面履歴 (アンドゥ/リドゥ/分岐) の宣言
+ *
+ * このファイルは配置ごとの盤面を永続データ構造として保持する履歴機能を宣言します。
+ * 主な機能:
+ *   - 配置ごとのスナップショット記録
+ *   - O(1) のアンドゥ/リドゥ
+ *   - 過去の局面からの分岐 (別ライン) の作成と切り替え
+ *   - 上限付きメモリでの長時間セッション対応
+ *
+ * 設計思想:
+ *   - 行単位のコピーオンライト: 変化しない行はスナップショット間で共有
+ *   - スナップショットは行IDの配列と最小限のメタ情報のみ (64バイト程度)
+ *   - 固定容量のノードプールと行プールによる動的確保の排除
+ *   - 容量超過時は現在のラインから外れた古い局面から回収
+ */
+
+#ifndef HISTORY_H
+#define HISTORY_H
+
+#include "game_defs.h"
+
+#define HISTORY_DEFAULT_CAPACITY 4096  /**< 既定のスナップショット数 */
+#define HISTORY_MAX_CAPACITY     16000 /**< スナップショット数の上限 (行IDが16ビットに収まる範囲) */
+
+/**
+ * @brief 履歴を作成する
+ * @param capacity 保持するスナップショット数 (0で既定値、上限を超える値は切り詰め)
+ * @return 作成した履歴 (失敗時はNULL)
+ */
+History* history_create(int capacity);
+
+/**
+ * @brief 履歴を解放する
+ * @param history 解放する履歴 (NULL可)
+ */
+void history_destroy(History *history);
+
+/**
+ * @brief 履歴を破棄し、現在の局面を新しい起点として記録する
+ * @param history 対象の履歴
+ * @param board 現在のボード
+ * @param score 現在のスコア
+ * @param next_type 次に出現するテトリミノ
+ * @return 成功時1、失敗時0
+ */
+int history_reset(History *history, const Board *board, const ScoreCtx *score,
+                  TetrominoType next_type);
+
+/**
+ * @brief 配置後の局面を現在の局面の子として記録する
+ *
+ * 現在の局面が過去の局面 (アンドゥ後) の場合は新しい分岐になります。
+ * 容量が不足した場合は現在のラインから外れた古い局面を回収します。
+ *
+ * @param history 対象の履歴
+ * @param board 配置後のボード
+ * @param score 配置後のスコア
+ * @param placed 配置したテトリミノ
+ * @param next_type 次に出現するテトリミノ
+ * @return 成功時1、失敗時0
+ */
+int history_commit(History *history, const Board *board, const ScoreCtx *score,
+                   const Piece *placed, TetrominoType next_type);
+
+/**
+ * @brief 1手戻す
+ * @param history 対象の履歴
+ * @return 移動できた場合1、起点にいる場合0
+ */
+int history_undo(History *history);
+
+/**
+ * @brief 直前に辿ったラインに沿って1手進める
+ * @param history 対象の履歴
+ * @return 移動できた場合1、末端にいる場合0
+ */
+int history_redo(History *history);
+
+/**
+ * @brief 同じ親を持つ次の分岐に切り替える
+ * @param history 対象の履歴
+ * @return 切り替えた場合1、分岐が無い場合0
+ */
+int history_next_branch(History *history);
+
+/**
+ * @brief 現在の局面をボードとスコアに書き戻す
+ * @param history 対象の履歴
+ * @param board 書き込み先のボード (BOARD_WIDTH x BOARD_HEIGHT)
+ * @param score 書き込み先のスコア
+ * @param placed 直前に配置したテトリミノの出力先 (NULL可、起点では種類のみ無効値)
+ * @param next_type 次のテトリミノの出力先 (NULL可)
+ * @return 成功時1、失敗時0
+ */
+int history_restore(const History *history, Board *board, ScoreCtx *score,
+                    Piece *placed, TetrominoType *next_type);
+
+/**
+ * @brief 起点から現在の局面までの手数を取得する
+ * @param history 対象の履歴
+ * @return 手数
+ */
+int history_depth(const History *history);
+
+/**
+ * @brief 保持しているスナップショット数を取得する
+ * @param history 対象の履歴
+ * @return スナップショット数
+ */
+int history_count(const History *history);
+
+#endif /* HISTORY_H */
@@ -22,6 +22,12 @@
 
 #include "game_defs.h"
 
+/* テトリミノ形状定義 [種類][回転][行][列] (piece.c で定義) */
+extern const int TETROMINO_SHAPES[TETROMINO_COUNT][4][4][4];
+
+/* テトリミノの初期位置 [種類][X, Y] (piece.c で定義) */
+extern const int INITIAL_POSITIONS[TETROMINO_COUNT][2];
+
 
 
 
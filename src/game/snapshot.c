@@ -0,0 +1,138 @@
+/**
+ * @file snapshot.c
+ * @brief ゲーム状態のスナップショット実装
+ *
+ * 主な機能:
+ *   - 盤面とテトリミノ、スコアのコピー
+ *   - リトルエンディアン固定の直列化と検証付きの復元
+ *
+ * 設計思想:
+ *   - テトリミノの回転マトリックスは送らず、種類と回転状態から再構築する
+ */
+
+#include "snapshot.h"
+#include "piece.h"
+#include <string.h>
+
+/**
+ * @brief 現在の状態を保存する
+ */
+void snapshot_capture(const GamePlayContext *gameplay, uint32_t frame, GameSnapshot *out) {
+    const Board *board = gameplay->board;
+    out->frame = frame;
+    if (board && board->grid && board->width * board->height == BOARD_SIZE) {
+        memcpy(out->grid, board->grid, BOARD_SIZE);
+    } else {
+        memset(out->grid, 0, BOARD_SIZE);
+    }
+    out->current_piece = gameplay->current_piece;
+    out->next_piece = gameplay->next_piece;
+    out->score = gameplay->score;
+}
+
+/**
+ * @brief 保存した状態を復元する
+ */
+int snapshot_restore(GamePlayContext *gameplay, const GameSnapshot *snapshot) {
+    Board *board = gameplay->board;
+    if (!board || !board->grid || board->width * board->height != BOARD_SIZE) {
+        return 0;
+    }
+    memcpy(board->grid, snapshot->grid, BOARD_SIZE);
+    gameplay->current_piece = snapshot->current_piece;
+    gameplay->next_piece = snapshot->next_piece;
+    gameplay->score = snapshot->score;
+    return 1;
+}
+
+static void put_u32(uint8_t *p, uint32_t v) {
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+    p[2] = (uint8_t)(v >> 16);
+    p[3] = (uint8_t)(v >> 24);
+}
+
+static uint32_t get_u32(const uint8_t *p) {
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static void put_piece(uint8_t *p, const Piece *piece) {
+    p[0] = (uint8_t)piece->type;
+    p[1] = (uint8_t)(int8_t)piece->x;
+    p[2] = (uint8_t)(int8_t)piece->y;
+    p[3] = (uint8_t)piece->rotation;
+}
+
+/**
+ * @brief 直列化されたテトリミノを復元する (回転マトリックスは形状定義から再構築)
+ */
+static int get_piece(const uint8_t *p, Piece *piece) {
+    if (p[0] >= TETROMINO_COUNT || p[3] >= 4) {
+        return 0;
+    }
+    piece->type = (TetrominoType)p[0];
+    piece->x = (int8_t)p[1];
+    piece->y = (int8_t)p[2];
+    piece->rotation = p[3];
+    for (int y = 0; y < TETROMINO_SIZE; y++) {
+        for (int x = 0; x < TETROMINO_SIZE; x++) {
+            piece->matrix[y][x] = TETROMINO_SHAPES[piece->type][piece->rotation][y][x];
+        }
+    }
+    return 1;
+}
+
+/**
+ * @brief スナップショットをバイト列に直列化する
+ */
+size_t snapshot_serialize(const GameSnapshot *snapshot, uint8_t *buf, size_t cap) {
+    if (cap < SNAPSHOT_WIRE_SIZE) {
+        return 0;
+    }
+    uint8_t *p = buf;
+    put_u32(p, snapshot->frame);
+    p += 4;
+    memcpy(p, snapshot->grid, BOARD_SIZE);
+    p += BOARD_SIZE;
+    put_piece(p, &snapshot->current_piece);
+    p += SNAPSHOT_PIECE_BYTES;
+    put_piece(p, &snapshot->next_piece);
+    p += SNAPSHOT_PIECE_BYTES;
+
+    const ScoreCtx *s = &snapshot->score;
+    put_u32(p + 0, (uint32_t)s->score);
+    put_u32(p + 4, (uint32_t)s->level);
+    put_u32(p + 8, (uint32_t)s->lines_cleared);
+    put_u32(p + 12, (uint32_t)s->lines_since_last_level);
+    put_u32(p + 16, (uint32_t)s->combo_count);
+    put_u32(p + 20, (uint32_t)s->last_clear_type);
+    return SNAPSHOT_WIRE_SIZE;
+}
+
+/**
+ * @brief バイト列からスナップショットを復元する
+ */
+int snapshot_deserialize(GameSnapshot *snapshot, const uint8_t *buf, size_t len) {
+    if (len != SNAPSHOT_WIRE_SIZE) {
+        return 0;
+    }
+    const uint8_t *p = buf;
+    snapshot->frame = get_u32(p);
+    p += 4;
+    memcpy(snapshot->grid, p, BOARD_SIZE);
+    p += BOARD_SIZE;
+    if (!get_piece(p, &snapshot->current_piece) ||
+        !get_piece(p + SNAPSHOT_PIECE_BYTES, &snapshot->next_piece)) {
+        return 0;
+    }
+    p += 2 * SNAPSHOT_PIECE_BYTES;
+
+    ScoreCtx *s = &snapshot->score;
+    s->score = (int)get_u32(p + 0);
+    s->level = (int)get_u32(p + 4);
+    s->lines_cleared = (int)get_u32(p + 8);
+    s->lines_since_last_level = (int)get_u32(p + 12);
+    s->combo_count = (int)get_u32(p + 16);
+    s->last_clear_type = (int)get_u32(p + 20);
+    return 1;
+}
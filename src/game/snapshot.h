@@ -0,0 +1,72 @@
+/**
+ * @file snapshot.h
+ * @brief ゲーム状態のスナップショットの宣言
+ *
+ * このファイルは GamePlayContext のうち対戦相手と一致すべき状態を
+ * 保存・復元・直列化する関数を宣言します。
+ * 主な機能:
+ *   - 盤面、操作中/次のテトリミノ、スコアの保存と復元
+ *   - ネットワーク送信用の固定長バイト列への直列化
+ *
+ * 設計思想:
+ *   - タイマー、統計、履歴などプレイヤー固有の状態は含めない
+ *   - 固定長・動的確保なしで、毎フレームのリングに置いても負担にならない
+ *   - 直列化はリトルエンディアン固定で、マシン間で同じバイト列になる
+ */
+
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+
+#include <stddef.h>
+#include "game_defs.h"
+
+#define SNAPSHOT_PIECE_BYTES 4 /**< 直列化したテトリミノのサイズ */
+#define SNAPSHOT_SCORE_BYTES 24 /**< 直列化したスコアのサイズ */
+#define SNAPSHOT_WIRE_SIZE   (4 + BOARD_SIZE + 2 * SNAPSHOT_PIECE_BYTES + SNAPSHOT_SCORE_BYTES) /**< 直列化後のサイズ */
+
+/**
+ * @brief ゲーム状態のスナップショット
+ */
+typedef struct {
+    uint32_t frame;              /**< 保存したフレーム番号 */
+    uint8_t grid[BOARD_SIZE];    /**< 盤面 */
+    Piece current_piece;         /**< 操作中のテトリミノ */
+    Piece next_piece;            /**< 次のテトリミノ */
+    ScoreCtx score;              /**< スコア */
+} GameSnapshot;
+
+/**
+ * @brief 現在の状態を保存する
+ * @param gameplay 保存元のコンテキスト
+ * @param frame フレーム番号
+ * @param out 保存先
+ */
+void snapshot_capture(const GamePlayContext *gameplay, uint32_t frame, GameSnapshot *out);
+
+/**
+ * @brief 保存した状態を復元する
+ * @param gameplay 復元先のコンテキスト (盤面は確保済みで BOARD_WIDTH x BOARD_HEIGHT)
+ * @param snapshot 復元するスナップショット
+ * @return 成功時1、盤面の大きさが一致しない場合0
+ */
+int snapshot_restore(GamePlayContext *gameplay, const GameSnapshot *snapshot);
+
+/**
+ * @brief スナップショットをバイト列に直列化する
+ * @param snapshot 直列化するスナップショット
+ * @param buf 出力先
+ * @param cap 出力先のサイズ (SNAPSHOT_WIRE_SIZE 以上)
+ * @return 書き込んだバイト数 (失敗時0)
+ */
+size_t snapshot_serialize(const GameSnapshot *snapshot, uint8_t *buf, size_t cap);
+
+/**
+ * @brief バイト列からスナップショットを復元する
+ * @param snapshot 出力先
+ * @param buf 直列化されたバイト列
+ * @param len バイト列の長さ
+ * @return 成功時1、長さや値が不正な場合0
+ */
+int snapshot_deserialize(GameSnapshot *snapshot, const uint8_t *buf, size_t len);
+
+#endif /* SNAPSHOT_H */
@@ -0,0 +1,234 @@
+/**
+ * @file stats.c
+ * @brief プレイ統計の逐次集計実装
+ *
+ * 主な機能:
+ *   - 累積値とスライディングウィンドウの更新
+ *   - 形状の対称性を考慮したフィネス判定
+ *   - 攻撃ライン数の算出
+ *
+ * 設計思想:
+ *   - ウィンドウの合計値をバケット送り時に差し引きし、参照をO(1)に保つ
+ *   - フィネスの等価回転テーブルは初回のみ形状定義から生成
+ */
+
+#include "stats.h"
+#include "piece.h"
+#include <stdlib.h>
+#include <string.h>
+
+/* ライン消去ごとの攻撃ライン数 (0-4ライン) */
+static const int ATTACK_TABLE[5] = {0, 0, 1, 2, 4};
+
+/* コンボ数ごとの追加攻撃ライン数 */
+static const int COMBO_ATTACK_TABLE[] = {0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 4, 5};
+#define COMBO_ATTACK_MAX ((int)(sizeof(COMBO_ATTACK_TABLE) / sizeof(COMBO_ATTACK_TABLE[0])) - 1)
+
+/* 回転状態ごとの最短回転キー数 (0, CW, 180, CCW) */
+static const int ROTATE_KEYS[4] = {0, 1, 2, 1};
+
+#define FINESSE_NOT_EQUIVALENT 127 /**< 形状が一致しない回転 */
+
+/* 回転 r の配置を回転 r2 で表す場合のX補正 [種類][r][r2] */
+static int8_t finesse_equiv_dx[TETROMINO_COUNT][4][4];
+
+/**
+ * @brief 回転状態の形状を左上詰めで比較し、一致すればX補正を返す
+ */
+static int shape_offset(TetrominoType type, int r, int r2) {
+    int min_x[2] = {TETROMINO_SIZE, TETROMINO_SIZE};
+    int min_y[2] = {TETROMINO_SIZE, TETROMINO_SIZE};
+    const int rots[2] = {r, r2};
+
+    for (int i = 0; i < 2; i++) {
+        for (int y = 0; y < TETROMINO_SIZE; y++) {
+            for (int x = 0; x < TETROMINO_SIZE; x++) {
+                if (TETROMINO_SHAPES[type][rots[i]][y][x]) {
+                    if (x < min_x[i]) min_x[i] = x;
+                    if (y < min_y[i]) min_y[i] = y;
+                }
+            }
+        }
+    }
+
+    for (int y = 0; y < TETROMINO_SIZE; y++) {
+        for (int x = 0; x < TETROMINO_SIZE; x++) {
+            int ay = y + min_y[0], ax = x + min_x[0];
+            int by = y + min_y[1], bx = x + min_x[1];
+            int a = (ay < TETROMINO_SIZE && ax < TETROMINO_SIZE) ? TETROMINO_SHAPES[type][r][ay][ax] : 0;
+            int b = (by < TETROMINO_SIZE && bx < TETROMINO_SIZE) ? TETROMINO_SHAPES[type][r2][by][bx] : 0;
+            if (a != b) {
+                return FINESSE_NOT_EQUIVALENT;
+            }
+        }
+    }
+    return min_x[0] - min_x[1];
+}
+
+/**
+ * @brief フィネス判定用の等価回転テーブルを初期化する
+ */
+static void finesse_init(void) {
+    static int initialized = 0;
+    if (initialized) {
+        return;
+    }
+    for (int t = 0; t < TETROMINO_COUNT; t++) {
+        for (int r = 0; r < 4; r++) {
+            for (int r2 = 0; r2 < 4; r2++) {
+                finesse_equiv_dx[t][r][r2] = (int8_t)shape_offset((TetrominoType)t, r, r2);
+            }
+        }
+    }
+    initialized = 1;
+}
+
+/**
+ * @brief 現在時刻までウィンドウのバケットを進める
+ */
+static void stats_advance(PlayerStats *stats, uint32_t now_ms) {
+    uint32_t elapsed = now_ms - stats->bucket_start_ms;
+    if (elapsed < STATS_BUCKET_MS) {
+        return;
+    }
+
+    uint32_t steps = elapsed / STATS_BUCKET_MS;
+    if (steps >= STATS_WINDOW_BUCKETS) {
+        // ウィンドウ全体が期限切れ
+        memset(stats->buckets, 0, sizeof(stats->buckets));
+        stats->window_pieces = 0;
+        stats->window_keys = 0;
+        stats->window_attack = 0;
+    } else {
+        for (uint32_t i = 0; i < steps; i++) {
+            stats->bucket_index = (uint16_t)((stats->bucket_index + 1) % STATS_WINDOW_BUCKETS);
+            StatsBucket *b = &stats->buckets[stats->bucket_index];
+            stats->window_pieces -= b->pieces;
+            stats->window_keys -= b->keys;
+            stats->window_attack -= b->attack;
+            b->pieces = 0;
+            b->keys = 0;
+            b->attack = 0;
+        }
+    }
+    stats->bucket_start_ms += steps * STATS_BUCKET_MS;
+}
+
+/**
+ * @brief 統計を初期化する
+ */
+void stats_init(PlayerStats *stats, uint32_t now_ms) {
+    memset(stats, 0, sizeof(*stats));
+    stats->start_ms = now_ms;
+    stats->bucket_start_ms = now_ms;
+    finesse_init();
+}
+
+/**
+ * @brief キー入力 (押下) を記録する
+ */
+void stats_on_key(PlayerStats *stats, uint32_t now_ms) {
+    stats_advance(stats, now_ms);
+    stats->keys++;
+    stats->window_keys++;
+    stats->buckets[stats->bucket_index].keys++;
+    stats->keys_this_piece++;
+}
+
+/**
+ * @brief テトリミノの設置を記録する
+ */
+void stats_on_lock(PlayerStats *stats, uint32_t now_ms, const Piece *placed,
+                   int lines_cleared, int attack) {
+    stats_advance(stats, now_ms);
+
+    StatsBucket *b = &stats->buckets[stats->bucket_index];
+    stats->pieces++;
+    stats->window_pieces++;
+    b->pieces++;
+    if (attack > 0) {
+        stats->attack += (uint32_t)attack;
+        stats->window_attack += (uint32_t)attack;
+        b->attack = (uint16_t)(b->attack + attack);
+    }
+
+    if (lines_cleared < 0) lines_cleared = 0;
+    if (lines_cleared > 4) lines_cleared = 4;
+    stats->clears[lines_cleared]++;
+    if (lines_cleared > 0) {
+        stats->combo++;
+        if (stats->combo > stats->max_combo) {
+            stats->max_combo = stats->combo;
+        }
+    } else {
+        stats->combo = 0;
+    }
+
+    if (placed && stats->keys_this_piece > stats_finesse_optimal(placed)) {
+        stats->finesse_faults++;
+    }
+    stats->keys_this_piece = 0;
+}
+
+/**
+ * @brief ライン消去とコンボから攻撃ライン数を求める
+ */
+int stats_attack_for_clear(int lines_cleared, int combo) {
+    if (lines_cleared <= 0) {
+        return 0;
+    }
+    if (lines_cleared > 4) {
+        lines_cleared = 4;
+    }
+    if (combo > COMBO_ATTACK_MAX) {
+        combo = COMBO_ATTACK_MAX;
+    }
+    return ATTACK_TABLE[lines_cleared] + (combo > 0 ? COMBO_ATTACK_TABLE[combo] : 0);
+}
+
+/**
+ * @brief 出現位置から設置位置までの最短キー数を求める
+ */
+int stats_finesse_optimal(const Piece *placed) {
+    finesse_init();
+
+    int spawn_x = INITIAL_POSITIONS[placed->type][0];
+    int rotation = placed->rotation & 3;
+    int best = -1;
+    for (int r2 = 0; r2 < 4; r2++) {
+        int dx = finesse_equiv_dx[placed->type][rotation][r2];
+        if (dx == FINESSE_NOT_EQUIVALENT) {
+            continue;
+        }
+        int keys = ROTATE_KEYS[r2] + abs(placed->x + dx - spawn_x);
+        if (best < 0 || keys < best) {
+            best = keys;
+        }
+    }
+    return best + 1; // ハードドロップ
+}
+
+/**
+ * @brief 現在の統計を読み出す
+ */
+void stats_snapshot(PlayerStats *stats, uint32_t now_ms, StatsSnapshot *out) {
+    stats_advance(stats, now_ms);
+
+    uint32_t elapsed = now_ms - stats->start_ms;
+    uint32_t window = (STATS_WINDOW_BUCKETS - 1) * STATS_BUCKET_MS + (now_ms - stats->bucket_start_ms);
+    if (window > elapsed) {
+        window = elapsed;
+    }
+
+    out->pps = elapsed ? stats->pieces * 1000.0f / elapsed : 0.0f;
+    out->apm = elapsed ? stats->attack * 60000.0f / elapsed : 0.0f;
+    out->kpp = stats->pieces ? (float)stats->keys / stats->pieces : 0.0f;
+    out->window_pps = window ? stats->window_pieces * 1000.0f / window : 0.0f;
+    out->window_apm = window ? stats->window_attack * 60000.0f / window : 0.0f;
+    out->window_kpp = stats->window_pieces ? (float)stats->window_keys / stats->window_pieces : 0.0f;
+    out->pieces = stats->pieces;
+    out->attack = stats->attack;
+    out->finesse_faults = stats->finesse_faults;
+    memcpy(out->clears, stats->clears, sizeof(out->clears));
+    out->max_combo = stats->max_combo;
+}
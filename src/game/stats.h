@@ -0,0 +1,92 @@
+/**
+ * @file stats.h
+ * @brief プレイ統計の逐次集計機能の宣言
+ *
+ * このファイルはプレイヤーごとの統計をゲームループ内で逐次集計する関数を宣言します。
+ * 主な機能:
+ *   - PPS (毎秒設置数)、APM (毎分攻撃ライン数)、KPP (設置あたりキー数)
+ *   - フィネスミス (最短手順より多いキー入力) の検出
+ *   - 消去種別の分布と最大コンボ
+ *   - 直近ウィンドウでの値と通算値の取得
+ *
+ * 設計思想:
+ *   - イベントごとの記録は持たず、固定サイズの累積値とバケットのみで集計
+ *   - 更新はキー入力と設置のイベント時のみで、毎フレームの処理は不要
+ *   - ウィンドウのバケット送りはイベントまたは参照時に遅延して行う
+ */
+
+#ifndef STATS_H
+#define STATS_H
+
+#include "game_defs.h"
+
+/**
+ * @brief 統計の読み出し結果
+ */
+typedef struct {
+    float pps;                   /**< 通算の毎秒設置数 */
+    float apm;                   /**< 通算の毎分攻撃ライン数 */
+    float kpp;                   /**< 通算の設置あたりキー数 */
+    float window_pps;            /**< 直近ウィンドウの毎秒設置数 */
+    float window_apm;            /**< 直近ウィンドウの毎分攻撃ライン数 */
+    float window_kpp;            /**< 直近ウィンドウの設置あたりキー数 */
+    uint32_t pieces;             /**< 設置数 */
+    uint32_t attack;             /**< 攻撃ライン数 */
+    uint32_t finesse_faults;     /**< フィネスミス数 */
+    uint32_t clears[5];          /**< 消去ライン数ごとの設置数 */
+    uint16_t max_combo;          /**< 最大コンボ数 */
+} StatsSnapshot;
+
+/**
+ * @brief 統計を初期化する
+ * @param stats 対象の統計
+ * @param now_ms 現在時刻 (ms)
+ */
+void stats_init(PlayerStats *stats, uint32_t now_ms);
+
+/**
+ * @brief キー入力 (押下) を記録する
+ * @param stats 対象の統計
+ * @param now_ms 現在時刻 (ms)
+ */
+void stats_on_key(PlayerStats *stats, uint32_t now_ms);
+
+/**
+ * @brief テトリミノの設置を記録する
+ * @param stats 対象の統計
+ * @param now_ms 現在時刻 (ms)
+ * @param placed 設置したテトリミノ (最終位置と回転)
+ * @param lines_cleared 消去したライン数
+ * @param attack 送った攻撃ライン数
+ */
+void stats_on_lock(PlayerStats *stats, uint32_t now_ms, const Piece *placed,
+                   int lines_cleared, int attack);
+
+/**
+ * @brief ライン消去とコンボから攻撃ライン数を求める
+ * @param lines_cleared 消去したライン数
+ * @param combo 現在のコンボ数 (今回の消去を含む)
+ * @return 攻撃ライン数
+ */
+int stats_attack_for_clear(int lines_cleared, int combo);
+
+/**
+ * @brief 出現位置から設置位置までの最短キー数を求める
+ *
+ * 回転キーと1マスずつの左右移動、ハードドロップ1回で数えます。
+ * 形状が同一になる回転 (I/S/Z の180度回転など) は短い方を採用します。
+ *
+ * @param placed 設置したテトリミノ
+ * @return 最短キー数
+ */
+int stats_finesse_optimal(const Piece *placed);
+
+/**
+ * @brief 現在の統計を読み出す
+ * @param stats 対象の統計 (ウィンドウのバケット送りを行う)
+ * @param now_ms 現在時刻 (ms)
+ * @param out 出力先
+ */
+void stats_snapshot(PlayerStats *stats, uint32_t now_ms, StatsSnapshot *out);
+
+#endif /* STATS_H */
@@ -0,0 +1,267 @@
+/**
+ * @file input_thread.c
+ * @brief 入力専用スレッドとキーイベントキューの実装
+ *
+ * 主な機能:
+ *   - poll による入力元と終了通知 (eventfd) の待機
+ *   - 読み取りをまたぐエスケープシーケンスの逐次解釈
+ *   - 相手側インデックスをキャッシュする SPSC リング
+ *
+ * 設計思想:
+ *   - head は生産者のみ、tail は消費者のみが書き込み、別キャッシュラインに置く
+ *   - 相手のインデックスはキャッシュが尽きたときのみ読み直し、共有キャッシュラインの往復を減らす
+ */
+
+#define _GNU_SOURCE // clock_gettime と CLOCK_MONOTONIC
+
+#include "input_thread.h"
+#include <ctype.h>
+#include <errno.h>
+#include <poll.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/eventfd.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+
+#define INPUT_READ_SIZE      64 /**< 1回の read で読むバイト数 */
+#define INPUT_ESC_TIMEOUT_MS 50 /**< ESC の後続を待つ時間 (ms)。過ぎたら単独の ESC キーとみなす */
+
+/* エスケープシーケンスの解釈状態 */
+enum {
+    ESC_NONE,                    /**< 通常 */
+    ESC_START,                   /**< ESC を読んだ */
+    ESC_CSI                      /**< ESC [ を読んだ */
+};
+
+/**
+ * @brief 入力スレッド
+ */
+struct InputThread {
+    _Alignas(64) _Atomic uint32_t head; /**< 次に書き込む位置 (生産者) */
+    uint32_t tail_cache;         /**< 生産者が最後に読んだ tail */
+    _Atomic uint32_t dropped;    /**< 満杯で捨てたイベント数 */
+    _Atomic int closed;          /**< 入力元が閉じられた */
+    _Alignas(64) _Atomic uint32_t tail; /**< 次に読み出す位置 (消費者) */
+    uint32_t head_cache;         /**< 消費者が最後に読んだ head */
+    _Alignas(64) KeyEvent events[INPUT_QUEUE_SIZE]; /**< リングバッファ */
+    int fd;                      /**< 入力元 */
+    int stop_fd;                 /**< 終了通知用の eventfd */
+    int escape;                  /**< エスケープシーケンスの解釈状態 */
+    int restore_tty;             /**< 終了時に端末設定を戻す */
+    struct termios saved_tty;    /**< 開始前の端末設定 */
+    pthread_t thread;            /**< 入力スレッド */
+};
+
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+/**
+ * @brief イベントをキューに追加する (入力スレッド専用)
+ */
+static void push(InputThread *it, uint8_t key, uint64_t timestamp_ns) {
+    uint32_t head = atomic_load_explicit(&it->head, memory_order_relaxed);
+    if (head - it->tail_cache == INPUT_QUEUE_SIZE) {
+        it->tail_cache = atomic_load_explicit(&it->tail, memory_order_acquire);
+        if (head - it->tail_cache == INPUT_QUEUE_SIZE) {
+            atomic_fetch_add_explicit(&it->dropped, 1, memory_order_relaxed);
+            return;
+        }
+    }
+    KeyEvent *ev = &it->events[head & (INPUT_QUEUE_SIZE - 1)];
+    ev->timestamp_ns = timestamp_ns;
+    ev->key = key;
+    ev->pressed = 1;
+    atomic_store_explicit(&it->head, head + 1, memory_order_release);
+}
+
+/**
+ * @brief 1バイトを解釈し、キーになればキューに追加する
+ */
+static void decode(InputThread *it, unsigned char c, uint64_t timestamp_ns) {
+    if (it->escape == ESC_START) {
+        it->escape = (c == '[' || c == 'O') ? ESC_CSI : ESC_NONE;
+        return;
+    }
+    if (it->escape == ESC_CSI) {
+        if ((c >= '0' && c <= '9') || c == ';') {
+            return; // 修飾付きシーケンスの引数は読み飛ばす
+        }
+        it->escape = ESC_NONE;
+        switch (c) {
+            case 'A': push(it, KEY_ROTATE_CW, timestamp_ns); break;
+            case 'B': push(it, KEY_SOFT_DROP, timestamp_ns); break;
+            case 'C': push(it, KEY_MOVE_RIGHT, timestamp_ns); break;
+            case 'D': push(it, KEY_MOVE_LEFT, timestamp_ns); break;
+            default: break;
+        }
+        return;
+    }
+    if (c == 0x1b) {
+        it->escape = ESC_START;
+        return;
+    }
+
+    int key = toupper(c);
+    switch (key) {
+        case KEY_MOVE_LEFT:
+        case KEY_MOVE_RIGHT:
+        case KEY_ROTATE_CW:
+        case KEY_ROTATE_CCW:
+        case KEY_SOFT_DROP:
+        case KEY_HARD_DROP:
+        case KEY_HOLD:
+        case KEY_PAUSE:
+        case KEY_QUIT:
+        case KEY_UNDO:
+        case KEY_REDO:
+            push(it, (uint8_t)key, timestamp_ns);
+            break;
+        default:
+            break;
+    }
+}
+
+/**
+ * @brief 入力スレッドの本体
+ */
+static void* input_main(void *arg) {
+    InputThread *it = (InputThread*)arg;
+    struct pollfd pfds[2] = {
+        {it->fd, POLLIN, 0},
+        {it->stop_fd, POLLIN, 0},
+    };
+    unsigned char buf[INPUT_READ_SIZE];
+
+    for (;;) {
+        // ESC の直後は後続のバイトを短時間だけ待つ (シーケンスが read をまたぐ場合がある)
+        int timeout = it->escape == ESC_START ? INPUT_ESC_TIMEOUT_MS : -1;
+        int ready = poll(pfds, 2, timeout);
+        if (ready < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            break;
+        }
+        if (ready == 0) {
+            // 後続が来なかった単独の ESC キーは捨てる
+            it->escape = ESC_NONE;
+            continue;
+        }
+        if (pfds[1].revents) {
+            break;
+        }
+        if (!pfds[0].revents) {
+            continue;
+        }
+        ssize_t n = read(it->fd, buf, sizeof(buf));
+        if (n < 0 && (errno == EINTR || errno == EAGAIN)) {
+            continue;
+        }
+        if (n <= 0) {
+            atomic_store_explicit(&it->closed, 1, memory_order_release);
+            break;
+        }
+        // 1回の read で届いたバイトは同時刻の入力として扱う
+        uint64_t timestamp_ns = now_ns();
+        for (ssize_t i = 0; i < n; i++) {
+            decode(it, buf[i], timestamp_ns);
+        }
+    }
+    return NULL;
+}
+
+/**
+ * @brief 入力スレッドを開始する
+ */
+InputThread* input_thread_create(int fd) {
+    InputThread *it = (InputThread*)aligned_alloc(64, (sizeof(InputThread) + 63) & ~(size_t)63);
+    if (!it) {
+        return NULL;
+    }
+    memset(it, 0, sizeof(*it));
+    it->fd = fd;
+    it->stop_fd = eventfd(0, EFD_CLOEXEC);
+    if (it->stop_fd < 0) {
+        free(it);
+        return NULL;
+    }
+
+    // 端末は1バイトごとに読めるよう非カノニカル/エコーなしにする
+    if (isatty(fd) && tcgetattr(fd, &it->saved_tty) == 0) {
+        struct termios raw = it->saved_tty;
+        raw.c_lflag &= ~(ICANON | ECHO);
+        raw.c_cc[VMIN] = 1;
+        raw.c_cc[VTIME] = 0;
+        it->restore_tty = tcsetattr(fd, TCSANOW, &raw) == 0;
+    }
+
+    if (pthread_create(&it->thread, NULL, input_main, it) != 0) {
+        if (it->restore_tty) {
+            tcsetattr(fd, TCSANOW, &it->saved_tty);
+        }
+        close(it->stop_fd);
+        free(it);
+        return NULL;
+    }
+    return it;
+}
+
+/**
+ * @brief 入力スレッドを終了して解放する
+ */
+void input_thread_destroy(InputThread *it) {
+    if (!it) {
+        return;
+    }
+    uint64_t one = 1;
+    ssize_t n;
+    do {
+        n = write(it->stop_fd, &one, sizeof(one));
+    } while (n < 0 && errno == EINTR);
+    pthread_join(it->thread, NULL);
+    if (it->restore_tty) {
+        tcsetattr(it->fd, TCSANOW, &it->saved_tty);
+    }
+    close(it->stop_fd);
+    free(it);
+}
+
+/**
+ * @brief キーイベントを取り出す
+ */
+int input_thread_poll(InputThread *it, KeyEvent *out, int max) {
+    uint32_t tail = atomic_load_explicit(&it->tail, memory_order_relaxed);
+    if (it->head_cache - tail < (uint32_t)max) {
+        it->head_cache = atomic_load_explicit(&it->head, memory_order_acquire);
+    }
+    int count = 0;
+    while (count < max && tail != it->head_cache) {
+        out[count++] = it->events[tail & (INPUT_QUEUE_SIZE - 1)];
+        tail++;
+    }
+    if (count > 0) {
+        atomic_store_explicit(&it->tail, tail, memory_order_release);
+    }
+    return count;
+}
+
+/**
+ * @brief 入力元が閉じられたかを判定する
+ */
+int input_thread_closed(const InputThread *it) {
+    return atomic_load_explicit(&((InputThread*)it)->closed, memory_order_acquire);
+}
+
+/**
+ * @brief キューが満杯で捨てたイベント数を取得する
+ */
+uint32_t input_thread_dropped(const InputThread *it) {
+    return atomic_load_explicit(&((InputThread*)it)->dropped, memory_order_relaxed);
+}
@@ -0,0 +1,74 @@
+/**
+ * @file input_thread.h
+ * @brief 入力専用スレッドとキーイベントキューの宣言
+ *
+ * このファイルは端末またはソケットからの入力を専用スレッドで読み取り、
+ * ゲームループへキーイベントとして渡す機能を宣言します。
+ * 主な機能:
+ *   - 入力スレッドの開始と終了 (端末の場合は非カノニカル/エコーなしに切り替え)
+ *   - バイト列からキーへの変換 (矢印キーのエスケープシーケンスを含む)
+ *   - 単一生産者/単一消費者のウェイトフリーなリングバッファ
+ *   - ゲームループからのタイムスタンプ付きキーイベントの取り出し
+ *
+ * 設計思想:
+ *   - 入力の読み取りはシミュレーションや描画、AI探索の処理時間に左右されない
+ *   - キューの操作は有限ステップで完了し、満杯時は待たずに新しいイベントを捨てて数える
+ *   - 読み取り時刻を記録し、ゲームループは取り出しが遅れても入力の順序と時刻を再現できる
+ */
+
+#ifndef INPUT_THREAD_H
+#define INPUT_THREAD_H
+
+#include <stdint.h>
+#include "../game/game_defs.h"
+
+#define INPUT_QUEUE_SIZE 256 /**< キューの容量 (2のべき乗) */
+
+/**
+ * @brief キーイベント
+ */
+typedef struct {
+    uint64_t timestamp_ns;       /**< 読み取り時刻 (CLOCK_MONOTONIC、ナノ秒) */
+    uint8_t key;                 /**< KEY_* の値 */
+    uint8_t pressed;             /**< 押下で1 (端末入力は押下のみ) */
+} KeyEvent;
+
+typedef struct InputThread InputThread;
+
+/**
+ * @brief 入力スレッドを開始する
+ * @param fd 入力元 (端末またはソケット)
+ * @return 開始した入力スレッド (失敗時はNULL)
+ */
+InputThread* input_thread_create(int fd);
+
+/**
+ * @brief 入力スレッドを終了して解放する (端末の設定を元に戻す)
+ * @param it 対象の入力スレッド (NULL可)
+ */
+void input_thread_destroy(InputThread *it);
+
+/**
+ * @brief キーイベントを取り出す (ゲームスレッド専用、ブロックしない)
+ * @param it 対象の入力スレッド
+ * @param out 出力先
+ * @param max 出力先の要素数
+ * @return 取り出したイベント数
+ */
+int input_thread_poll(InputThread *it, KeyEvent *out, int max);
+
+/**
+ * @brief 入力元が閉じられたかを判定する
+ * @param it 対象の入力スレッド
+ * @return 閉じられた場合1 (キューに残ったイベントは取り出せる)
+ */
+int input_thread_closed(const InputThread *it);
+
+/**
+ * @brief キューが満杯で捨てたイベント数を取得する
+ * @param it 対象の入力スレッド
+ * @return 捨てたイベント数
+ */
+uint32_t input_thread_dropped(const InputThread *it);
+
+#endif /* INPUT_THREAD_H */
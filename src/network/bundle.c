@@ -0,0 +1,152 @@
+/**
+ * @file bundle.c
+ * @brief 1ティック分のメッセージをまとめたバンドルの組み立てと読み出しの実装
+ *
+ * 主な機能:
+ *   - レコードヘッダーと本体の連続書き込み
+ *   - 長さの検証付きの順次読み出し
+ *   - ヘッダーの全体長によるストリーム上の区切りの判定
+ *
+ * 設計思想:
+ *   - 多バイト値はリトルエンディアンで書き、構造体の直接代入に頼らない
+ *   - 全体の長さは BUNDLE_MAX_BYTES 以下に限り、組み立てと区切りの判定で同じ上限を使う
+ */
+
+#include "bundle.h"
+#include <string.h>
+
+static void put_u16(uint8_t *p, uint16_t v) {
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+}
+
+static void put_u32(uint8_t *p, uint32_t v) {
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+    p[2] = (uint8_t)(v >> 16);
+    p[3] = (uint8_t)(v >> 24);
+}
+
+static uint16_t get_u16(const uint8_t *p) {
+    return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+static uint32_t get_u32(const uint8_t *p) {
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+/**
+ * @brief バンドルの組み立てを開始する
+ */
+void bundle_begin(BundleWriter *writer, uint8_t *buf, size_t cap) {
+    writer->buf = buf;
+    writer->cap = cap < BUNDLE_MAX_BYTES ? cap : BUNDLE_MAX_BYTES;
+    writer->len = sizeof(BundleHeader);
+    writer->count = 0;
+}
+
+/**
+ * @brief レコードを追加できるかを判定する
+ */
+int bundle_fits(const BundleWriter *writer, size_t length) {
+    return writer->count < BUNDLE_MAX_RECORDS &&
+           writer->len + sizeof(BundleRecord) + length <= writer->cap;
+}
+
+/**
+ * @brief レコードを追加する
+ */
+int bundle_add(BundleWriter *writer, MessageType type, const void *payload, uint16_t length) {
+    if (!bundle_fits(writer, length)) {
+        return 0;
+    }
+    uint8_t *p = writer->buf + writer->len;
+    p[0] = (uint8_t)type;
+    put_u16(p + 1, length);
+    if (length > 0) {
+        memcpy(p + sizeof(BundleRecord), payload, length);
+    }
+    writer->len += sizeof(BundleRecord) + length;
+    writer->count++;
+    return 1;
+}
+
+/**
+ * @brief ヘッダーを書き込んでバンドルを確定する
+ */
+size_t bundle_finish(BundleWriter *writer, uint32_t tick, int has_ack, uint32_t ack) {
+    uint8_t *p = writer->buf;
+    p[0] = MSG_BUNDLE;
+    p[1] = (uint8_t)writer->count;
+    put_u16(p + 2, has_ack ? BUNDLE_FLAG_ACK : 0);
+    put_u32(p + 4, tick);
+    put_u32(p + 8, has_ack ? ack : 0);
+    put_u32(p + 12, (uint32_t)writer->len);
+    return writer->len;
+}
+
+/**
+ * @brief ストリームの先頭にあるバンドルの長さを求める
+ */
+int bundle_frame(const uint8_t *data, size_t len, size_t *bundle_len) {
+    if (len > 0 && data[0] != MSG_BUNDLE) {
+        return -1;
+    }
+    if (len < sizeof(BundleHeader)) {
+        return 0;
+    }
+    uint32_t total = get_u32(data + 12);
+    // 上限を超える長さは、続きを待ち続けて受信バッファを使い切る前に拒否する
+    if (total < sizeof(BundleHeader) || total > BUNDLE_MAX_BYTES) {
+        return -1;
+    }
+    if (len < total) {
+        return 0;
+    }
+    *bundle_len = total;
+    return 1;
+}
+
+/**
+ * @brief 受信したバンドルの読み出しを開始する
+ */
+int bundle_open(BundleReader *reader, BundleHeader *header, const uint8_t *data, size_t len) {
+    size_t total;
+    if (bundle_frame(data, len, &total) != 1) {
+        return 0;
+    }
+    header->type = data[0];
+    header->count = data[1];
+    header->flags = get_u16(data + 2);
+    header->tick = get_u32(data + 4);
+    header->ack = get_u32(data + 8);
+    header->length = (uint32_t)total;
+    reader->data = data;
+    reader->len = total;
+    reader->pos = sizeof(BundleHeader);
+    reader->remaining = header->count;
+    return 1;
+}
+
+/**
+ * @brief 次のレコードを取り出す
+ */
+int bundle_next(BundleReader *reader, uint8_t *type, const uint8_t **payload, uint16_t *length) {
+    if (reader->remaining == 0) {
+        return reader->pos == reader->len ? 0 : -1;
+    }
+    if (reader->len - reader->pos < sizeof(BundleRecord)) {
+        return -1;
+    }
+    const uint8_t *p = reader->data + reader->pos;
+    uint16_t n = get_u16(p + 1);
+    if (reader->len - reader->pos - sizeof(BundleRecord) < n) {
+        return -1;
+    }
+    *type = p[0];
+    *payload = p + sizeof(BundleRecord);
+    *length = n;
+    reader->pos += sizeof(BundleRecord) + n;
+    reader->remaining--;
+    return 1;
+}
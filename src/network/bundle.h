@@ -0,0 +1,117 @@
+/**
+ * @file bundle.h
+ * @brief 1ティック分のメッセージをまとめたバンドルの組み立てと読み出しの宣言
+ *
+ * このファイルは複数のメッセージを1つのパケットに詰めるバンドル形式
+ * (protocol.h の BundleHeader + BundleRecord の列) を扱う関数を宣言します。
+ * 主な機能:
+ *   - バンドルの組み立て (ヘッダー予約、レコード追加、確定)
+ *   - 受信したバンドルからのレコードの順次取り出し
+ *   - ストリーム (TCP) 上のバンドルの区切りの判定
+ *
+ * 設計思想:
+ *   - 組み立ては呼び出し側のバッファに直接書き込み、コピーは本体の1回のみ
+ *   - 読み出しは長さを検証しながら進め、壊れたバンドルで範囲外を読まない
+ *   - ヘッダーに全体の長さを持たせ、レコードをたどらずにストリームから切り出せるようにする
+ */
+
+#ifndef BUNDLE_H
+#define BUNDLE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "protocol.h"
+
+/**
+ * @brief バンドルの組み立て状態
+ */
+typedef struct {
+    uint8_t* buf;                /**< 出力先 */
+    size_t cap;                  /**< 出力先のサイズ */
+    size_t len;                  /**< 書き込み済みの長さ (ヘッダーを含む) */
+    int count;                   /**< レコード数 */
+} BundleWriter;
+
+/**
+ * @brief バンドルの読み出し状態
+ */
+typedef struct {
+    const uint8_t* data;         /**< バンドル全体 */
+    size_t len;                  /**< バンドル全体の長さ (ヘッダーの length) */
+    size_t pos;                  /**< 次のレコードの位置 */
+    int remaining;               /**< 残りのレコード数 */
+} BundleReader;
+
+#define BUNDLE_MAX_RECORDS 255   /**< 1バンドルのレコード数の上限 */
+#define BUNDLE_MAX_BYTES   65536 /**< 1バンドル全体の長さの上限 (これを超える length は壊れたものとして扱う) */
+
+/**
+ * @brief バンドルの組み立てを開始する (ヘッダー分を予約)
+ * @param writer 組み立て状態
+ * @param buf 出力先
+ * @param cap 出力先のサイズ (sizeof(BundleHeader) 以上、BUNDLE_MAX_BYTES を超える分は使わない)
+ */
+void bundle_begin(BundleWriter *writer, uint8_t *buf, size_t cap);
+
+/**
+ * @brief レコードを追加できるかを判定する
+ * @param writer 組み立て状態
+ * @param length 追加する本体の長さ
+ * @return 追加できる場合1
+ */
+int bundle_fits(const BundleWriter *writer, size_t length);
+
+/**
+ * @brief レコードを追加する
+ * @param writer 組み立て状態
+ * @param type メッセージ種別
+ * @param payload 本体
+ * @param length 本体の長さ
+ * @return 成功時1、入りきらない場合0
+ */
+int bundle_add(BundleWriter *writer, MessageType type, const void *payload, uint16_t length);
+
+/**
+ * @brief ヘッダーを書き込んでバンドルを確定する
+ * @param writer 組み立て状態
+ * @param tick ティック番号
+ * @param has_ack ack を含める場合1
+ * @param ack 確認するクライアントの入力フレーム
+ * @return バンドル全体の長さ
+ */
+size_t bundle_finish(BundleWriter *writer, uint32_t tick, int has_ack, uint32_t ack);
+
+/**
+ * @brief ストリームの先頭にあるバンドルの長さを求める
+ * @param data 受信済みのデータ (先頭がバンドルの先頭)
+ * @param len 受信済みのデータの長さ
+ * @param bundle_len バンドル全体の長さの出力先 (戻り値が1の場合)
+ * @return 1つ分が揃っている場合1、続きが必要な場合0、バンドルでないか長さが BUNDLE_MAX_BYTES を超える場合-1
+ */
+int bundle_frame(const uint8_t *data, size_t len, size_t *bundle_len);
+
+/**
+ * @brief 受信したバンドルの読み出しを開始する
+ *
+ * 後続のデータ (ストリームの次のバンドルなど) は読み出しの対象外で、
+ * このバンドルが消費する長さは reader->len です。
+ *
+ * @param reader 読み出し状態
+ * @param header ヘッダーの出力先
+ * @param data 受信データ
+ * @param len 受信データの長さ
+ * @return 成功時1、バンドルでないか全体が揃っていない場合0
+ */
+int bundle_open(BundleReader *reader, BundleHeader *header, const uint8_t *data, size_t len);
+
+/**
+ * @brief 次のレコードを取り出す
+ * @param reader 読み出し状態
+ * @param type メッセージ種別の出力先
+ * @param payload 本体の出力先 (受信データ内を指す)
+ * @param length 本体の長さの出力先
+ * @return 取り出した場合1、終端の場合0、壊れている場合-1
+ */
+int bundle_next(BundleReader *reader, uint8_t *type, const uint8_t **payload, uint16_t *length);
+
+#endif /* BUNDLE_H */
@@ -0,0 +1,205 @@
+/**
+ * @file desync.c
+ * @brief 対戦相手との非同期 (desync) 検出の実装
+ *
+ * 主な機能:
+ *   - フレーム番号からリング上のチェックポイントへの対応付け
+ *   - 自分/相手のチェックサムの到着順に依存しない照合
+ *   - 不一致時の再実行と再同期の判定
+ *
+ * 設計思想:
+ *   - 間隔は2のべき乗とし、チェックポイント判定をマスク1回にする
+ *   - フレーム番号の比較は差分の符号で行い、32ビットの周回に耐える
+ *   - 再実行を指示したら合意済みフレームより後の自分の記録を破棄し、再シミュレーションの結果で照合し直す
+ */
+
+#include "desync.h"
+#include "../game/checksum.h"
+#include <string.h>
+
+/**
+ * @brief a が b より後のフレームかを判定する
+ */
+static inline int frame_after(uint32_t a, uint32_t b) {
+    return (int32_t)(a - b) > 0;
+}
+
+static inline int slot_index(const DesyncDetector *detector, uint32_t frame) {
+    return (int)((frame >> detector->shift) & (DESYNC_HISTORY - 1));
+}
+
+/**
+ * @brief 検出器を初期化する
+ */
+void desync_init(DesyncDetector *detector, uint32_t interval) {
+    memset(detector, 0, sizeof(*detector));
+    if (interval == 0) {
+        interval = DESYNC_DEFAULT_INTERVAL;
+    }
+    uint32_t shift = 0;
+    while ((1u << shift) < interval && shift < 16) {
+        shift++;
+    }
+    detector->shift = shift;
+    detector->mask = (1u << shift) - 1;
+}
+
+/**
+ * @brief 指定フレームのチェックポイントを取得する (古い記録は再利用する)
+ * @return チェックポイント (リング上のより新しい記録と衝突する場合はNULL)
+ */
+static DesyncCheckpoint* checkpoint_for(DesyncDetector *detector, uint32_t frame) {
+    DesyncCheckpoint *cp = &detector->checkpoints[slot_index(detector, frame)];
+    if (cp->frame == frame) {
+        return cp;
+    }
+    if ((cp->has_local || cp->has_remote) && frame_after(cp->frame, frame)) {
+        return NULL;
+    }
+    cp->frame = frame;
+    cp->has_local = 0;
+    cp->has_remote = 0;
+    return cp;
+}
+
+/**
+ * @brief 合意済みフレームより後の自分の記録を破棄する (再実行の前)
+ */
+static void discard_after_agreed(DesyncDetector *detector) {
+    for (int i = 0; i < DESYNC_HISTORY; i++) {
+        DesyncCheckpoint *cp = &detector->checkpoints[i];
+        if (cp->has_local && frame_after(cp->frame, detector->agreed_frame)) {
+            cp->has_local = 0;
+        }
+    }
+}
+
+/**
+ * @brief 自分と相手のチェックサムがそろったチェックポイントを照合する
+ */
+static DesyncResult compare(DesyncDetector *detector, const DesyncCheckpoint *cp) {
+    if (cp->local == cp->remote) {
+        if (!detector->has_agreed || frame_after(cp->frame, detector->agreed_frame)) {
+            detector->agreed_frame = cp->frame;
+            detector->has_agreed = 1;
+        }
+        if (detector->rolled_back && !frame_after(detector->rollback_frame, cp->frame)) {
+            detector->rolled_back = 0;
+        }
+        return DESYNC_OK;
+    }
+
+    // 再実行後も同じ区間で不一致なら決定性の問題。権威側の状態で上書きする
+    if (detector->rolled_back || !desync_agreed_snapshot(detector)) {
+        return DESYNC_RESYNC;
+    }
+    detector->rolled_back = 1;
+    detector->rollback_frame = cp->frame;
+    discard_after_agreed(detector);
+    return DESYNC_ROLLBACK;
+}
+
+/**
+ * @brief フレームのシミュレーション後に呼び出す
+ */
+DesyncResult desync_on_frame(DesyncDetector *detector, const GamePlayContext *gameplay, uint32_t frame) {
+    if (frame & detector->mask) {
+        return DESYNC_PENDING;
+    }
+    DesyncCheckpoint *cp = checkpoint_for(detector, frame);
+    if (!cp) {
+        return DESYNC_PENDING;
+    }
+    cp->local = checksum_gameplay(gameplay);
+    cp->has_local = 1;
+    snapshot_capture(gameplay, frame, &detector->snapshots[slot_index(detector, frame)]);
+
+    detector->latest_frame = frame;
+    detector->latest_checksum = cp->local;
+    detector->has_latest = 1;
+
+    return cp->has_remote ? compare(detector, cp) : DESYNC_PENDING;
+}
+
+/**
+ * @brief 送信する入力パケットに載せるチェックサムを取得する
+ */
+int desync_outgoing(const DesyncDetector *detector, uint32_t *frame, uint32_t *checksum) {
+    if (!detector->has_latest) {
+        return 0;
+    }
+    *frame = detector->latest_frame;
+    *checksum = detector->latest_checksum;
+    return 1;
+}
+
+/**
+ * @brief 相手から届いたチェックサムを照合する
+ */
+DesyncResult desync_on_remote(DesyncDetector *detector, uint32_t frame, uint32_t checksum) {
+    if (frame & detector->mask) {
+        return DESYNC_PENDING;
+    }
+    DesyncCheckpoint *cp = checkpoint_for(detector, frame);
+    if (!cp) {
+        return DESYNC_PENDING;
+    }
+    if (cp->has_remote && cp->remote == checksum) {
+        return DESYNC_PENDING; // 同じチェックサムが複数のパケットに載っている
+    }
+    cp->remote = checksum;
+    cp->has_remote = 1;
+    return cp->has_local ? compare(detector, cp) : DESYNC_PENDING;
+}
+
+/**
+ * @brief 一致を確認した最新のスナップショットを取得する
+ */
+const GameSnapshot* desync_agreed_snapshot(const DesyncDetector *detector) {
+    if (!detector->has_agreed) {
+        return NULL;
+    }
+    return desync_snapshot_at(detector, detector->agreed_frame);
+}
+
+/**
+ * @brief 指定フレームのスナップショットを取得する
+ */
+const GameSnapshot* desync_snapshot_at(const DesyncDetector *detector, uint32_t frame) {
+    int index = slot_index(detector, frame);
+    const DesyncCheckpoint *cp = &detector->checkpoints[index];
+    if (cp->frame != frame || !cp->has_local) {
+        return NULL;
+    }
+    return &detector->snapshots[index];
+}
+
+/**
+ * @brief 権威側のスナップショットで再同期した後に呼び出す
+ */
+void desync_resynced(DesyncDetector *detector, const GameSnapshot *snapshot) {
+    for (int i = 0; i < DESYNC_HISTORY; i++) {
+        DesyncCheckpoint *cp = &detector->checkpoints[i];
+        if (!frame_after(snapshot->frame, cp->frame)) {
+            cp->has_local = 0;
+            cp->has_remote = 0;
+        }
+    }
+
+    uint32_t checksum = checksum_snapshot(snapshot);
+    int index = slot_index(detector, snapshot->frame);
+    DesyncCheckpoint *cp = &detector->checkpoints[index];
+    cp->frame = snapshot->frame;
+    cp->local = checksum;
+    cp->remote = checksum;
+    cp->has_local = 1;
+    cp->has_remote = 1;
+    detector->snapshots[index] = *snapshot;
+
+    detector->agreed_frame = snapshot->frame;
+    detector->has_agreed = 1;
+    detector->rolled_back = 0;
+    detector->latest_frame = snapshot->frame;
+    detector->latest_checksum = checksum;
+    detector->has_latest = 1;
+}
@@ -0,0 +1,136 @@
+/**
+ * @file desync.h
+ * @brief 対戦相手との非同期 (desync) 検出の宣言
+ *
+ * このファイルはロックステップ/ロールバック対戦で、各ピアの状態が
+ * 一致しているかを定期的なチェックサムの交換で確認する機能を宣言します。
+ * 主な機能:
+ *   - Nフレームごとのチェックポイント (チェックサムとスナップショット) の記録
+ *   - 入力パケットに載せる最新チェックサムの取得
+ *   - 相手のチェックサムとの照合と、一致した最新フレームの追跡
+ *   - 不一致時の再同期手段の判定 (合意済みスナップショットからの再実行/権威側の状態の取得)
+ *
+ * 設計思想:
+ *   - チェックポイント以外のフレームは比較1回のみ。記録も間隔ごとに償却される
+ *   - 相手が先行していてもよいよう、相手のチェックサムは自分の記録前でも保持しておく
+ *   - 固定長のリングのみで動的確保なし
+ *
+ * 再同期の手順:
+ *   1. DESYNC_ROLLBACK: desync_agreed_snapshot を復元し、確定済みの入力で再シミュレーションする
+ *      (ロールバックの予測入力の取り違えなどはこれで解消する)
+ *   2. DESYNC_RESYNC: 再実行後も同じ区間で不一致、または合意済みスナップショットが無い場合。
+ *      権威側 (ホスト/サーバー) にスナップショットを要求し、受け取ったら desync_resynced を呼ぶ
+ */
+
+#ifndef DESYNC_H
+#define DESYNC_H
+
+#include "../game/game_defs.h"
+#include "../game/snapshot.h"
+
+#define DESYNC_DEFAULT_INTERVAL 16 /**< 既定のチェックポイント間隔 (フレーム) */
+#define DESYNC_HISTORY          32 /**< 保持するチェックポイント数 (2のべき乗) */
+
+/**
+ * @brief 照合結果
+ */
+typedef enum {
+    DESYNC_PENDING,              /**< 照合できる組がまだ無い */
+    DESYNC_OK,                   /**< 一致した */
+    DESYNC_ROLLBACK,             /**< 不一致: 合意済みスナップショットから再実行する */
+    DESYNC_RESYNC                /**< 不一致: 権威側のスナップショットが必要 */
+} DesyncResult;
+
+/**
+ * @brief チェックポイント1件
+ */
+typedef struct {
+    uint32_t frame;              /**< フレーム番号 */
+    uint32_t local;              /**< 自分のチェックサム */
+    uint32_t remote;             /**< 相手のチェックサム */
+    uint8_t has_local;           /**< local が有効 */
+    uint8_t has_remote;          /**< remote が有効 */
+} DesyncCheckpoint;
+
+/**
+ * @brief 非同期検出器
+ */
+typedef struct {
+    uint32_t mask;               /**< チェックポイント間隔 - 1 */
+    uint32_t shift;              /**< log2(チェックポイント間隔) */
+    uint32_t latest_frame;       /**< 最新のチェックポイントのフレーム */
+    uint32_t latest_checksum;    /**< 最新のチェックポイントのチェックサム */
+    int has_latest;              /**< latest が有効 */
+    uint32_t agreed_frame;       /**< 一致を確認した最新のフレーム */
+    int has_agreed;              /**< agreed_frame が有効 */
+    uint32_t rollback_frame;     /**< 直前に再実行を指示した不一致フレーム */
+    int rolled_back;             /**< 再実行の結果待ち */
+    DesyncCheckpoint checkpoints[DESYNC_HISTORY]; /**< チェックポイントのリング */
+    GameSnapshot snapshots[DESYNC_HISTORY];       /**< チェックポイントごとのスナップショット */
+} DesyncDetector;
+
+/**
+ * @brief 検出器を初期化する
+ * @param detector 初期化する検出器
+ * @param interval チェックポイント間隔 (2のべき乗に切り上げ、0で既定値)
+ */
+void desync_init(DesyncDetector *detector, uint32_t interval);
+
+/**
+ * @brief フレームのシミュレーション後に呼び出す
+ *
+ * チェックポイントのフレームではチェックサムとスナップショットを記録し、
+ * 相手のチェックサムが既に届いていれば照合します。
+ * ロールバックによる再シミュレーションで同じフレームを再び渡してもかまいません。
+ *
+ * @param detector 検出器
+ * @param gameplay シミュレーション後の状態
+ * @param frame シミュレーションしたフレーム番号
+ * @return 照合結果 (チェックポイント以外のフレームでは DESYNC_PENDING)
+ */
+DesyncResult desync_on_frame(DesyncDetector *detector, const GamePlayContext *gameplay, uint32_t frame);
+
+/**
+ * @brief 送信する入力パケットに載せるチェックサムを取得する
+ * @param detector 検出器
+ * @param frame チェックポイントのフレームの出力先
+ * @param checksum チェックサムの出力先
+ * @return 載せるチェックサムがある場合1、無い場合0
+ */
+int desync_outgoing(const DesyncDetector *detector, uint32_t *frame, uint32_t *checksum);
+
+/**
+ * @brief 相手から届いたチェックサムを照合する
+ * @param detector 検出器
+ * @param frame 相手のチェックポイントのフレーム
+ * @param checksum 相手のチェックサム
+ * @return 照合結果
+ */
+DesyncResult desync_on_remote(DesyncDetector *detector, uint32_t frame, uint32_t checksum);
+
+/**
+ * @brief 一致を確認した最新のスナップショットを取得する
+ * @param detector 検出器
+ * @return スナップショット (リングから外れた場合や未確認の場合はNULL)
+ */
+const GameSnapshot* desync_agreed_snapshot(const DesyncDetector *detector);
+
+/**
+ * @brief 指定フレームのスナップショットを取得する (権威側が再同期要求に応える場合など)
+ * @param detector 検出器
+ * @param frame フレーム番号
+ * @return スナップショット (記録が無い場合はNULL)
+ */
+const GameSnapshot* desync_snapshot_at(const DesyncDetector *detector, uint32_t frame);
+
+/**
+ * @brief 権威側のスナップショットで再同期した後に呼び出す
+ *
+ * スナップショットのフレームを合意済みとし、それ以降の記録を破棄します。
+ *
+ * @param detector 検出器
+ * @param snapshot 復元したスナップショット
+ */
+void desync_resynced(DesyncDetector *detector, const GameSnapshot *snapshot);
+
+#endif /* DESYNC_H */
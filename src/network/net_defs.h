@@ -0,0 +1,29 @@
+/**
+ * @file net_defs.h
+ * @brief ネットワーク層の共通定義
+ *
+ * このファイルはトランスポート間で共有する定数と列挙型を定義します。
+ * 主な内容:
+ *   - トランスポート種別
+ *   - 既定のポートとソケットパス
+ *
+ * 設計思想:
+ *   - ServerContext/ClientContext はトランスポート種別を保持し、送受信処理を切り替える
+ *   - 同一マシン上の接続は TCP/UDP スタックを経由しない AF_UNIX を優先
+ */
+
+#ifndef NET_DEFS_H
+#define NET_DEFS_H
+
+/* トランスポート種別の列挙型 */
+typedef enum {
+    NET_TRANSPORT_TCP,          /**< TCP (リモート接続) */
+    NET_TRANSPORT_UDP,          /**< UDP (リモート接続、低遅延) */
+    NET_TRANSPORT_UNIX          /**< Unix ドメインソケット (同一マシン上のボット/サーバー) */
+} NetTransport;
+
+#define NET_DEFAULT_PORT        7777                 /**< 既定のTCP/UDPポート */
+#define NET_DEFAULT_UNIX_PATH   "@tetris-server"     /**< 既定のソケットパス (先頭@は抽象名前空間) */
+#define NET_UNIX_MAX_FDS        16                   /**< 1メッセージで受け渡すファイル記述子の上限 */
+
+#endif /* NET_DEFS_H */
@@ -0,0 +1,265 @@
+/**
+ * @file net_unix.c
+ * @brief Unix ドメインソケットトランスポート実装
+ *
+ * 主な機能:
+ *   - sockaddr_un の組み立て (パス名/抽象名前空間)
+ *   - SO_PEERCRED による接続相手の確認
+ *   - SCM_RIGHTS 制御メッセージの組み立てと検証
+ *   - 接続済みソケットの引き渡しプロトコル
+ *
+ * 設計思想:
+ *   - 受け取ったファイル記述子は必ず close-on-exec を付け、子プロセスへ漏らさない
+ *   - 制御メッセージが切り詰められた場合は受け取った記述子をすべて閉じて失敗とする
+ *   - 引き渡しのヘッダーと記述子は1回の sendmsg で送り、受信側で分離しない
+ */
+
+#define _GNU_SOURCE // accept4 と struct ucred (SO_PEERCRED)
+
+#include "net_unix.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <stddef.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#define NET_HANDOFF_MAGIC 0x54484f46u /**< "THOF" */
+
+/**
+ * @brief ソケットパスからアドレスを組み立てる
+ */
+static int make_address(const char *path, struct sockaddr_un *addr, socklen_t *len) {
+    size_t n = path ? strlen(path) : 0;
+    if (n == 0 || n >= sizeof(addr->sun_path)) {
+        return 0;
+    }
+    memset(addr, 0, sizeof(*addr));
+    addr->sun_family = AF_UNIX;
+    memcpy(addr->sun_path, path, n);
+    if (path[0] == '@') {
+        // 抽象名前空間: 先頭をNULにし、長さは終端NULを含めない
+        addr->sun_path[0] = '\0';
+        *len = (socklen_t)(offsetof(struct sockaddr_un, sun_path) + n);
+    } else {
+        *len = (socklen_t)(offsetof(struct sockaddr_un, sun_path) + n + 1);
+    }
+    return 1;
+}
+
+/**
+ * @brief 待ち受けソケットを作成する
+ */
+int net_unix_listen(const char *path, int backlog) {
+    struct sockaddr_un addr;
+    socklen_t len;
+    if (!make_address(path, &addr, &len)) {
+        return -1;
+    }
+    int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+        return -1;
+    }
+    if (path[0] != '@') {
+        unlink(path); // 前回の異常終了で残ったソケットファイル
+    }
+    if (bind(fd, (struct sockaddr*)&addr, len) != 0 || listen(fd, backlog) != 0) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+/**
+ * @brief 待ち受けソケットへ接続する
+ */
+int net_unix_connect(const char *path) {
+    struct sockaddr_un addr;
+    socklen_t len;
+    if (!make_address(path, &addr, &len)) {
+        return -1;
+    }
+    int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+        return -1;
+    }
+    int rc;
+    do {
+        rc = connect(fd, (struct sockaddr*)&addr, len);
+    } while (rc != 0 && errno == EINTR);
+    if (rc != 0) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+/**
+ * @brief 接続を受け入れる
+ */
+int net_unix_accept(int listen_fd) {
+    int fd;
+    do {
+        fd = accept4(listen_fd, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC);
+    } while (fd < 0 && errno == EINTR);
+    return fd;
+}
+
+/**
+ * @brief 接続相手の資格情報を取得する
+ */
+int net_unix_peer_cred(int sock, pid_t *pid, uid_t *uid) {
+    struct ucred cred;
+    socklen_t len = sizeof(cred);
+    if (getsockopt(sock, SOL_SOCKET, SO_PEERCRED, &cred, &len) != 0 || len != sizeof(cred)) {
+        return 0;
+    }
+    if (pid) {
+        *pid = cred.pid;
+    }
+    if (uid) {
+        *uid = cred.uid;
+    }
+    return 1;
+}
+
+/**
+ * @brief データとファイル記述子を送信する
+ */
+int net_unix_send_fds(int sock, const int *fds, int count, const void *data, size_t len) {
+    if (count < 0 || count > NET_UNIX_MAX_FDS || !data || len == 0) {
+        return 0;
+    }
+    struct iovec iov = {(void*)data, len};
+    union {
+        char buf[CMSG_SPACE(sizeof(int) * NET_UNIX_MAX_FDS)];
+        struct cmsghdr align;
+    } control;
+    memset(&control, 0, sizeof(control));
+
+    struct msghdr msg;
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    if (count > 0) {
+        msg.msg_control = control.buf;
+        msg.msg_controllen = CMSG_SPACE(sizeof(int) * count);
+        struct cmsghdr *cmsg = CMSG_FIRSTHDR(&msg);
+        cmsg->cmsg_level = SOL_SOCKET;
+        cmsg->cmsg_type = SCM_RIGHTS;
+        cmsg->cmsg_len = CMSG_LEN(sizeof(int) * count);
+        memcpy(CMSG_DATA(cmsg), fds, sizeof(int) * count);
+    }
+
+    ssize_t n;
+    do {
+        n = sendmsg(sock, &msg, MSG_NOSIGNAL);
+    } while (n < 0 && errno == EINTR);
+    return n == (ssize_t)len;
+}
+
+/**
+ * @brief データとファイル記述子を受信する
+ */
+ssize_t net_unix_recv_fds(int sock, int *fds, int max_fds, int *count, void *data, size_t cap) {
+    *count = 0;
+    struct iovec iov = {data, cap};
+    union {
+        char buf[CMSG_SPACE(sizeof(int) * NET_UNIX_MAX_FDS)];
+        struct cmsghdr align;
+    } control;
+
+    struct msghdr msg;
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control.buf;
+    msg.msg_controllen = sizeof(control.buf);
+
+    ssize_t n;
+    do {
+        n = recvmsg(sock, &msg, MSG_CMSG_CLOEXEC);
+    } while (n < 0 && errno == EINTR);
+    if (n < 0) {
+        return -1;
+    }
+
+    int received[NET_UNIX_MAX_FDS];
+    int total = 0;
+    for (struct cmsghdr *cmsg = CMSG_FIRSTHDR(&msg); cmsg; cmsg = CMSG_NXTHDR(&msg, cmsg)) {
+        if (cmsg->cmsg_level != SOL_SOCKET || cmsg->cmsg_type != SCM_RIGHTS) {
+            continue;
+        }
+        int k = (int)((cmsg->cmsg_len - CMSG_LEN(0)) / sizeof(int));
+        if (total + k > NET_UNIX_MAX_FDS) {
+            k = NET_UNIX_MAX_FDS - total;
+        }
+        memcpy(received + total, CMSG_DATA(cmsg), sizeof(int) * k);
+        total += k;
+    }
+
+    if ((msg.msg_flags & (MSG_CTRUNC | MSG_TRUNC)) || total > max_fds) {
+        for (int i = 0; i < total; i++) {
+            close(received[i]);
+        }
+        return -1;
+    }
+    memcpy(fds, received, sizeof(int) * total);
+    *count = total;
+    return n;
+}
+
+/**
+ * @brief 接続済みソケットとセッション状態を別プロセスへ引き渡す
+ */
+int net_unix_handoff_send(int channel, int client_fd, const NetHandoffHeader *header, const void *state) {
+    if (header->state_len > NET_HANDOFF_STATE_MAX || (header->state_len > 0 && !state)) {
+        return 0;
+    }
+    unsigned char buf[sizeof(uint32_t) + sizeof(NetHandoffHeader) + NET_HANDOFF_STATE_MAX];
+    uint32_t magic = NET_HANDOFF_MAGIC;
+    memcpy(buf, &magic, sizeof(magic));
+    memcpy(buf + sizeof(magic), header, sizeof(*header));
+    if (header->state_len > 0) {
+        memcpy(buf + sizeof(magic) + sizeof(*header), state, header->state_len);
+    }
+    return net_unix_send_fds(channel, &client_fd, 1, buf,
+                             sizeof(magic) + sizeof(*header) + header->state_len);
+}
+
+/**
+ * @brief 引き渡された接続とセッション状態を受け取る
+ */
+int net_unix_handoff_recv(int channel, NetHandoffHeader *header, void *state) {
+    unsigned char buf[sizeof(uint32_t) + sizeof(NetHandoffHeader) + NET_HANDOFF_STATE_MAX];
+    int fd = -1;
+    int count = 0;
+    ssize_t n = net_unix_recv_fds(channel, &fd, 1, &count, buf, sizeof(buf));
+    if (n <= 0 || count != 1) {
+        return -1;
+    }
+
+    uint32_t magic;
+    size_t head = sizeof(magic) + sizeof(*header);
+    if ((size_t)n < head) {
+        close(fd);
+        return -1;
+    }
+    memcpy(&magic, buf, sizeof(magic));
+    memcpy(header, buf + sizeof(magic), sizeof(*header));
+    if (magic != NET_HANDOFF_MAGIC || header->state_len > NET_HANDOFF_STATE_MAX ||
+        (size_t)n != head + header->state_len) {
+        close(fd);
+        return -1;
+    }
+    if (header->state_len > 0) {
+        memcpy(state, buf + head, header->state_len);
+    }
+    // 送信側の設定に関わらず、受け取った接続はイベントループ用にノンブロッキングにする
+    int flags = fcntl(fd, F_GETFL);
+    if (flags >= 0) {
+        fcntl(fd, F_SETFL, flags | O_NONBLOCK);
+    }
+    return fd;
+}
@@ -0,0 +1,114 @@
+/**
+ * @file net_unix.h
+ * @brief Unix ドメインソケットトランスポートの宣言
+ *
+ * このファイルは同一マシン上のボット、トーナメントランナー、サーバープロセス間の
+ * AF_UNIX 接続と、ファイル記述子の受け渡しを宣言します。
+ * 主な機能:
+ *   - 待ち受け/接続/受け入れ (パス名および抽象名前空間)
+ *   - 接続相手の資格情報 (PID/UID) の取得
+ *   - SCM_RIGHTS によるファイル記述子の送受信
+ *   - 受付プロセスからシャードプロセスへの接続済みソケットの引き渡し
+ *
+ * 設計思想:
+ *   - TCP/UDP と同じくファイル記述子を返し、呼び出し側のイベントループにそのまま載せる
+ *   - パスの先頭が '@' の場合は抽象名前空間を使い、ソケットファイルの後始末を不要にする
+ *   - 引き渡しでは接続とセッション状態を1メッセージで送り、クライアントは再接続不要
+ */
+
+#ifndef NET_UNIX_H
+#define NET_UNIX_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/types.h>
+#include "net_defs.h"
+
+#define NET_HANDOFF_STATE_MAX 4096 /**< 引き渡すセッション状態の最大長 */
+
+/**
+ * @brief 接続の引き渡し情報
+ */
+typedef struct {
+    uint64_t session_id;         /**< セッションID */
+    uint32_t transport;          /**< 元の接続のトランスポート (NetTransport) */
+    uint32_t state_len;          /**< 後続するセッション状態の長さ */
+} NetHandoffHeader;
+
+/**
+ * @brief 待ち受けソケットを作成する
+ * @param path ソケットパス (先頭'@'で抽象名前空間)
+ * @param backlog 接続待ち行列の長さ
+ * @return ソケット (失敗時-1)
+ */
+int net_unix_listen(const char *path, int backlog);
+
+/**
+ * @brief 待ち受けソケットへ接続する
+ * @param path ソケットパス (先頭'@'で抽象名前空間)
+ * @return ソケット (失敗時-1)
+ */
+int net_unix_connect(const char *path);
+
+/**
+ * @brief 接続を受け入れる (ノンブロッキング、close-on-exec)
+ * @param listen_fd 待ち受けソケット
+ * @return 接続済みソケット (接続が無い場合や失敗時-1)
+ */
+int net_unix_accept(int listen_fd);
+
+/**
+ * @brief 接続相手の資格情報を取得する
+ * @param sock 接続済みソケット
+ * @param pid 相手のプロセスIDの出力先 (NULL可)
+ * @param uid 相手のユーザーIDの出力先 (NULL可)
+ * @return 成功時1、失敗時0
+ */
+int net_unix_peer_cred(int sock, pid_t *pid, uid_t *uid);
+
+/**
+ * @brief データとファイル記述子を送信する
+ * @param sock 接続済みソケット
+ * @param fds 送るファイル記述子
+ * @param count ファイル記述子の数 (NET_UNIX_MAX_FDS 以下)
+ * @param data 同時に送るデータ (1バイト以上必須)
+ * @param len データ長
+ * @return 成功時1、失敗時0
+ */
+int net_unix_send_fds(int sock, const int *fds, int count, const void *data, size_t len);
+
+/**
+ * @brief データとファイル記述子を受信する
+ * @param sock 接続済みソケット
+ * @param fds 受け取ったファイル記述子の出力先 (close-on-exec 付き)
+ * @param max_fds 出力先の要素数
+ * @param count 受け取ったファイル記述子の数の出力先
+ * @param data データの出力先
+ * @param cap データの出力先のサイズ
+ * @return 受信したデータ長、切断時0、失敗時-1
+ */
+ssize_t net_unix_recv_fds(int sock, int *fds, int max_fds, int *count, void *data, size_t cap);
+
+/**
+ * @brief 接続済みソケットとセッション状態を別プロセスへ引き渡す
+ *
+ * 送信後、呼び出し側は自身の client_fd を閉じてください。
+ *
+ * @param channel 引き渡し先プロセスとの AF_UNIX 接続
+ * @param client_fd 引き渡すクライアントの接続
+ * @param header 引き渡し情報 (state_len はセッション状態の長さ)
+ * @param state セッション状態 (NULL可)
+ * @return 成功時1、失敗時0
+ */
+int net_unix_handoff_send(int channel, int client_fd, const NetHandoffHeader *header, const void *state);
+
+/**
+ * @brief 引き渡された接続とセッション状態を受け取る
+ * @param channel 引き渡し元プロセスとの AF_UNIX 接続
+ * @param header 引き渡し情報の出力先
+ * @param state セッション状態の出力先 (NET_HANDOFF_STATE_MAX バイト)
+ * @return 受け取ったクライアントの接続 (失敗時-1)
+ */
+int net_unix_handoff_recv(int channel, NetHandoffHeader *header, void *state);
+
+#endif /* NET_UNIX_H */
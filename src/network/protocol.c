@@ -0,0 +1,158 @@
+/**
+ * @file protocol.c
+ * @brief 対戦プロトコルのメッセージの直列化と復元の実装
+ *
+ * 主な機能:
+ *   - 入力パケット、再同期の要求、スナップショット、スコアの書き込み
+ *   - 長さと種別の検証付きの読み出し
+ *
+ * 設計思想:
+ *   - 多バイト値はリトルエンディアンで書き、構造体の memcpy に頼らない
+ *     (packed 構造体の配置はワイヤ形式と同じで、バイト順だけをここで変換する)
+ */
+
+#include "protocol.h"
+#include <string.h>
+
+static void put_u16(uint8_t *p, uint16_t v) {
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+}
+
+static void put_u32(uint8_t *p, uint32_t v) {
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+    p[2] = (uint8_t)(v >> 16);
+    p[3] = (uint8_t)(v >> 24);
+}
+
+static uint16_t get_u16(const uint8_t *p) {
+    return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+static uint32_t get_u32(const uint8_t *p) {
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+/**
+ * @brief 入力パケットを直列化する
+ */
+size_t protocol_write_input(const InputPacket *packet, uint8_t *buf, size_t cap) {
+    if (cap < sizeof(InputPacket)) {
+        return 0;
+    }
+    buf[0] = MSG_INPUT;
+    buf[1] = packet->player_id;
+    put_u16(buf + 2, packet->keys);
+    put_u32(buf + 4, packet->frame);
+    buf[8] = packet->flags;
+    memset(buf + 9, 0, 3);
+    put_u32(buf + 12, packet->check_frame);
+    put_u32(buf + 16, packet->checksum);
+    return sizeof(InputPacket);
+}
+
+/**
+ * @brief 入力パケットを復元する
+ */
+int protocol_read_input(InputPacket *packet, const uint8_t *buf, size_t len) {
+    if (len != sizeof(InputPacket) || buf[0] != MSG_INPUT) {
+        return 0;
+    }
+    packet->type = buf[0];
+    packet->player_id = buf[1];
+    packet->keys = get_u16(buf + 2);
+    packet->frame = get_u32(buf + 4);
+    packet->flags = buf[8];
+    memset(packet->reserved, 0, sizeof(packet->reserved));
+    packet->check_frame = get_u32(buf + 12);
+    packet->checksum = get_u32(buf + 16);
+    return 1;
+}
+
+/**
+ * @brief 再同期の要求を直列化する
+ */
+size_t protocol_write_resync(const ResyncRequestPacket *packet, uint8_t *buf, size_t cap) {
+    if (cap < sizeof(ResyncRequestPacket)) {
+        return 0;
+    }
+    buf[0] = MSG_RESYNC_REQUEST;
+    buf[1] = packet->player_id;
+    put_u16(buf + 2, 0);
+    put_u32(buf + 4, packet->agreed_frame);
+    put_u32(buf + 8, packet->mismatch_frame);
+    return sizeof(ResyncRequestPacket);
+}
+
+/**
+ * @brief 再同期の要求を復元する
+ */
+int protocol_read_resync(ResyncRequestPacket *packet, const uint8_t *buf, size_t len) {
+    if (len != sizeof(ResyncRequestPacket) || buf[0] != MSG_RESYNC_REQUEST) {
+        return 0;
+    }
+    packet->type = buf[0];
+    packet->player_id = buf[1];
+    packet->reserved = 0;
+    packet->agreed_frame = get_u32(buf + 4);
+    packet->mismatch_frame = get_u32(buf + 8);
+    return 1;
+}
+
+/**
+ * @brief スナップショットを直列化する
+ */
+size_t protocol_write_snapshot(const SnapshotPacket *packet, uint8_t *buf, size_t cap) {
+    if (cap < sizeof(SnapshotPacket)) {
+        return 0;
+    }
+    buf[0] = MSG_SNAPSHOT;
+    buf[1] = packet->player_id;
+    put_u16(buf + 2, SNAPSHOT_WIRE_SIZE);
+    memcpy(buf + 4, packet->data, SNAPSHOT_WIRE_SIZE); // data は snapshot_serialize 済み
+    return sizeof(SnapshotPacket);
+}
+
+/**
+ * @brief スナップショットを復元する
+ */
+int protocol_read_snapshot(SnapshotPacket *packet, const uint8_t *buf, size_t len) {
+    if (len != sizeof(SnapshotPacket) || buf[0] != MSG_SNAPSHOT ||
+        get_u16(buf + 2) != SNAPSHOT_WIRE_SIZE) {
+        return 0;
+    }
+    packet->type = buf[0];
+    packet->player_id = buf[1];
+    packet->length = SNAPSHOT_WIRE_SIZE;
+    memcpy(packet->data, buf + 4, SNAPSHOT_WIRE_SIZE);
+    return 1;
+}
+
+/**
+ * @brief スコアを直列化する
+ */
+size_t protocol_write_score(const ScoreUpdateMessage *message, uint8_t *buf, size_t cap) {
+    if (cap < sizeof(ScoreUpdateMessage)) {
+        return 0;
+    }
+    buf[0] = message->player_id;
+    buf[1] = message->level;
+    put_u16(buf + 2, message->lines);
+    put_u32(buf + 4, message->score);
+    return sizeof(ScoreUpdateMessage);
+}
+
+/**
+ * @brief スコアを復元する
+ */
+int protocol_read_score(ScoreUpdateMessage *message, const uint8_t *buf, size_t len) {
+    if (len != sizeof(ScoreUpdateMessage)) {
+        return 0;
+    }
+    message->player_id = buf[0];
+    message->level = buf[1];
+    message->lines = get_u16(buf + 2);
+    message->score = get_u32(buf + 4);
+    return 1;
+}
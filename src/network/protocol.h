@@ -0,0 +1,222 @@
+/**
+ * @file protocol.h
+ * @brief 対戦プロトコルのメッセージ定義
+ *
+ * このファイルはピア間/サーバー間で送受信するメッセージの種別と形式を定義します。
+ * 主な内容:
+ *   - メッセージ種別
+ *   - 入力パケット (チェックサムを同乗させる)
+ *   - 再同期の要求とスナップショット
+ *   - サーバーからの対戦イベント (おじゃま、盤面差分、スコア) とそれらをまとめるバンドル
+ *   - 多バイト値を含むメッセージの直列化と復元
+ *
+ * 設計思想:
+ *   - 全メッセージは先頭1バイトの種別で判別する
+ *   - 多バイト値はリトルエンディアン、構造体は詰め物なしの固定長
+ *     (構造体はホストのバイト順のため、そのまま送らず protocol_write_* / protocol_read_* を通す)
+ *   - チェックサムは専用メッセージを設けず入力パケットに載せ、追加の送信を発生させない
+ *   - サーバーから1ティックに送るイベントは接続ごとに1つのバンドルにまとめる (bundle.h)
+ */
+
+#ifndef PROTOCOL_H
+#define PROTOCOL_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "../game/snapshot.h"
+
+#define PROTOCOL_VERSION 1 /**< プロトコルのバージョン */
+
+/* メッセージ種別の列挙型 */
+typedef enum {
+    MSG_INPUT = 1,              /**< 入力 (InputPacket) */
+    MSG_RESYNC_REQUEST,         /**< 再同期の要求 (ResyncRequestPacket) */
+    MSG_SNAPSHOT,               /**< 再同期用のスナップショット (SnapshotPacket) */
+    MSG_BUNDLE,                 /**< 1ティック分のイベントのまとめ (BundleHeader + BundleRecord の列) */
+    MSG_GARBAGE,                /**< 対戦相手からのおじゃまライン (GarbageMessage) */
+    MSG_BOARD_DELTA,            /**< 対戦相手の盤面の変化した行 (BoardDeltaMessage + 行データ) */
+    MSG_SCORE_UPDATE,           /**< 対戦相手のスコア (ScoreUpdateMessage) */
+    MSG_BOARD_SUMMARY           /**< 注目外の対戦相手の盤面の要約 (BoardSummaryMessage) */
+} MessageType;
+
+/**
+ * @brief 入力パケット
+ *
+ * check_frame/checksum には送信側の最新チェックポイントを載せます (desync_outgoing)。
+ * まだチェックポイントが無い場合は flags の PROTOCOL_FLAG_CHECKSUM を立てません。
+ */
+typedef struct __attribute__((packed)) {
+    uint8_t type;                /**< MSG_INPUT */
+    uint8_t player_id;           /**< 送信元のプレイヤー */
+    uint16_t keys;               /**< 押下中のキー (KEY_COUNT ビット) */
+    uint32_t frame;              /**< 入力を適用するフレーム */
+    uint8_t flags;               /**< PROTOCOL_FLAG_* */
+    uint8_t reserved[3];         /**< 予約 (0) */
+    uint32_t check_frame;        /**< チェックサムを計算したフレーム */
+    uint32_t checksum;           /**< 状態のチェックサム */
+} InputPacket;
+
+#define PROTOCOL_FLAG_CHECKSUM 0x01 /**< check_frame/checksum が有効 */
+
+/**
+ * @brief 再同期の要求
+ *
+ * 合意済みスナップショットからの再実行でも一致しない場合に、権威側へ送ります。
+ */
+typedef struct __attribute__((packed)) {
+    uint8_t type;                /**< MSG_RESYNC_REQUEST */
+    uint8_t player_id;           /**< 要求元のプレイヤー */
+    uint16_t reserved;           /**< 予約 (0) */
+    uint32_t agreed_frame;       /**< 要求元が一致を確認した最新のフレーム */
+    uint32_t mismatch_frame;     /**< 不一致を検出したフレーム */
+} ResyncRequestPacket;
+
+/**
+ * @brief 再同期用のスナップショット
+ *
+ * 権威側は mismatch_frame 以前で記録が残っている最新のスナップショットを送ります。
+ */
+typedef struct __attribute__((packed)) {
+    uint8_t type;                /**< MSG_SNAPSHOT */
+    uint8_t player_id;           /**< 状態の持ち主のプレイヤー */
+    uint16_t length;             /**< data の長さ (SNAPSHOT_WIRE_SIZE) */
+    uint8_t data[SNAPSHOT_WIRE_SIZE]; /**< snapshot_serialize の出力 */
+} SnapshotPacket;
+
+/**
+ * @brief バンドルのヘッダー
+ *
+ * 後続に count 個の BundleRecord (とその本体) が続きます。
+ * length はストリーム (TCP) 上でバンドルの境界を求めるのに使います。
+ */
+typedef struct __attribute__((packed)) {
+    uint8_t type;                /**< MSG_BUNDLE */
+    uint8_t count;               /**< レコード数 */
+    uint16_t flags;              /**< BUNDLE_FLAG_* */
+    uint32_t tick;               /**< サーバーのティック番号 */
+    uint32_t ack;                /**< 受信済みとして確認するクライアントの入力フレーム */
+    uint32_t length;             /**< ヘッダーを含むバンドル全体の長さ */
+} BundleHeader;
+
+#define BUNDLE_FLAG_ACK 0x0001 /**< ack が有効 */
+
+/**
+ * @brief バンドル内のレコードのヘッダー
+ */
+typedef struct __attribute__((packed)) {
+    uint8_t type;                /**< MessageType */
+    uint16_t length;             /**< 後続する本体の長さ */
+} BundleRecord;
+
+/**
+ * @brief おじゃまライン
+ */
+typedef struct __attribute__((packed)) {
+    uint8_t from_player;         /**< 送り主のプレイヤー */
+    uint8_t lines;               /**< ライン数 */
+    uint8_t hole_column;         /**< 穴の列 */
+    uint8_t reserved;            /**< 予約 (0) */
+} GarbageMessage;
+
+/**
+ * @brief 盤面差分
+ *
+ * 後続に row_count 組の (行番号1バイト + BOARD_WIDTH バイトのセル) が続きます。
+ */
+typedef struct __attribute__((packed)) {
+    uint8_t player_id;           /**< 盤面の持ち主のプレイヤー */
+    uint8_t row_count;           /**< 変化した行数 */
+} BoardDeltaMessage;
+
+/**
+ * @brief スコア
+ */
+typedef struct __attribute__((packed)) {
+    uint8_t player_id;           /**< プレイヤー */
+    uint8_t level;               /**< レベル */
+    uint16_t lines;              /**< 消去したライン数 */
+    uint32_t score;              /**< スコア */
+} ScoreUpdateMessage;
+
+/**
+ * @brief 盤面の要約 (狙い/狙われの関係にない対戦相手向けの低頻度・低精度の更新)
+ */
+typedef struct __attribute__((packed)) {
+    uint8_t player_id;           /**< 盤面の持ち主のプレイヤー */
+    uint8_t danger;              /**< 危険度 (0-255、積み上がりと受けているおじゃまから算出) */
+    uint8_t heights[BOARD_WIDTH]; /**< 列ごとの高さ */
+} BoardSummaryMessage;
+
+/**
+ * @brief 入力パケットを直列化する
+ * @param packet 入力パケット
+ * @param buf 出力先
+ * @param cap 出力先のサイズ (sizeof(InputPacket) 以上)
+ * @return 書き込んだバイト数 (失敗時0)
+ */
+size_t protocol_write_input(const InputPacket *packet, uint8_t *buf, size_t cap);
+
+/**
+ * @brief 入力パケットを復元する
+ * @param packet 出力先
+ * @param buf 受信データ
+ * @param len 受信データの長さ
+ * @return 成功時1、長さや種別が不正な場合0
+ */
+int protocol_read_input(InputPacket *packet, const uint8_t *buf, size_t len);
+
+/**
+ * @brief 再同期の要求を直列化する
+ * @param packet 再同期の要求
+ * @param buf 出力先
+ * @param cap 出力先のサイズ (sizeof(ResyncRequestPacket) 以上)
+ * @return 書き込んだバイト数 (失敗時0)
+ */
+size_t protocol_write_resync(const ResyncRequestPacket *packet, uint8_t *buf, size_t cap);
+
+/**
+ * @brief 再同期の要求を復元する
+ * @param packet 出力先
+ * @param buf 受信データ
+ * @param len 受信データの長さ
+ * @return 成功時1、長さや種別が不正な場合0
+ */
+int protocol_read_resync(ResyncRequestPacket *packet, const uint8_t *buf, size_t len);
+
+/**
+ * @brief スナップショットを直列化する
+ * @param packet スナップショット
+ * @param buf 出力先
+ * @param cap 出力先のサイズ (sizeof(SnapshotPacket) 以上)
+ * @return 書き込んだバイト数 (失敗時0)
+ */
+size_t protocol_write_snapshot(const SnapshotPacket *packet, uint8_t *buf, size_t cap);
+
+/**
+ * @brief スナップショットを復元する
+ * @param packet 出力先
+ * @param buf 受信データ
+ * @param len 受信データの長さ
+ * @return 成功時1、長さや種別が不正な場合0
+ */
+int protocol_read_snapshot(SnapshotPacket *packet, const uint8_t *buf, size_t len);
+
+/**
+ * @brief スコアを直列化する (バンドルのレコード本体)
+ * @param message スコア
+ * @param buf 出力先
+ * @param cap 出力先のサイズ (sizeof(ScoreUpdateMessage) 以上)
+ * @return 書き込んだバイト数 (失敗時0)
+ */
+size_t protocol_write_score(const ScoreUpdateMessage *message, uint8_t *buf, size_t cap);
+
+/**
+ * @brief スコアを復元する
+ * @param message 出力先
+ * @param buf レコード本体
+ * @param len レコード本体の長さ
+ * @return 成功時1、長さが不正な場合0
+ */
+int protocol_read_score(ScoreUpdateMessage *message, const uint8_t *buf, size_t len);
+
+#endif /* PROTOCOL_H */
@@ -0,0 +1,335 @@
+/**
+ * @file shm_link.c
+ * @brief 共有メモリによるプロセス間ローカル対戦リンク実装
+ *
+ * 主な機能:
+ *   - memfd への方向別リングの配置
+ *   - acquire/release による SPSC リングの送受信
+ *   - 待機フラグと eventfd による起床
+ *   - net_unix の SCM_RIGHTS 送受信による memfd/eventfd の受け渡し
+ *
+ * 設計思想:
+ *   - head は生産者のみ、tail と待機フラグは消費者のみが書き込み、別キャッシュラインに置く
+ *   - 送信側は head 公開後に全順序フェンスを挟んで待機フラグを読む (起床の取りこぼし防止)
+ *   - 受信側は待機フラグを立てた後に全順序フェンスを挟んで再確認してから眠る
+ */
+
+#define _GNU_SOURCE // memfd_create
+
+#include "shm_link.h"
+#include "net_unix.h"
+#include <errno.h>
+#include <poll.h>
+#include <stdatomic.h>
+#include <stddef.h>
+#include <string.h>
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#define SHM_LINK_MAGIC   0x4B4E4C53u /**< "SLNK" */
+#define SHM_LINK_VERSION 1
+#define SHM_CACHE_LINE   64
+#define SHM_SLOT_MASK    (SHM_LINK_SLOT_COUNT - 1)
+
+/**
+ * @brief 1方向のリング
+ */
+typedef struct {
+    _Alignas(SHM_CACHE_LINE) _Atomic uint32_t head; /**< 次に書き込む位置 (生産者) */
+    _Atomic uint32_t closed;     /**< 生産者が切断した */
+    _Alignas(SHM_CACHE_LINE) _Atomic uint32_t tail; /**< 次に読み込む位置 (消費者) */
+    _Atomic uint32_t waiting;    /**< 消費者が eventfd で待機中 */
+    _Alignas(SHM_CACHE_LINE) uint8_t slots[SHM_LINK_SLOT_COUNT][SHM_LINK_SLOT_SIZE]; /**< メッセージ */
+} ShmRing;
+
+struct ShmRegion {
+    uint32_t magic;              /**< SHM_LINK_MAGIC */
+    uint32_t version;            /**< SHM_LINK_VERSION */
+    ShmRing rings[2];            /**< [0]: ホスト→ゲスト、[1]: ゲスト→ホスト */
+};
+
+/**
+ * @brief スピン待ちのヒント
+ */
+static inline void cpu_relax(void) {
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#elif defined(__aarch64__)
+    __asm__ __volatile__("yield");
+#endif
+}
+
+/**
+ * @brief 共有メモリをマップする
+ */
+static int map_region(ShmLink *link) {
+    void *map = mmap(NULL, sizeof(ShmRegion), PROT_READ | PROT_WRITE, MAP_SHARED, link->memfd, 0);
+    if (map == MAP_FAILED) {
+        return 0;
+    }
+    link->region = (ShmRegion*)map;
+    return 1;
+}
+
+/**
+ * @brief 端点のファイル記述子を全て閉じる
+ */
+static void close_fds(ShmLink *link) {
+    if (link->memfd >= 0) close(link->memfd);
+    if (link->wake_fds[0] >= 0) close(link->wake_fds[0]);
+    if (link->wake_fds[1] >= 0) close(link->wake_fds[1]);
+    link->memfd = -1;
+    link->wake_fds[0] = -1;
+    link->wake_fds[1] = -1;
+}
+
+/**
+ * @brief ホスト側としてリンクを作成する
+ */
+int shm_link_create(ShmLink *link) {
+    link->side = 0;
+    link->region = NULL;
+    link->memfd = memfd_create("tetris-shm-link", MFD_CLOEXEC);
+    link->wake_fds[0] = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    link->wake_fds[1] = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (link->memfd < 0 || link->wake_fds[0] < 0 || link->wake_fds[1] < 0 ||
+        ftruncate(link->memfd, sizeof(ShmRegion)) != 0 || !map_region(link)) {
+        close_fds(link);
+        return 0;
+    }
+
+    // ftruncate 直後の領域はゼロ埋めされているため、リングの位置とフラグは初期化済み
+    link->region->magic = SHM_LINK_MAGIC;
+    link->region->version = SHM_LINK_VERSION;
+    return 1;
+}
+
+/**
+ * @brief 接続済みの Unix ドメインソケットでリンクをゲストへ渡す (ホスト側)
+ */
+int shm_link_offer(const ShmLink *link, int sock) {
+    int fds[3] = {link->memfd, link->wake_fds[0], link->wake_fds[1]};
+    uint32_t magic = SHM_LINK_MAGIC;
+    return net_unix_send_fds(sock, fds, 3, &magic, sizeof(magic));
+}
+
+/**
+ * @brief 接続済みの Unix ドメインソケットからリンクを受け取る (ゲスト側)
+ */
+int shm_link_accept(ShmLink *link, int sock) {
+    int fds[3] = {-1, -1, -1};
+    int count = 0;
+    uint32_t magic = 0;
+    ssize_t n = net_unix_recv_fds(sock, fds, 3, &count, &magic, sizeof(magic));
+    if (n > 0 && count != 3) {
+        for (int i = 0; i < count; i++) {
+            close(fds[i]);
+            fds[i] = -1;
+        }
+    }
+
+    link->side = 1;
+    link->region = NULL;
+    link->memfd = fds[0];
+    link->wake_fds[0] = fds[1];
+    link->wake_fds[1] = fds[2];
+
+    struct stat st;
+    if (n != (ssize_t)sizeof(magic) || magic != SHM_LINK_MAGIC || fds[0] < 0 || fds[1] < 0 || fds[2] < 0 ||
+        fstat(link->memfd, &st) != 0 || (size_t)st.st_size < sizeof(ShmRegion) || !map_region(link)) {
+        close_fds(link);
+        return 0;
+    }
+    if (link->region->magic != SHM_LINK_MAGIC || link->region->version != SHM_LINK_VERSION) {
+        munmap(link->region, sizeof(ShmRegion));
+        link->region = NULL;
+        close_fds(link);
+        return 0;
+    }
+    return 1;
+}
+
+/**
+ * @brief eventfd に通知を書き込む
+ */
+static void wake(int fd) {
+    uint64_t one = 1;
+    ssize_t n;
+    do {
+        n = write(fd, &one, sizeof(one));
+    } while (n < 0 && errno == EINTR);
+}
+
+/**
+ * @brief eventfd の通知を読み捨てる
+ */
+static void drain(int fd) {
+    uint64_t value;
+    while (read(fd, &value, sizeof(value)) > 0) {
+    }
+}
+
+/**
+ * @brief リンクを閉じる (相手には切断として通知される)
+ */
+void shm_link_close(ShmLink *link) {
+    if (link->region) {
+        atomic_store_explicit(&link->region->rings[link->side].closed, 1, memory_order_release);
+        wake(link->wake_fds[link->side]);
+        munmap(link->region, sizeof(ShmRegion));
+        link->region = NULL;
+    }
+    close_fds(link);
+}
+
+/**
+ * @brief メッセージを送信する (ブロックしない)
+ */
+int shm_link_send(ShmLink *link, ShmMessageType type, uint32_t frame,
+                  const void *payload, uint16_t length) {
+    if (!link->region || length > SHM_LINK_PAYLOAD_MAX || (length && !payload)) {
+        return -1;
+    }
+    if (atomic_load_explicit(&link->region->rings[1 - link->side].closed, memory_order_acquire)) {
+        return -1;
+    }
+
+    ShmRing *ring = &link->region->rings[link->side];
+    uint32_t head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+    uint32_t tail = atomic_load_explicit(&ring->tail, memory_order_acquire);
+    if (head - tail >= SHM_LINK_SLOT_COUNT) {
+        return 0;
+    }
+
+    ShmMessage *slot = (ShmMessage*)ring->slots[head & SHM_SLOT_MASK];
+    slot->type = (uint16_t)type;
+    slot->length = length;
+    slot->frame = frame;
+    if (length) {
+        memcpy(slot->payload, payload, length);
+    }
+    atomic_store_explicit(&ring->head, head + 1, memory_order_release);
+
+    // 相手が待機中の場合のみ起床させる
+    atomic_thread_fence(memory_order_seq_cst);
+    if (atomic_load_explicit(&ring->waiting, memory_order_relaxed)) {
+        wake(link->wake_fds[link->side]);
+    }
+    return 1;
+}
+
+/**
+ * @brief 受信リングから1件取り出す
+ */
+static int try_pop(ShmRing *ring, ShmMessage *out) {
+    uint32_t tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+    uint32_t head = atomic_load_explicit(&ring->head, memory_order_acquire);
+    if (tail == head) {
+        return 0;
+    }
+
+    const ShmMessage *slot = (const ShmMessage*)ring->slots[tail & SHM_SLOT_MASK];
+    uint16_t length = slot->length <= SHM_LINK_PAYLOAD_MAX ? slot->length : SHM_LINK_PAYLOAD_MAX;
+    out->type = slot->type;
+    out->length = length;
+    out->frame = slot->frame;
+    memcpy(out->payload, slot->payload, length);
+    atomic_store_explicit(&ring->tail, tail + 1, memory_order_release);
+    return 1;
+}
+
+/**
+ * @brief 単調増加時刻 (ms)
+ */
+static int64_t now_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+/**
+ * @brief メッセージを受信する
+ */
+int shm_link_recv(ShmLink *link, ShmMessage *out, int timeout_ms) {
+    if (!link->region) {
+        return -1;
+    }
+    ShmRing *ring = &link->region->rings[1 - link->side];
+    int wake_fd = link->wake_fds[1 - link->side];
+
+    // shm_link_arm による待機要求は受信に来た時点で解除する
+    if (atomic_load_explicit(&ring->waiting, memory_order_relaxed)) {
+        atomic_store_explicit(&ring->waiting, 0, memory_order_relaxed);
+    }
+    if (try_pop(ring, out)) {
+        return 1;
+    }
+    if (timeout_ms == 0) {
+        return atomic_load_explicit(&ring->closed, memory_order_acquire) ? -1 : 0;
+    }
+
+    // 短時間スピンしてから眠る
+    for (int i = 0; i < SHM_LINK_SPIN_COUNT; i++) {
+        cpu_relax();
+        if (try_pop(ring, out)) {
+            return 1;
+        }
+    }
+
+    int64_t deadline = timeout_ms > 0 ? now_ms() + timeout_ms : 0;
+    for (;;) {
+        atomic_store_explicit(&ring->waiting, 1, memory_order_relaxed);
+        atomic_thread_fence(memory_order_seq_cst);
+        int got = try_pop(ring, out);
+        if (!got && !atomic_load_explicit(&ring->closed, memory_order_acquire)) {
+            int wait = -1;
+            if (timeout_ms > 0) {
+                int64_t left = deadline - now_ms();
+                wait = left > 0 ? (int)left : 0;
+            }
+            struct pollfd pfd = {wake_fd, POLLIN, 0};
+            if (wait != 0) {
+                poll(&pfd, 1, wait);
+            }
+            drain(wake_fd);
+            got = try_pop(ring, out);
+        }
+        atomic_store_explicit(&ring->waiting, 0, memory_order_relaxed);
+
+        if (got) {
+            return 1;
+        }
+        if (atomic_load_explicit(&ring->closed, memory_order_acquire)) {
+            return try_pop(ring, out) ? 1 : -1;
+        }
+        if (timeout_ms > 0 && now_ms() >= deadline) {
+            return 0;
+        }
+    }
+}
+
+/**
+ * @brief 受信待ちに使うファイル記述子を取得する
+ */
+int shm_link_wait_fd(const ShmLink *link) {
+    return link->wake_fds[1 - link->side];
+}
+
+/**
+ * @brief 外部のイベントループで待機する前に起床通知を要求する
+ */
+int shm_link_arm(ShmLink *link) {
+    if (!link->region) {
+        return 1;
+    }
+    ShmRing *ring = &link->region->rings[1 - link->side];
+    drain(link->wake_fds[1 - link->side]);
+    atomic_store_explicit(&ring->waiting, 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_seq_cst);
+    uint32_t tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+    uint32_t head = atomic_load_explicit(&ring->head, memory_order_acquire);
+    return head != tail || atomic_load_explicit(&ring->closed, memory_order_acquire);
+}
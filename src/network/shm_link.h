@@ -0,0 +1,129 @@
+/**
+ * @file shm_link.h
+ * @brief 共有メモリによるプロセス間ローカル対戦リンクの宣言
+ *
+ * このファイルは同一マシン上のゲームプロセス同士 (分割ターミナル、ボット対人間など) が
+ * ソケットを介さずに入力と状態をやり取りするためのリンクを宣言します。
+ * 主な機能:
+ *   - memfd 上の方向別 SPSC リングバッファ (単一生産者/単一消費者)
+ *   - eventfd による待機中の相手の起床
+ *   - Unix ドメインソケット経由でのファイル記述子の受け渡しによる接続確立
+ *
+ * 設計思想:
+ *   - 送受信の高速経路はシステムコールなし (相手が待機中のときのみ eventfd に書き込む)
+ *   - 受信側は短時間スピンしてから eventfd で待機し、遅延とCPU使用率を両立
+ *   - スロットは固定長でキャッシュラインに揃え、偽共有を避ける
+ *   - 1つのリンクは2プロセス間の双方向通信。3プロセス以上はホストが相手ごとにリンクを持つ
+ */
+
+#ifndef SHM_LINK_H
+#define SHM_LINK_H
+
+#include <stdint.h>
+
+#define SHM_LINK_SLOT_SIZE   256  /**< 1メッセージのスロットサイズ (バイト) */
+#define SHM_LINK_SLOT_COUNT  1024 /**< 1方向あたりのスロット数 (2のべき乗) */
+#define SHM_LINK_PAYLOAD_MAX (SHM_LINK_SLOT_SIZE - 8) /**< ペイロードの最大長 */
+#define SHM_LINK_SPIN_COUNT  2000 /**< 待機前にスピンする回数 */
+
+/**
+ * @brief メッセージ種別
+ */
+typedef enum {
+    SHM_MSG_INPUT,               /**< キー入力 */
+    SHM_MSG_STATE,               /**< 盤面とスコアの状態 */
+    SHM_MSG_GARBAGE,             /**< おじゃまライン */
+    SHM_MSG_CONTROL              /**< 開始/一時停止/終了などの制御 */
+} ShmMessageType;
+
+/**
+ * @brief リンク上のメッセージ
+ */
+typedef struct {
+    uint16_t type;               /**< ShmMessageType */
+    uint16_t length;             /**< ペイロード長 */
+    uint32_t frame;              /**< 送信側のフレーム番号 */
+    uint8_t payload[SHM_LINK_PAYLOAD_MAX]; /**< ペイロード */
+} ShmMessage;
+
+typedef struct ShmRegion ShmRegion;
+
+/**
+ * @brief リンクの端点
+ */
+typedef struct {
+    int memfd;                   /**< 共有メモリのファイル記述子 */
+    int wake_fds[2];             /**< 方向ごとの受信側起床用 eventfd */
+    ShmRegion* region;           /**< マップした共有メモリ */
+    int side;                    /**< 0: ホスト、1: ゲスト */
+} ShmLink;
+
+/**
+ * @brief ホスト側としてリンクを作成する
+ * @param link 初期化する端点
+ * @return 成功時1、失敗時0
+ */
+int shm_link_create(ShmLink *link);
+
+/**
+ * @brief 接続済みの Unix ドメインソケットでリンクをゲストへ渡す (ホスト側)
+ * @param link 作成済みの端点
+ * @param sock 接続済みの AF_UNIX ソケット
+ * @return 成功時1、失敗時0
+ */
+int shm_link_offer(const ShmLink *link, int sock);
+
+/**
+ * @brief 接続済みの Unix ドメインソケットからリンクを受け取る (ゲスト側)
+ * @param link 初期化する端点
+ * @param sock 接続済みの AF_UNIX ソケット
+ * @return 成功時1、失敗時0
+ */
+int shm_link_accept(ShmLink *link, int sock);
+
+/**
+ * @brief リンクを閉じる (相手には切断として通知される)
+ * @param link 閉じる端点
+ */
+void shm_link_close(ShmLink *link);
+
+/**
+ * @brief メッセージを送信する (ブロックしない)
+ * @param link 端点
+ * @param type メッセージ種別
+ * @param frame フレーム番号
+ * @param payload ペイロード (NULL可)
+ * @param length ペイロード長 (SHM_LINK_PAYLOAD_MAX 以下)
+ * @return 送信した場合1、リングが満杯の場合0、相手が切断済みまたは引数が不正な場合-1
+ */
+int shm_link_send(ShmLink *link, ShmMessageType type, uint32_t frame,
+                  const void *payload, uint16_t length);
+
+/**
+ * @brief メッセージを受信する
+ * @param link 端点
+ * @param out 受信したメッセージの出力先
+ * @param timeout_ms 待機時間 (0で待機しない、負で無期限)
+ * @return 受信した場合1、タイムアウトの場合0、相手が切断済みの場合-1
+ */
+int shm_link_recv(ShmLink *link, ShmMessage *out, int timeout_ms);
+
+/**
+ * @brief 受信待ちに使うファイル記述子を取得する (呼び出し側の poll/epoll 用)
+ *
+ * 待機の前に shm_link_arm を呼び、0が返った場合のみ待機してください。
+ * 読み込み可能になった後は shm_link_recv を0タイムアウトで呼び出してください。
+ *
+ * @param link 端点
+ * @return eventfd
+ */
+int shm_link_wait_fd(const ShmLink *link);
+
+/**
+ * @brief 外部のイベントループで待機する前に起床通知を要求する
+ * @param link 端点
+ * @return 既に受信可能なメッセージがある場合1 (待機不要)、無い場合0
+ */
+int shm_link_arm(ShmLink *link);
+
+#endif /* SHM_LINK_H */
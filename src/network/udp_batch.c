@@ -0,0 +1,187 @@
+/**
+ * @file udp_batch.c
+ * @brief UDP トランスポートの一括送受信の実装
+ *
+ * 主な機能:
+ *   - 受信/送信それぞれの mmsghdr、iovec、アドレス、本体の固定長配列
+ *   - 部分送信時の残りの再送と、送信バッファ満杯時の破棄
+ *
+ * 設計思想:
+ *   - mmsghdr と iovec の対応は作成時に一度だけ設定し、送受信のたびには長さのみ更新する
+ */
+
+#define _GNU_SOURCE // recvmmsg/sendmmsg と struct mmsghdr
+
+#include "udp_batch.h"
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * @brief 一括送受信器
+ */
+struct UdpBatch {
+    int fd;                      /**< UDP ソケット */
+    int capacity;                /**< 一括送受信数 */
+    int tx_count;                /**< 送信待ちの数 */
+    uint64_t dropped;            /**< 破棄した数 */
+    struct mmsghdr* rx_msgs;     /**< 受信のメッセージ */
+    struct iovec* rx_iov;        /**< 受信の本体 */
+    struct sockaddr_storage* rx_addr; /**< 受信の送信元 */
+    uint8_t* rx_buf;             /**< 受信の本体領域 */
+    struct mmsghdr* tx_msgs;     /**< 送信のメッセージ */
+    struct iovec* tx_iov;        /**< 送信の本体 */
+    struct sockaddr_storage* tx_addr; /**< 送信の宛先 */
+    uint8_t* tx_buf;             /**< 送信の本体領域 */
+};
+
+/**
+ * @brief 一括送受信器を作成する
+ */
+UdpBatch* udp_batch_create(int fd, int capacity) {
+    if (capacity <= 0) {
+        capacity = UDP_BATCH_DEFAULT_CAPACITY;
+    }
+    UdpBatch *batch = (UdpBatch*)calloc(1, sizeof(UdpBatch));
+    if (!batch) {
+        return NULL;
+    }
+    size_t n = (size_t)capacity;
+    batch->fd = fd;
+    batch->capacity = capacity;
+    batch->rx_msgs = (struct mmsghdr*)calloc(n, sizeof(struct mmsghdr));
+    batch->rx_iov = (struct iovec*)calloc(n, sizeof(struct iovec));
+    batch->rx_addr = (struct sockaddr_storage*)calloc(n, sizeof(struct sockaddr_storage));
+    batch->rx_buf = (uint8_t*)malloc(n * UDP_PACKET_MAX);
+    batch->tx_msgs = (struct mmsghdr*)calloc(n, sizeof(struct mmsghdr));
+    batch->tx_iov = (struct iovec*)calloc(n, sizeof(struct iovec));
+    batch->tx_addr = (struct sockaddr_storage*)calloc(n, sizeof(struct sockaddr_storage));
+    batch->tx_buf = (uint8_t*)malloc(n * UDP_PACKET_MAX);
+    if (!batch->rx_msgs || !batch->rx_iov || !batch->rx_addr || !batch->rx_buf ||
+        !batch->tx_msgs || !batch->tx_iov || !batch->tx_addr || !batch->tx_buf) {
+        udp_batch_destroy(batch);
+        return NULL;
+    }
+
+    for (int i = 0; i < capacity; i++) {
+        batch->rx_iov[i].iov_base = batch->rx_buf + (size_t)i * UDP_PACKET_MAX;
+        batch->rx_msgs[i].msg_hdr.msg_iov = &batch->rx_iov[i];
+        batch->rx_msgs[i].msg_hdr.msg_iovlen = 1;
+        batch->rx_msgs[i].msg_hdr.msg_name = &batch->rx_addr[i];
+        batch->tx_iov[i].iov_base = batch->tx_buf + (size_t)i * UDP_PACKET_MAX;
+        batch->tx_msgs[i].msg_hdr.msg_iov = &batch->tx_iov[i];
+        batch->tx_msgs[i].msg_hdr.msg_iovlen = 1;
+        batch->tx_msgs[i].msg_hdr.msg_name = &batch->tx_addr[i];
+    }
+    return batch;
+}
+
+/**
+ * @brief 一括送受信器を解放する
+ */
+void udp_batch_destroy(UdpBatch *batch) {
+    if (!batch) {
+        return;
+    }
+    free(batch->rx_msgs);
+    free(batch->rx_iov);
+    free(batch->rx_addr);
+    free(batch->rx_buf);
+    free(batch->tx_msgs);
+    free(batch->tx_iov);
+    free(batch->tx_addr);
+    free(batch->tx_buf);
+    free(batch);
+}
+
+/**
+ * @brief 届いているデータグラムをまとめて受信する
+ */
+int udp_batch_recv(UdpBatch *batch, UdpDatagram *out, int max) {
+    int want = max < batch->capacity ? max : batch->capacity;
+    if (want <= 0) {
+        return 0;
+    }
+    for (int i = 0; i < want; i++) {
+        struct msghdr *hdr = &batch->rx_msgs[i].msg_hdr;
+        batch->rx_iov[i].iov_len = UDP_PACKET_MAX;
+        hdr->msg_namelen = sizeof(struct sockaddr_storage);
+        hdr->msg_flags = 0;
+    }
+
+    int n;
+    do {
+        n = recvmmsg(batch->fd, batch->rx_msgs, (unsigned int)want, MSG_DONTWAIT, NULL);
+    } while (n < 0 && errno == EINTR);
+    if (n < 0) {
+        return (errno == EAGAIN || errno == EWOULDBLOCK) ? 0 : -1;
+    }
+
+    int count = 0;
+    for (int i = 0; i < n; i++) {
+        const struct msghdr *hdr = &batch->rx_msgs[i].msg_hdr;
+        if (hdr->msg_flags & MSG_TRUNC) {
+            continue; // 上限を超える長さのデータグラムはプロトコル違反として捨てる
+        }
+        out[count].data = (const uint8_t*)batch->rx_iov[i].iov_base;
+        out[count].len = batch->rx_msgs[i].msg_len;
+        out[count].addr = (const struct sockaddr*)hdr->msg_name;
+        out[count].addrlen = hdr->msg_namelen;
+        count++;
+    }
+    return count;
+}
+
+/**
+ * @brief データグラムを送信待ちに追加する
+ */
+int udp_batch_queue(UdpBatch *batch, const struct sockaddr *addr, socklen_t addrlen,
+                    const void *data, size_t len) {
+    if (len > UDP_PACKET_MAX || addrlen > sizeof(struct sockaddr_storage)) {
+        return 0;
+    }
+    if (batch->tx_count == batch->capacity) {
+        udp_batch_flush(batch);
+    }
+    int i = batch->tx_count++;
+    memcpy(&batch->tx_addr[i], addr, addrlen);
+    batch->tx_msgs[i].msg_hdr.msg_namelen = addrlen;
+    memcpy(batch->tx_iov[i].iov_base, data, len);
+    batch->tx_iov[i].iov_len = len;
+    return 1;
+}
+
+/**
+ * @brief 送信待ちのデータグラムをまとめて送信する
+ */
+int udp_batch_flush(UdpBatch *batch) {
+    int done = 0;      // 処理済み (送信または破棄) の数
+    int delivered = 0; // 送信できた数
+    while (done < batch->tx_count) {
+        int n = sendmmsg(batch->fd, batch->tx_msgs + done, (unsigned int)(batch->tx_count - done), MSG_DONTWAIT);
+        if (n > 0) {
+            done += n;
+            delivered += n;
+        } else if (n < 0 && errno == EINTR) {
+            continue;
+        } else if (n < 0 && errno != EAGAIN && errno != EWOULDBLOCK && errno != ENOBUFS) {
+            // 先頭のデータグラムのみの失敗 (宛先に届かないなど)。飛ばして続ける
+            batch->dropped++;
+            done++;
+        } else {
+            break; // 送信バッファが満杯
+        }
+    }
+    if (done < batch->tx_count) {
+        batch->dropped += (uint64_t)(batch->tx_count - done);
+    }
+    batch->tx_count = 0;
+    return delivered;
+}
+
+/**
+ * @brief 送信できずに破棄したデータグラムの数を取得する
+ */
+uint64_t udp_batch_dropped(const UdpBatch *batch) {
+    return batch->dropped;
+}
@@ -0,0 +1,88 @@
+/**
+ * @file udp_batch.h
+ * @brief UDP トランスポートの一括送受信の宣言
+ *
+ * このファイルは recvmmsg/sendmmsg により複数のデータグラムを
+ * 1回のシステムコールで送受信する機能を宣言します。
+ * 主な機能:
+ *   - 受信: 届いているデータグラムを最大 capacity 個まとめて取得
+ *   - 送信: ティック中の送信をためておき、ティックの終わりに一括送信
+ *
+ * 設計思想:
+ *   - シャードごとに1つ持ち、シャード上の全試合の送信を同じバッファに集めてから1回で流す
+ *   - データグラムの本体と宛先は固定長の領域にコピーし、送受信中の動的確保をなくす
+ *   - 送信できなかったデータグラムは UDP の性質どおり破棄し、件数のみ数える
+ */
+
+#ifndef UDP_BATCH_H
+#define UDP_BATCH_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/socket.h>
+
+#define UDP_BATCH_DEFAULT_CAPACITY 64   /**< 既定の一括送受信数 */
+#define UDP_PACKET_MAX             1200 /**< データグラムの最大長 (経路MTUを超えない値) */
+
+/**
+ * @brief 受信したデータグラム
+ */
+typedef struct {
+    const uint8_t* data;         /**< 本体 (次の udp_batch_recv まで有効) */
+    size_t len;                  /**< 本体の長さ */
+    const struct sockaddr* addr; /**< 送信元アドレス */
+    socklen_t addrlen;           /**< 送信元アドレスの長さ */
+} UdpDatagram;
+
+typedef struct UdpBatch UdpBatch;
+
+/**
+ * @brief 一括送受信器を作成する
+ * @param fd UDP ソケット (ノンブロッキングでなくてもよい)
+ * @param capacity 一括送受信数 (0で既定値)
+ * @return 作成した送受信器 (失敗時はNULL)
+ */
+UdpBatch* udp_batch_create(int fd, int capacity);
+
+/**
+ * @brief 一括送受信器を解放する (未送信のデータグラムは破棄)
+ * @param batch 解放する送受信器 (NULL可)
+ */
+void udp_batch_destroy(UdpBatch *batch);
+
+/**
+ * @brief 届いているデータグラムをまとめて受信する (ブロックしない)
+ * @param batch 対象の送受信器
+ * @param out 出力先
+ * @param max 出力先の要素数
+ * @return 受信した数 (失敗時-1)
+ */
+int udp_batch_recv(UdpBatch *batch, UdpDatagram *out, int max);
+
+/**
+ * @brief データグラムを送信待ちに追加する (満杯の場合は先に一括送信する)
+ * @param batch 対象の送受信器
+ * @param addr 宛先アドレス
+ * @param addrlen 宛先アドレスの長さ
+ * @param data 本体
+ * @param len 本体の長さ (UDP_PACKET_MAX 以下)
+ * @return 成功時1、引数が不正な場合0
+ */
+int udp_batch_queue(UdpBatch *batch, const struct sockaddr *addr, socklen_t addrlen,
+                    const void *data, size_t len);
+
+/**
+ * @brief 送信待ちのデータグラムをまとめて送信する (ティックの終わりに呼び出す)
+ * @param batch 対象の送受信器
+ * @return 送信できた数 (破棄したデータグラムは含まない)
+ */
+int udp_batch_flush(UdpBatch *batch);
+
+/**
+ * @brief 送信できずに破棄したデータグラムの数を取得する
+ * @param batch 対象の送受信器
+ * @return 破棄した数
+ */
+uint64_t udp_batch_dropped(const UdpBatch *batch);
+
+#endif /* UDP_BATCH_H */
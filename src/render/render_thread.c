@@ -0,0 +1,393 @@
+/**
+ * @file render_thread.c
+ * @brief 描画スレッドとフレーム受け渡しの実装
+ *
+ * 主な機能:
+ *   - 3枚のフレームと「中央」インデックスの交換によるトリプルバッファ
+ *   - 公開の通番に対する futex 待機による描画スレッドの起床
+ *   - 盤面、テトリミノ、ゴーストの合成と、前回描画との差分出力
+ *
+ * 設計思想:
+ *   - 中央インデックスの最上位ビットを「未読」印とし、交換1回で受け渡しを完結させる
+ *   - 起床は Dekker 型: 公開側は通番更新後、描画側は待機フラグ設定後に全順序フェンスを挟んで相手を確認
+ *   - 出力は1フレーム分をバッファにまとめて書き、端末への write 回数を最小にする
+ */
+
+#define _GNU_SOURCE // syscall
+
+#include "render_thread.h"
+#include "../game/piece.h"
+#include <errno.h>
+#include <linux/futex.h>
+#include <poll.h>
+#include <pthread.h>
+#include <stdarg.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+
+#define RENDER_DIRTY       0x80u  /**< 中央のフレームが未読 */
+#define RENDER_INDEX_MASK  0x03u  /**< フレーム番号の取り出し */
+#define RENDER_OUT_SIZE    16384  /**< 1フレーム分の出力バッファ */
+#define RENDER_IDLE_MS     100    /**< 公開が無い場合の待機上限 (終了確認用) */
+#define RENDER_PANEL_COL   26     /**< 情報欄の表示列 */
+
+/* テトリミノの種類ごとの背景色 (RENDER_CELL_* の値で引く) */
+static const char *const CELL_STYLE[RENDER_CELL_GHOST + 1] = {
+    "\x1b[0m",                   /* 空き */
+    "\x1b[0;46m",                /* I: シアン */
+    "\x1b[0;43m",                /* O: 黄 */
+    "\x1b[0;42m",                /* S: 緑 */
+    "\x1b[0;41m",                /* Z: 赤 */
+    "\x1b[0;44m",                /* J: 青 */
+    "\x1b[0;48;5;208m",          /* L: 橙 */
+    "\x1b[0;45m",                /* T: 紫 */
+    "\x1b[0;2m",                 /* ゴースト */
+};
+
+/**
+ * @brief 描画スレッド
+ */
+struct RenderThread {
+    RenderFrame frames[3];       /**< トリプルバッファ */
+    uint32_t back;               /**< ゲームスレッドが書き込み中のフレーム */
+    uint32_t front;              /**< 描画スレッドが読んでいるフレーム */
+    _Alignas(64) _Atomic uint32_t middle; /**< 受け渡し中のフレーム | RENDER_DIRTY */
+    _Atomic uint32_t seq;        /**< 公開の通番 (futex) */
+    _Atomic int sleeping;        /**< 描画スレッドが待機中 */
+    _Atomic int running;         /**< 実行中フラグ */
+    _Atomic int invalidated;     /**< 全体の描き直し要求 */
+    _Alignas(64) int out_fd;     /**< 描画先 */
+    pthread_t thread;            /**< 描画スレッド */
+    char out[RENDER_OUT_SIZE];   /**< 出力バッファ */
+    size_t out_len;              /**< 出力バッファの使用量 */
+    int style;                   /**< 出力中の色 (-1で未設定) */
+    int drawn;                   /**< 前回の描画内容が有効 */
+    uint8_t cells[BOARD_SIZE];   /**< 前回描画したセル */
+    RenderFrame last;            /**< 前回描画したフレーム */
+};
+
+static long futex(_Atomic uint32_t *addr, int op, uint32_t val, const struct timespec *timeout) {
+    return syscall(SYS_futex, (uint32_t*)addr, op, val, timeout, NULL, 0);
+}
+
+/**
+ * @brief 出力バッファに文字列を追加する
+ */
+static void emit(RenderThread *rt, const char *s, size_t len) {
+    if (rt->out_len + len <= sizeof(rt->out)) {
+        memcpy(rt->out + rt->out_len, s, len);
+        rt->out_len += len;
+    }
+}
+
+static void emitf(RenderThread *rt, const char *fmt, ...) {
+    char tmp[64];
+    va_list ap;
+    va_start(ap, fmt);
+    int n = vsnprintf(tmp, sizeof(tmp), fmt, ap);
+    va_end(ap);
+    if (n > 0) {
+        emit(rt, tmp, (size_t)n);
+    }
+}
+
+static void set_style(RenderThread *rt, int style) {
+    if (rt->style != style) {
+        emit(rt, CELL_STYLE[style], strlen(CELL_STYLE[style]));
+        rt->style = style;
+    }
+}
+
+/**
+ * @brief 出力バッファを端末へ書き出す (部分書き込みとノンブロッキングに対応)
+ */
+static void flush_out(RenderThread *rt) {
+    size_t done = 0;
+    while (done < rt->out_len) {
+        ssize_t n = write(rt->out_fd, rt->out + done, rt->out_len - done);
+        if (n > 0) {
+            done += (size_t)n;
+        } else if (n < 0 && errno == EAGAIN) {
+            struct pollfd pfd = {rt->out_fd, POLLOUT, 0};
+            poll(&pfd, 1, RENDER_IDLE_MS);
+        } else if (n < 0 && errno == EINTR) {
+            continue;
+        } else {
+            break; // 端末が閉じられた
+        }
+    }
+    rt->out_len = 0;
+}
+
+/**
+ * @brief テトリミノとゴーストを盤面に合成する
+ */
+static void compose(const RenderFrame *frame, uint8_t *cells) {
+    for (int i = 0; i < BOARD_SIZE; i++) {
+        cells[i] = frame->grid[i] ? (uint8_t)((frame->grid[i] - 1) % TETROMINO_COUNT + 1) : RENDER_CELL_EMPTY;
+    }
+    if (!frame->has_piece || frame->piece_type >= TETROMINO_COUNT) {
+        return;
+    }
+    const int (*shape)[4] = TETROMINO_SHAPES[frame->piece_type][frame->piece_rotation & 3];
+    for (int pass = 0; pass < 2; pass++) {
+        int top = pass == 0 ? frame->ghost_y : frame->piece_y;
+        uint8_t value = pass == 0 ? RENDER_CELL_GHOST : (uint8_t)(frame->piece_type + 1);
+        for (int r = 0; r < TETROMINO_SIZE; r++) {
+            for (int c = 0; c < TETROMINO_SIZE; c++) {
+                int x = frame->piece_x + c;
+                int y = top + r;
+                if (shape[r][c] && x >= 0 && x < BOARD_WIDTH && y >= 0 && y < BOARD_HEIGHT) {
+                    cells[y * BOARD_WIDTH + x] = value;
+                }
+            }
+        }
+    }
+}
+
+/**
+ * @brief 枠と見出しを描く (全体の描き直し時)
+ */
+static void draw_frame_border(RenderThread *rt) {
+    emit(rt, "\x1b[0m\x1b[2J\x1b[?25l", 14);
+    rt->style = RENDER_CELL_EMPTY;
+    for (int y = 0; y <= BOARD_HEIGHT + 1; y++) {
+        emitf(rt, "\x1b[%d;%dH", y + 1, 1);
+        if (y == 0 || y == BOARD_HEIGHT + 1) {
+            emit(rt, "+--------------------+", 2 + BOARD_WIDTH * 2);
+        } else {
+            emit(rt, "|", 1);
+            emitf(rt, "\x1b[%d;%dH", y + 1, 2 + BOARD_WIDTH * 2);
+            emit(rt, "|", 1);
+        }
+    }
+    emitf(rt, "\x1b[%d;%dHNEXT", 8, RENDER_PANEL_COL);
+}
+
+/**
+ * @brief 情報欄 (スコア、次のテトリミノ、状態) を描く
+ */
+static void draw_panel(RenderThread *rt, const RenderFrame *frame, int full) {
+    const RenderFrame *last = &rt->last;
+    set_style(rt, RENDER_CELL_EMPTY);
+    if (full || frame->score != last->score) {
+        emitf(rt, "\x1b[%d;%dHSCORE %-10d", 2, RENDER_PANEL_COL, frame->score);
+    }
+    if (full || frame->level != last->level) {
+        emitf(rt, "\x1b[%d;%dHLEVEL %-10d", 4, RENDER_PANEL_COL, frame->level);
+    }
+    if (full || frame->lines != last->lines) {
+        emitf(rt, "\x1b[%d;%dHLINES %-10d", 6, RENDER_PANEL_COL, frame->lines);
+    }
+    if (full || frame->next_type != last->next_type) {
+        int type = frame->next_type < TETROMINO_COUNT ? frame->next_type : -1;
+        for (int r = 0; r < TETROMINO_SIZE; r++) {
+            emitf(rt, "\x1b[%d;%dH", 9 + r, RENDER_PANEL_COL);
+            for (int c = 0; c < TETROMINO_SIZE; c++) {
+                set_style(rt, (type >= 0 && TETROMINO_SHAPES[type][0][r][c]) ? type + 1 : RENDER_CELL_EMPTY);
+                emit(rt, "  ", 2);
+            }
+        }
+        set_style(rt, RENDER_CELL_EMPTY);
+    }
+    if (full || frame->state != last->state) {
+        const char *label = frame->state == GAME_STATE_PAUSED    ? "PAUSED   " :
+                            frame->state == GAME_STATE_GAME_OVER ? "GAME OVER" :
+                            frame->state == GAME_STATE_ANALYSIS  ? "ANALYSIS " : "         ";
+        emitf(rt, "\x1b[%d;%dH", 15, RENDER_PANEL_COL);
+        emit(rt, label, strlen(label));
+    }
+}
+
+/**
+ * @brief フレームを描画する (前回との差分のみ出力)
+ */
+static void draw(RenderThread *rt, const RenderFrame *frame) {
+    uint8_t cells[BOARD_SIZE];
+    compose(frame, cells);
+
+    int full = !rt->drawn || atomic_exchange_explicit(&rt->invalidated, 0, memory_order_acquire);
+    if (full) {
+        draw_frame_border(rt);
+    }
+
+    int cursor = -1; // 直前に出力したセルの次の位置
+    for (int i = 0; i < BOARD_SIZE; i++) {
+        if (!full && cells[i] == rt->cells[i]) {
+            continue;
+        }
+        if (cursor != i || i % BOARD_WIDTH == 0) {
+            emitf(rt, "\x1b[%d;%dH", i / BOARD_WIDTH + 2, (i % BOARD_WIDTH) * 2 + 2);
+        }
+        set_style(rt, cells[i]);
+        emit(rt, cells[i] == RENDER_CELL_GHOST ? "[]" : "  ", 2);
+        cursor = i + 1;
+    }
+
+    draw_panel(rt, frame, full);
+    if (rt->out_len > 0) {
+        emitf(rt, "\x1b[%d;%dH", BOARD_HEIGHT + 3, 1); // カーソルを盤面の下へ退避
+        flush_out(rt);
+    }
+    memcpy(rt->cells, cells, sizeof(cells));
+    rt->last = *frame;
+    rt->drawn = 1;
+}
+
+/**
+ * @brief 描画スレッドの本体
+ */
+static void* render_main(void *arg) {
+    RenderThread *rt = (RenderThread*)arg;
+    for (;;) {
+        uint32_t seq = atomic_load_explicit(&rt->seq, memory_order_acquire);
+        if (atomic_load_explicit(&rt->middle, memory_order_relaxed) & RENDER_DIRTY) {
+            uint32_t prev = atomic_exchange_explicit(&rt->middle, rt->front, memory_order_acq_rel);
+            rt->front = prev & RENDER_INDEX_MASK;
+            draw(rt, &rt->frames[rt->front]);
+            continue;
+        }
+        if (!atomic_load_explicit(&rt->running, memory_order_acquire)) {
+            break;
+        }
+
+        atomic_store_explicit(&rt->sleeping, 1, memory_order_relaxed);
+        atomic_thread_fence(memory_order_seq_cst);
+        if (!(atomic_load_explicit(&rt->middle, memory_order_relaxed) & RENDER_DIRTY) &&
+            atomic_load_explicit(&rt->running, memory_order_relaxed)) {
+            struct timespec timeout = {0, RENDER_IDLE_MS * 1000000L};
+            futex(&rt->seq, FUTEX_WAIT_PRIVATE, seq, &timeout);
+        }
+        atomic_store_explicit(&rt->sleeping, 0, memory_order_relaxed);
+    }
+
+    set_style(rt, RENDER_CELL_EMPTY);
+    emit(rt, "\x1b[?25h", 6);
+    flush_out(rt);
+    return NULL;
+}
+
+/**
+ * @brief 描画スレッドを開始する
+ */
+RenderThread* render_thread_create(int out_fd) {
+    RenderThread *rt = (RenderThread*)aligned_alloc(64, (sizeof(RenderThread) + 63) & ~(size_t)63);
+    if (!rt) {
+        return NULL;
+    }
+    memset(rt, 0, sizeof(*rt));
+    rt->out_fd = out_fd;
+    rt->back = 0;
+    atomic_init(&rt->middle, 1);
+    rt->front = 2;
+    rt->style = -1;
+    atomic_init(&rt->running, 1);
+
+    if (pthread_create(&rt->thread, NULL, render_main, rt) != 0) {
+        free(rt);
+        return NULL;
+    }
+    return rt;
+}
+
+/**
+ * @brief 描画スレッドを終了して解放する
+ */
+void render_thread_destroy(RenderThread *rt) {
+    if (!rt) {
+        return;
+    }
+    atomic_store_explicit(&rt->running, 0, memory_order_release);
+    atomic_fetch_add_explicit(&rt->seq, 1, memory_order_release);
+    futex(&rt->seq, FUTEX_WAKE_PRIVATE, 1, NULL);
+    pthread_join(rt->thread, NULL);
+    free(rt);
+}
+
+/**
+ * @brief 次に公開するフレームの書き込み先を取得する
+ */
+RenderFrame* render_thread_acquire(RenderThread *rt) {
+    return &rt->frames[rt->back];
+}
+
+/**
+ * @brief 書き込んだフレームを公開する
+ */
+void render_thread_publish(RenderThread *rt) {
+    uint32_t prev = atomic_exchange_explicit(&rt->middle, rt->back | RENDER_DIRTY, memory_order_acq_rel);
+    rt->back = prev & RENDER_INDEX_MASK;
+    atomic_fetch_add_explicit(&rt->seq, 1, memory_order_release);
+    atomic_thread_fence(memory_order_seq_cst);
+    if (atomic_load_explicit(&rt->sleeping, memory_order_relaxed)) {
+        futex(&rt->seq, FUTEX_WAKE_PRIVATE, 1, NULL);
+    }
+}
+
+/**
+ * @brief 次のフレームで画面全体を描き直す
+ */
+void render_thread_invalidate(RenderThread *rt) {
+    atomic_store_explicit(&rt->invalidated, 1, memory_order_release);
+}
+
+/**
+ * @brief テトリミノが盤面と重なるか判定する (ゴースト位置の計算用)
+ */
+static int piece_blocked(const RenderFrame *frame, int top) {
+    const int (*shape)[4] = TETROMINO_SHAPES[frame->piece_type][frame->piece_rotation & 3];
+    for (int r = 0; r < TETROMINO_SIZE; r++) {
+        for (int c = 0; c < TETROMINO_SIZE; c++) {
+            if (!shape[r][c]) {
+                continue;
+            }
+            int x = frame->piece_x + c;
+            int y = top + r;
+            if (x < 0 || x >= BOARD_WIDTH || y >= BOARD_HEIGHT) {
+                return 1;
+            }
+            if (y >= 0 && frame->grid[y * BOARD_WIDTH + x]) {
+                return 1;
+            }
+        }
+    }
+    return 0;
+}
+
+/**
+ * @brief ゲーム状態から描画用のフレームを作成する
+ */
+void render_frame_capture(RenderFrame *out, const GamePlayContext *gameplay, GameState state, uint32_t frame) {
+    const Board *board = gameplay->board;
+    const Piece *piece = &gameplay->current_piece;
+
+    out->frame = frame;
+    out->state = (uint8_t)state;
+    if (board && board->grid && board->width * board->height == BOARD_SIZE) {
+        memcpy(out->grid, board->grid, BOARD_SIZE);
+    } else {
+        memset(out->grid, 0, BOARD_SIZE);
+    }
+    out->score = gameplay->score.score;
+    out->level = gameplay->score.level;
+    out->lines = gameplay->score.lines_cleared;
+    out->next_type = (uint8_t)gameplay->next_piece.type;
+
+    out->has_piece = (state == GAME_STATE_PLAYING || state == GAME_STATE_PAUSED ||
+                      state == GAME_STATE_ANALYSIS) && (unsigned)piece->type < TETROMINO_COUNT;
+    out->piece_type = (uint8_t)piece->type;
+    out->piece_rotation = (uint8_t)(piece->rotation & 3);
+    out->piece_x = (int8_t)piece->x;
+    out->piece_y = (int8_t)piece->y;
+    out->ghost_y = out->piece_y;
+    if (out->has_piece) {
+        while (out->ghost_y < BOARD_HEIGHT && !piece_blocked(out, out->ghost_y + 1)) {
+            out->ghost_y++;
+        }
+    }
+}
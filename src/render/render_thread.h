@@ -0,0 +1,90 @@
+/**
+ * @file render_thread.h
+ * @brief 描画スレッドとフレーム受け渡しの宣言
+ *
+ * このファイルはシミュレーションと描画を別スレッドで実行するための機能を宣言します。
+ * 主な機能:
+ *   - 描画用の不変なフレーム (盤面、テトリミノ、ゴースト、次のテトリミノ、スコア)
+ *   - ロックフリーなトリプルバッファによる最新フレームの受け渡し
+ *   - 端末へのANSIエスケープシーケンスによる差分描画
+ *
+ * 設計思想:
+ *   - ゲームスレッドは公開でブロックしない (描画スレッドが眠っている場合のみ起床のシステムコール)
+ *   - 描画スレッドは常に最新のフレームのみ描き、遅い端末では中間のフレームを読み飛ばす
+ *   - 描画の write はすべて描画スレッドで行い、SSH越しの遅延が落下や入力処理を止めない
+ *   - 前回描いた内容との差分のみ出力し、回線に送るバイト数を抑える
+ */
+
+#ifndef RENDER_THREAD_H
+#define RENDER_THREAD_H
+
+#include "../game/game_defs.h"
+
+#define RENDER_CELL_EMPTY 0 /**< 空きセル */
+#define RENDER_CELL_GHOST 8 /**< ゴーストのセル (1-7はテトリミノの種類+1) */
+
+/**
+ * @brief 描画用のフレーム
+ *
+ * ゲームスレッドが書き込み、公開後は描画スレッドのみが読む不変な状態です。
+ */
+typedef struct {
+    uint32_t frame;              /**< フレーム番号 */
+    uint8_t state;               /**< GameState */
+    uint8_t has_piece;           /**< 操作中のテトリミノがある */
+    uint8_t piece_type;          /**< 操作中のテトリミノの種類 */
+    uint8_t piece_rotation;      /**< 操作中のテトリミノの回転状態 */
+    int8_t piece_x;              /**< 操作中のテトリミノのX位置 */
+    int8_t piece_y;              /**< 操作中のテトリミノのY位置 */
+    int8_t ghost_y;              /**< ゴーストのY位置 */
+    uint8_t next_type;           /**< 次のテトリミノの種類 */
+    int score;                   /**< スコア */
+    int level;                   /**< レベル */
+    int lines;                   /**< 消去したライン数 */
+    uint8_t grid[BOARD_SIZE];    /**< 固定済みのブロック */
+} RenderFrame;
+
+typedef struct RenderThread RenderThread;
+
+/**
+ * @brief 描画スレッドを開始する
+ * @param out_fd 描画先の端末のファイル記述子
+ * @return 開始した描画スレッド (失敗時はNULL)
+ */
+RenderThread* render_thread_create(int out_fd);
+
+/**
+ * @brief 描画スレッドを終了して解放する (描画中のフレームの完了を待つ)
+ * @param rt 対象の描画スレッド (NULL可)
+ */
+void render_thread_destroy(RenderThread *rt);
+
+/**
+ * @brief 次に公開するフレームの書き込み先を取得する (ゲームスレッド専用)
+ * @param rt 対象の描画スレッド
+ * @return 書き込み先のフレーム (render_thread_publish まで有効)
+ */
+RenderFrame* render_thread_acquire(RenderThread *rt);
+
+/**
+ * @brief 書き込んだフレームを公開する (ゲームスレッド専用、ブロックしない)
+ * @param rt 対象の描画スレッド
+ */
+void render_thread_publish(RenderThread *rt);
+
+/**
+ * @brief 次のフレームで画面全体を描き直す (端末のサイズ変更後など)
+ * @param rt 対象の描画スレッド
+ */
+void render_thread_invalidate(RenderThread *rt);
+
+/**
+ * @brief ゲーム状態から描画用のフレームを作成する (ゴースト位置もここで求める)
+ * @param out 出力先
+ * @param gameplay 対象のコンテキスト
+ * @param state ゲームの実行状態
+ * @param frame フレーム番号
+ */
+void render_frame_capture(RenderFrame *out, const GamePlayContext *gameplay, GameState state, uint32_t frame);
+
+#endif /* RENDER_THREAD_H */
@@ -0,0 +1,288 @@
+/**
+ * @file affinity.c
+ * @brief スレッドの CPU 固定と NUMA を考慮した配置の実装
+ *
+ * 主な機能:
+ *   - /sys/devices/system/node/nodeN/cpulist の読み込み
+ *   - シャードのノードへの均等な割り当てとノード内の CPU の順番の割り当て
+ *   - pthread_setaffinity_np による呼び出しスレッドの固定
+ *
+ * 設計思想:
+ *   - シャードはノードを順番に巡って割り当て、各ノードの負荷とメモリ使用量を揃える
+ *   - シャード数が CPU 数を超える場合は同じ CPU を再利用する (固定しないよりは良い)
+ */
+
+#define _GNU_SOURCE // cpu_set_t、sched_getaffinity、pthread_setaffinity_np
+
+#include "affinity.h"
+#include <ctype.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define AFFINITY_SYSFS_NODE "/sys/devices/system/node/node%d/cpulist"
+
+/**
+ * @brief CPU リスト文字列を解析する
+ */
+int affinity_parse_cpulist(const char *list, cpu_set_t *out) {
+    CPU_ZERO(out);
+    if (!list) {
+        return 0;
+    }
+    const char *p = list;
+    while (*p) {
+        while (isspace((unsigned char)*p) || *p == ',') {
+            p++;
+        }
+        if (!*p) {
+            break;
+        }
+        char *end;
+        long first = strtol(p, &end, 10);
+        if (end == p) {
+            return 0;
+        }
+        long last = first;
+        p = end;
+        if (*p == '-') {
+            p++;
+            last = strtol(p, &end, 10);
+            if (end == p) {
+                return 0;
+            }
+            p = end;
+        }
+        if (first < 0 || last < first || last >= CPU_SETSIZE) {
+            return 0;
+        }
+        for (long cpu = first; cpu <= last; cpu++) {
+            CPU_SET((int)cpu, out);
+        }
+        while (isspace((unsigned char)*p)) {
+            p++;
+        }
+        if (*p && *p != ',') {
+            return 0;
+        }
+    }
+    return CPU_COUNT(out) > 0;
+}
+
+/**
+ * @brief CPU と NUMA ノードの対応を読み込む
+ */
+void affinity_topology_load(CpuTopology *topo) {
+    for (int i = 0; i < CPU_SETSIZE; i++) {
+        topo->cpu_node[i] = -1;
+    }
+    topo->node_count = 0;
+
+    for (int node = 0; node < AFFINITY_MAX_NODES; node++) {
+        char path[64];
+        char line[4096];
+        snprintf(path, sizeof(path), AFFINITY_SYSFS_NODE, node);
+        FILE *f = fopen(path, "r");
+        if (!f) {
+            continue; // ノード番号は飛びうる
+        }
+        cpu_set_t set;
+        if (fgets(line, sizeof(line), f) && affinity_parse_cpulist(line, &set)) {
+            for (int cpu = 0; cpu < CPU_SETSIZE; cpu++) {
+                if (CPU_ISSET(cpu, &set)) {
+                    topo->cpu_node[cpu] = (int16_t)node;
+                }
+            }
+            topo->node_count = node + 1;
+        }
+        fclose(f);
+    }
+
+    if (topo->node_count == 0) {
+        // NUMA 情報が無い: 使える CPU をすべてノード0とする
+        cpu_set_t set;
+        if (sched_getaffinity(0, sizeof(set), &set) != 0) {
+            CPU_ZERO(&set);
+            CPU_SET(0, &set);
+        }
+        for (int cpu = 0; cpu < CPU_SETSIZE; cpu++) {
+            if (CPU_ISSET(cpu, &set)) {
+                topo->cpu_node[cpu] = 0;
+            }
+        }
+        topo->node_count = 1;
+    }
+}
+
+/**
+ * @brief ノードが不明な CPU をノード0として扱う
+ */
+static int node_of(const CpuTopology *topo, int cpu) {
+    return topo->cpu_node[cpu] >= 0 ? topo->cpu_node[cpu] : 0;
+}
+
+/**
+ * @brief シャード用 CPU のうち、ノード内で k 番目の CPU を探す
+ */
+static int nth_cpu_on_node(const AffinityPlan *plan, const CpuTopology *topo, int node, int k) {
+    for (int cpu = 0; cpu < CPU_SETSIZE; cpu++) {
+        if (CPU_ISSET(cpu, &plan->shard_cpus) && node_of(topo, cpu) == node && k-- == 0) {
+            return cpu;
+        }
+    }
+    return -1;
+}
+
+/**
+ * @brief シャードに CPU とノードを割り当てる
+ */
+static void assign_shards(AffinityPlan *plan, const CpuTopology *topo) {
+    int node_size[AFFINITY_MAX_NODES] = {0};
+    int nodes[AFFINITY_MAX_NODES];
+    int node_count = 0;
+
+    for (int cpu = 0; cpu < CPU_SETSIZE; cpu++) {
+        if (!CPU_ISSET(cpu, &plan->shard_cpus)) {
+            continue;
+        }
+        int node = node_of(topo, cpu);
+        if (node_size[node]++ == 0) {
+            nodes[node_count++] = node;
+        }
+    }
+
+    for (int i = 0; i < plan->shard_count; i++) {
+        int node = nodes[i % node_count];
+        int k = (i / node_count) % node_size[node];
+        plan->shard_cpu[i] = nth_cpu_on_node(plan, topo, node, k);
+        plan->shard_node[i] = node;
+    }
+}
+
+/**
+ * @brief AI ワーカー用 CPU をノードごとに分ける
+ */
+static void split_ai_nodes(AffinityPlan *plan, const CpuTopology *topo) {
+    plan->ai_node_count = 0;
+    for (int node = 0; node < AFFINITY_MAX_NODES; node++) {
+        CPU_ZERO(&plan->ai_node_cpus[node]);
+    }
+    for (int cpu = 0; cpu < CPU_SETSIZE; cpu++) {
+        if (CPU_ISSET(cpu, &plan->ai_cpus)) {
+            CPU_SET(cpu, &plan->ai_node_cpus[node_of(topo, cpu)]);
+        }
+    }
+    for (int node = 0; node < AFFINITY_MAX_NODES; node++) {
+        if (CPU_COUNT(&plan->ai_node_cpus[node]) > 0) {
+            plan->ai_nodes[plan->ai_node_count++] = node;
+        }
+    }
+}
+
+/**
+ * @brief 配置計画を作成する
+ */
+int affinity_plan_build(AffinityPlan *plan, const CpuTopology *topo,
+                        const char *shard_list, const char *ai_list, int shard_count) {
+    memset(plan, 0, sizeof(*plan));
+    if (shard_count < 1 || shard_count > AFFINITY_MAX_SHARDS) {
+        return 0;
+    }
+    plan->shard_count = shard_count;
+
+    cpu_set_t allowed;
+    if (sched_getaffinity(0, sizeof(allowed), &allowed) != 0) {
+        return 0;
+    }
+
+    if (shard_list) {
+        if (!affinity_parse_cpulist(shard_list, &plan->shard_cpus)) {
+            return 0;
+        }
+        CPU_AND(&plan->shard_cpus, &plan->shard_cpus, &allowed);
+    } else {
+        plan->shard_cpus = allowed;
+    }
+    if (CPU_COUNT(&plan->shard_cpus) == 0) {
+        return 0;
+    }
+
+    cpu_set_t ai_base;
+    if (ai_list) {
+        if (!affinity_parse_cpulist(ai_list, &ai_base)) {
+            return 0;
+        }
+        CPU_AND(&ai_base, &ai_base, &allowed);
+        if (CPU_COUNT(&ai_base) == 0) {
+            return 0;
+        }
+    } else {
+        ai_base = allowed;
+    }
+
+    // シャード用の CPU は実際にシャードを固定した CPU に絞る (残りは AI ワーカーに回す)
+    assign_shards(plan, topo);
+    CPU_ZERO(&plan->shard_cpus);
+    for (int i = 0; i < plan->shard_count; i++) {
+        CPU_SET(plan->shard_cpu[i], &plan->shard_cpus);
+    }
+
+    // AI ワーカーがシャードのコアを奪わないよう、シャード用の CPU を除く
+    for (int cpu = 0; cpu < CPU_SETSIZE; cpu++) {
+        if (CPU_ISSET(cpu, &ai_base) && !CPU_ISSET(cpu, &plan->shard_cpus)) {
+            CPU_SET(cpu, &plan->ai_cpus);
+        }
+    }
+    if (CPU_COUNT(&plan->ai_cpus) == 0) {
+        plan->ai_cpus = ai_base;
+        plan->ai_shared = 1;
+    }
+
+    split_ai_nodes(plan, topo);
+    return 1;
+}
+
+/**
+ * @brief シャードの NUMA ノードを取得する
+ */
+int affinity_shard_node(const AffinityPlan *plan, int shard) {
+    if (shard < 0 || shard >= plan->shard_count) {
+        return 0;
+    }
+    return plan->shard_node[shard];
+}
+
+/**
+ * @brief AI ワーカーの NUMA ノードを取得する
+ */
+int affinity_ai_worker_node(const AffinityPlan *plan, int worker) {
+    if (plan->ai_node_count == 0 || worker < 0) {
+        return 0;
+    }
+    return plan->ai_nodes[worker % plan->ai_node_count];
+}
+
+/**
+ * @brief 呼び出しスレッドをシャードの CPU に固定する
+ */
+int affinity_pin_shard(const AffinityPlan *plan, int shard) {
+    if (shard < 0 || shard >= plan->shard_count) {
+        return 0;
+    }
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(plan->shard_cpu[shard], &set);
+    return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+}
+
+/**
+ * @brief 呼び出しスレッドを AI ワーカーの CPU 集合に固定する
+ */
+int affinity_pin_ai_worker(const AffinityPlan *plan, int worker) {
+    if (plan->ai_node_count == 0 || worker < 0) {
+        return 0;
+    }
+    int node = affinity_ai_worker_node(plan, worker);
+    return pthread_setaffinity_np(pthread_self(), sizeof(cpu_set_t), &plan->ai_node_cpus[node]) == 0;
+}
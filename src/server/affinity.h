@@ -0,0 +1,117 @@
+/**
+ * @file affinity.h
+ * @brief スレッドの CPU 固定と NUMA を考慮した配置の宣言
+ *
+ * このファイルはイベントループのシャードと AI ワーカーのスレッドを
+ * 設定されたコアに固定し、メモリを同じ NUMA ノードに置くための配置計画を宣言します。
+ * 主な機能:
+ *   - CPU リスト文字列 ("0-7,16-23" 形式) の解析
+ *   - sysfs からの CPU と NUMA ノードの対応の読み込み
+ *   - シャードごとの CPU とノードの割り当て (ノード間で均等に分散)
+ *   - AI ワーカー用 CPU のシャード用 CPU からの分離
+ *   - 呼び出しスレッドの固定
+ *
+ * 設計思想:
+ *   - シャードは1コアに固定し、移動によるキャッシュとリモートメモリのジッターをなくす
+ *   - AI ワーカーは自ノードの AI 用 CPU の集合に固定し、ソケットをまたいだ移動のみを防ぐ
+ *   - 計画は起動時に一度作るだけの値で、スレッドは自分の番号で引いて自身を固定する
+ *   - NUMA 情報が読めない環境では全 CPU をノード0として扱い、固定のみを行う
+ */
+
+#ifndef AFFINITY_H
+#define AFFINITY_H
+
+#include <sched.h>
+#include <stdint.h>
+
+#define AFFINITY_MAX_NODES  64  /**< 扱う NUMA ノード数の上限 */
+#define AFFINITY_MAX_SHARDS 256 /**< 扱うシャード数の上限 */
+
+/**
+ * @brief CPU と NUMA ノードの対応
+ */
+typedef struct {
+    int node_count;              /**< NUMA ノード数 (1以上) */
+    int16_t cpu_node[CPU_SETSIZE]; /**< CPU ごとのノード (-1: オフライン/不明) */
+} CpuTopology;
+
+/**
+ * @brief 配置計画
+ */
+typedef struct {
+    cpu_set_t shard_cpus;        /**< シャードを固定した CPU (shard_cpu の集合) */
+    cpu_set_t ai_cpus;           /**< AI ワーカー用の CPU */
+    cpu_set_t ai_node_cpus[AFFINITY_MAX_NODES]; /**< ノードごとの AI ワーカー用 CPU */
+    int ai_nodes[AFFINITY_MAX_NODES]; /**< AI 用 CPU を持つノード */
+    int ai_node_count;           /**< AI 用 CPU を持つノード数 */
+    int ai_shared;               /**< AI 用 CPU がシャード用 CPU と重なっている */
+    int shard_count;             /**< シャード数 */
+    int shard_cpu[AFFINITY_MAX_SHARDS];  /**< シャードを固定する CPU */
+    int shard_node[AFFINITY_MAX_SHARDS]; /**< シャードの NUMA ノード */
+} AffinityPlan;
+
+/**
+ * @brief CPU リスト文字列を解析する
+ * @param list "0-3,8,10-11" 形式の文字列
+ * @param out 出力先
+ * @return 成功時1、書式が不正または空の場合0
+ */
+int affinity_parse_cpulist(const char *list, cpu_set_t *out);
+
+/**
+ * @brief CPU と NUMA ノードの対応を読み込む
+ * @param topo 出力先
+ */
+void affinity_topology_load(CpuTopology *topo);
+
+/**
+ * @brief 配置計画を作成する
+ *
+ * shard_list を省略した場合はプロセスが使える全 CPU から選びます。
+ * シャード用の CPU は実際にシャードを固定した CPU のみで、選ばれなかった CPU は AI ワーカーに回します。
+ * ai_list を省略した場合はシャード用以外の CPU を使い、残りが無ければシャード用と共有します。
+ * ai_list を指定した場合もシャード用の CPU は除きます (除くと空になる場合のみ共有)。
+ *
+ * @param plan 出力先
+ * @param topo CPU と NUMA ノードの対応
+ * @param shard_list シャード用の CPU リスト (NULL可)
+ * @param ai_list AI ワーカー用の CPU リスト (NULL可)
+ * @param shard_count シャード数
+ * @return 成功時1、リストが不正または使える CPU が無い場合0
+ */
+int affinity_plan_build(AffinityPlan *plan, const CpuTopology *topo,
+                        const char *shard_list, const char *ai_list, int shard_count);
+
+/**
+ * @brief シャードの NUMA ノードを取得する (シャードのプールの配置先)
+ * @param plan 配置計画
+ * @param shard シャード番号
+ * @return ノード番号
+ */
+int affinity_shard_node(const AffinityPlan *plan, int shard);
+
+/**
+ * @brief AI ワーカーの NUMA ノードを取得する (ワーカーのプールの配置先)
+ * @param plan 配置計画
+ * @param worker ワーカー番号 (ノード間で順番に割り当てる)
+ * @return ノード番号
+ */
+int affinity_ai_worker_node(const AffinityPlan *plan, int worker);
+
+/**
+ * @brief 呼び出しスレッドをシャードの CPU に固定する
+ * @param plan 配置計画
+ * @param shard シャード番号
+ * @return 成功時1、失敗時0
+ */
+int affinity_pin_shard(const AffinityPlan *plan, int shard);
+
+/**
+ * @brief 呼び出しスレッドを AI ワーカーの CPU 集合に固定する
+ * @param plan 配置計画
+ * @param worker ワーカー番号
+ * @return 成功時1、失敗時0
+ */
+int affinity_pin_ai_worker(const AffinityPlan *plan, int worker);
+
+#endif /* AFFINITY_H */
@@ -0,0 +1,175 @@
+/**
+ * @file arena.c
+ * @brief ヒュージページ対応の事前フォルト済みメモリ領域の実装
+ *
+ * 主な機能:
+ *   - MAP_HUGETLB → 整列した匿名領域 + MADV_HUGEPAGE → 通常の匿名領域 の順の試行
+ *   - mbind による NUMA ノードの優先指定 (libnuma に依存しないようシステムコールを直接呼ぶ)
+ *   - MADV_POPULATE_WRITE による事前フォルト (未対応カーネルではページごとの書き込み)
+ *
+ * 設計思想:
+ *   - THP 用の領域は2MB余分に予約してから境界に合わせて前後を切り落とす
+ *   - 事前フォルトしない領域は MAP_NORESERVE とし、上限分を予約しても物理メモリを消費しない
+ *   - ノードの指定は事前フォルトより前に行い、最初から指定ノードのページが割り当てられるようにする
+ */
+
+#define _GNU_SOURCE // MAP_ANONYMOUS、MAP_HUGETLB、syscall
+
+#include "arena.h"
+#include <errno.h>
+#include <linux/mempolicy.h>
+#include <stdint.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#ifndef MADV_POPULATE_WRITE
+#define MADV_POPULATE_WRITE 23
+#endif
+
+static size_t round_up(size_t value, size_t unit) {
+    return (value + unit - 1) / unit * unit;
+}
+
+/**
+ * @brief 2MB境界に整列した匿名領域を確保する
+ */
+static void* map_aligned(size_t size, int extra_flags) {
+    size_t span = size + ARENA_HUGE_PAGE_SIZE;
+    uint8_t *raw = (uint8_t*)mmap(NULL, span, PROT_READ | PROT_WRITE,
+                                  MAP_PRIVATE | MAP_ANONYMOUS | extra_flags, -1, 0);
+    if (raw == MAP_FAILED) {
+        return NULL;
+    }
+    uint8_t *aligned = (uint8_t*)round_up((uintptr_t)raw, ARENA_HUGE_PAGE_SIZE);
+    size_t head = (size_t)(aligned - raw);
+    size_t tail = span - head - size;
+    if (head > 0) {
+        munmap(raw, head);
+    }
+    if (tail > 0) {
+        munmap(aligned + size, tail);
+    }
+    return aligned;
+}
+
+/**
+ * @brief 領域を NUMA ノードに優先配置する
+ */
+static int bind_node(void *base, size_t size, int node) {
+    unsigned long mask[16];
+    if (node < 0 || node >= (int)(sizeof(mask) * 8)) {
+        return 0;
+    }
+    memset(mask, 0, sizeof(mask));
+    mask[node / (sizeof(unsigned long) * 8)] = 1ul << (node % (sizeof(unsigned long) * 8));
+    return syscall(SYS_mbind, base, size, MPOL_PREFERRED, mask, sizeof(mask) * 8, 0) == 0;
+}
+
+/**
+ * @brief 領域を確保する
+ */
+int arena_map(Arena *arena, size_t size, int flags, int node) {
+    memset(arena, 0, sizeof(*arena));
+    arena->node = ARENA_NODE_ANY;
+    if (size == 0) {
+        return 0;
+    }
+    size_t page = (size_t)sysconf(_SC_PAGESIZE);
+    int noreserve = (flags & ARENA_PREFAULT) ? 0 : MAP_NORESERVE;
+
+    if (flags & ARENA_HUGETLB) {
+        // ノード指定前にフォルトさせないよう MAP_POPULATE は使わない
+        size_t huge_size = round_up(size, ARENA_HUGE_PAGE_SIZE);
+        void *p = mmap(NULL, huge_size, PROT_READ | PROT_WRITE,
+                       MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+        if (p != MAP_FAILED) {
+            arena->base = p;
+            arena->size = huge_size;
+            arena->kind = ARENA_PAGES_HUGETLB;
+        }
+        // 失敗時はヒュージページが予約されていない。次の方法へ
+    }
+
+    if (!arena->base && (flags & ARENA_THP)) {
+        size_t huge_size = round_up(size, ARENA_HUGE_PAGE_SIZE);
+        void *p = map_aligned(huge_size, noreserve);
+        if (p) {
+            arena->base = p;
+            arena->size = huge_size;
+            arena->kind = madvise(p, huge_size, MADV_HUGEPAGE) == 0 ? ARENA_PAGES_THP : ARENA_PAGES_NORMAL;
+        }
+    }
+
+    if (!arena->base) {
+        size_t normal_size = round_up(size, page);
+        void *p = mmap(NULL, normal_size, PROT_READ | PROT_WRITE,
+                       MAP_PRIVATE | MAP_ANONYMOUS | noreserve, -1, 0);
+        if (p == MAP_FAILED) {
+            return 0;
+        }
+        arena->base = p;
+        arena->size = normal_size;
+        arena->kind = ARENA_PAGES_NORMAL;
+    }
+
+    if (node != ARENA_NODE_ANY && bind_node(arena->base, arena->size, node)) {
+        arena->node = node;
+    }
+    if (flags & ARENA_PREFAULT) {
+        arena_prefault(arena, 0, arena->size);
+    }
+    return 1;
+}
+
+/**
+ * @brief 領域を解放する
+ */
+void arena_unmap(Arena *arena) {
+    if (arena->base) {
+        munmap(arena->base, arena->size);
+    }
+    memset(arena, 0, sizeof(*arena));
+    arena->node = ARENA_NODE_ANY;
+}
+
+/**
+ * @brief 領域の一部を事前フォルトさせる
+ */
+int arena_prefault(Arena *arena, size_t offset, size_t len) {
+    if (offset > arena->size || len > arena->size - offset) {
+        return 0;
+    }
+    size_t page = (size_t)sysconf(_SC_PAGESIZE);
+    uint8_t *start = (uint8_t*)arena->base + offset / page * page;
+    uint8_t *end = (uint8_t*)arena->base + round_up(offset + len, page);
+    if (end > (uint8_t*)arena->base + arena->size) {
+        end = (uint8_t*)arena->base + arena->size;
+    }
+
+    if (madvise(start, (size_t)(end - start), MADV_POPULATE_WRITE) != 0) {
+        if (errno != EINVAL) {
+            return 0; // メモリ不足など
+        }
+        // 5.14 未満のカーネル: 各ページに書き込んでフォルトさせる
+        for (volatile uint8_t *p = start; p < end; p += page) {
+            *p = *p;
+        }
+    }
+    if (offset == 0 && len == arena->size) {
+        arena->prefaulted = 1;
+    }
+    return 1;
+}
+
+/**
+ * @brief ページ種別の名前を取得する
+ */
+const char* arena_page_kind_name(ArenaPageKind kind) {
+    switch (kind) {
+        case ARENA_PAGES_HUGETLB: return "hugetlb";
+        case ARENA_PAGES_THP:     return "thp";
+        default:                  return "normal";
+    }
+}
@@ -0,0 +1,83 @@
+/**
+ * @file arena.h
+ * @brief ヒュージページ対応の事前フォルト済みメモリ領域の宣言
+ *
+ * このファイルはサーバーの試合/コンテキストのプールを置く大きな連続領域を
+ * 確保する機能を宣言します。
+ * 主な機能:
+ *   - 明示的ヒュージページ (hugetlbfs) による確保
+ *   - 透過的ヒュージページ (THP) の要求と2MB境界への整列
+ *   - 通常ページへの段階的なフォールバック
+ *   - 起動時の事前フォルト (初回アクセスのページフォルトを試合中に起こさない)
+ *   - NUMA ノードへの配置 (使用するスレッドと同じノードのメモリを割り当てる)
+ *
+ * 設計思想:
+ *   - 使えるものから順に試し、ヒュージページが無い環境でも必ず確保できる
+ *   - 実際に使われたページ種別を記録し、運用時に確認できるようにする
+ *   - ノード指定は優先指定とし、そのノードが満杯でも確保自体は失敗させない
+ */
+
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <stddef.h>
+
+#define ARENA_HUGE_PAGE_SIZE (2u << 20) /**< ヒュージページの大きさ */
+
+#define ARENA_HUGETLB  0x01 /**< 明示的ヒュージページを試す */
+#define ARENA_THP      0x02 /**< 透過的ヒュージページを要求する */
+#define ARENA_PREFAULT 0x04 /**< 確保時に全ページをフォルトさせる */
+
+#define ARENA_NODE_ANY (-1) /**< NUMA ノードを指定しない */
+
+/* 実際に使われたページ種別の列挙型 */
+typedef enum {
+    ARENA_PAGES_NORMAL,          /**< 通常ページ */
+    ARENA_PAGES_THP,             /**< 透過的ヒュージページ (要求が通った) */
+    ARENA_PAGES_HUGETLB          /**< 明示的ヒュージページ */
+} ArenaPageKind;
+
+/**
+ * @brief メモリ領域
+ */
+typedef struct {
+    void* base;                  /**< 先頭 */
+    size_t size;                 /**< 大きさ (ページ単位に切り上げ済み) */
+    ArenaPageKind kind;          /**< 使われたページ種別 */
+    int prefaulted;              /**< 事前フォルト済み */
+    int node;                    /**< 配置した NUMA ノード (ARENA_NODE_ANY: 指定なし/失敗) */
+} Arena;
+
+/**
+ * @brief 領域を確保する
+ * @param arena 出力先
+ * @param size 必要な大きさ
+ * @param flags ARENA_* の組み合わせ (0で通常ページ、物理メモリは初回書き込み時)
+ * @param node 優先して配置する NUMA ノード (ARENA_NODE_ANY で指定なし)
+ * @return 成功時1、失敗時0
+ */
+int arena_map(Arena *arena, size_t size, int flags, int node);
+
+/**
+ * @brief 領域を解放する
+ * @param arena 対象の領域
+ */
+void arena_unmap(Arena *arena);
+
+/**
+ * @brief 領域の一部を事前フォルトさせる
+ * @param arena 対象の領域
+ * @param offset 先頭からの位置
+ * @param len 長さ
+ * @return 成功時1、失敗時0
+ */
+int arena_prefault(Arena *arena, size_t offset, size_t len);
+
+/**
+ * @brief ページ種別の名前を取得する (ログ出力用)
+ * @param kind ページ種別
+ * @return 名前
+ */
+const char* arena_page_kind_name(ArenaPageKind kind);
+
+#endif /* ARENA_H */
@@ -0,0 +1,194 @@
+/**
+ * @file coalescer.c
+ * @brief 接続ごとのティック単位のメッセージまとめ送信の実装
+ *
+ * 主な機能:
+ *   - 接続ごとの組み立て中バンドルと受信確認の保持
+ *   - 送るものがある接続のリスト
+ *
+ * 設計思想:
+ *   - ティックの途中でバンドルがあふれた場合のみ早めに送出し、それ以外はティックに1回
+ */
+
+#include "coalescer.h"
+#include "../network/bundle.h"
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * @brief 接続ごとの状態
+ */
+typedef struct {
+    uint8_t* buf;                /**< バンドルの領域 */
+    BundleWriter writer;         /**< 組み立て中のバンドル */
+    uint32_t ack;                /**< 受信確認するフレーム */
+    uint8_t has_ack;             /**< ack が有効 */
+    uint8_t started;             /**< writer を開始済み */
+    uint8_t pending;             /**< 送出待ちリストに登録済み */
+} CoalescerConn;
+
+/**
+ * @brief まとめ送信器
+ */
+struct Coalescer {
+    int max_conns;               /**< 接続番号の上限 */
+    size_t packet_max;           /**< バンドルの最大長 */
+    CoalescerSendFn send;        /**< 送出コールバック */
+    void* user;                  /**< コールバックのユーザーデータ */
+    uint32_t tick;               /**< 現在のティック番号 (早めの送出に使う) */
+    CoalescerConn* conns;        /**< 接続ごとの状態 */
+    int* pending;                /**< 送出待ちの接続 */
+    int pending_count;           /**< 送出待ちの接続数 */
+};
+
+/**
+ * @brief まとめ送信器を作成する
+ */
+Coalescer* coalescer_create(int max_conns, size_t packet_max, CoalescerSendFn send, void *user) {
+    if (max_conns <= 0 || !send) {
+        return NULL;
+    }
+    if (packet_max == 0) {
+        packet_max = COALESCER_DEFAULT_PACKET;
+    }
+    if (packet_max < sizeof(BundleHeader) + sizeof(BundleRecord) || packet_max > BUNDLE_MAX_BYTES) {
+        return NULL;
+    }
+    Coalescer *co = (Coalescer*)calloc(1, sizeof(Coalescer));
+    if (!co) {
+        return NULL;
+    }
+    co->max_conns = max_conns;
+    co->packet_max = packet_max;
+    co->send = send;
+    co->user = user;
+    co->conns = (CoalescerConn*)calloc((size_t)max_conns, sizeof(CoalescerConn));
+    co->pending = (int*)malloc(sizeof(int) * (size_t)max_conns);
+    if (!co->conns || !co->pending) {
+        coalescer_destroy(co);
+        return NULL;
+    }
+    return co;
+}
+
+/**
+ * @brief まとめ送信器を解放する
+ */
+void coalescer_destroy(Coalescer *co) {
+    if (!co) {
+        return;
+    }
+    if (co->conns) {
+        for (int i = 0; i < co->max_conns; i++) {
+            free(co->conns[i].buf);
+        }
+    }
+    free(co->conns);
+    free(co->pending);
+    free(co);
+}
+
+/**
+ * @brief 接続を送出待ちにし、バンドルの組み立てを開始する
+ */
+static CoalescerConn* conn_prepare(Coalescer *co, int conn) {
+    if (conn < 0 || conn >= co->max_conns) {
+        return NULL;
+    }
+    CoalescerConn *c = &co->conns[conn];
+    if (!c->buf) {
+        c->buf = (uint8_t*)malloc(co->packet_max);
+        if (!c->buf) {
+            return NULL;
+        }
+    }
+    if (!c->started) {
+        bundle_begin(&c->writer, c->buf, co->packet_max);
+        c->started = 1;
+    }
+    if (!c->pending) {
+        c->pending = 1;
+        co->pending[co->pending_count++] = conn;
+    }
+    return c;
+}
+
+/**
+ * @brief 接続の組み立て中のバンドルを送出する
+ */
+static void conn_emit(Coalescer *co, int conn, uint32_t tick) {
+    CoalescerConn *c = &co->conns[conn];
+    if (!c->started || (c->writer.count == 0 && !c->has_ack)) {
+        return;
+    }
+    size_t len = bundle_finish(&c->writer, tick, c->has_ack, c->ack);
+    co->send(conn, c->buf, len, co->user);
+    c->has_ack = 0;
+    c->started = 0;
+}
+
+/**
+ * @brief メッセージを追加する
+ */
+int coalescer_add(Coalescer *co, int conn, MessageType type, const void *payload, uint16_t length) {
+    if (sizeof(BundleHeader) + sizeof(BundleRecord) + length > co->packet_max) {
+        return 0;
+    }
+    CoalescerConn *c = conn_prepare(co, conn);
+    if (!c) {
+        return 0;
+    }
+    if (!bundle_fits(&c->writer, length)) {
+        // あふれた分は次のバンドルへ。受信確認は先に送る方に載せる
+        conn_emit(co, conn, co->tick);
+        bundle_begin(&c->writer, c->buf, co->packet_max);
+        c->started = 1;
+    }
+    return bundle_add(&c->writer, type, payload, length);
+}
+
+/**
+ * @brief 入力の受信確認を設定する
+ */
+void coalescer_ack(Coalescer *co, int conn, uint32_t frame) {
+    CoalescerConn *c = conn_prepare(co, conn);
+    if (!c) {
+        return;
+    }
+    if (!c->has_ack || (int32_t)(frame - c->ack) > 0) {
+        c->ack = frame;
+        c->has_ack = 1;
+    }
+}
+
+/**
+ * @brief 接続の未送出のメッセージを破棄する
+ */
+void coalescer_drop(Coalescer *co, int conn) {
+    if (conn < 0 || conn >= co->max_conns) {
+        return;
+    }
+    CoalescerConn *c = &co->conns[conn];
+    c->started = 0;
+    c->has_ack = 0;
+}
+
+/**
+ * @brief ティックの終わりに全接続のバンドルを送出する
+ */
+int coalescer_flush(Coalescer *co, uint32_t tick) {
+    int emitted = 0;
+    for (int i = 0; i < co->pending_count; i++) {
+        int conn = co->pending[i];
+        CoalescerConn *c = &co->conns[conn];
+        c->pending = 0;
+        if (c->started && (c->writer.count > 0 || c->has_ack)) {
+            conn_emit(co, conn, tick);
+            emitted++;
+        }
+        c->started = 0;
+    }
+    co->pending_count = 0;
+    co->tick = tick + 1;
+    return emitted;
+}
@@ -0,0 +1,89 @@
+/**
+ * @file coalescer.h
+ * @brief 接続ごとのティック単位のメッセージまとめ送信の宣言
+ *
+ * このファイルは1ティックの間にクライアントへ送るメッセージ
+ * (おじゃまライン、盤面差分、スコア、入力の受信確認) を接続ごとに
+ * 1つのバンドルへ詰め、ティックの終わりに1回で送る機能を宣言します。
+ * 主な機能:
+ *   - メッセージの追加 (入りきらない場合はその時点のバンドルを送って続ける)
+ *   - 入力の受信確認は最新の1件のみをヘッダーに載せる
+ *   - ティックの終わりの一括送出
+ *
+ * 設計思想:
+ *   - 実際の送信はコールバックに任せ、TCP (net_backend) と UDP (udp_batch) のどちらにも載せられる
+ *   - 送るものがある接続のみを記録し、送出時に全接続を走査しない
+ *   - バンドルの領域は接続ごとに初回の追加時に確保し、以後は再利用する
+ */
+
+#ifndef COALESCER_H
+#define COALESCER_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "../network/protocol.h"
+
+#define COALESCER_DEFAULT_PACKET 1200 /**< 既定のバンドルの最大長 (UDP_PACKET_MAX と同じ) */
+
+/**
+ * @brief バンドルの送出コールバック
+ * @param conn 宛先の接続
+ * @param packet バンドル
+ * @param len バンドルの長さ
+ * @param user 作成時に渡したユーザーデータ
+ */
+typedef void (*CoalescerSendFn)(int conn, const uint8_t *packet, size_t len, void *user);
+
+typedef struct Coalescer Coalescer;
+
+/**
+ * @brief まとめ送信器を作成する
+ * @param max_conns 接続番号の上限
+ * @param packet_max バンドルの最大長 (0で既定値、BUNDLE_MAX_BYTES 以下)
+ * @param send 送出コールバック
+ * @param user コールバックに渡すユーザーデータ
+ * @return 作成したまとめ送信器 (失敗時はNULL)
+ */
+Coalescer* coalescer_create(int max_conns, size_t packet_max, CoalescerSendFn send, void *user);
+
+/**
+ * @brief まとめ送信器を解放する (未送出のメッセージは破棄)
+ * @param co 解放するまとめ送信器 (NULL可)
+ */
+void coalescer_destroy(Coalescer *co);
+
+/**
+ * @brief メッセージを追加する
+ * @param co 対象のまとめ送信器
+ * @param conn 宛先の接続
+ * @param type メッセージ種別
+ * @param payload 本体
+ * @param length 本体の長さ
+ * @return 成功時1、本体がバンドルの最大長を超えるなど追加できない場合0
+ */
+int coalescer_add(Coalescer *co, int conn, MessageType type, const void *payload, uint16_t length);
+
+/**
+ * @brief 入力の受信確認を設定する (同じティック内では最新の値で上書き)
+ * @param co 対象のまとめ送信器
+ * @param conn 宛先の接続
+ * @param frame 受信したクライアントの入力フレーム
+ */
+void coalescer_ack(Coalescer *co, int conn, uint32_t frame);
+
+/**
+ * @brief 接続の未送出のメッセージを破棄する (切断時)
+ * @param co 対象のまとめ送信器
+ * @param conn 接続
+ */
+void coalescer_drop(Coalescer *co, int conn);
+
+/**
+ * @brief ティックの終わりに全接続のバンドルを送出する
+ * @param co 対象のまとめ送信器
+ * @param tick ティック番号
+ * @return 送出したバンドル数
+ */
+int coalescer_flush(Coalescer *co, uint32_t tick);
+
+#endif /* COALESCER_H */
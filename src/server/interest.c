@@ -0,0 +1,257 @@
+/**
+ * @file interest.c
+ * @brief 多人数対戦での対戦相手の盤面更新の関心管理の実装
+ *
+ * 主な機能:
+ *   - 攻撃対象の記録と、受信側ごとの全精度の相手の選択
+ *   - 予算内での要約の巡回選択
+ *   - 加算増加/乗算減少による送信予算の調整
+ *
+ * 設計思想:
+ *   - 「狙われている」関係は攻撃対象の配列から計画時に求め、逆引きの表を持たない
+ *   - 要約の最終送信ティックは受信側×相手の表で持ち、最短間隔を守る
+ */
+
+#include "interest.h"
+#include "../network/bundle.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define INTEREST_BUDGET_STEP     32   /**< 混雑が無い場合の予算の増分 (バイト) */
+#define INTEREST_DECREASE_NUM    3    /**< 混雑時の予算の倍率 (分子) */
+#define INTEREST_DECREASE_DEN    4    /**< 混雑時の予算の倍率 (分母) */
+#define INTEREST_SUMMARY_COST    (sizeof(BundleRecord) + sizeof(BoardSummaryMessage)) /**< 要約1件の送信量 */
+#define INTEREST_NEVER           0xffffffffu /**< 要約を一度も送っていない */
+
+/**
+ * @brief 関心管理
+ */
+struct InterestManager {
+    int max_players;             /**< プレイヤー数の上限 */
+    uint8_t* alive;              /**< 参加中 */
+    int* target;                 /**< 攻撃対象 */
+    uint32_t* update_cost;       /**< このティックの盤面差分の大きさ */
+    uint32_t* budget;            /**< 受信側ごとの送信予算 */
+    int* cursor;                 /**< 受信側ごとの要約の巡回位置 */
+    uint32_t* last_summary;      /**< [受信側][相手] 最後に要約を送ったティック */
+    uint8_t* full_scratch;       /**< 計画中に全精度とした相手の印 */
+    uint32_t summary_interval;   /**< 同じ相手の要約を送る最短間隔 (ティック) */
+};
+
+/**
+ * @brief 関心管理を作成する
+ */
+InterestManager* interest_create(int max_players) {
+    if (max_players <= 0) {
+        return NULL;
+    }
+    InterestManager *im = (InterestManager*)calloc(1, sizeof(InterestManager));
+    if (!im) {
+        return NULL;
+    }
+    size_t n = (size_t)max_players;
+    im->max_players = max_players;
+    im->alive = (uint8_t*)calloc(n, 1);
+    im->target = (int*)malloc(sizeof(int) * n);
+    im->update_cost = (uint32_t*)calloc(n, sizeof(uint32_t));
+    im->budget = (uint32_t*)malloc(sizeof(uint32_t) * n);
+    im->cursor = (int*)calloc(n, sizeof(int));
+    im->last_summary = (uint32_t*)malloc(sizeof(uint32_t) * n * n);
+    im->full_scratch = (uint8_t*)calloc(n, 1);
+    if (!im->alive || !im->target || !im->update_cost || !im->budget || !im->cursor ||
+        !im->last_summary || !im->full_scratch) {
+        interest_destroy(im);
+        return NULL;
+    }
+    for (int i = 0; i < max_players; i++) {
+        im->target[i] = INTEREST_NO_TARGET;
+        im->budget[i] = INTEREST_DEFAULT_BUDGET;
+    }
+    memset(im->last_summary, 0xff, sizeof(uint32_t) * n * n);
+    im->summary_interval = INTEREST_MIN_SUMMARY_TICKS;
+    return im;
+}
+
+/**
+ * @brief 関心管理を解放する
+ */
+void interest_destroy(InterestManager *im) {
+    if (!im) {
+        return;
+    }
+    free(im->alive);
+    free(im->target);
+    free(im->update_cost);
+    free(im->budget);
+    free(im->cursor);
+    free(im->last_summary);
+    free(im->full_scratch);
+    free(im);
+}
+
+static int valid_player(const InterestManager *im, int player) {
+    return player >= 0 && player < im->max_players;
+}
+
+/**
+ * @brief プレイヤーの参加状態を設定する
+ */
+void interest_set_alive(InterestManager *im, int player, int alive) {
+    if (valid_player(im, player)) {
+        im->alive[player] = (uint8_t)(alive != 0);
+    }
+}
+
+/**
+ * @brief プレイヤーの攻撃対象を設定する
+ */
+void interest_set_target(InterestManager *im, int player, int target) {
+    if (valid_player(im, player)) {
+        im->target[player] = valid_player(im, target) && target != player ? target : INTEREST_NO_TARGET;
+    }
+}
+
+/**
+ * @brief 同じ相手の要約を送る最短間隔を設定する
+ */
+void interest_set_summary_interval(InterestManager *im, uint32_t ticks) {
+    im->summary_interval = ticks > 0 ? ticks : INTEREST_MIN_SUMMARY_TICKS;
+}
+
+/**
+ * @brief このティックで送る盤面差分の大きさを設定する
+ */
+void interest_set_update_cost(InterestManager *im, int player, uint32_t bytes) {
+    if (valid_player(im, player)) {
+        im->update_cost[player] = bytes;
+    }
+}
+
+/**
+ * @brief 受信側の混雑状況を報告して送信予算を調整する
+ */
+void interest_on_feedback(InterestManager *im, int viewer, int congested) {
+    if (!valid_player(im, viewer)) {
+        return;
+    }
+    uint32_t budget = im->budget[viewer];
+    if (congested) {
+        budget = budget * INTEREST_DECREASE_NUM / INTEREST_DECREASE_DEN;
+        if (budget < INTEREST_MIN_BUDGET) {
+            budget = INTEREST_MIN_BUDGET;
+        }
+    } else {
+        budget += INTEREST_BUDGET_STEP;
+        if (budget > INTEREST_MAX_BUDGET) {
+            budget = INTEREST_MAX_BUDGET;
+        }
+    }
+    im->budget[viewer] = budget;
+}
+
+/**
+ * @brief 受信側の現在の送信予算を取得する
+ */
+uint32_t interest_budget(const InterestManager *im, int viewer) {
+    return valid_player(im, viewer) ? im->budget[viewer] : 0;
+}
+
+/**
+ * @brief 全精度の相手を1人計画に加える (予算を超える場合は要約に落とす)
+ */
+static int plan_full(InterestManager *im, int subject, uint32_t *spent, uint32_t budget,
+                     InterestEntry *out, int count, int max) {
+    if (count >= max || im->full_scratch[subject]) {
+        return count;
+    }
+    im->full_scratch[subject] = 1;
+    uint32_t cost = im->update_cost[subject];
+    if (cost == 0) {
+        return count; // 変化なし。要約も不要
+    }
+    if (*spent + cost <= budget || *spent == 0) {
+        // 予算を超えても最優先の1件は送る
+        *spent += cost;
+        out[count].subject = subject;
+        out[count].level = INTEREST_FULL;
+        return count + 1;
+    }
+    im->full_scratch[subject] = 0; // 要約の巡回に回す
+    return count;
+}
+
+/**
+ * @brief 受信側へこのティックに送る盤面更新を決める
+ */
+int interest_plan(InterestManager *im, int viewer, uint32_t tick, InterestEntry *out, int max) {
+    if (!valid_player(im, viewer)) {
+        return 0;
+    }
+    int n = im->max_players;
+    uint32_t budget = im->budget[viewer];
+    uint32_t spent = 0;
+    int count = 0;
+    memset(im->full_scratch, 0, (size_t)n);
+    im->full_scratch[viewer] = 1; // 自分の盤面は送らない
+
+    // 1. 自分の攻撃対象、2. 自分を狙っている相手
+    int target = im->target[viewer];
+    if (target != INTEREST_NO_TARGET && im->alive[target]) {
+        count = plan_full(im, target, &spent, budget, out, count, max);
+    }
+    for (int p = 0; p < n && count < max; p++) {
+        if (im->alive[p] && im->target[p] == viewer) {
+            count = plan_full(im, p, &spent, budget, out, count, max);
+        }
+    }
+
+    // 3. 残りの予算で、それ以外の相手の要約を巡回して送る
+    uint32_t *last = &im->last_summary[(size_t)viewer * (size_t)n];
+    int start = im->cursor[viewer];
+    int next = start;
+    for (int k = 0; k < n && count < max; k++) {
+        int p = (start + k) % n;
+        if (!im->alive[p] || im->full_scratch[p]) {
+            continue;
+        }
+        if (last[p] != INTEREST_NEVER && tick - last[p] < im->summary_interval) {
+            continue;
+        }
+        if (spent + INTEREST_SUMMARY_COST > budget) {
+            break;
+        }
+        spent += (uint32_t)INTEREST_SUMMARY_COST;
+        last[p] = tick;
+        out[count].subject = p;
+        out[count].level = INTEREST_SUMMARY;
+        count++;
+        next = (p + 1) % n;
+    }
+    im->cursor[viewer] = next;
+    return count;
+}
+
+/**
+ * @brief 盤面の要約を作成する
+ */
+void interest_make_summary(const Board *board, int player, int incoming_garbage, BoardSummaryMessage *out) {
+    int max_height = 0;
+    out->player_id = (uint8_t)player;
+    for (int x = 0; x < BOARD_WIDTH; x++) {
+        int height = 0;
+        if (board && board->grid && x < board->width) {
+            for (int y = 0; y < board->height; y++) {
+                if (board->grid[y * board->width + x]) {
+                    height = board->height - y;
+                    break;
+                }
+            }
+        }
+        out->heights[x] = (uint8_t)height;
+        if (height > max_height) {
+            max_height = height;
+        }
+    }
+    int danger = (max_height + (incoming_garbage > 0 ? incoming_garbage : 0)) * 255 / BOARD_HEIGHT;
+    out->danger = (uint8_t)(danger > 255 ? 255 : danger);
+}
@@ -0,0 +1,128 @@
+/**
+ * @file interest.h
+ * @brief 多人数対戦での対戦相手の盤面更新の関心管理の宣言
+ *
+ * このファイルは各クライアントへ送る対戦相手の盤面更新を、関係の深さと
+ * 回線の帯域に応じて間引く機能を宣言します。
+ * 主な機能:
+ *   - 狙っている相手と狙われている相手には毎ティックの盤面差分 (全精度)
+ *   - それ以外の相手には列の高さと危険度のみの要約を低頻度で
+ *   - 受信側の混雑の報告に応じた1ティックあたりの送信予算の増減 (AIMD)
+ *
+ * 設計思想:
+ *   - 全員への全盤面の配信 (人数の2乗の通信量) を、関係する数人分と予算内の要約に抑える
+ *   - 要約は巡回カーソルで順に送り、予算が多いほど全員の要約が新しくなる
+ *   - 予算が足りない場合は自分の狙う相手、自分を狙う相手の順に全精度を優先し、残りは要約に落とす
+ *   - 計画の作成はプレイヤー数に比例する時間で、ティックごとの動的確保なし
+ */
+
+#ifndef INTEREST_H
+#define INTEREST_H
+
+#include <stdint.h>
+#include "../game/game_defs.h"
+#include "../network/protocol.h"
+
+#define INTEREST_NO_TARGET          -1   /**< 誰も狙っていない */
+#define INTEREST_DEFAULT_BUDGET     800  /**< 既定の1ティックあたりの送信予算 (バイト) */
+#define INTEREST_MIN_BUDGET         96   /**< 送信予算の下限 */
+#define INTEREST_MAX_BUDGET         8192 /**< 送信予算の上限 */
+#define INTEREST_MIN_SUMMARY_TICKS  4    /**< 同じ相手の要約を送る既定の最短間隔 (ティック) */
+
+/* 更新の精度の列挙型 */
+typedef enum {
+    INTEREST_FULL,               /**< 盤面差分を送る */
+    INTEREST_SUMMARY             /**< 要約を送る */
+} InterestLevel;
+
+/**
+ * @brief 1ティックの送信計画の1件
+ */
+typedef struct {
+    int subject;                 /**< 盤面の持ち主のプレイヤー */
+    InterestLevel level;         /**< 送る精度 */
+} InterestEntry;
+
+typedef struct InterestManager InterestManager;
+
+/**
+ * @brief 関心管理を作成する
+ * @param max_players 試合のプレイヤー数の上限
+ * @return 作成した関心管理 (失敗時はNULL)
+ */
+InterestManager* interest_create(int max_players);
+
+/**
+ * @brief 関心管理を解放する
+ * @param im 解放する関心管理 (NULL可)
+ */
+void interest_destroy(InterestManager *im);
+
+/**
+ * @brief プレイヤーの参加状態を設定する (脱落したプレイヤーの盤面は送らない)
+ * @param im 対象の関心管理
+ * @param player プレイヤー
+ * @param alive 参加中なら1
+ */
+void interest_set_alive(InterestManager *im, int player, int alive);
+
+/**
+ * @brief プレイヤーの攻撃対象を設定する
+ * @param im 対象の関心管理
+ * @param player プレイヤー
+ * @param target 攻撃対象 (INTEREST_NO_TARGET で無し)
+ */
+void interest_set_target(InterestManager *im, int player, int target);
+
+/**
+ * @brief 同じ相手の要約を送る最短間隔を設定する (サーバーの負荷制限で延ばす)
+ * @param im 対象の関心管理
+ * @param ticks 最短間隔 (ティック、0の場合は既定値)
+ */
+void interest_set_summary_interval(InterestManager *im, uint32_t ticks);
+
+/**
+ * @brief このティックで送る盤面差分の大きさを設定する (毎ティック、シミュレーション後に呼び出す)
+ * @param im 対象の関心管理
+ * @param player 盤面の持ち主のプレイヤー
+ * @param bytes 盤面差分のバイト数 (変化が無ければ0)
+ */
+void interest_set_update_cost(InterestManager *im, int player, uint32_t bytes);
+
+/**
+ * @brief 受信側の混雑状況を報告して送信予算を調整する
+ * @param im 対象の関心管理
+ * @param viewer 受信側のプレイヤー
+ * @param congested 送信待ちの滞留やパケット損失があれば1
+ */
+void interest_on_feedback(InterestManager *im, int viewer, int congested);
+
+/**
+ * @brief 受信側の現在の送信予算を取得する
+ * @param im 対象の関心管理
+ * @param viewer 受信側のプレイヤー
+ * @return 1ティックあたりの送信予算 (バイト)
+ */
+uint32_t interest_budget(const InterestManager *im, int viewer);
+
+/**
+ * @brief 受信側へこのティックに送る盤面更新を決める
+ * @param im 対象の関心管理
+ * @param viewer 受信側のプレイヤー
+ * @param tick ティック番号
+ * @param out 送信計画の出力先
+ * @param max 出力先の要素数
+ * @return 送信計画の件数
+ */
+int interest_plan(InterestManager *im, int viewer, uint32_t tick, InterestEntry *out, int max);
+
+/**
+ * @brief 盤面の要約を作成する
+ * @param board 対象の盤面
+ * @param player 盤面の持ち主のプレイヤー
+ * @param incoming_garbage 受けているおじゃまライン数
+ * @param out 出力先
+ */
+void interest_make_summary(const Board *board, int player, int incoming_garbage, BoardSummaryMessage *out);
+
+#endif /* INTEREST_H */
@@ -0,0 +1,438 @@
+/**
+ * @file leaderboard.c
+ * @brief ロックフリーなハイスコアランキング実装
+ *
+ * 主な機能:
+ *   - CAS による上位K件配列の更新
+ *   - mmap したログファイルへのアトミックな追記と復元
+ *   - 二重化したログによる並行コンパクション
+ *
+ * 設計思想:
+ *   - ランキングの値は単調に大きくなるため、観測した最小値は常に安全な下限になる
+ *   - ログ構造体は2つを交互に使い回して解放しないため、古いポインタを読んだスレッドも安全
+ *   - 書き込み中カウンタを増やした後に現在のログを再確認し、差し替え済みなら再試行する
+ *   - コンパクション中のクラッシュに備え、一時ファイルも復元対象にする
+ *
+ * ログファイル形式:
+ *   ヘッダ (LOG_HEADER_SIZE バイト) | レコード (24バイト) の並び
+ */
+
+#define _GNU_SOURCE // ftruncate
+
+#include "leaderboard.h"
+#include <fcntl.h>
+#include <sched.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#define LOG_MAGIC        0x4C424C47u /**< "LBLG" */
+#define LOG_VERSION      1
+#define LOG_HEADER_SIZE  64
+#define RECORD_COMMITTED 0x52454331u /**< コミット済みレコードのマーカー */
+#define COMPACT_THRESHOLD_PERCENT 75 /**< コンパクションを行うログ使用率 */
+#define LB_PATH_MAX      512
+
+/**
+ * @brief ログファイルのヘッダ
+ */
+typedef struct {
+    uint32_t magic;              /**< LOG_MAGIC */
+    uint32_t version;            /**< LOG_VERSION */
+    uint64_t capacity;           /**< レコード領域のバイト数 */
+    _Atomic uint64_t tail;       /**< 予約済みのバイト数 */
+} LogHeader;
+
+/**
+ * @brief ログのレコード
+ */
+typedef struct {
+    _Atomic uint32_t commit;     /**< RECORD_COMMITTED ならば書き込み完了 */
+    uint8_t mode;                /**< ゲームモード */
+    uint8_t reserved[3];         /**< 予約 */
+    uint32_t player_id;          /**< プレイヤーID */
+    int32_t score;               /**< スコア */
+    uint64_t timestamp;          /**< 登録時刻 (UNIX時刻) */
+} LogRecord;
+
+/**
+ * @brief メモリマップしたログ
+ */
+typedef struct {
+    int fd;                      /**< ファイル記述子 (未使用時-1) */
+    size_t map_size;             /**< マップサイズ */
+    LogHeader* header;           /**< ヘッダ (マップ先頭) */
+    uint8_t* records;            /**< レコード領域 */
+    atomic_int writers;          /**< 追記中のスレッド数 */
+} LeaderboardLog;
+
+/**
+ * @brief 上位K件のランキング
+ */
+typedef struct {
+    _Atomic uint64_t slots[LEADERBOARD_K]; /**< (スコア << 32 | プレイヤーID)、0は空き */
+    _Atomic uint64_t floor;      /**< 最小値の下限 (これ以下は圏外) */
+} TopK;
+
+struct Leaderboard {
+    TopK boards[LEADERBOARD_BOARD_COUNT]; /**< 全体 + モード別ランキング */
+    LeaderboardLog logs[2];      /**< 交互に使うログ */
+    _Atomic(LeaderboardLog*) log; /**< 現在のログ */
+    atomic_flag compacting;      /**< コンパクション実行中 */
+    atomic_int log_full;         /**< ログが満杯になった */
+    size_t log_bytes;            /**< ログファイルのサイズ */
+    char path[LB_PATH_MAX];      /**< ログファイルのパス */
+    char tmp_path[LB_PATH_MAX];  /**< コンパクション用の一時パス */
+};
+
+/* ---- 上位K件 ---- */
+
+static uint64_t pack_entry(uint32_t player_id, int score) {
+    return ((uint64_t)(uint32_t)score << 32) | player_id;
+}
+
+/**
+ * @brief ランキングに値を挿入する
+ */
+static int topk_insert(TopK *topk, uint64_t value) {
+    for (;;) {
+        if (value <= atomic_load_explicit(&topk->floor, memory_order_relaxed)) {
+            return 0;
+        }
+
+        int min_idx = 0;
+        uint64_t min_val = UINT64_MAX;
+        for (int i = 0; i < LEADERBOARD_K; i++) {
+            uint64_t v = atomic_load_explicit(&topk->slots[i], memory_order_relaxed);
+            if (v == value) {
+                return 0; // 登録済み
+            }
+            if (v < min_val) {
+                min_val = v;
+                min_idx = i;
+            }
+        }
+
+        if (value <= min_val) {
+            // 観測した最小値で下限を引き上げる (値は単調増加なので安全)
+            uint64_t f = atomic_load_explicit(&topk->floor, memory_order_relaxed);
+            while (f < min_val &&
+                   !atomic_compare_exchange_weak_explicit(&topk->floor, &f, min_val,
+                                                          memory_order_relaxed, memory_order_relaxed)) {
+            }
+            return 0;
+        }
+
+        if (atomic_compare_exchange_strong_explicit(&topk->slots[min_idx], &min_val, value,
+                                                    memory_order_release, memory_order_relaxed)) {
+            return 1;
+        }
+        // 他スレッドが先に置き換えたので再走査
+    }
+}
+
+/* ---- ログ ---- */
+
+/**
+ * @brief ログファイルを開いてマップする
+ */
+static int log_map(LeaderboardLog *log, const char *path, size_t bytes, int truncate) {
+    int flags = O_RDWR | O_CREAT | (truncate ? O_TRUNC : 0);
+    int fd = open(path, flags, 0644);
+    if (fd < 0) {
+        return 0;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        close(fd);
+        return 0;
+    }
+    size_t size = (size_t)st.st_size;
+    if (size < LOG_HEADER_SIZE + sizeof(LogRecord)) {
+        size = bytes;
+        if (ftruncate(fd, (off_t)size) != 0) {
+            close(fd);
+            return 0;
+        }
+    }
+
+    void *map = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (map == MAP_FAILED) {
+        close(fd);
+        return 0;
+    }
+
+    LogHeader *header = (LogHeader*)map;
+    uint64_t capacity = ((size - LOG_HEADER_SIZE) / sizeof(LogRecord)) * sizeof(LogRecord);
+    if (header->magic != LOG_MAGIC || header->version != LOG_VERSION || header->capacity > capacity) {
+        memset(map, 0, LOG_HEADER_SIZE);
+        header->magic = LOG_MAGIC;
+        header->version = LOG_VERSION;
+        header->capacity = capacity;
+        atomic_store(&header->tail, 0);
+    }
+
+    log->fd = fd;
+    log->map_size = size;
+    log->header = header;
+    log->records = (uint8_t*)map + LOG_HEADER_SIZE;
+    return 1;
+}
+
+/**
+ * @brief ログのマップを解除して閉じる (構造体自体は再利用する)
+ */
+static void log_unmap(LeaderboardLog *log) {
+    if (log->fd < 0) {
+        return;
+    }
+    msync(log->header, log->map_size, MS_SYNC);
+    munmap(log->header, log->map_size);
+    close(log->fd);
+    log->fd = -1;
+    log->header = NULL;
+    log->records = NULL;
+}
+
+/**
+ * @brief ログにレコードを1件追記する
+ */
+static int log_append(LeaderboardLog *log, GameMode mode, uint32_t player_id, int score, uint64_t ts) {
+    LogHeader *header = log->header;
+    uint64_t off = atomic_fetch_add_explicit(&header->tail, sizeof(LogRecord), memory_order_relaxed);
+    if (off + sizeof(LogRecord) > header->capacity) {
+        return 0;
+    }
+
+    LogRecord *rec = (LogRecord*)(log->records + off);
+    rec->mode = (uint8_t)mode;
+    rec->player_id = player_id;
+    rec->score = score;
+    rec->timestamp = ts;
+    atomic_store_explicit(&rec->commit, RECORD_COMMITTED, memory_order_release);
+    return 1;
+}
+
+/**
+ * @brief 現在のログを取得し、書き込み中として登録する
+ */
+static LeaderboardLog* log_acquire(Leaderboard *lb) {
+    for (;;) {
+        LeaderboardLog *log = atomic_load_explicit(&lb->log, memory_order_acquire);
+        atomic_fetch_add_explicit(&log->writers, 1, memory_order_seq_cst);
+        if (atomic_load_explicit(&lb->log, memory_order_seq_cst) == log) {
+            return log;
+        }
+        // 差し替え中だったので旧ログには触れずに再試行
+        atomic_fetch_sub_explicit(&log->writers, 1, memory_order_release);
+    }
+}
+
+static void log_release(LeaderboardLog *log) {
+    atomic_fetch_sub_explicit(&log->writers, 1, memory_order_release);
+}
+
+/**
+ * @brief ランキングへ挿入する (全体 + モード別)
+ */
+static int insert_score(Leaderboard *lb, GameMode mode, uint32_t player_id, int score) {
+    if (score <= 0 || (int)mode < 0 || (int)mode >= LEADERBOARD_MODE_COUNT) {
+        return 0;
+    }
+    uint64_t value = pack_entry(player_id, score);
+    int entered = topk_insert(&lb->boards[LEADERBOARD_GLOBAL], value);
+    entered |= topk_insert(&lb->boards[1 + mode], value);
+    return entered;
+}
+
+/**
+ * @brief ログの内容をランキングへ復元する
+ */
+static void log_replay(Leaderboard *lb, const LeaderboardLog *log) {
+    uint64_t tail = atomic_load(&log->header->tail);
+    if (tail > log->header->capacity) {
+        tail = log->header->capacity;
+    }
+    for (uint64_t off = 0; off + sizeof(LogRecord) <= tail; off += sizeof(LogRecord)) {
+        LogRecord *rec = (LogRecord*)(log->records + off);
+        if (atomic_load_explicit(&rec->commit, memory_order_acquire) == RECORD_COMMITTED) {
+            insert_score(lb, (GameMode)rec->mode, rec->player_id, rec->score);
+        }
+    }
+}
+
+/* ---- 公開関数 ---- */
+
+/**
+ * @brief ランキングを開く (ログがあれば復元する)
+ */
+Leaderboard* leaderboard_open(const char *path, size_t log_bytes) {
+    if (!path || strlen(path) + 5 >= LB_PATH_MAX) {
+        return NULL;
+    }
+    if (log_bytes == 0) {
+        log_bytes = LEADERBOARD_DEFAULT_LOG_BYTES;
+    }
+    if (log_bytes < LOG_HEADER_SIZE + sizeof(LogRecord) * LEADERBOARD_K * LEADERBOARD_BOARD_COUNT * 2) {
+        log_bytes = LOG_HEADER_SIZE + sizeof(LogRecord) * LEADERBOARD_K * LEADERBOARD_BOARD_COUNT * 2;
+    }
+
+    Leaderboard *lb = (Leaderboard*)calloc(1, sizeof(Leaderboard));
+    if (!lb) {
+        return NULL;
+    }
+    lb->log_bytes = log_bytes;
+    snprintf(lb->path, sizeof(lb->path), "%s", path);
+    snprintf(lb->tmp_path, sizeof(lb->tmp_path), "%s.tmp", path);
+    atomic_flag_clear(&lb->compacting);
+    for (int i = 0; i < 2; i++) {
+        lb->logs[i].fd = -1;
+        atomic_init(&lb->logs[i].writers, 0);
+    }
+
+    if (!log_map(&lb->logs[0], lb->path, log_bytes, 0)) {
+        free(lb);
+        return NULL;
+    }
+    log_replay(lb, &lb->logs[0]);
+
+    // コンパクション途中で終了していた場合は一時ファイルの内容も取り込む
+    if (access(lb->tmp_path, F_OK) == 0 && log_map(&lb->logs[1], lb->tmp_path, log_bytes, 0)) {
+        log_replay(lb, &lb->logs[1]);
+        log_unmap(&lb->logs[1]);
+        unlink(lb->tmp_path);
+    }
+    atomic_init(&lb->log, &lb->logs[0]);
+    atomic_init(&lb->log_full, 0);
+
+    // 復元後は常にコンパクションして重複や途中書き込みを取り除く
+    leaderboard_compact(lb);
+    return lb;
+}
+
+/**
+ * @brief ランキングを閉じる
+ */
+void leaderboard_close(Leaderboard *lb) {
+    if (!lb) {
+        return;
+    }
+    log_unmap(&lb->logs[0]);
+    log_unmap(&lb->logs[1]);
+    free(lb);
+}
+
+/**
+ * @brief 試合結果のスコアを登録する (ロックフリー)
+ */
+int leaderboard_submit(Leaderboard *lb, GameMode mode, uint32_t player_id, const ScoreCtx *score) {
+    if (!lb || !score || !insert_score(lb, mode, player_id, score->score)) {
+        return 0;
+    }
+
+    LeaderboardLog *log = log_acquire(lb);
+    if (!log_append(log, mode, player_id, score->score, (uint64_t)time(NULL))) {
+        atomic_store_explicit(&lb->log_full, 1, memory_order_relaxed);
+    }
+    log_release(log);
+    return 1;
+}
+
+/**
+ * @brief 値の降順比較
+ */
+static int compare_desc(const void *a, const void *b) {
+    uint64_t x = *(const uint64_t*)a;
+    uint64_t y = *(const uint64_t*)b;
+    return (x < y) - (x > y);
+}
+
+/**
+ * @brief ランキングを高い順に読み出す
+ */
+int leaderboard_top(const Leaderboard *lb, int board, LeaderboardEntry *out, int max) {
+    if (!lb || !out || board < 0 || board >= LEADERBOARD_BOARD_COUNT) {
+        return 0;
+    }
+
+    uint64_t values[LEADERBOARD_K];
+    int n = 0;
+    for (int i = 0; i < LEADERBOARD_K; i++) {
+        uint64_t v = atomic_load_explicit(&lb->boards[board].slots[i], memory_order_acquire);
+        if (v) {
+            values[n++] = v;
+        }
+    }
+    qsort(values, (size_t)n, sizeof(values[0]), compare_desc);
+
+    if (n > max) {
+        n = max;
+    }
+    for (int i = 0; i < n; i++) {
+        out[i].player_id = (uint32_t)values[i];
+        out[i].score = (int)(values[i] >> 32);
+    }
+    return n;
+}
+
+/**
+ * @brief ログをコンパクションする
+ */
+int leaderboard_compact(Leaderboard *lb) {
+    if (!lb || atomic_flag_test_and_set(&lb->compacting)) {
+        return 0;
+    }
+
+    LeaderboardLog *old = atomic_load(&lb->log);
+    LeaderboardLog *next = (old == &lb->logs[0]) ? &lb->logs[1] : &lb->logs[0];
+    if (!log_map(next, lb->tmp_path, lb->log_bytes, 1)) {
+        atomic_flag_clear(&lb->compacting);
+        return 0;
+    }
+
+    // 新しい追記は新ログへ向け、旧ログへの追記が終わるのを待つ
+    atomic_store(&lb->log, next);
+    while (atomic_load(&old->writers) > 0) {
+        sched_yield();
+    }
+    atomic_store_explicit(&lb->log_full, 0, memory_order_relaxed);
+
+    // 旧ログの内容は全てランキングに反映済みなので、モード別ランキングだけを書き出す
+    uint64_t now = (uint64_t)time(NULL);
+    for (int mode = 0; mode < LEADERBOARD_MODE_COUNT; mode++) {
+        const TopK *topk = &lb->boards[1 + mode];
+        for (int i = 0; i < LEADERBOARD_K; i++) {
+            uint64_t v = atomic_load_explicit(&topk->slots[i], memory_order_acquire);
+            if (v) {
+                log_append(next, (GameMode)mode, (uint32_t)v, (int)(v >> 32), now);
+            }
+        }
+    }
+
+    int ok = msync(next->header, next->map_size, MS_SYNC) == 0 &&
+             rename(lb->tmp_path, lb->path) == 0;
+    log_unmap(old);
+    atomic_flag_clear(&lb->compacting);
+    return ok;
+}
+
+/**
+ * @brief 定期保守: ログの使用量が閾値を超えていればコンパクションする
+ */
+int leaderboard_maintain(Leaderboard *lb) {
+    if (!lb) {
+        return 0;
+    }
+    LeaderboardLog *log = log_acquire(lb);
+    uint64_t used = atomic_load_explicit(&log->header->tail, memory_order_relaxed);
+    int needed = atomic_load_explicit(&lb->log_full, memory_order_relaxed) ||
+                 used * 100 >= log->header->capacity * COMPACT_THRESHOLD_PERCENT;
+    log_release(log);
+    return needed ? leaderboard_compact(lb) : 0;
+}
@@ -0,0 +1,98 @@
+/**
+ * @file leaderboard.h
+ * @brief ロックフリーなハイスコアランキングの宣言
+ *
+ * このファイルは全体およびゲームモード別の上位K件ランキングを宣言します。
+ * 主な機能:
+ *   - 多数の試合スレッドからのロックなしのスコア登録
+ *   - 全体/モード別ランキングの読み出し
+ *   - メモリマップしたログファイルへの追記による永続化
+ *   - ログの定期的なコンパクション
+ *
+ * 設計思想:
+ *   - ランキングは (スコア, プレイヤーID) を詰めた64ビット値の配列で、CAS で最小値を置き換える
+ *   - 下限値のキャッシュにより、圏外のスコアは共有メモリへの書き込みなしで棄却
+ *   - ログ領域は fetch_add で予約し、レコード単位のコミットマーカーで途中書き込みを検出
+ *   - コンパクションはログを丸ごと差し替え、追記中のスレッドが抜けるのを待ってから旧ログを閉じる
+ */
+
+#ifndef LEADERBOARD_H
+#define LEADERBOARD_H
+
+#include <stddef.h>
+#include "../game/game_defs.h"
+
+#define LEADERBOARD_K           100 /**< 各ランキングの件数 */
+#define LEADERBOARD_GLOBAL      0   /**< 全体ランキングの番号 */
+#define LEADERBOARD_MODE_COUNT  (GAME_MODE_MULTIPLAYER + 1) /**< ゲームモード数 */
+#define LEADERBOARD_BOARD_COUNT (1 + LEADERBOARD_MODE_COUNT) /**< ランキング数 (全体 + モード別) */
+#define LEADERBOARD_DEFAULT_LOG_BYTES (4u << 20) /**< 既定のログファイルサイズ */
+
+typedef struct Leaderboard Leaderboard;
+
+/**
+ * @brief ランキングの1件
+ */
+typedef struct {
+    uint32_t player_id;          /**< プレイヤーID */
+    int score;                   /**< スコア */
+} LeaderboardEntry;
+
+/**
+ * @brief ランキングを開く (ログがあれば復元する)
+ * @param path ログファイルのパス
+ * @param log_bytes ログファイルのサイズ (0で既定値)
+ * @return 開いたランキング (失敗時はNULL)
+ */
+Leaderboard* leaderboard_open(const char *path, size_t log_bytes);
+
+/**
+ * @brief ランキングを閉じる
+ * @param lb 閉じるランキング (NULL可)
+ */
+void leaderboard_close(Leaderboard *lb);
+
+/**
+ * @brief 試合結果のスコアを登録する (ロックフリー)
+ *
+ * 同じプレイヤーの同じスコアは1件として扱います。
+ *
+ * @param lb 対象のランキング
+ * @param mode 試合のゲームモード
+ * @param player_id プレイヤーID
+ * @param score 試合終了時のスコア (score->score を使用)
+ * @return いずれかのランキングに入った場合1、圏外の場合0
+ */
+int leaderboard_submit(Leaderboard *lb, GameMode mode, uint32_t player_id, const ScoreCtx *score);
+
+/**
+ * @brief ランキングを高い順に読み出す
+ * @param lb 対象のランキング
+ * @param board LEADERBOARD_GLOBAL または 1 + GameMode
+ * @param out 出力先
+ * @param max 出力先の要素数
+ * @return 出力した件数
+ */
+int leaderboard_top(const Leaderboard *lb, int board, LeaderboardEntry *out, int max);
+
+/**
+ * @brief ログをコンパクションする (現在のランキングのみを含む新しいログに差し替える)
+ *
+ * 登録とは並行して実行できます。同時に複数のコンパクションは行いません。
+ *
+ * @param lb 対象のランキング
+ * @return 成功時1、失敗または他のコンパクション実行中の場合0
+ */
+int leaderboard_compact(Leaderboard *lb);
+
+/**
+ * @brief 定期保守: ログの使用量が閾値を超えていればコンパクションする
+ *
+ * 保守スレッドなどから定期的に呼び出してください。
+ *
+ * @param lb 対象のランキング
+ * @return コンパクションした場合1、不要または失敗した場合0
+ */
+int leaderboard_maintain(Leaderboard *lb);
+
+#endif /* LEADERBOARD_H */
@@ -0,0 +1,214 @@
+/**
+ * @file match.c
+ * @brief サーバー上の試合の記録の実装
+ *
+ * 主な機能:
+ *   - 入力ログの追加とチェックポイント時の切り詰め
+ *   - リトルエンディアン固定の直列化と検証付きの復元
+ *
+ * 設計思想:
+ *   - 入力ログはフレーム順に追記されるため、切り詰めは先頭からの除去のみ
+ */
+
+#include "match.h"
+#include <string.h>
+
+#define MATCH_WIRE_VERSION 1
+
+/**
+ * @brief 試合を初期化する
+ */
+void match_init(ServerMatch *match, uint64_t match_id, GameMode mode, uint64_t seed) {
+    memset(match, 0, sizeof(*match));
+    match->match_id = match_id;
+    match->mode = mode;
+    match->state = GAME_STATE_MENU;
+    match->rng_state = seed;
+    for (int i = 0; i < MATCH_MAX_PLAYERS; i++) {
+        match->players[i].conn = -1;
+    }
+}
+
+/**
+ * @brief 参加者を追加する
+ */
+int match_add_player(ServerMatch *match, uint32_t player_id, int conn, NetTransport transport) {
+    if (match->player_count >= MATCH_MAX_PLAYERS) {
+        return -1;
+    }
+    int index = match->player_count++;
+    MatchPlayer *p = &match->players[index];
+    p->player_id = player_id;
+    p->conn = conn;
+    p->transport = (uint8_t)transport;
+    p->alive = 1;
+    return index;
+}
+
+/**
+ * @brief 入力をログに追加する
+ */
+int match_log_input(ServerMatch *match, const MatchInput *input) {
+    if (match->input_count >= MATCH_INPUT_LOG || input->player >= match->player_count ||
+        (int32_t)(input->frame - match->checkpoint_frame) < 0) {
+        return 0;
+    }
+    // 遅れて届いた入力もフレーム順を保つ位置に入れる
+    int pos = match->input_count;
+    while (pos > 0 && (int32_t)(match->inputs[pos - 1].frame - input->frame) > 0) {
+        match->inputs[pos] = match->inputs[pos - 1];
+        pos--;
+    }
+    match->inputs[pos] = *input;
+    match->input_count++;
+    return 1;
+}
+
+/**
+ * @brief 現在のフレームでチェックポイントを取る
+ */
+void match_checkpoint(ServerMatch *match, const GamePlayContext *const gameplays[], uint64_t rng_state) {
+    for (int i = 0; i < match->player_count; i++) {
+        snapshot_capture(gameplays[i], match->frame, &match->players[i].checkpoint);
+    }
+    match->checkpoint_frame = match->frame;
+    match->rng_state = rng_state;
+
+    int drop = 0;
+    while (drop < match->input_count && (int32_t)(match->inputs[drop].frame - match->frame) < 0) {
+        drop++;
+    }
+    if (drop > 0) {
+        memmove(match->inputs, match->inputs + drop, sizeof(MatchInput) * (size_t)(match->input_count - drop));
+        match->input_count -= drop;
+    }
+}
+
+/**
+ * @brief チェックポイントの状態を復元する
+ */
+int match_restore(const ServerMatch *match, GamePlayContext *const gameplays[]) {
+    for (int i = 0; i < match->player_count; i++) {
+        if (!snapshot_restore(gameplays[i], &match->players[i].checkpoint)) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+static void put_u16(uint8_t *p, uint16_t v) {
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+}
+
+static void put_u32(uint8_t *p, uint32_t v) {
+    put_u16(p, (uint16_t)v);
+    put_u16(p + 2, (uint16_t)(v >> 16));
+}
+
+static void put_u64(uint8_t *p, uint64_t v) {
+    put_u32(p, (uint32_t)v);
+    put_u32(p + 4, (uint32_t)(v >> 32));
+}
+
+static uint16_t get_u16(const uint8_t *p) {
+    return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+static uint32_t get_u32(const uint8_t *p) {
+    return (uint32_t)get_u16(p) | ((uint32_t)get_u16(p + 2) << 16);
+}
+
+static uint64_t get_u64(const uint8_t *p) {
+    return (uint64_t)get_u32(p) | ((uint64_t)get_u32(p + 4) << 32);
+}
+
+/**
+ * @brief 試合をバイト列に直列化する
+ */
+size_t match_serialize(const ServerMatch *match, uint8_t *buf, size_t cap) {
+    size_t need = 32 + (size_t)match->player_count * MATCH_PLAYER_WIRE +
+                  (size_t)match->input_count * MATCH_INPUT_WIRE;
+    if (cap < need) {
+        return 0;
+    }
+    memset(buf, 0, 32);
+    buf[0] = MATCH_WIRE_VERSION;
+    buf[1] = (uint8_t)match->mode;
+    buf[2] = (uint8_t)match->state;
+    buf[3] = (uint8_t)match->player_count;
+    put_u16(buf + 4, (uint16_t)match->input_count);
+    put_u64(buf + 8, match->match_id);
+    put_u32(buf + 16, match->frame);
+    put_u32(buf + 20, match->checkpoint_frame);
+    put_u64(buf + 24, match->rng_state);
+
+    uint8_t *p = buf + 32;
+    for (int i = 0; i < match->player_count; i++) {
+        const MatchPlayer *player = &match->players[i];
+        put_u32(p, player->player_id);
+        p[4] = player->transport;
+        p[5] = player->alive;
+        p[6] = 0;
+        p[7] = 0;
+        snapshot_serialize(&player->checkpoint, p + 8, SNAPSHOT_WIRE_SIZE);
+        p += MATCH_PLAYER_WIRE;
+    }
+    for (int i = 0; i < match->input_count; i++) {
+        const MatchInput *in = &match->inputs[i];
+        put_u32(p, in->frame);
+        p[4] = in->player;
+        p[5] = in->key;
+        p[6] = in->pressed;
+        p += MATCH_INPUT_WIRE;
+    }
+    return need;
+}
+
+/**
+ * @brief バイト列から試合を復元する
+ */
+int match_deserialize(ServerMatch *match, const uint8_t *buf, size_t len) {
+    if (len < 32 || buf[0] != MATCH_WIRE_VERSION || buf[1] > GAME_MODE_MULTIPLAYER ||
+        buf[2] > GAME_STATE_EXIT || buf[3] > MATCH_MAX_PLAYERS) {
+        return 0;
+    }
+    int player_count = buf[3];
+    int input_count = get_u16(buf + 4);
+    if (input_count > MATCH_INPUT_LOG ||
+        len != 32 + (size_t)player_count * MATCH_PLAYER_WIRE + (size_t)input_count * MATCH_INPUT_WIRE) {
+        return 0;
+    }
+
+    match_init(match, get_u64(buf + 8), (GameMode)buf[1], get_u64(buf + 24));
+    match->state = (GameState)buf[2];
+    match->frame = get_u32(buf + 16);
+    match->checkpoint_frame = get_u32(buf + 20);
+
+    const uint8_t *p = buf + 32;
+    for (int i = 0; i < player_count; i++) {
+        MatchPlayer *player = &match->players[i];
+        player->player_id = get_u32(p);
+        player->transport = p[4];
+        player->alive = p[5] != 0;
+        if (player->transport > NET_TRANSPORT_UNIX ||
+            !snapshot_deserialize(&player->checkpoint, p + 8, SNAPSHOT_WIRE_SIZE)) {
+            return 0;
+        }
+        p += MATCH_PLAYER_WIRE;
+    }
+    match->player_count = player_count;
+    for (int i = 0; i < input_count; i++) {
+        MatchInput *in = &match->inputs[i];
+        in->frame = get_u32(p);
+        in->player = p[4];
+        in->key = p[5];
+        in->pressed = p[6];
+        if (in->player >= player_count || in->key >= KEY_COUNT || in->pressed > 1) {
+            return 0;
+        }
+        p += MATCH_INPUT_WIRE;
+    }
+    match->input_count = input_count;
+    return 1;
+}
@@ -0,0 +1,130 @@
+/**
+ * @file match.h
+ * @brief サーバー上の試合の記録の宣言
+ *
+ * このファイルはサーバーが試合ごとに持つ、再開に必要な最小限の状態を宣言します。
+ * 主な機能:
+ *   - 試合の参加者と接続の管理
+ *   - チェックポイント (全プレイヤーのスナップショット) と以降の入力ログ
+ *   - 別プロセス/別シャードへ渡すための直列化
+ *
+ * 設計思想:
+ *   - 試合はチェックポイントから入力ログを再生すれば現在のフレームまで決定的に再現できる
+ *   - 固定長・動的確保なしで、スラブプールにそのまま置ける
+ *   - 接続の記述子はプロセス内でのみ意味を持つため直列化に含めない
+ *     (復元後はすべて切断中になり、受け取った側で接続を付け直す)
+ */
+
+#ifndef MATCH_H
+#define MATCH_H
+
+#include <stddef.h>
+#include "../game/game_defs.h"
+#include "../game/snapshot.h"
+#include "../network/net_defs.h"
+
+#define MATCH_MAX_PLAYERS 4   /**< 1試合の参加者数の上限 */
+#define MATCH_INPUT_LOG   256 /**< チェックポイント以降に保持する入力数の上限 */
+#define MATCH_INPUT_WIRE  7   /**< 直列化した入力1件のサイズ */
+#define MATCH_PLAYER_WIRE (8 + SNAPSHOT_WIRE_SIZE) /**< 直列化したプレイヤー1人のサイズ */
+#define MATCH_WIRE_MAX    (32 + MATCH_MAX_PLAYERS * MATCH_PLAYER_WIRE + MATCH_INPUT_LOG * MATCH_INPUT_WIRE) /**< 直列化後の最大サイズ */
+
+/**
+ * @brief 入力ログの1件
+ */
+typedef struct {
+    uint32_t frame;              /**< 入力を適用するフレーム */
+    uint8_t player;              /**< プレイヤー番号 */
+    uint8_t key;                 /**< キー (KEY_*) */
+    uint8_t pressed;             /**< 1: 押下、0: 解放 */
+} MatchInput;
+
+/**
+ * @brief 試合の参加者
+ */
+typedef struct {
+    uint32_t player_id;          /**< プレイヤーID */
+    int conn;                    /**< 接続 (-1: 切断中) */
+    uint8_t transport;           /**< 接続のトランスポート (NetTransport) */
+    uint8_t alive;               /**< ゲームオーバーになっていない */
+    GameSnapshot checkpoint;     /**< チェックポイントの状態 */
+} MatchPlayer;
+
+/**
+ * @brief サーバー上の試合
+ */
+typedef struct {
+    uint64_t match_id;           /**< 試合ID */
+    GameMode mode;               /**< ゲームモード */
+    GameState state;             /**< 試合の状態 */
+    uint32_t frame;              /**< 次にシミュレーションするフレーム */
+    uint32_t checkpoint_frame;   /**< チェックポイントのフレーム */
+    uint64_t rng_state;          /**< テトリミノ生成の乱数状態 (チェックポイント時点) */
+    int player_count;            /**< 参加者数 */
+    MatchPlayer players[MATCH_MAX_PLAYERS]; /**< 参加者 */
+    int input_count;             /**< 入力ログの件数 */
+    MatchInput inputs[MATCH_INPUT_LOG]; /**< チェックポイント以降の入力 (フレーム順) */
+} ServerMatch;
+
+/**
+ * @brief 試合を初期化する
+ * @param match 初期化する試合
+ * @param match_id 試合ID
+ * @param mode ゲームモード
+ * @param seed テトリミノ生成の乱数の種
+ */
+void match_init(ServerMatch *match, uint64_t match_id, GameMode mode, uint64_t seed);
+
+/**
+ * @brief 参加者を追加する
+ * @param match 対象の試合
+ * @param player_id プレイヤーID
+ * @param conn 接続
+ * @param transport 接続のトランスポート
+ * @return プレイヤー番号 (満員の場合-1)
+ */
+int match_add_player(ServerMatch *match, uint32_t player_id, int conn, NetTransport transport);
+
+/**
+ * @brief 入力をログに追加する
+ * @param match 対象の試合
+ * @param input 追加する入力 (フレームはチェックポイント以降)
+ * @return 追加した場合1、ログが満杯または不正な入力の場合0 (先にチェックポイントを取る)
+ */
+int match_log_input(ServerMatch *match, const MatchInput *input);
+
+/**
+ * @brief 現在のフレームでチェックポイントを取り、それより前の入力をログから除く
+ * @param match 対象の試合
+ * @param gameplays プレイヤーごとの現在の状態 (player_count 個)
+ * @param rng_state 現在のテトリミノ生成の乱数状態
+ */
+void match_checkpoint(ServerMatch *match, const GamePlayContext *const gameplays[], uint64_t rng_state);
+
+/**
+ * @brief チェックポイントの状態を復元する (続けて入力ログを再生する)
+ * @param match 対象の試合
+ * @param gameplays 復元先 (player_count 個)
+ * @return 成功時1、失敗時0
+ */
+int match_restore(const ServerMatch *match, GamePlayContext *const gameplays[]);
+
+/**
+ * @brief 試合をバイト列に直列化する
+ * @param match 直列化する試合
+ * @param buf 出力先
+ * @param cap 出力先のサイズ (MATCH_WIRE_MAX 以上を推奨)
+ * @return 書き込んだバイト数 (失敗時0)
+ */
+size_t match_serialize(const ServerMatch *match, uint8_t *buf, size_t cap);
+
+/**
+ * @brief バイト列から試合を復元する (接続はすべて-1になる)
+ * @param match 出力先
+ * @param buf 直列化されたバイト列
+ * @param len バイト列の長さ
+ * @return 成功時1、長さや値が不正な場合0
+ */
+int match_deserialize(ServerMatch *match, const uint8_t *buf, size_t len);
+
+#endif /* MATCH_H */
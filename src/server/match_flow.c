@@ -0,0 +1,275 @@
+/**
+ * @file match_flow.c
+ * @brief サーバー上の試合の進行の実装
+ *
+ * 主な機能:
+ *   - switch 文による再開位置への分岐 (FLOW_BEGIN/FLOW_AWAIT/FLOW_END)
+ *   - イベントの反映 (準備完了、切断、再接続、要求、脱落) と待機条件の判定
+ *   - 段階の切り替えと期限の登録
+ *
+ * 設計思想:
+ *   - コルーチン内の値はすべて MatchFlow と ServerMatch に置き、局所変数を待機点を越えて使わない
+ *   - 待機条件は再開のたびに評価するため、どのイベントで再開しても誤って先へ進まない
+ *   - 再開位置は行番号のため同じバイナリ内でのみ有効 (シャード間の移動は可、再起動の引き継ぎは不可)
+ */
+
+#include "match_flow.h"
+#include <stddef.h>
+
+#define FLOW_REQ_PAUSE  0x01 /**< 一時停止の要求 */
+#define FLOW_REQ_RESUME 0x02 /**< 再開の要求 */
+
+/* コルーチンの先頭 (前回の待機点へ分岐する) */
+#define FLOW_BEGIN(f) switch ((f)->resume) { case 0:
+/* 条件が満たされるまで待機する (満たされていればそのまま進む) */
+#define FLOW_AWAIT(f, cond) do { (f)->resume = __LINE__; __attribute__((fallthrough)); \
+                                  case __LINE__: if (!(cond)) return; } while (0)
+/* コルーチンの末尾 */
+#define FLOW_END(f) } (f)->resume = 0
+
+/**
+ * @brief 進行段階に対応するゲーム状態を取得する
+ */
+GameState match_phase_state(MatchPhase phase) {
+    switch (phase) {
+        case MATCH_PHASE_PLAYING:   return GAME_STATE_PLAYING;
+        case MATCH_PHASE_PAUSED:    return GAME_STATE_PAUSED;
+        case MATCH_PHASE_GAME_OVER: return GAME_STATE_GAME_OVER;
+        case MATCH_PHASE_FINISHED:  return GAME_STATE_EXIT;
+        default:                    return GAME_STATE_NETWORKING;
+    }
+}
+
+/**
+ * @brief 進行段階の名前を取得する
+ */
+const char* match_phase_name(MatchPhase phase) {
+    static const char *const names[] = {
+        "lobby", "countdown", "playing", "paused", "reconnect-wait", "game-over", "finished"
+    };
+    return (unsigned)phase <= MATCH_PHASE_FINISHED ? names[phase] : "unknown";
+}
+
+/**
+ * @brief 進行を初期化する
+ */
+void match_flow_init(MatchFlow *flow, const ServerMatch *match) {
+    timer_node_init(&flow->timer);
+    flow->resume = 0;
+    flow->ready_mask = 0;
+    flow->disconnected_mask = 0;
+    flow->requests = 0;
+    flow->armed = 0;
+    for (int i = 0; i < match->player_count; i++) {
+        if (match->players[i].conn < 0) {
+            flow->disconnected_mask |= (uint8_t)(1u << i);
+        }
+    }
+    switch (match->state) {
+        case GAME_STATE_PLAYING:   flow->phase = MATCH_PHASE_PLAYING; break;
+        case GAME_STATE_PAUSED:    flow->phase = MATCH_PHASE_PAUSED; break;
+        case GAME_STATE_GAME_OVER: flow->phase = MATCH_PHASE_GAME_OVER; break;
+        case GAME_STATE_EXIT:      flow->phase = MATCH_PHASE_FINISHED; break;
+        default:
+            // 開始済みの試合が接続待ちだった場合は再接続待ちから
+            flow->phase = match->frame > 0 ? MATCH_PHASE_RECONNECT_WAIT : MATCH_PHASE_LOBBY;
+            break;
+    }
+}
+
+/**
+ * @brief 期限をタイマーホイールから外す
+ */
+void match_flow_detach_timer(MatchFlow *flow, TimerWheel *wheel) {
+    timer_wheel_cancel(wheel, &flow->timer);
+}
+
+/**
+ * @brief 期限を別のタイマーホイールに登録し直す
+ */
+void match_flow_attach_timer(MatchFlow *flow, TimerWheel *wheel) {
+    flow->timer.next = NULL;
+    flow->timer.prev = NULL;
+    if (flow->armed) {
+        timer_wheel_schedule(wheel, &flow->timer, flow->timer.deadline);
+    }
+}
+
+static uint8_t player_bit(int player) {
+    return (uint8_t)(1u << player);
+}
+
+static uint8_t all_players(const ServerMatch *match) {
+    return (uint8_t)((1u << match->player_count) - 1);
+}
+
+static uint8_t alive_players(const ServerMatch *match) {
+    uint8_t mask = 0;
+    for (int i = 0; i < match->player_count; i++) {
+        if (match->players[i].alive) {
+            mask |= player_bit(i);
+        }
+    }
+    return mask;
+}
+
+/**
+ * @brief 全員が揃って準備完了か判定する
+ */
+static int everyone_ready(const MatchFlow *flow, const ServerMatch *match) {
+    int needed = match->mode == GAME_MODE_MULTIPLAYER ? 2 : 1;
+    return match->player_count >= needed && flow->disconnected_mask == 0 &&
+           (flow->ready_mask & all_players(match)) == all_players(match);
+}
+
+/**
+ * @brief 勝敗が決まったか判定する (対戦は残り1人、それ以外は全員脱落)
+ */
+static int play_decided(const ServerMatch *match) {
+    int alive = __builtin_popcount(alive_players(match));
+    return match->player_count > 1 ? alive <= 1 : alive == 0;
+}
+
+/**
+ * @brief 生存中で切断しているプレイヤーのビット集合
+ */
+static uint8_t waiting_players(const MatchFlow *flow, const ServerMatch *match) {
+    return flow->disconnected_mask & alive_players(match);
+}
+
+static int expired(const MatchFlow *flow, uint32_t now) {
+    return flow->armed && (int32_t)(now - flow->timer.deadline) >= 0;
+}
+
+/**
+ * @brief 段階を切り替え、期限を設定する (ticks が0なら期限なし)
+ */
+static void enter(MatchFlow *flow, ServerMatch *match, TimerWheel *wheel, uint32_t now,
+                  MatchPhase phase, uint32_t ticks) {
+    flow->phase = (uint8_t)phase;
+    match->state = match_phase_state(phase);
+    if (ticks > 0) {
+        flow->armed = 1;
+        timer_wheel_schedule(wheel, &flow->timer, now + ticks);
+    } else {
+        flow->armed = 0;
+        timer_wheel_cancel(wheel, &flow->timer);
+    }
+}
+
+/**
+ * @brief イベントを待機条件に使う状態へ反映する
+ */
+static void apply_event(MatchFlow *flow, ServerMatch *match, MatchEventType type, int player) {
+    int valid = player >= 0 && player < match->player_count;
+    switch (type) {
+        case MATCH_EVENT_READY:
+            if (valid) flow->ready_mask |= player_bit(player);
+            break;
+        case MATCH_EVENT_DISCONNECT:
+            if (valid) {
+                flow->disconnected_mask |= player_bit(player);
+                flow->ready_mask &= (uint8_t)~player_bit(player);
+            }
+            break;
+        case MATCH_EVENT_RECONNECT:
+            if (valid) flow->disconnected_mask &= (uint8_t)~player_bit(player);
+            break;
+        case MATCH_EVENT_PAUSE:
+            flow->requests |= FLOW_REQ_PAUSE;
+            break;
+        case MATCH_EVENT_RESUME:
+            flow->requests |= FLOW_REQ_RESUME;
+            break;
+        case MATCH_EVENT_TOPOUT:
+            if (valid) match->players[player].alive = 0;
+            break;
+        default:
+            break;
+    }
+}
+
+/**
+ * @brief 進行の本体 (待機点で戻り、次の再開で続きから実行する)
+ */
+static void flow_run(MatchFlow *flow, ServerMatch *match, TimerWheel *wheel, uint32_t now) {
+    FLOW_BEGIN(flow);
+    // 引き継いだ試合は記録の段階の先頭から
+    switch (flow->phase) {
+        case MATCH_PHASE_PLAYING:        goto playing;
+        case MATCH_PHASE_PAUSED:         goto paused;
+        case MATCH_PHASE_RECONNECT_WAIT: goto reconnect_wait;
+        case MATCH_PHASE_GAME_OVER:      goto game_over;
+        case MATCH_PHASE_FINISHED:       goto finished;
+        default:                         break;
+    }
+
+    enter(flow, match, wheel, now, MATCH_PHASE_LOBBY, MATCH_FLOW_LOBBY_TICKS);
+    FLOW_AWAIT(flow, everyone_ready(flow, match) || expired(flow, now));
+    if (!everyone_ready(flow, match)) {
+        goto finished; // 揃わないまま放棄
+    }
+
+countdown:
+    // 再開の要求はここで消費済み (カウントダウン中の一時停止の要求は次の段階へ持ち越す)
+    flow->requests = 0;
+    // 開始前は通常の、途中からの再開は短いカウントダウン
+    enter(flow, match, wheel, now, MATCH_PHASE_COUNTDOWN,
+          match->frame == 0 ? MATCH_FLOW_COUNTDOWN_TICKS : MATCH_FLOW_RESUME_TICKS);
+    FLOW_AWAIT(flow, expired(flow, now) || waiting_players(flow, match));
+    if (waiting_players(flow, match)) {
+        goto reconnect_wait;
+    }
+
+playing:
+    flow->requests &= FLOW_REQ_PAUSE; // カウントダウン中の一時停止の要求は残し、すぐに一時停止する
+    enter(flow, match, wheel, now, MATCH_PHASE_PLAYING, 0);
+    FLOW_AWAIT(flow, play_decided(match) || waiting_players(flow, match) || (flow->requests & FLOW_REQ_PAUSE));
+    if (play_decided(match)) {
+        goto game_over;
+    }
+    if (waiting_players(flow, match)) {
+        goto reconnect_wait;
+    }
+
+paused:
+    flow->requests = 0;
+    enter(flow, match, wheel, now, MATCH_PHASE_PAUSED, MATCH_FLOW_PAUSE_TICKS);
+    FLOW_AWAIT(flow, (flow->requests & FLOW_REQ_RESUME) || expired(flow, now) || waiting_players(flow, match));
+    if (waiting_players(flow, match)) {
+        goto reconnect_wait;
+    }
+    goto countdown;
+
+reconnect_wait:
+    enter(flow, match, wheel, now, MATCH_PHASE_RECONNECT_WAIT, MATCH_FLOW_RECONNECT_TICKS);
+    FLOW_AWAIT(flow, !waiting_players(flow, match) || expired(flow, now));
+    // 猶予内に戻らなかったプレイヤーは脱落
+    for (int i = 0; i < match->player_count; i++) {
+        if (waiting_players(flow, match) & player_bit(i)) {
+            match->players[i].alive = 0;
+        }
+    }
+    if (!play_decided(match)) {
+        goto countdown;
+    }
+
+game_over:
+    enter(flow, match, wheel, now, MATCH_PHASE_GAME_OVER, MATCH_FLOW_RESULTS_TICKS);
+    FLOW_AWAIT(flow, expired(flow, now));
+
+finished:
+    enter(flow, match, wheel, now, MATCH_PHASE_FINISHED, 0);
+    FLOW_AWAIT(flow, 0);
+    FLOW_END(flow);
+}
+
+/**
+ * @brief イベントを反映して進行を再開する
+ */
+MatchPhase match_flow_resume(MatchFlow *flow, ServerMatch *match, TimerWheel *wheel, uint32_t now,
+                             MatchEventType type, int player) {
+    apply_event(flow, match, type, player);
+    flow_run(flow, match, wheel, now);
+    return (MatchPhase)flow->phase;
+}
@@ -0,0 +1,122 @@
+/**
+ * @file match_flow.h
+ * @brief サーバー上の試合の進行 (スタックレスコルーチン) の宣言
+ *
+ * このファイルは試合の待機室から結果表示までの流れを、シャードのイベントループと
+ * タイマーホイールから再開されるスタックレスコルーチンとして宣言します。
+ * 主な機能:
+ *   - 進行段階: 待機室 → カウントダウン → プレイ中 ⇄ 一時停止 / 再接続待ち → ゲームオーバー → 終了
+ *   - 参加者の準備完了、切断、再接続、一時停止/再開、脱落のイベントによる再開
+ *   - 各段階の期限 (待機室の放棄、カウントダウン、一時停止の上限、再接続の猶予、結果表示)
+ *   - 進行段階に対応する GameState の試合の記録への反映
+ *
+ * 設計思想:
+ *   - 試合ごとのスレッドやスタックを持たず、再開位置と数バイトの状態のみを試合に埋め込む
+ *   - 進行は1つの関数に上から順に書き、イベントごとのコールバックに分散させない
+ *   - 期限はシャードのタイマーホイールに登録し、期限の到来もイベントの1つとして再開する
+ *   - 再起動の引き継ぎ後は試合の記録の GameState から該当する段階の先頭で再開する
+ */
+
+#ifndef MATCH_FLOW_H
+#define MATCH_FLOW_H
+
+#include <stdint.h>
+#include "match.h"
+#include "timer_wheel.h"
+
+#define MATCH_FLOW_LOBBY_TICKS      (60 * 60) /**< 待機室で全員の準備完了を待つ上限 (ティック) */
+#define MATCH_FLOW_COUNTDOWN_TICKS  (3 * 60)  /**< 開始前のカウントダウン */
+#define MATCH_FLOW_RESUME_TICKS     60        /**< 一時停止/再接続後の再開前のカウントダウン */
+#define MATCH_FLOW_PAUSE_TICKS      (30 * 60) /**< 一時停止の上限 (超えると自動で再開) */
+#define MATCH_FLOW_RECONNECT_TICKS  (20 * 60) /**< 切断したプレイヤーの再接続の猶予 */
+#define MATCH_FLOW_RESULTS_TICKS    (10 * 60) /**< 結果表示の時間 */
+
+/* 進行段階の列挙型 */
+typedef enum {
+    MATCH_PHASE_LOBBY,           /**< 待機室 (参加者の準備完了待ち) */
+    MATCH_PHASE_COUNTDOWN,       /**< 開始/再開前のカウントダウン */
+    MATCH_PHASE_PLAYING,         /**< プレイ中 (シミュレーションを進める) */
+    MATCH_PHASE_PAUSED,          /**< 一時停止中 */
+    MATCH_PHASE_RECONNECT_WAIT,  /**< 切断したプレイヤーの再接続待ち */
+    MATCH_PHASE_GAME_OVER,       /**< ゲームオーバー (結果表示) */
+    MATCH_PHASE_FINISHED         /**< 終了 (試合を解放してよい) */
+} MatchPhase;
+
+/* 進行を再開するイベントの列挙型 */
+typedef enum {
+    MATCH_EVENT_START,           /**< 進行の開始 (作成/復元の直後) */
+    MATCH_EVENT_READY,           /**< プレイヤーの準備完了 */
+    MATCH_EVENT_DISCONNECT,      /**< プレイヤーの切断 */
+    MATCH_EVENT_RECONNECT,       /**< プレイヤーの再接続 */
+    MATCH_EVENT_PAUSE,           /**< 一時停止の要求 */
+    MATCH_EVENT_RESUME,          /**< 再開の要求 */
+    MATCH_EVENT_TOPOUT,          /**< プレイヤーの脱落 */
+    MATCH_EVENT_TIMER            /**< 期限の到来 */
+} MatchEventType;
+
+/**
+ * @brief 試合の進行 (試合に埋め込む)
+ */
+typedef struct {
+    TimerNode timer;             /**< 段階の期限 */
+    uint16_t resume;             /**< コルーチンの再開位置 (0: 先頭) */
+    uint8_t phase;               /**< 進行段階 (MatchPhase) */
+    uint8_t ready_mask;          /**< 準備完了のプレイヤーのビット集合 */
+    uint8_t disconnected_mask;   /**< 切断中のプレイヤーのビット集合 */
+    uint8_t requests;            /**< 一時停止/再開の要求 */
+    uint8_t armed;               /**< 期限を設定中 */
+} MatchFlow;
+
+/**
+ * @brief 進行を初期化する
+ *
+ * 試合の記録の GameState から開始段階を決めます (新しい試合は待機室、
+ * 引き継いだ試合は記録の段階)。接続のない参加者は切断中として扱います。
+ *
+ * @param flow 対象の進行
+ * @param match 試合の記録
+ */
+void match_flow_init(MatchFlow *flow, const ServerMatch *match);
+
+/**
+ * @brief イベントを反映して進行を再開する (次の待機点まで進める)
+ * @param flow 対象の進行
+ * @param match 試合の記録 (state を更新する)
+ * @param wheel 期限を登録するタイマーホイール
+ * @param now 現在のティック
+ * @param type イベント種別
+ * @param player イベントのプレイヤー番号 (プレイヤーに関係しないイベントでは無視)
+ * @return 再開後の進行段階
+ */
+MatchPhase match_flow_resume(MatchFlow *flow, ServerMatch *match, TimerWheel *wheel, uint32_t now,
+                             MatchEventType type, int player);
+
+/**
+ * @brief 期限をタイマーホイールから外す (試合を別のシャードへ移す前に)
+ * @param flow 対象の進行
+ * @param wheel 登録中のタイマーホイール
+ */
+void match_flow_detach_timer(MatchFlow *flow, TimerWheel *wheel);
+
+/**
+ * @brief 期限を別のタイマーホイールに登録し直す (移動先で)
+ * @param flow 対象の進行 (match_flow_detach_timer 済み)
+ * @param wheel 登録先のタイマーホイール
+ */
+void match_flow_attach_timer(MatchFlow *flow, TimerWheel *wheel);
+
+/**
+ * @brief 進行段階に対応するゲーム状態を取得する
+ * @param phase 進行段階
+ * @return ゲーム状態 (待機室、カウントダウン、再接続待ちは GAME_STATE_NETWORKING)
+ */
+GameState match_phase_state(MatchPhase phase);
+
+/**
+ * @brief 進行段階の名前を取得する (ログ用)
+ * @param phase 進行段階
+ * @return 名前
+ */
+const char* match_phase_name(MatchPhase phase);
+
+#endif /* MATCH_FLOW_H */
@@ -0,0 +1,475 @@
+/**
+ * @file matchmaker.c
+ * @brief レーティングと回線品質に基づくマッチメイキング実装
+ *
+ * 主な機能:
+ *   - インデックス付き二分ヒープ (待ち時間順/シャード負荷順)
+ *   - Ping帯 x レーティング帯の双方向リストによる相手探し
+ *   - 世代付きハンドルによる安全な取り消し
+ *
+ * 設計思想:
+ *   - ヒープ内の位置をチケット側に保持し、任意要素の削除を O(log n) に
+ *   - レーティング帯リストは末尾追加のため、先頭ほど待ち時間が長い
+ *   - 1つのレーティング帯で調べる候補数を固定し、偏った分布でも時間を抑える
+ */
+
+#include "matchmaker.h"
+#include <stdlib.h>
+
+#define MM_NONE              (-1)
+#define MM_RATING_BUCKETS    (MATCHMAKER_RATING_MAX / MATCHMAKER_RATING_BUCKET + 1)
+#define MM_CANDIDATES_PER_BUCKET 4   /**< 1レーティング帯で調べる候補数 */
+#define MM_INDEX_BITS        20      /**< ハンドル内のインデックスのビット数 */
+#define MM_GEN_MASK          0x7FF   /**< ハンドル内の世代のマスク */
+
+/**
+ * @brief インデックス付き二分ヒープ (キー最小が先頭)
+ */
+typedef struct {
+    int* items;                  /**< 要素ハンドル */
+    int64_t* keys;               /**< 要素のキー */
+    int* pos;                    /**< ハンドルごとのヒープ内位置 (未登録はMM_NONE) */
+    int size;                    /**< 要素数 */
+} IndexedHeap;
+
+/**
+ * @brief チケットの内部表現
+ */
+typedef struct {
+    MatchmakerTicket ticket;     /**< 登録内容 */
+    int prev;                    /**< レーティング帯リストの前 */
+    int next;                    /**< レーティング帯リストの次 / 空きリストの次 */
+    uint16_t list;               /**< 所属するリスト */
+    uint16_t generation;         /**< ハンドルの世代 */
+    uint8_t in_use;              /**< 使用中フラグ */
+} MmEntry;
+
+/**
+ * @brief レーティング帯リスト
+ */
+typedef struct {
+    int head;                    /**< 先頭 (最古) */
+    int tail;                    /**< 末尾 (最新) */
+} MmList;
+
+struct Matchmaker {
+    MmEntry* entries;            /**< チケットプール */
+    int max_players;             /**< チケット数の上限 */
+    int free_head;               /**< 空きチケットリスト */
+    int queued;                  /**< 待機中のチケット数 */
+    IndexedHeap wait_heap;       /**< 登録時刻順のヒープ */
+    int* deferred;               /**< 組み合わせを保留したチケット (poll用の作業領域) */
+    MmList lists[MATCHMAKER_PING_BUCKETS * MM_RATING_BUCKETS]; /**< Ping帯 x レーティング帯 */
+    IndexedHeap shard_heap;      /**< 負荷順のシャードヒープ */
+    int* shard_ids;              /**< シャード番号からシャードIDへの対応 */
+    int shard_count;             /**< 登録済みシャード数 */
+    int max_shards;              /**< シャード数の上限 */
+    MatchmakerCallback callback; /**< 成立時のコールバック */
+    void* user;                  /**< コールバックのデータ */
+};
+
+/* ---- インデックス付きヒープ ---- */
+
+static int heap_init(IndexedHeap *heap, int capacity) {
+    heap->items = (int*)malloc(sizeof(int) * (size_t)capacity);
+    heap->keys = (int64_t*)malloc(sizeof(int64_t) * (size_t)capacity);
+    heap->pos = (int*)malloc(sizeof(int) * (size_t)capacity);
+    heap->size = 0;
+    if (!heap->items || !heap->keys || !heap->pos) {
+        return 0;
+    }
+    for (int i = 0; i < capacity; i++) {
+        heap->pos[i] = MM_NONE;
+    }
+    return 1;
+}
+
+static void heap_free(IndexedHeap *heap) {
+    free(heap->items);
+    free(heap->keys);
+    free(heap->pos);
+}
+
+static void heap_set(IndexedHeap *heap, int i, int item, int64_t key) {
+    heap->items[i] = item;
+    heap->keys[i] = key;
+    heap->pos[item] = i;
+}
+
+static void heap_sift_up(IndexedHeap *heap, int i) {
+    int item = heap->items[i];
+    int64_t key = heap->keys[i];
+    while (i > 0) {
+        int parent = (i - 1) / 2;
+        if (heap->keys[parent] <= key) {
+            break;
+        }
+        heap_set(heap, i, heap->items[parent], heap->keys[parent]);
+        i = parent;
+    }
+    heap_set(heap, i, item, key);
+}
+
+static void heap_sift_down(IndexedHeap *heap, int i) {
+    int item = heap->items[i];
+    int64_t key = heap->keys[i];
+    for (;;) {
+        int child = 2 * i + 1;
+        if (child >= heap->size) {
+            break;
+        }
+        if (child + 1 < heap->size && heap->keys[child + 1] < heap->keys[child]) {
+            child++;
+        }
+        if (key <= heap->keys[child]) {
+            break;
+        }
+        heap_set(heap, i, heap->items[child], heap->keys[child]);
+        i = child;
+    }
+    heap_set(heap, i, item, key);
+}
+
+static void heap_push(IndexedHeap *heap, int item, int64_t key) {
+    heap_set(heap, heap->size++, item, key);
+    heap_sift_up(heap, heap->size - 1);
+}
+
+static void heap_remove(IndexedHeap *heap, int item) {
+    int i = heap->pos[item];
+    if (i == MM_NONE) {
+        return;
+    }
+    heap->pos[item] = MM_NONE;
+    int last = --heap->size;
+    if (i == last) {
+        return;
+    }
+    int moved = heap->items[last];
+    heap_set(heap, i, moved, heap->keys[last]);
+    heap_sift_down(heap, i);
+    heap_sift_up(heap, heap->pos[moved]);
+}
+
+static void heap_update(IndexedHeap *heap, int item, int64_t key) {
+    int i = heap->pos[item];
+    int64_t old = heap->keys[i];
+    heap->keys[i] = key;
+    if (key < old) {
+        heap_sift_up(heap, i);
+    } else {
+        heap_sift_down(heap, i);
+    }
+}
+
+/* ---- チケット管理 ---- */
+
+static int clamp_rating(int rating) {
+    if (rating < 0) return 0;
+    if (rating > MATCHMAKER_RATING_MAX) return MATCHMAKER_RATING_MAX;
+    return rating;
+}
+
+static int ping_bucket(int ping_ms) {
+    int b = ping_ms / MATCHMAKER_PING_STEP_MS;
+    if (b < 0) return 0;
+    if (b >= MATCHMAKER_PING_BUCKETS) return MATCHMAKER_PING_BUCKETS - 1;
+    return b;
+}
+
+static int list_index(int ping_b, int rating_b) {
+    return ping_b * MM_RATING_BUCKETS + rating_b;
+}
+
+static void list_append(Matchmaker *mm, int list, int idx) {
+    MmList *l = &mm->lists[list];
+    MmEntry *e = &mm->entries[idx];
+    e->list = (uint16_t)list;
+    e->prev = l->tail;
+    e->next = MM_NONE;
+    if (l->tail != MM_NONE) {
+        mm->entries[l->tail].next = idx;
+    } else {
+        l->head = idx;
+    }
+    l->tail = idx;
+}
+
+static void list_unlink(Matchmaker *mm, int idx) {
+    MmEntry *e = &mm->entries[idx];
+    MmList *l = &mm->lists[e->list];
+    if (e->prev != MM_NONE) {
+        mm->entries[e->prev].next = e->next;
+    } else {
+        l->head = e->next;
+    }
+    if (e->next != MM_NONE) {
+        mm->entries[e->next].prev = e->prev;
+    } else {
+        l->tail = e->prev;
+    }
+}
+
+/**
+ * @brief 待ち行列からチケットを外して空きリストへ戻す
+ */
+static void entry_release(Matchmaker *mm, int idx) {
+    MmEntry *e = &mm->entries[idx];
+    list_unlink(mm, idx);
+    heap_remove(&mm->wait_heap, idx);
+    e->in_use = 0;
+    e->generation = (uint16_t)((e->generation + 1) & MM_GEN_MASK);
+    if (e->generation == 0) {
+        e->generation = 1;
+    }
+    e->next = mm->free_head;
+    mm->free_head = idx;
+    mm->queued--;
+}
+
+/**
+ * @brief 許容幅内で最も待ち時間の長い相手を探す
+ */
+static int find_partner(Matchmaker *mm, int idx, int window) {
+    const MmEntry *self = &mm->entries[idx];
+    int rating = clamp_rating(self->ticket.rating);
+    int pb = ping_bucket(self->ticket.ping_ms);
+    int lo = clamp_rating(rating - window) / MATCHMAKER_RATING_BUCKET;
+    int hi = clamp_rating(rating + window) / MATCHMAKER_RATING_BUCKET;
+    int center = rating / MATCHMAKER_RATING_BUCKET;
+
+    int best = MM_NONE;
+    uint32_t best_time = 0;
+    // 中心のレーティング帯から外側へ向かって調べる
+    for (int d = 0; center - d >= lo || center + d <= hi; d++) {
+        for (int side = 0; side < 2; side++) {
+            int rb = side ? center + d : center - d;
+            if ((side && d == 0) || rb < lo || rb > hi) {
+                continue;
+            }
+            int c = mm->lists[list_index(pb, rb)].head;
+            for (int n = 0; c != MM_NONE && n < MM_CANDIDATES_PER_BUCKET; c = mm->entries[c].next, n++) {
+                const MmEntry *cand = &mm->entries[c];
+                if (c == idx || abs(clamp_rating(cand->ticket.rating) - rating) > window) {
+                    continue;
+                }
+                if (best == MM_NONE || cand->ticket.enqueue_ms < best_time) {
+                    best = c;
+                    best_time = cand->ticket.enqueue_ms;
+                }
+                break; // 帯の中では先頭ほど古い
+            }
+        }
+        if (best != MM_NONE) {
+            break; // 最も近いレーティング帯を優先
+        }
+    }
+    return best;
+}
+
+/**
+ * @brief 最も負荷の低いシャードを選び、負荷を加算する
+ */
+static int assign_shard(Matchmaker *mm) {
+    if (mm->shard_heap.size == 0) {
+        return -1;
+    }
+    int slot = mm->shard_heap.items[0];
+    heap_update(&mm->shard_heap, slot, mm->shard_heap.keys[0] + 1);
+    return mm->shard_ids[slot];
+}
+
+/**
+ * @brief 組み合わせを成立させ、両チケットを解放する
+ */
+static void make_match(Matchmaker *mm, int a, int b) {
+    MatchmakerTicket ta = mm->entries[a].ticket;
+    MatchmakerTicket tb = mm->entries[b].ticket;
+    if (tb.enqueue_ms < ta.enqueue_ms) {
+        MatchmakerTicket t = ta;
+        ta = tb;
+        tb = t;
+    }
+    entry_release(mm, a);
+    entry_release(mm, b);
+    int shard = assign_shard(mm);
+    if (mm->callback) {
+        mm->callback(&ta, &tb, shard, mm->user);
+    }
+}
+
+/**
+ * @brief 待ち時間から許容幅を求める
+ */
+static int rating_window(uint32_t waited_ms) {
+    uint32_t window = MATCHMAKER_BASE_WINDOW + (waited_ms / 1000) * MATCHMAKER_WIDEN_PER_SEC;
+    return window > MATCHMAKER_MAX_WINDOW ? MATCHMAKER_MAX_WINDOW : (int)window;
+}
+
+/* ---- 公開関数 ---- */
+
+/**
+ * @brief マッチメーカーを作成する
+ */
+Matchmaker* matchmaker_create(int max_players, int max_shards,
+                              MatchmakerCallback callback, void *user) {
+    if (max_players <= 0 || max_players >= (1 << MM_INDEX_BITS) || max_shards < 0) {
+        return NULL;
+    }
+
+    Matchmaker *mm = (Matchmaker*)calloc(1, sizeof(Matchmaker));
+    if (!mm) {
+        return NULL;
+    }
+    mm->max_players = max_players;
+    mm->max_shards = max_shards;
+    mm->callback = callback;
+    mm->user = user;
+    mm->entries = (MmEntry*)calloc((size_t)max_players, sizeof(MmEntry));
+    mm->shard_ids = (int*)calloc((size_t)(max_shards > 0 ? max_shards : 1), sizeof(int));
+    mm->deferred = (int*)malloc(sizeof(int) * (size_t)max_players);
+    if (!mm->entries || !mm->shard_ids || !mm->deferred ||
+        !heap_init(&mm->wait_heap, max_players) ||
+        !heap_init(&mm->shard_heap, max_shards > 0 ? max_shards : 1)) {
+        matchmaker_destroy(mm);
+        return NULL;
+    }
+
+    for (int i = 0; i < max_players; i++) {
+        mm->entries[i].next = (i + 1 < max_players) ? i + 1 : MM_NONE;
+        mm->entries[i].generation = 1;
+    }
+    mm->free_head = 0;
+    for (int i = 0; i < MATCHMAKER_PING_BUCKETS * MM_RATING_BUCKETS; i++) {
+        mm->lists[i].head = MM_NONE;
+        mm->lists[i].tail = MM_NONE;
+    }
+    return mm;
+}
+
+/**
+ * @brief マッチメーカーを解放する
+ */
+void matchmaker_destroy(Matchmaker *mm) {
+    if (!mm) {
+        return;
+    }
+    heap_free(&mm->wait_heap);
+    heap_free(&mm->shard_heap);
+    free(mm->entries);
+    free(mm->shard_ids);
+    free(mm->deferred);
+    free(mm);
+}
+
+/**
+ * @brief シャードを登録する
+ */
+int matchmaker_add_shard(Matchmaker *mm, int shard_id, int load) {
+    if (!mm || mm->shard_count >= mm->max_shards) {
+        return 0;
+    }
+    int slot = mm->shard_count++;
+    mm->shard_ids[slot] = shard_id;
+    heap_push(&mm->shard_heap, slot, load);
+    return 1;
+}
+
+/**
+ * @brief シャードの負荷を更新する
+ */
+int matchmaker_set_shard_load(Matchmaker *mm, int shard_id, int load) {
+    if (!mm) {
+        return 0;
+    }
+    for (int slot = 0; slot < mm->shard_count; slot++) {
+        if (mm->shard_ids[slot] == shard_id) {
+            heap_update(&mm->shard_heap, slot, load);
+            return 1;
+        }
+    }
+    return 0;
+}
+
+/**
+ * @brief プレイヤーを待ち行列に登録する
+ */
+int matchmaker_enqueue(Matchmaker *mm, const MatchmakerTicket *ticket) {
+    if (!mm || !ticket || mm->free_head == MM_NONE) {
+        return -1;
+    }
+
+    int idx = mm->free_head;
+    MmEntry *e = &mm->entries[idx];
+    mm->free_head = e->next;
+    e->ticket = *ticket;
+    e->in_use = 1;
+    mm->queued++;
+
+    int rb = clamp_rating(ticket->rating) / MATCHMAKER_RATING_BUCKET;
+    list_append(mm, list_index(ping_bucket(ticket->ping_ms), rb), idx);
+    heap_push(&mm->wait_heap, idx, ticket->enqueue_ms);
+
+    int partner = find_partner(mm, idx, MATCHMAKER_BASE_WINDOW);
+    if (partner != MM_NONE) {
+        make_match(mm, idx, partner);
+        return 0;
+    }
+    return (e->generation << MM_INDEX_BITS) | idx;
+}
+
+/**
+ * @brief 待ち行列から取り消す
+ */
+int matchmaker_cancel(Matchmaker *mm, int handle) {
+    if (!mm || handle <= 0) {
+        return 0;
+    }
+    int idx = handle & ((1 << MM_INDEX_BITS) - 1);
+    int gen = (handle >> MM_INDEX_BITS) & MM_GEN_MASK;
+    if (idx >= mm->max_players || !mm->entries[idx].in_use || mm->entries[idx].generation != gen) {
+        return 0;
+    }
+    entry_release(mm, idx);
+    return 1;
+}
+
+/**
+ * @brief 待ち時間の長いプレイヤーから順に組み合わせを試みる
+ */
+int matchmaker_poll(Matchmaker *mm, uint32_t now_ms, int max_checks) {
+    if (!mm) {
+        return 0;
+    }
+
+    // 成立しなかったプレイヤーは一旦ヒープから外し、最後に戻す
+    int deferred = 0;
+    int matches = 0;
+    for (int i = 0; i < max_checks && mm->wait_heap.size > 0; i++) {
+        int idx = mm->wait_heap.items[0];
+        MmEntry *e = &mm->entries[idx];
+        int partner = find_partner(mm, idx, rating_window(now_ms - e->ticket.enqueue_ms));
+        if (partner != MM_NONE) {
+            make_match(mm, idx, partner);
+            matches++;
+        } else {
+            heap_remove(&mm->wait_heap, idx);
+            mm->deferred[deferred++] = idx;
+        }
+    }
+    for (int i = 0; i < deferred; i++) {
+        int idx = mm->deferred[i];
+        // 保留中に相手として選ばれたものは戻さない
+        if (mm->entries[idx].in_use && mm->wait_heap.pos[idx] == MM_NONE) {
+            heap_push(&mm->wait_heap, idx, mm->entries[idx].ticket.enqueue_ms);
+        }
+    }
+    return matches;
+}
+
+/**
+ * @brief 待機中のプレイヤー数を取得する
+ */
+int matchmaker_queue_length(const Matchmaker *mm) {
+    return mm ? mm->queued : 0;
+}
@@ -0,0 +1,124 @@
+/**
+ * @file matchmaker.h
+ * @brief レーティングと回線品質に基づくマッチメイキングの宣言
+ *
+ * このファイルは対戦待ちのプレイヤーを組み合わせるマッチメーカーを宣言します。
+ * 主な機能:
+ *   - 待ち行列への登録と取り消し
+ *   - 同じPing帯でレーティングの近いプレイヤー同士の組み合わせ
+ *   - 待ち時間に応じたレーティング許容幅の拡大
+ *   - 最も負荷の低いサーバーシャードへの割り当て
+ *
+ * 設計思想:
+ *   - 待ち時間順のインデックス付きヒープで登録/取り消し/最古取得を O(log n) に
+ *   - 相手探しはレーティング帯ごとのリストで行い、許容幅に比例する定数時間
+ *   - 固定容量のチケットプールで動的確保を排除
+ *   - ネットワーク層に依存せず、結果はコールバックで通知
+ */
+
+#ifndef MATCHMAKER_H
+#define MATCHMAKER_H
+
+#include <stdint.h>
+
+#define MATCHMAKER_RATING_MAX     4000 /**< 扱うレーティングの上限 */
+#define MATCHMAKER_RATING_BUCKET  25   /**< レーティング帯の幅 */
+#define MATCHMAKER_PING_BUCKETS   8    /**< Ping帯の数 */
+#define MATCHMAKER_PING_STEP_MS   40   /**< Ping帯の幅 (ms) */
+#define MATCHMAKER_BASE_WINDOW    50   /**< 登録直後のレーティング許容幅 */
+#define MATCHMAKER_WIDEN_PER_SEC  25   /**< 待ち1秒あたりの許容幅の拡大量 */
+#define MATCHMAKER_MAX_WINDOW     600  /**< レーティング許容幅の上限 */
+
+typedef struct Matchmaker Matchmaker;
+
+/**
+ * @brief 待ち行列のチケット
+ */
+typedef struct {
+    uint64_t player_id;          /**< プレイヤーID */
+    int rating;                  /**< レーティング */
+    int ping_ms;                 /**< 計測したPing (ms) */
+    uint32_t enqueue_ms;         /**< 登録時刻 (ms) */
+} MatchmakerTicket;
+
+/**
+ * @brief 組み合わせ成立時のコールバック
+ * @param a 1人目のチケット (待ち時間が長い方)
+ * @param b 2人目のチケット
+ * @param shard_id 割り当てたシャード (シャード未登録時は-1)
+ * @param user 呼び出し側のデータ
+ */
+typedef void (*MatchmakerCallback)(const MatchmakerTicket *a, const MatchmakerTicket *b,
+                                   int shard_id, void *user);
+
+/**
+ * @brief マッチメーカーを作成する
+ * @param max_players 同時に待機できるプレイヤー数
+ * @param max_shards 登録できるシャード数
+ * @param callback 組み合わせ成立時のコールバック
+ * @param user コールバックに渡すデータ
+ * @return 作成したマッチメーカー (失敗時はNULL)
+ */
+Matchmaker* matchmaker_create(int max_players, int max_shards,
+                              MatchmakerCallback callback, void *user);
+
+/**
+ * @brief マッチメーカーを解放する
+ * @param mm 解放するマッチメーカー (NULL可)
+ */
+void matchmaker_destroy(Matchmaker *mm);
+
+/**
+ * @brief シャードを登録する
+ * @param mm 対象のマッチメーカー
+ * @param shard_id シャードID
+ * @param load 現在の負荷 (進行中の試合数など)
+ * @return 成功時1、失敗時0
+ */
+int matchmaker_add_shard(Matchmaker *mm, int shard_id, int load);
+
+/**
+ * @brief シャードの負荷を更新する
+ * @param mm 対象のマッチメーカー
+ * @param shard_id シャードID
+ * @param load 新しい負荷
+ * @return 成功時1、未登録の場合0
+ */
+int matchmaker_set_shard_load(Matchmaker *mm, int shard_id, int load);
+
+/**
+ * @brief プレイヤーを待ち行列に登録する
+ *
+ * 登録時に許容幅内の相手がいれば、その場で組み合わせを成立させます。
+ *
+ * @param mm 対象のマッチメーカー
+ * @param ticket 登録するチケット
+ * @return チケットハンドル (即座に成立した場合0、失敗時-1)
+ */
+int matchmaker_enqueue(Matchmaker *mm, const MatchmakerTicket *ticket);
+
+/**
+ * @brief 待ち行列から取り消す
+ * @param mm 対象のマッチメーカー
+ * @param handle matchmaker_enqueue が返したハンドル
+ * @return 取り消した場合1、既に成立/取り消し済みの場合0
+ */
+int matchmaker_cancel(Matchmaker *mm, int handle);
+
+/**
+ * @brief 待ち時間の長いプレイヤーから順に組み合わせを試みる
+ * @param mm 対象のマッチメーカー
+ * @param now_ms 現在時刻 (ms)
+ * @param max_checks 調べるプレイヤー数の上限
+ * @return 成立した組み合わせ数
+ */
+int matchmaker_poll(Matchmaker *mm, uint32_t now_ms, int max_checks);
+
+/**
+ * @brief 待機中のプレイヤー数を取得する
+ * @param mm 対象のマッチメーカー
+ * @return 待機中のプレイヤー数
+ */
+int matchmaker_queue_length(const Matchmaker *mm);
+
+#endif /* MATCHMAKER_H */
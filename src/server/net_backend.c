@@ -0,0 +1,950 @@
+/**
+ * @file net_backend.c
+ * @brief ゲームサーバーの接続I/Oバックエンド実装
+ *
+ * 主な機能:
+ *   - 接続表と送信バッファ、未送信の接続リストの管理 (両バックエンド共通)
+ *   - epoll: レベルトリガーでの受信と、送信しきれない場合のみの EPOLLOUT 監視
+ *   - io_uring: liburing を使わずシステムコールとリングのメモリマップで直接操作
+ *
+ * 設計思想:
+ *   - 接続はソケットのファイル記述子で識別し、接続表は記述子で直接引く
+ *   - io_uring の受信はマルチショット recv と提供バッファリングで、再投入なしに受信し続ける
+ *   - 受信バッファは次の poll の先頭でまとめてリングへ返却する (呼び出し側がデータを参照できる期間)
+ *   - 送信は接続ごとに同時に1件のみ発行し、完了時に未送信分が残っていれば次の flush で続きを送る
+ *   - 投入キューが満杯で投入できなかった recv/accept は、次の poll の先頭で投入し直す
+ *   - 切り離しは受信の取り消しと送信中の完了を待ってから、次の poll の先頭でイベントとして返す
+ */
+
+#define _GNU_SOURCE // accept4 と syscall
+
+#include "net_backend.h"
+#include <errno.h>
+#include <linux/io_uring.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/epoll.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/syscall.h>
+#include <sys/utsname.h>
+#include <time.h>
+#include <unistd.h>
+
+#define NET_EPOLL_EVENTS  256  /**< epoll_wait 1回で取得するイベント数の上限 */
+#define NET_URING_ENTRIES 4096 /**< 投入キューの長さ */
+#define NET_URING_BGID    0    /**< 受信バッファグループの番号 */
+
+/* io_uring の操作種別 (user_data の上位32ビット) */
+enum {
+    URING_OP_ACCEPT = 1,         /**< マルチショット accept */
+    URING_OP_RECV,               /**< マルチショット recv */
+    URING_OP_SEND,               /**< send */
+    URING_OP_CANCEL              /**< 切り離し時の recv の取り消し */
+};
+
+/**
+ * @brief 接続の状態
+ */
+typedef struct {
+    uint8_t* out;                /**< 送信バッファ (初回送信時に確保) */
+    uint32_t out_len;            /**< 送信バッファ内のデータ長 (送信中の分を含む) */
+    uint32_t inflight;           /**< 送信中のデータ長 (io_uring) */
+    uint8_t open;                /**< 接続が有効 */
+    uint8_t closing;             /**< 閉じる処理中 (io_uring: 受信の終了待ち) */
+    uint8_t recv_armed;          /**< マルチショット recv が有効 (io_uring) */
+    uint8_t arm_pending;         /**< 投入キューが満杯で recv を再投入待ち (io_uring) */
+    uint8_t want_out;            /**< EPOLLOUT を監視中 (epoll) */
+    uint8_t dirty;               /**< 未送信リストに登録済み */
+    uint8_t detaching;           /**< 切り離し処理中 */
+} NetConn;
+
+/**
+ * @brief I/Oバックエンド
+ */
+struct NetBackend {
+    NetBackendKind kind;         /**< 使用中のバックエンド種別 */
+    int listen_fd;               /**< 待ち受けソケット */
+    int max_conns;               /**< 接続の記述子の上限 */
+    NetConn* conns;              /**< 接続表 (記述子で引く) */
+    int* dirty;                  /**< 未送信データのある接続 */
+    int dirty_count;             /**< 未送信データのある接続数 */
+    int* detached;               /**< 切り離しが完了し、イベント未通知の接続 */
+    int detached_count;          /**< detached の数 */
+    int* rearm;                  /**< recv の投入を待っている接続 (io_uring) */
+    int rearm_count;             /**< rearm の数 */
+
+    /* epoll */
+    int epfd;                    /**< epoll インスタンス */
+    struct epoll_event* ep_events; /**< epoll_wait の出力先 */
+    uint8_t* scratch;            /**< 受信データの置き場 (イベントごとに1区画) */
+
+    /* io_uring */
+    int ring_fd;                 /**< io_uring インスタンス */
+    void* ring_mem;              /**< 投入/完了リングのマップ */
+    size_t ring_size;            /**< ring_mem のサイズ */
+    struct io_uring_sqe* sqes;   /**< 投入エントリ */
+    size_t sqes_size;            /**< sqes のサイズ */
+    uint32_t* sq_head;           /**< 投入リングの先頭 (カーネルが更新) */
+    uint32_t* sq_tail;           /**< 投入リングの末尾 */
+    uint32_t sq_mask;            /**< 投入リングのマスク */
+    uint32_t sq_entries;         /**< 投入リングの長さ */
+    uint32_t sq_local_tail;      /**< 準備済みで未公開の末尾 */
+    uint32_t to_submit;          /**< 未投入のエントリ数 */
+    uint32_t* cq_head;           /**< 完了リングの先頭 */
+    uint32_t* cq_tail;           /**< 完了リングの末尾 (カーネルが更新) */
+    uint32_t cq_mask;            /**< 完了リングのマスク */
+    struct io_uring_cqe* cqes;   /**< 完了エントリ */
+    struct io_uring_buf_ring* buf_ring; /**< 提供バッファリング */
+    size_t buf_ring_size;        /**< buf_ring のサイズ */
+    uint8_t* bufs;               /**< 受信バッファ本体 */
+    uint16_t* recycle;           /**< 次の poll で返却する受信バッファ */
+    int recycle_count;           /**< 返却待ちの受信バッファ数 */
+    int accept_armed;            /**< マルチショット accept が有効 */
+};
+
+/**
+ * @brief 接続表から有効な接続を引く
+ */
+static NetConn* conn_get(NetBackend *nb, int conn) {
+    if (conn < 0 || conn >= nb->max_conns || !nb->conns[conn].open) {
+        return NULL;
+    }
+    return &nb->conns[conn];
+}
+
+static void conn_mark_dirty(NetBackend *nb, int conn) {
+    NetConn *c = &nb->conns[conn];
+    if (!c->dirty) {
+        c->dirty = 1;
+        nb->dirty[nb->dirty_count++] = conn;
+    }
+}
+
+/**
+ * @brief 接続を初期化する (受け入れ時)
+ */
+static void conn_open(NetBackend *nb, int conn) {
+    NetConn *c = &nb->conns[conn];
+    uint8_t *out = c->out;
+    int dirty = c->dirty;
+    int arm_pending = c->arm_pending;
+    memset(c, 0, sizeof(*c));
+    c->out = out;     // 送信バッファは再利用する
+    c->dirty = dirty; // 未送信リストには残っている場合がある (flush で読み飛ばされる)
+    c->arm_pending = (uint8_t)arm_pending; // 再投入待ちリストに残っている場合も同様 (二重登録しない)
+    c->open = 1;
+}
+
+/**
+ * @brief 接続を解放してソケットを閉じる
+ */
+static void conn_release(NetBackend *nb, int conn) {
+    NetConn *c = &nb->conns[conn];
+    c->open = 0;
+    c->closing = 0;
+    c->out_len = 0;
+    c->inflight = 0;
+    close(conn);
+}
+
+/**
+ * @brief 切り離しが完了した接続を通知待ちにする (ソケットは閉じない)
+ */
+static void conn_detached(NetBackend *nb, int conn) {
+    NetConn *c = &nb->conns[conn];
+    c->open = 0;
+    c->detaching = 0;
+    c->inflight = 0;
+    nb->detached[nb->detached_count++] = conn;
+}
+
+/* ------------------------------------------------------------------ */
+/* epoll                                                               */
+/* ------------------------------------------------------------------ */
+
+static int epoll_setup(NetBackend *nb) {
+    nb->epfd = epoll_create1(EPOLL_CLOEXEC);
+    nb->ep_events = (struct epoll_event*)malloc(sizeof(struct epoll_event) * NET_EPOLL_EVENTS);
+    nb->scratch = (uint8_t*)malloc((size_t)NET_EPOLL_EVENTS * NET_BACKEND_RECV_SIZE);
+    if (nb->epfd < 0 || !nb->ep_events || !nb->scratch) {
+        return 0;
+    }
+    struct epoll_event ev;
+    ev.events = EPOLLIN;
+    ev.data.u64 = (uint64_t)nb->listen_fd;
+    return epoll_ctl(nb->epfd, EPOLL_CTL_ADD, nb->listen_fd, &ev) == 0;
+}
+
+static void epoll_watch_out(NetBackend *nb, int conn, int want) {
+    NetConn *c = &nb->conns[conn];
+    if (c->want_out == want) {
+        return;
+    }
+    struct epoll_event ev;
+    ev.events = EPOLLIN | (want ? EPOLLOUT : 0);
+    ev.data.u64 = (uint64_t)conn;
+    epoll_ctl(nb->epfd, EPOLL_CTL_MOD, conn, &ev);
+    c->want_out = (uint8_t)want;
+}
+
+/**
+ * @brief 接続の送信バッファをできるだけ送る
+ */
+static void epoll_send_conn(NetBackend *nb, int conn) {
+    NetConn *c = &nb->conns[conn];
+    uint32_t sent = 0;
+    while (sent < c->out_len) {
+        ssize_t n = send(conn, c->out + sent, c->out_len - sent, MSG_NOSIGNAL | MSG_DONTWAIT);
+        if (n > 0) {
+            sent += (uint32_t)n;
+        } else if (n < 0 && errno == EINTR) {
+            continue;
+        } else {
+            if (n < 0 && errno != EAGAIN) {
+                sent = c->out_len; // 切断は受信側で検出する
+            }
+            break;
+        }
+    }
+    if (sent > 0) {
+        memmove(c->out, c->out + sent, c->out_len - sent);
+        c->out_len -= sent;
+    }
+    epoll_watch_out(nb, conn, c->out_len > 0);
+}
+
+static int epoll_poll(NetBackend *nb, NetEvent *events, int max, int timeout_ms) {
+    int limit = max < NET_EPOLL_EVENTS ? max : NET_EPOLL_EVENTS;
+    int n = epoll_wait(nb->epfd, nb->ep_events, limit, timeout_ms);
+    if (n < 0) {
+        return errno == EINTR ? 0 : -1;
+    }
+
+    // 受信バッファ (scratch) はイベント1つにつき1つのため、受け入れもデータも limit 件まで
+    // (残りはレベルトリガーのため次回の取得で返る)
+    int count = 0;
+    for (int i = 0; i < n && count < limit; i++) {
+        int fd = (int)nb->ep_events[i].data.u64;
+        uint32_t flags = nb->ep_events[i].events;
+
+        if (fd == nb->listen_fd) {
+            while (count < limit) {
+                int conn = accept4(nb->listen_fd, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC);
+                if (conn < 0) {
+                    break;
+                }
+                struct epoll_event ev;
+                ev.events = EPOLLIN;
+                ev.data.u64 = (uint64_t)conn;
+                if (conn >= nb->max_conns || epoll_ctl(nb->epfd, EPOLL_CTL_ADD, conn, &ev) != 0) {
+                    close(conn);
+                    continue;
+                }
+                conn_open(nb, conn);
+                events[count].type = NET_EVENT_ACCEPT;
+                events[count].conn = conn;
+                events[count].data = NULL;
+                events[count].len = 0;
+                count++;
+            }
+            continue;
+        }
+
+        NetConn *c = conn_get(nb, fd);
+        if (!c) {
+            continue;
+        }
+        if (flags & EPOLLOUT) {
+            epoll_send_conn(nb, fd);
+        }
+        if (flags & (EPOLLIN | EPOLLHUP | EPOLLERR)) {
+            uint8_t *buf = nb->scratch + (size_t)count * NET_BACKEND_RECV_SIZE;
+            ssize_t r = recv(fd, buf, NET_BACKEND_RECV_SIZE, MSG_DONTWAIT);
+            if (r < 0 && (errno == EAGAIN || errno == EINTR)) {
+                continue;
+            }
+            events[count].conn = fd;
+            if (r > 0) {
+                events[count].type = NET_EVENT_DATA;
+                events[count].data = buf;
+                events[count].len = (size_t)r;
+            } else {
+                events[count].type = NET_EVENT_CLOSED;
+                events[count].data = NULL;
+                events[count].len = 0;
+                conn_release(nb, fd);
+            }
+            count++;
+        }
+    }
+    return count;
+}
+
+static int epoll_flush(NetBackend *nb) {
+    for (int i = 0; i < nb->dirty_count; i++) {
+        int conn = nb->dirty[i];
+        NetConn *c = &nb->conns[conn];
+        c->dirty = 0;
+        if (c->open && c->out_len > 0 && !c->want_out) {
+            epoll_send_conn(nb, conn);
+        }
+    }
+    nb->dirty_count = 0;
+    return 1;
+}
+
+/* ------------------------------------------------------------------ */
+/* io_uring                                                            */
+/* ------------------------------------------------------------------ */
+
+static int uring_enter(NetBackend *nb, uint32_t to_submit, uint32_t min_complete, uint32_t flags,
+                       const void *arg, size_t argsz) {
+    return (int)syscall(__NR_io_uring_enter, nb->ring_fd, to_submit, min_complete, flags, arg, argsz);
+}
+
+/**
+ * @brief 準備済みのエントリを公開してカーネルへ投入する
+ */
+static int uring_submit(NetBackend *nb, uint32_t min_complete, uint32_t flags, const void *arg, size_t argsz) {
+    __atomic_store_n(nb->sq_tail, nb->sq_local_tail, __ATOMIC_RELEASE);
+    int rc;
+    do {
+        rc = uring_enter(nb, nb->to_submit, min_complete, flags, arg, argsz);
+    } while (rc < 0 && errno == EINTR && min_complete == 0);
+    if (rc >= 0) {
+        nb->to_submit -= (uint32_t)rc < nb->to_submit ? (uint32_t)rc : nb->to_submit;
+    }
+    return rc;
+}
+
+/**
+ * @brief 投入エントリを1つ確保する (満杯なら先に投入する)
+ */
+static struct io_uring_sqe* uring_get_sqe(NetBackend *nb) {
+    uint32_t head = __atomic_load_n(nb->sq_head, __ATOMIC_ACQUIRE);
+    if (nb->sq_local_tail - head == nb->sq_entries) {
+        uring_submit(nb, 0, 0, NULL, 0);
+        head = __atomic_load_n(nb->sq_head, __ATOMIC_ACQUIRE);
+        if (nb->sq_local_tail - head == nb->sq_entries) {
+            return NULL;
+        }
+    }
+    struct io_uring_sqe *sqe = &nb->sqes[nb->sq_local_tail & nb->sq_mask];
+    memset(sqe, 0, sizeof(*sqe));
+    nb->sq_local_tail++;
+    nb->to_submit++;
+    return sqe;
+}
+
+static void uring_arm_accept(NetBackend *nb) {
+    struct io_uring_sqe *sqe = uring_get_sqe(nb);
+    if (!sqe) {
+        return;
+    }
+    sqe->opcode = IORING_OP_ACCEPT;
+    sqe->fd = nb->listen_fd;
+    sqe->ioprio = IORING_ACCEPT_MULTISHOT;
+    sqe->accept_flags = SOCK_NONBLOCK | SOCK_CLOEXEC;
+    sqe->user_data = (uint64_t)URING_OP_ACCEPT << 32;
+    nb->accept_armed = 1;
+}
+
+static void uring_arm_recv(NetBackend *nb, int conn) {
+    struct io_uring_sqe *sqe = uring_get_sqe(nb);
+    if (!sqe) {
+        // 投入キューが満杯。次の poll で投入し直す (受信が止まったままにしない)
+        NetConn *c = &nb->conns[conn];
+        if (!c->arm_pending) {
+            c->arm_pending = 1;
+            nb->rearm[nb->rearm_count++] = conn;
+        }
+        return;
+    }
+    sqe->opcode = IORING_OP_RECV;
+    sqe->fd = conn;
+    sqe->ioprio = IORING_RECV_MULTISHOT;
+    sqe->flags = IOSQE_BUFFER_SELECT;
+    sqe->buf_group = NET_URING_BGID;
+    sqe->user_data = (uint64_t)URING_OP_RECV << 32 | (uint32_t)conn;
+    nb->conns[conn].recv_armed = 1;
+}
+
+/**
+ * @brief 投入キューが満杯で投入できなかった recv と accept を投入し直す
+ */
+static void uring_rearm(NetBackend *nb) {
+    if (!nb->accept_armed) {
+        uring_arm_accept(nb);
+    }
+    // 再登録は読み終えた位置より前に書かれるため、同じ配列をそのまま使える
+    int count = nb->rearm_count;
+    nb->rearm_count = 0;
+    for (int i = 0; i < count; i++) {
+        int conn = nb->rearm[i];
+        NetConn *c = &nb->conns[conn];
+        c->arm_pending = 0;
+        if (c->open && !c->closing && !c->detaching && !c->recv_armed) {
+            uring_arm_recv(nb, conn); // 再び満杯なら再登録される
+        }
+    }
+}
+
+/**
+ * @brief 受信と送信が終わった閉じる処理中の接続を解放する
+ */
+static void uring_maybe_release(NetBackend *nb, int conn) {
+    NetConn *c = &nb->conns[conn];
+    if (c->open && c->closing && !c->recv_armed && c->inflight == 0) {
+        conn_release(nb, conn);
+    }
+}
+
+/**
+ * @brief 使用する操作をカーネルが扱えるか確認する
+ *
+ * マルチショット recv (6.0) は操作の一覧では区別できないため、カーネルのバージョンでも判定します。
+ * 扱えない場合は epoll にフォールバックさせます (5.19 では全ての recv が -EINVAL で終わるため)。
+ */
+static int uring_probe(NetBackend *nb) {
+    static const uint8_t ops[] = {IORING_OP_ACCEPT, IORING_OP_RECV, IORING_OP_SEND, IORING_OP_ASYNC_CANCEL};
+    size_t size = sizeof(struct io_uring_probe) + sizeof(struct io_uring_probe_op) * IORING_OP_LAST;
+    struct io_uring_probe *probe = (struct io_uring_probe*)calloc(1, size);
+    if (!probe) {
+        return 0;
+    }
+    int ok = syscall(__NR_io_uring_register, nb->ring_fd, IORING_REGISTER_PROBE, probe, IORING_OP_LAST) == 0;
+    for (size_t i = 0; ok && i < sizeof(ops); i++) {
+        ok = ops[i] <= probe->last_op && (probe->ops[ops[i]].flags & IO_URING_OP_SUPPORTED);
+    }
+    free(probe);
+
+    struct utsname un;
+    int major = 0;
+    int minor = 0;
+    if (!ok || uname(&un) != 0 || sscanf(un.release, "%d.%d", &major, &minor) != 2) {
+        return 0;
+    }
+    return major >= 6;
+}
+
+static int uring_setup(NetBackend *nb) {
+    struct io_uring_params p;
+    memset(&p, 0, sizeof(p));
+    p.flags = IORING_SETUP_SUBMIT_ALL | IORING_SETUP_COOP_TASKRUN | IORING_SETUP_SINGLE_ISSUER |
+              IORING_SETUP_CQSIZE;
+    p.cq_entries = NET_URING_ENTRIES * 4;
+    nb->ring_fd = (int)syscall(__NR_io_uring_setup, NET_URING_ENTRIES, &p);
+    if (nb->ring_fd < 0 && errno == EINVAL) {
+        // 古いカーネルは最適化フラグを受け付けない
+        memset(&p, 0, sizeof(p));
+        p.flags = IORING_SETUP_CQSIZE;
+        p.cq_entries = NET_URING_ENTRIES * 4;
+        nb->ring_fd = (int)syscall(__NR_io_uring_setup, NET_URING_ENTRIES, &p);
+    }
+    if (nb->ring_fd < 0) {
+        return 0;
+    }
+    uint32_t required = IORING_FEAT_SINGLE_MMAP | IORING_FEAT_NODROP | IORING_FEAT_EXT_ARG;
+    if ((p.features & required) != required || !uring_probe(nb)) {
+        return 0;
+    }
+
+    size_t sq_size = p.sq_off.array + p.sq_entries * sizeof(uint32_t);
+    size_t cq_size = p.cq_off.cqes + p.cq_entries * sizeof(struct io_uring_cqe);
+    nb->ring_size = sq_size > cq_size ? sq_size : cq_size;
+    nb->ring_mem = mmap(NULL, nb->ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                        nb->ring_fd, IORING_OFF_SQ_RING);
+    if (nb->ring_mem == MAP_FAILED) {
+        nb->ring_mem = NULL;
+        return 0;
+    }
+    nb->sqes_size = p.sq_entries * sizeof(struct io_uring_sqe);
+    nb->sqes = (struct io_uring_sqe*)mmap(NULL, nb->sqes_size, PROT_READ | PROT_WRITE,
+                                          MAP_SHARED | MAP_POPULATE, nb->ring_fd, IORING_OFF_SQES);
+    if (nb->sqes == MAP_FAILED) {
+        nb->sqes = NULL;
+        return 0;
+    }
+
+    uint8_t *ring = (uint8_t*)nb->ring_mem;
+    nb->sq_head = (uint32_t*)(ring + p.sq_off.head);
+    nb->sq_tail = (uint32_t*)(ring + p.sq_off.tail);
+    nb->sq_mask = *(uint32_t*)(ring + p.sq_off.ring_mask);
+    nb->sq_entries = p.sq_entries;
+    nb->sq_local_tail = *nb->sq_tail;
+    uint32_t *array = (uint32_t*)(ring + p.sq_off.array);
+    for (uint32_t i = 0; i < p.sq_entries; i++) {
+        array[i] = i; // エントリは末尾の位置と同じ番号を使う
+    }
+    nb->cq_head = (uint32_t*)(ring + p.cq_off.head);
+    nb->cq_tail = (uint32_t*)(ring + p.cq_off.tail);
+    nb->cq_mask = *(uint32_t*)(ring + p.cq_off.ring_mask);
+    nb->cqes = (struct io_uring_cqe*)(ring + p.cq_off.cqes);
+
+    // 提供バッファリング: カーネルが受信のたびにここからバッファを選ぶ
+    nb->buf_ring_size = NET_BACKEND_RECV_COUNT * sizeof(struct io_uring_buf);
+    nb->buf_ring = (struct io_uring_buf_ring*)mmap(NULL, nb->buf_ring_size, PROT_READ | PROT_WRITE,
+                                                   MAP_PRIVATE | MAP_ANONYMOUS | MAP_POPULATE, -1, 0);
+    nb->bufs = (uint8_t*)malloc((size_t)NET_BACKEND_RECV_COUNT * NET_BACKEND_RECV_SIZE);
+    nb->recycle = (uint16_t*)malloc(sizeof(uint16_t) * NET_BACKEND_RECV_COUNT);
+    if (nb->buf_ring == MAP_FAILED || !nb->bufs || !nb->recycle) {
+        if (nb->buf_ring == MAP_FAILED) {
+            nb->buf_ring = NULL;
+        }
+        return 0;
+    }
+    struct io_uring_buf_reg reg;
+    memset(&reg, 0, sizeof(reg));
+    reg.ring_addr = (uint64_t)(uintptr_t)nb->buf_ring;
+    reg.ring_entries = NET_BACKEND_RECV_COUNT;
+    reg.bgid = NET_URING_BGID;
+    if (syscall(__NR_io_uring_register, nb->ring_fd, IORING_REGISTER_PBUF_RING, &reg, 1) != 0) {
+        return 0; // 5.19 未満
+    }
+    for (int i = 0; i < NET_BACKEND_RECV_COUNT; i++) {
+        struct io_uring_buf *buf = &nb->buf_ring->bufs[i];
+        buf->addr = (uint64_t)(uintptr_t)(nb->bufs + (size_t)i * NET_BACKEND_RECV_SIZE);
+        buf->len = NET_BACKEND_RECV_SIZE;
+        buf->bid = (uint16_t)i;
+    }
+    __atomic_store_n(&nb->buf_ring->tail, (uint16_t)NET_BACKEND_RECV_COUNT, __ATOMIC_RELEASE);
+
+    uring_arm_accept(nb);
+    return uring_submit(nb, 0, 0, NULL, 0) >= 0;
+}
+
+/**
+ * @brief 前回の poll で渡した受信バッファをリングへ返却する
+ */
+static void uring_recycle(NetBackend *nb) {
+    if (nb->recycle_count == 0) {
+        return;
+    }
+    uint16_t tail = nb->buf_ring->tail;
+    for (int i = 0; i < nb->recycle_count; i++) {
+        uint16_t bid = nb->recycle[i];
+        struct io_uring_buf *buf = &nb->buf_ring->bufs[(uint16_t)(tail + i) & (NET_BACKEND_RECV_COUNT - 1)];
+        buf->addr = (uint64_t)(uintptr_t)(nb->bufs + (size_t)bid * NET_BACKEND_RECV_SIZE);
+        buf->len = NET_BACKEND_RECV_SIZE;
+        buf->bid = bid;
+    }
+    __atomic_store_n(&nb->buf_ring->tail, (uint16_t)(tail + nb->recycle_count), __ATOMIC_RELEASE);
+    nb->recycle_count = 0;
+}
+
+/**
+ * @brief 完了エントリ1件を処理する
+ * @return 出力したイベント数 (0または1)
+ */
+static int uring_complete(NetBackend *nb, const struct io_uring_cqe *cqe, NetEvent *event) {
+    int op = (int)(cqe->user_data >> 32);
+    int conn = (int)(uint32_t)cqe->user_data;
+    int more = (cqe->flags & IORING_CQE_F_MORE) != 0;
+
+    if (op == URING_OP_ACCEPT) {
+        if (!more) {
+            nb->accept_armed = 0;
+            uring_arm_accept(nb);
+        }
+        if (cqe->res < 0) {
+            return 0;
+        }
+        conn = cqe->res;
+        if (conn >= nb->max_conns) {
+            close(conn);
+            return 0;
+        }
+        conn_open(nb, conn);
+        uring_arm_recv(nb, conn);
+        event->type = NET_EVENT_ACCEPT;
+        event->conn = conn;
+        event->data = NULL;
+        event->len = 0;
+        return 1;
+    }
+
+    NetConn *c = &nb->conns[conn];
+    if (op == URING_OP_RECV) {
+        if (!more) {
+            c->recv_armed = 0;
+        }
+        int has_data = cqe->res > 0 && (cqe->flags & IORING_CQE_F_BUFFER);
+        if (has_data) {
+            nb->recycle[nb->recycle_count++] = (uint16_t)(cqe->flags >> IORING_CQE_BUFFER_SHIFT);
+        }
+        if (c->closing) {
+            uring_maybe_release(nb, conn);
+            return 0;
+        }
+        if (c->detaching) {
+            // 取り消しまでに届いたデータは通常どおり返す
+            if (!more && c->inflight == 0) {
+                conn_detached(nb, conn);
+            }
+            if (!has_data) {
+                return 0;
+            }
+            event->type = NET_EVENT_DATA;
+            event->conn = conn;
+            event->data = nb->bufs + (size_t)nb->recycle[nb->recycle_count - 1] * NET_BACKEND_RECV_SIZE;
+            event->len = (size_t)cqe->res;
+            return 1;
+        }
+        if (has_data || cqe->res == -ENOBUFS) {
+            // 終了したマルチショットは再投入 (ENOBUFS のバッファは次の poll で返却される)
+            if (!more) {
+                uring_arm_recv(nb, conn);
+            }
+            if (!has_data) {
+                return 0;
+            }
+            event->type = NET_EVENT_DATA;
+            event->conn = conn;
+            event->data = nb->bufs + (size_t)nb->recycle[nb->recycle_count - 1] * NET_BACKEND_RECV_SIZE;
+            event->len = (size_t)cqe->res;
+            return 1;
+        }
+        if (more) {
+            return 0;
+        }
+        // 切断またはエラー
+        c->closing = 1;
+        c->out_len = c->inflight;
+        uring_maybe_release(nb, conn);
+        event->type = NET_EVENT_CLOSED;
+        event->conn = conn;
+        event->data = NULL;
+        event->len = 0;
+        return 1;
+    }
+
+    if (op == URING_OP_SEND) {
+        uint32_t sent = cqe->res > 0 ? (uint32_t)cqe->res : c->inflight;
+        if (sent > c->out_len) {
+            sent = c->out_len;
+        }
+        memmove(c->out, c->out + sent, c->out_len - sent);
+        c->out_len -= sent;
+        c->inflight = 0;
+        if (c->closing) {
+            c->out_len = 0;
+            uring_maybe_release(nb, conn);
+        } else if (c->detaching) {
+            if (!c->recv_armed) {
+                conn_detached(nb, conn);
+            }
+        } else if (c->out_len > 0) {
+            conn_mark_dirty(nb, conn);
+        }
+    }
+    return 0;
+}
+
+static int uring_poll(NetBackend *nb, NetEvent *events, int max, int timeout_ms) {
+    uring_recycle(nb);
+    uring_rearm(nb);
+
+    uint32_t head = *nb->cq_head;
+    uint32_t tail = __atomic_load_n(nb->cq_tail, __ATOMIC_ACQUIRE);
+    if (head == tail && timeout_ms != 0) {
+        struct __kernel_timespec ts;
+        struct io_uring_getevents_arg arg;
+        memset(&arg, 0, sizeof(arg));
+        if (timeout_ms > 0) {
+            ts.tv_sec = timeout_ms / 1000;
+            ts.tv_nsec = (long long)(timeout_ms % 1000) * 1000000LL;
+            arg.ts = (uint64_t)(uintptr_t)&ts;
+        }
+        int rc = uring_submit(nb, 1, IORING_ENTER_GETEVENTS | IORING_ENTER_EXT_ARG, &arg, sizeof(arg));
+        if (rc < 0 && errno != ETIME && errno != EINTR) {
+            return -1;
+        }
+    } else if (nb->to_submit > 0 || head == tail) {
+        uring_submit(nb, 0, head == tail ? IORING_ENTER_GETEVENTS : 0, NULL, 0);
+    }
+
+    int count = 0;
+    tail = __atomic_load_n(nb->cq_tail, __ATOMIC_ACQUIRE);
+    while (head != tail && count < max) {
+        count += uring_complete(nb, &nb->cqes[head & nb->cq_mask], &events[count]);
+        head++;
+    }
+    __atomic_store_n(nb->cq_head, head, __ATOMIC_RELEASE);
+    return count;
+}
+
+static int uring_flush(NetBackend *nb) {
+    for (int i = 0; i < nb->dirty_count; i++) {
+        int conn = nb->dirty[i];
+        NetConn *c = &nb->conns[conn];
+        c->dirty = 0;
+        if (!c->open || c->closing || c->detaching || c->inflight > 0 || c->out_len == 0) {
+            continue; // 送信中の接続は完了時に再登録される
+        }
+        struct io_uring_sqe *sqe = uring_get_sqe(nb);
+        if (!sqe) {
+            c->dirty = 1; // まだ未送信リストの i 番目にあるため、登録し直さない
+            break;
+        }
+        sqe->opcode = IORING_OP_SEND;
+        sqe->fd = conn;
+        sqe->addr = (uint64_t)(uintptr_t)c->out;
+        sqe->len = c->out_len;
+        sqe->msg_flags = MSG_NOSIGNAL;
+        sqe->user_data = (uint64_t)URING_OP_SEND << 32 | (uint32_t)conn;
+        c->inflight = c->out_len;
+    }
+    // 未登録のまま残った接続を詰める
+    int kept = 0;
+    for (int i = 0; i < nb->dirty_count; i++) {
+        if (nb->conns[nb->dirty[i]].dirty) {
+            nb->dirty[kept++] = nb->dirty[i];
+        }
+    }
+    nb->dirty_count = kept;
+    return nb->to_submit == 0 || uring_submit(nb, 0, 0, NULL, 0) >= 0;
+}
+
+/* ------------------------------------------------------------------ */
+/* 共通                                                                */
+/* ------------------------------------------------------------------ */
+
+static void backend_teardown(NetBackend *nb) {
+    for (int i = 0; i < nb->max_conns; i++) {
+        if (nb->conns[i].open) {
+            close(i);
+        }
+        free(nb->conns[i].out);
+    }
+    if (nb->epfd >= 0) close(nb->epfd);
+    if (nb->ring_fd >= 0) close(nb->ring_fd);
+    if (nb->ring_mem) munmap(nb->ring_mem, nb->ring_size);
+    if (nb->sqes) munmap(nb->sqes, nb->sqes_size);
+    if (nb->buf_ring) munmap(nb->buf_ring, nb->buf_ring_size);
+    free(nb->ep_events);
+    free(nb->scratch);
+    free(nb->bufs);
+    free(nb->recycle);
+    free(nb->dirty);
+    free(nb->detached);
+    free(nb->rearm);
+    free(nb->conns);
+    free(nb);
+}
+
+static NetBackend* backend_alloc(int listen_fd, int max_conns) {
+    NetBackend *nb = (NetBackend*)calloc(1, sizeof(NetBackend));
+    if (!nb) {
+        return NULL;
+    }
+    nb->listen_fd = listen_fd;
+    nb->max_conns = max_conns;
+    nb->epfd = -1;
+    nb->ring_fd = -1;
+    nb->conns = (NetConn*)calloc((size_t)max_conns, sizeof(NetConn));
+    nb->dirty = (int*)malloc(sizeof(int) * (size_t)max_conns);
+    nb->detached = (int*)malloc(sizeof(int) * (size_t)max_conns);
+    nb->rearm = (int*)malloc(sizeof(int) * (size_t)max_conns);
+    if (!nb->conns || !nb->dirty || !nb->detached || !nb->rearm) {
+        backend_teardown(nb);
+        return NULL;
+    }
+    return nb;
+}
+
+/**
+ * @brief バックエンドを作成する
+ */
+NetBackend* net_backend_create(NetBackendKind kind, int listen_fd, int max_conns) {
+    if (listen_fd < 0 || max_conns <= listen_fd) {
+        return NULL;
+    }
+    NetBackend *nb;
+    if (kind != NET_BACKEND_EPOLL) {
+        nb = backend_alloc(listen_fd, max_conns);
+        if (!nb) {
+            return NULL;
+        }
+        nb->kind = NET_BACKEND_URING;
+        if (uring_setup(nb)) {
+            return nb;
+        }
+        backend_teardown(nb);
+        if (kind == NET_BACKEND_URING) {
+            return NULL;
+        }
+    }
+    nb = backend_alloc(listen_fd, max_conns);
+    if (!nb) {
+        return NULL;
+    }
+    nb->kind = NET_BACKEND_EPOLL;
+    if (!epoll_setup(nb)) {
+        backend_teardown(nb);
+        return NULL;
+    }
+    return nb;
+}
+
+/**
+ * @brief バックエンドを解放する
+ */
+void net_backend_destroy(NetBackend *nb) {
+    if (nb) {
+        backend_teardown(nb);
+    }
+}
+
+/**
+ * @brief 実際に使用しているバックエンド種別を取得する
+ */
+NetBackendKind net_backend_kind(const NetBackend *nb) {
+    return nb->kind;
+}
+
+/**
+ * @brief I/Oイベントを待って取得する
+ */
+int net_backend_poll(NetBackend *nb, NetEvent *events, int max, int timeout_ms) {
+    if (max <= 0) {
+        return 0;
+    }
+    // 切り離しの完了を先に返す (未送信データは次の poll まで有効)
+    int count = 0;
+    while (nb->detached_count > 0 && count < max) {
+        int conn = nb->detached[--nb->detached_count];
+        NetConn *c = &nb->conns[conn];
+        events[count].type = NET_EVENT_DETACHED;
+        events[count].conn = conn;
+        events[count].data = c->out_len > 0 ? c->out : NULL;
+        events[count].len = c->out_len;
+        c->out_len = 0;
+        count++;
+    }
+    if (count == max) {
+        return count;
+    }
+    int n = nb->kind == NET_BACKEND_URING ? uring_poll(nb, events + count, max - count, count ? 0 : timeout_ms)
+                                          : epoll_poll(nb, events + count, max - count, count ? 0 : timeout_ms);
+    return n < 0 ? (count ? count : -1) : count + n;
+}
+
+/**
+ * @brief 送信データを接続の送信バッファに追加する
+ */
+int net_backend_send(NetBackend *nb, int conn, const void *data, size_t len) {
+    NetConn *c = conn_get(nb, conn);
+    if (!c || c->closing || c->detaching || len > NET_BACKEND_OUT_SIZE - c->out_len) {
+        return 0;
+    }
+    if (!c->out) {
+        c->out = (uint8_t*)malloc(NET_BACKEND_OUT_SIZE);
+        if (!c->out) {
+            return 0;
+        }
+    }
+    memcpy(c->out + c->out_len, data, len);
+    c->out_len += (uint32_t)len;
+    conn_mark_dirty(nb, conn);
+    return 1;
+}
+
+/**
+ * @brief 全接続の送信バッファを送信する
+ */
+int net_backend_flush(NetBackend *nb) {
+    return nb->kind == NET_BACKEND_URING ? uring_flush(nb) : epoll_flush(nb);
+}
+
+/**
+ * @brief 接続を閉じる
+ */
+void net_backend_close(NetBackend *nb, int conn) {
+    NetConn *c = conn_get(nb, conn);
+    if (!c || c->closing || c->detaching) {
+        return;
+    }
+    if (nb->kind == NET_BACKEND_EPOLL) {
+        conn_release(nb, conn);
+        return;
+    }
+    // 受信中のマルチショット recv を終わらせてから記述子を閉じる
+    c->closing = 1;
+    c->out_len = c->inflight;
+    shutdown(conn, SHUT_RDWR);
+    uring_maybe_release(nb, conn);
+}
+
+/**
+ * @brief 接続を閉じずに切り離す
+ */
+int net_backend_detach(NetBackend *nb, int conn) {
+    NetConn *c = conn_get(nb, conn);
+    if (!c || c->closing || c->detaching) {
+        return 0;
+    }
+    c->detaching = 1;
+    if (nb->kind == NET_BACKEND_EPOLL) {
+        epoll_ctl(nb->epfd, EPOLL_CTL_DEL, conn, NULL);
+        c->want_out = 0;
+        conn_detached(nb, conn);
+        return 1;
+    }
+    if (!c->recv_armed) {
+        if (c->inflight == 0) {
+            conn_detached(nb, conn);
+        }
+        return 1;
+    }
+    // マルチショット recv を取り消す (完了は recv の最後の完了エントリで分かる)
+    struct io_uring_sqe *sqe = uring_get_sqe(nb);
+    if (!sqe) {
+        c->detaching = 0;
+        return 0;
+    }
+    sqe->opcode = IORING_OP_ASYNC_CANCEL;
+    sqe->addr = (uint64_t)URING_OP_RECV << 32 | (uint32_t)conn;
+    sqe->user_data = (uint64_t)URING_OP_CANCEL << 32 | (uint32_t)conn;
+    return 1;
+}
+
+/**
+ * @brief 他で受け入れた接続を取り込む
+ */
+int net_backend_adopt(NetBackend *nb, int conn, const void *pending, size_t len) {
+    if (conn < 0 || conn >= nb->max_conns || conn == nb->listen_fd || nb->conns[conn].open ||
+        len > NET_BACKEND_OUT_SIZE) {
+        return 0;
+    }
+    NetConn *c = &nb->conns[conn];
+    if (len > 0 && !c->out) {
+        c->out = (uint8_t*)malloc(NET_BACKEND_OUT_SIZE);
+        if (!c->out) {
+            return 0;
+        }
+    }
+    if (nb->kind == NET_BACKEND_EPOLL) {
+        struct epoll_event ev;
+        ev.events = EPOLLIN;
+        ev.data.u64 = (uint64_t)conn;
+        if (epoll_ctl(nb->epfd, EPOLL_CTL_ADD, conn, &ev) != 0) {
+            return 0;
+        }
+        conn_open(nb, conn);
+    } else {
+        conn_open(nb, conn);
+        uring_arm_recv(nb, conn);
+        if (!c->recv_armed) {
+            c->open = 0;
+            return 0;
+        }
+    }
+    if (len > 0) {
+        memcpy(c->out, pending, len);
+        c->out_len = (uint32_t)len;
+        conn_mark_dirty(nb, conn);
+    }
+    return 1;
+}
@@ -0,0 +1,144 @@
+/**
+ * @file net_backend.h
+ * @brief ゲームサーバーの接続I/Oバックエンドの宣言
+ *
+ * このファイルは多数のクライアント接続の受け入れ・受信・送信を行う
+ * I/Oバックエンドの共通インターフェースを宣言します。
+ * 主な機能:
+ *   - epoll バックエンド (全環境)
+ *   - io_uring バックエンド (マルチショットの accept/recv、登録済みバッファリング、一括投入)
+ *   - 接続ごとの送信バッファとティック単位のまとめ送信
+ *   - 接続の切り離しと取り込み (再起動時の引き継ぎ、シャード間の移動)
+ *
+ * 設計思想:
+ *   - ゲームループは「ポーリング → シミュレーション → 送信の確定」の順に呼び出す
+ *   - 送信はバッファに追加するのみで、net_backend_flush で全接続分を一度に送る
+ *   - io_uring では1ティックのシステムコールが接続数によらず flush と poll の2回になる
+ *   - io_uring が使えないカーネルでは自動的に epoll に切り替える
+ */
+
+#ifndef NET_BACKEND_H
+#define NET_BACKEND_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define NET_BACKEND_RECV_SIZE  2048  /**< 受信バッファ1個のサイズ */
+#define NET_BACKEND_RECV_COUNT 1024  /**< 受信バッファの個数 (2のべき乗) */
+#define NET_BACKEND_OUT_SIZE   16384 /**< 接続ごとの送信バッファのサイズ */
+
+/* バックエンド種別の列挙型 */
+typedef enum {
+    NET_BACKEND_AUTO,            /**< io_uring が使えれば io_uring、使えなければ epoll */
+    NET_BACKEND_EPOLL,           /**< epoll */
+    NET_BACKEND_URING            /**< io_uring */
+} NetBackendKind;
+
+/* I/Oイベント種別の列挙型 */
+typedef enum {
+    NET_EVENT_ACCEPT,            /**< 新しい接続 */
+    NET_EVENT_DATA,              /**< データを受信した */
+    NET_EVENT_CLOSED,            /**< 接続が閉じられた (以後 conn は再利用されうる) */
+    NET_EVENT_DETACHED           /**< 切り離しが完了した (data は未送信データ、以後 conn は呼び出し側の所有) */
+} NetEventType;
+
+/**
+ * @brief I/Oイベント
+ */
+typedef struct {
+    NetEventType type;           /**< イベント種別 */
+    int conn;                    /**< 接続 (ソケットのファイル記述子) */
+    const uint8_t* data;         /**< 受信データ (次の net_backend_poll まで有効) */
+    size_t len;                  /**< 受信データ長 */
+} NetEvent;
+
+typedef struct NetBackend NetBackend;
+
+/**
+ * @brief バックエンドを作成する
+ *
+ * io_uring は作成したスレッドからの投入のみを受け付けるため、バックエンドは
+ * それを使うイベントループのスレッドで作成してください。
+ *
+ * @param kind バックエンド種別
+ * @param listen_fd 待ち受けソケット (ノンブロッキング)
+ * @param max_conns 接続のファイル記述子の上限 (この値未満の記述子のみ受け入れる)
+ * @return 作成したバックエンド (失敗時はNULL)
+ */
+NetBackend* net_backend_create(NetBackendKind kind, int listen_fd, int max_conns);
+
+/**
+ * @brief バックエンドを解放する (すべての接続を閉じる)
+ * @param nb 解放するバックエンド (NULL可)
+ */
+void net_backend_destroy(NetBackend *nb);
+
+/**
+ * @brief 実際に使用しているバックエンド種別を取得する
+ * @param nb 対象のバックエンド
+ * @return NET_BACKEND_EPOLL または NET_BACKEND_URING
+ */
+NetBackendKind net_backend_kind(const NetBackend *nb);
+
+/**
+ * @brief I/Oイベントを待って取得する
+ *
+ * 前回の poll で返した受信データはこの呼び出しで無効になります。
+ *
+ * @param nb 対象のバックエンド
+ * @param events 出力先
+ * @param max 出力先の要素数
+ * @param timeout_ms 待機時間 (0で待機しない、負で無期限)
+ * @return 取得したイベント数 (失敗時-1)
+ */
+int net_backend_poll(NetBackend *nb, NetEvent *events, int max, int timeout_ms);
+
+/**
+ * @brief 送信データを接続の送信バッファに追加する
+ * @param nb 対象のバックエンド
+ * @param conn 接続
+ * @param data 送信データ
+ * @param len 送信データ長
+ * @return 成功時1、送信バッファが満杯または接続が無効な場合0
+ */
+int net_backend_send(NetBackend *nb, int conn, const void *data, size_t len);
+
+/**
+ * @brief 全接続の送信バッファを送信する (ティックの終わりに1回呼び出す)
+ * @param nb 対象のバックエンド
+ * @return 成功時1、失敗時0
+ */
+int net_backend_flush(NetBackend *nb);
+
+/**
+ * @brief 接続を閉じる (NET_EVENT_CLOSED は発生しない)
+ * @param nb 対象のバックエンド
+ * @param conn 接続
+ */
+void net_backend_close(NetBackend *nb, int conn);
+
+/**
+ * @brief 接続を閉じずに切り離す
+ *
+ * 受信を止め、送信中の処理の完了を待ってから NET_EVENT_DETACHED を発生させます。
+ * それまでに届いたデータは通常どおり NET_EVENT_DATA で返します。
+ * NET_EVENT_DETACHED の data には送信しきれなかったデータが入り、
+ * 以後この接続は呼び出し側が所有します (別プロセスへの引き渡しや別バックエンドへの取り込み)。
+ *
+ * @param nb 対象のバックエンド
+ * @param conn 接続
+ * @return 切り離しを開始した場合1、接続が無効な場合0
+ */
+int net_backend_detach(NetBackend *nb, int conn);
+
+/**
+ * @brief 他で受け入れた接続を取り込む
+ * @param nb 対象のバックエンド
+ * @param conn 接続 (ノンブロッキング)
+ * @param pending 先に送信するデータ (切り離し時の未送信データ、NULL可)
+ * @param len pending の長さ (NET_BACKEND_OUT_SIZE 以下)
+ * @return 成功時1、失敗時0 (接続は閉じない)
+ */
+int net_backend_adopt(NetBackend *nb, int conn, const void *pending, size_t len);
+
+#endif /* NET_BACKEND_H */
@@ -0,0 +1,296 @@
+/**
+ * @file restart.c
+ * @brief 試合を止めないサーバー再起動の実装
+ *
+ * 主な機能:
+ *   - 固定長の見出し (記述子付き) と本体からなるフレームの送受信
+ *   - 試合フレーム: 試合の直列化と参加者ごとの未送信データ
+ *   - 新プロセスからの確認応答
+ *
+ * 設計思想:
+ *   - 記述子は見出しと一緒に送り、本体は通常の送信で続ける (大きな本体を1回で送らない)
+ *   - 引き継ぎ用の接続はブロッキングにして送受信の待機時間を付け、相手の停止で固まらない
+ */
+
+#include "restart.h"
+#include "../network/net_unix.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+#define RESTART_MAGIC 0x54535254u /**< "TRST" */
+#define RESTART_ACK   0x4B434154u /**< "TACK" */
+#define RESTART_MAX_FDS (RESTART_MAX_LISTENERS > MATCH_MAX_PLAYERS ? RESTART_MAX_LISTENERS : MATCH_MAX_PLAYERS)
+
+/* フレーム種別 */
+enum {
+    RESTART_FRAME_BEGIN = 1,     /**< 待ち受けソケットと試合数 */
+    RESTART_FRAME_MATCH,         /**< 試合1件と参加者の接続 */
+    RESTART_FRAME_END            /**< 送信の終わり */
+};
+
+/**
+ * @brief フレームの見出し
+ */
+typedef struct {
+    uint32_t magic;              /**< RESTART_MAGIC */
+    uint32_t type;               /**< フレーム種別 */
+    uint32_t len;                /**< 本体の長さ */
+    uint32_t fd_mask;            /**< 記述子を伴う要素のビット集合 (要素順に記述子が並ぶ) */
+} RestartFrame;
+
+/**
+ * @brief 引き継ぎ用の接続をブロッキングにして待機時間を設定する
+ */
+static int setup_channel(int fd) {
+    int flags = fcntl(fd, F_GETFL);
+    struct timeval tv = {RESTART_IO_TIMEOUT_MS / 1000, (RESTART_IO_TIMEOUT_MS % 1000) * 1000};
+    return flags >= 0 && fcntl(fd, F_SETFL, flags & ~O_NONBLOCK) == 0 &&
+           setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv)) == 0 &&
+           setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv)) == 0;
+}
+
+static int send_all(int fd, const void *data, size_t len) {
+    const uint8_t *p = (const uint8_t*)data;
+    while (len > 0) {
+        ssize_t n = send(fd, p, len, MSG_NOSIGNAL);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            return 0;
+        }
+        p += n;
+        len -= (size_t)n;
+    }
+    return 1;
+}
+
+static int recv_all(int fd, void *data, size_t len) {
+    uint8_t *p = (uint8_t*)data;
+    while (len > 0) {
+        ssize_t n = recv(fd, p, len, 0);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            return 0;
+        }
+        p += n;
+        len -= (size_t)n;
+    }
+    return 1;
+}
+
+static int popcount(uint32_t mask) {
+    return __builtin_popcount(mask);
+}
+
+/**
+ * @brief フレームの見出しと記述子を送る
+ */
+static int send_frame(int channel, uint32_t type, uint32_t len, const int *fds, uint32_t fd_mask) {
+    RestartFrame frame = {RESTART_MAGIC, type, len, fd_mask};
+    return net_unix_send_fds(channel, fds, popcount(fd_mask), &frame, sizeof(frame));
+}
+
+/**
+ * @brief フレームの見出しと記述子を受け取る
+ * @return 受け取った記述子の数 (失敗時-1、記述子は閉じ済み)
+ */
+static int recv_frame(int channel, RestartFrame *frame, int *fds, size_t cap) {
+    int count = 0;
+    ssize_t n = net_unix_recv_fds(channel, fds, RESTART_MAX_FDS, &count, frame, sizeof(*frame));
+    if (n > 0 && (size_t)n < sizeof(*frame) &&
+        !recv_all(channel, (uint8_t*)frame + n, sizeof(*frame) - (size_t)n)) {
+        n = -1;
+    }
+    if (n <= 0 || frame->magic != RESTART_MAGIC || frame->len > cap || count != popcount(frame->fd_mask)) {
+        for (int i = 0; i < count; i++) {
+            close(fds[i]);
+        }
+        return -1;
+    }
+    return count;
+}
+
+/**
+ * @brief 引き継ぎ用ソケットで待ち受ける
+ */
+int restart_listen(const char *path) {
+    return net_unix_listen(path, 1);
+}
+
+/**
+ * @brief 新プロセスからの接続を受け入れる
+ */
+int restart_accept(int listen_fd) {
+    int fd = net_unix_accept(listen_fd);
+    if (fd < 0) {
+        return -1;
+    }
+    uid_t uid;
+    if (!net_unix_peer_cred(fd, NULL, &uid) || uid != geteuid() || !setup_channel(fd)) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+/**
+ * @brief 待ち受けソケットと試合数を送る
+ */
+int restart_send_begin(int channel, const int *listen_fds, int count, uint32_t match_count) {
+    if (count < 0 || count > RESTART_MAX_LISTENERS) {
+        return 0;
+    }
+    return send_frame(channel, RESTART_FRAME_BEGIN, sizeof(match_count), listen_fds, (1u << count) - 1) &&
+           send_all(channel, &match_count, sizeof(match_count));
+}
+
+/**
+ * @brief 試合を1件送る
+ */
+int restart_send_match(int channel, const ServerMatch *match, const RestartPending *pending) {
+    uint8_t wire[MATCH_WIRE_MAX];
+    uint32_t wire_len = (uint32_t)match_serialize(match, wire, sizeof(wire));
+    if (wire_len == 0) {
+        return 0;
+    }
+
+    int fds[MATCH_MAX_PLAYERS];
+    uint32_t mask = 0;
+    uint32_t len = sizeof(wire_len) + wire_len;
+    for (int i = 0; i < match->player_count; i++) {
+        if (match->players[i].conn >= 0) {
+            fds[popcount(mask)] = match->players[i].conn;
+            mask |= 1u << i;
+        }
+        size_t extra = pending ? pending[i].len : 0;
+        if (extra > NET_BACKEND_OUT_SIZE) {
+            return 0;
+        }
+        len += sizeof(uint32_t) + (uint32_t)extra;
+    }
+
+    if (!send_frame(channel, RESTART_FRAME_MATCH, len, fds, mask) ||
+        !send_all(channel, &wire_len, sizeof(wire_len)) || !send_all(channel, wire, wire_len)) {
+        return 0;
+    }
+    for (int i = 0; i < match->player_count; i++) {
+        uint32_t extra = pending ? (uint32_t)pending[i].len : 0;
+        if (!send_all(channel, &extra, sizeof(extra)) ||
+            (extra > 0 && !send_all(channel, pending[i].data, extra))) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+/**
+ * @brief 送信の終わりを伝え、新プロセスの確認応答を待つ
+ */
+int restart_send_end(int channel) {
+    uint32_t ack = 0;
+    return send_frame(channel, RESTART_FRAME_END, 0, NULL, 0) &&
+           recv_all(channel, &ack, sizeof(ack)) && ack == RESTART_ACK;
+}
+
+/**
+ * @brief 旧プロセスの引き継ぎ用ソケットへ接続する
+ */
+int restart_connect(const char *path) {
+    int fd = net_unix_connect(path);
+    if (fd >= 0 && !setup_channel(fd)) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+/**
+ * @brief 待ち受けソケットと試合数を受け取る
+ */
+int restart_recv_begin(int channel, int *listen_fds, int *count, uint32_t *match_count) {
+    RestartFrame frame;
+    int fds[RESTART_MAX_FDS];
+    int n = recv_frame(channel, &frame, fds, sizeof(*match_count));
+    if (n < 0) {
+        return 0;
+    }
+    if (frame.type != RESTART_FRAME_BEGIN || frame.len != sizeof(*match_count) || n > RESTART_MAX_LISTENERS ||
+        !recv_all(channel, match_count, sizeof(*match_count))) {
+        for (int i = 0; i < n; i++) {
+            close(fds[i]);
+        }
+        return 0;
+    }
+    memcpy(listen_fds, fds, sizeof(int) * (size_t)n);
+    *count = n;
+    return 1;
+}
+
+/**
+ * @brief 試合フレームの本体を解釈する
+ */
+static int parse_match(const uint8_t *buf, size_t len, ServerMatch *match, RestartPending *pending) {
+    uint32_t wire_len;
+    if (len < sizeof(wire_len)) {
+        return 0;
+    }
+    memcpy(&wire_len, buf, sizeof(wire_len));
+    size_t pos = sizeof(wire_len);
+    if (wire_len > len - pos || !match_deserialize(match, buf + pos, wire_len)) {
+        return 0;
+    }
+    pos += wire_len;
+    for (int i = 0; i < match->player_count; i++) {
+        uint32_t extra;
+        if (len - pos < sizeof(extra)) {
+            return 0;
+        }
+        memcpy(&extra, buf + pos, sizeof(extra));
+        pos += sizeof(extra);
+        if (extra > NET_BACKEND_OUT_SIZE || extra > len - pos) {
+            return 0;
+        }
+        pending[i].data = extra > 0 ? buf + pos : NULL;
+        pending[i].len = extra;
+        pos += extra;
+    }
+    return pos == len;
+}
+
+/**
+ * @brief 試合を1件受け取る
+ */
+int restart_recv_match(int channel, ServerMatch *match, uint8_t *buf, RestartPending *pending) {
+    RestartFrame frame;
+    int fds[RESTART_MAX_FDS];
+    int n = recv_frame(channel, &frame, fds, RESTART_FRAME_MAX);
+    if (n < 0) {
+        return -1;
+    }
+    if (frame.type == RESTART_FRAME_END && n == 0) {
+        uint32_t ack = RESTART_ACK;
+        return send_all(channel, &ack, sizeof(ack)) ? 0 : -1;
+    }
+
+    memset(pending, 0, sizeof(*pending) * MATCH_MAX_PLAYERS);
+    if (frame.type != RESTART_FRAME_MATCH || frame.fd_mask >> MATCH_MAX_PLAYERS ||
+        !recv_all(channel, buf, frame.len) || !parse_match(buf, frame.len, match, pending) ||
+        frame.fd_mask >> match->player_count) {
+        for (int i = 0; i < n; i++) {
+            close(fds[i]);
+        }
+        return -1;
+    }
+    int next = 0;
+    for (int i = 0; i < match->player_count; i++) {
+        match->players[i].conn = (frame.fd_mask >> i) & 1 ? fds[next++] : -1;
+    }
+    return 1;
+}
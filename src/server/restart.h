@@ -0,0 +1,124 @@
+/**
+ * @file restart.h
+ * @brief 試合を止めないサーバー再起動 (新旧プロセス間の引き継ぎ) の宣言
+ *
+ * このファイルはサーバーのバイナリを更新する際に、旧プロセスが待ち受けソケット、
+ * クライアントの接続、試合の状態を新プロセスへ渡すための手順を宣言します。
+ * 主な機能:
+ *   - 旧プロセスの引き継ぎ用ソケットの待ち受けと、同一ユーザーの新プロセスのみの受け入れ
+ *   - SCM_RIGHTS による待ち受けソケットと試合ごとの接続の受け渡し
+ *   - 試合のチェックポイント、入力ログ、未送信データの受け渡し
+ *   - 新プロセスの受信完了の確認応答 (旧プロセスはこれを受けてから終了する)
+ *
+ * 手順:
+ *   1. 新プロセスは起動時に restart_connect する。接続できなければ通常の起動
+ *   2. 旧プロセスは引き継ぎ用ソケットの受け入れで試合の進行を止め、全接続を net_backend_detach する
+ *   3. NET_EVENT_DETACHED で未送信データを受け取り、各試合のチェックポイントを取る
+ *   4. restart_send_begin、試合ごとに restart_send_match、restart_send_end の順に送る
+ *   5. 新プロセスは受け取った試合ごとに match_restore と入力ログの再生を行い、
+ *      接続を net_backend_adopt してすぐに再開する (全試合の受信を待たない)。
+ *      試合の進行は match_flow_init で記録の GameState の段階から始め直す
+ *
+ * 設計思想:
+ *   - 接続はカーネル内でそのまま生きているため、クライアントは再接続も遅延も感じない
+ *   - 受信はすべて止めてから渡すため、旧プロセスが新プロセス宛てのデータを読むことはない
+ *   - 待ち受けソケットは共有されるため、引き継ぎ中も新しい接続はカーネルの待ち行列に溜まる
+ *   - 確認応答の前に旧プロセスが異常終了しても、新プロセスは受信済みの試合のみで続行する
+ */
+
+#ifndef RESTART_H
+#define RESTART_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "match.h"
+#include "net_backend.h"
+
+#define RESTART_DEFAULT_PATH   "@tetris-server-restart" /**< 既定の引き継ぎ用ソケット */
+#define RESTART_MAX_LISTENERS  8    /**< 引き継ぐ待ち受けソケット数の上限 */
+#define RESTART_IO_TIMEOUT_MS  5000 /**< 引き継ぎ中の1回の送受信の待機時間 */
+#define RESTART_FRAME_MAX      (4 + MATCH_WIRE_MAX + MATCH_MAX_PLAYERS * (4 + NET_BACKEND_OUT_SIZE)) /**< 試合1件の最大サイズ */
+
+/**
+ * @brief 接続ごとの未送信データ
+ */
+typedef struct {
+    const uint8_t* data;         /**< 未送信データ (NULL可) */
+    size_t len;                  /**< 長さ */
+} RestartPending;
+
+/**
+ * @brief 引き継ぎ用ソケットで待ち受ける (旧プロセス、起動時)
+ * @param path ソケットパス (先頭'@'で抽象名前空間)
+ * @return 待ち受けソケット (イベントループで読み込み可能を監視する、失敗時-1)
+ */
+int restart_listen(const char *path);
+
+/**
+ * @brief 新プロセスからの接続を受け入れる (旧プロセス)
+ * @param listen_fd restart_listen の待ち受けソケット
+ * @return 引き継ぎ用の接続 (同一ユーザーでない場合や失敗時-1)
+ */
+int restart_accept(int listen_fd);
+
+/**
+ * @brief 待ち受けソケットと試合数を送る (旧プロセス)
+ * @param channel 引き継ぎ用の接続
+ * @param listen_fds 待ち受けソケット
+ * @param count 待ち受けソケット数 (RESTART_MAX_LISTENERS 以下)
+ * @param match_count 続いて送る試合数
+ * @return 成功時1、失敗時0
+ */
+int restart_send_begin(int channel, const int *listen_fds, int count, uint32_t match_count);
+
+/**
+ * @brief 試合を1件送る (旧プロセス)
+ *
+ * 接続中の参加者 (conn >= 0) の接続を一緒に送ります。送信後も旧プロセスの記述子は
+ * 有効なため、確認応答を受けてから閉じてください。
+ *
+ * @param channel 引き継ぎ用の接続
+ * @param match 送る試合 (チェックポイント取得済み)
+ * @param pending 参加者ごとの未送信データ (player_count 個、NULL可)
+ * @return 成功時1、失敗時0
+ */
+int restart_send_match(int channel, const ServerMatch *match, const RestartPending *pending);
+
+/**
+ * @brief 送信の終わりを伝え、新プロセスの確認応答を待つ (旧プロセス)
+ * @param channel 引き継ぎ用の接続
+ * @return 確認応答を受けた場合1 (旧プロセスは終了してよい)、失敗時0 (旧プロセスは試合を再開する)
+ */
+int restart_send_end(int channel);
+
+/**
+ * @brief 旧プロセスの引き継ぎ用ソケットへ接続する (新プロセス、起動時)
+ * @param path ソケットパス
+ * @return 引き継ぎ用の接続 (旧プロセスがいない場合-1: 通常の起動)
+ */
+int restart_connect(const char *path);
+
+/**
+ * @brief 待ち受けソケットと試合数を受け取る (新プロセス)
+ * @param channel 引き継ぎ用の接続
+ * @param listen_fds 待ち受けソケットの出力先 (RESTART_MAX_LISTENERS 個)
+ * @param count 待ち受けソケット数の出力先
+ * @param match_count 試合数の出力先
+ * @return 成功時1、失敗時0
+ */
+int restart_recv_begin(int channel, int *listen_fds, int *count, uint32_t *match_count);
+
+/**
+ * @brief 試合を1件受け取る (新プロセス)
+ *
+ * 終わりの通知を受けた場合は確認応答を返します。
+ *
+ * @param channel 引き継ぎ用の接続
+ * @param match 試合の出力先 (接続中の参加者の conn に受け取った記述子が入る)
+ * @param buf 受信用の作業領域 (RESTART_FRAME_MAX バイト、pending はこの中を指す)
+ * @param pending 参加者ごとの未送信データの出力先 (MATCH_MAX_PLAYERS 個)
+ * @return 受け取った場合1、終わりの場合0、失敗時-1
+ */
+int restart_recv_match(int channel, ServerMatch *match, uint8_t *buf, RestartPending *pending);
+
+#endif /* RESTART_H */
@@ -0,0 +1,748 @@
+/**
+ * @file shard.c
+ * @brief サーバーのシャードの実装
+ *
+ * 主な機能:
+ *   - 試合の一覧 (末尾との入れ替えで削除) と接続表の管理
+ *   - 受信箱: 生産者は CAS で先頭に積み、消費者は交換で一括取得して順序を戻す
+ *   - 移動: 切り離し完了の集計、チェックポイント、移動先での復元と接続の取り込み
+ *   - 試合の進行の駆動: イベントと期限による再開、終了した試合の解放
+ *   - 毎ティック走査する試合のフィールド (段階、落下期限、未処理入力数、重力レベル) の SoA 配置
+ *   - 負荷制限: 平滑化したティック時間と予算の比から段階を決める (戻す側に余裕を持たせる)
+ *
+ * 設計思想:
+ *   - 移動先はチェックポイントから盤面とスコアを復元し、統計とタイマーはそのまま引き継ぐ
+ *   - 試合の進行の期限は全シャード共通のティックで持ち、移動時はタイマーホイールを付け替える
+ *   - 走査用のフィールドは試合一覧と同じ位置の配列に置き、処理の要らない試合の本体には触れない
+ *   - 移動の通知要素は元の試合に埋め込まれており、DONE/ABORT で元のシャードへ戻ってくる
+ *   - 負荷分散の指示はシャードごとに1件のみ (処理されるまで次の指示を出さない)
+ */
+
+#include "shard.h"
+#include "interest.h"
+#include "slab.h"
+#include <stdatomic.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+/**
+ * @brief 接続表の要素
+ */
+typedef struct {
+    ShardMatch* match;           /**< 接続の持ち主の試合 (NULL: なし) */
+    int player;                  /**< プレイヤー番号 */
+} ShardConn;
+
+#define SHARD_HOT_MIGRATING 0xff /**< 走査用の段階: 移動中 */
+
+/**
+ * @brief 毎ティック走査する試合のフィールド (試合一覧と同じ位置)
+ */
+typedef struct {
+    uint8_t* state;              /**< 進行段階 (SHARD_HOT_MIGRATING: 移動中) */
+    uint32_t* deadline;          /**< 次に落下処理が必要なティック */
+    uint16_t* pending;           /**< 未処理の入力数 */
+    uint8_t* gravity;            /**< 生存中の参加者の最も高いレベル */
+} ShardHot;
+
+/**
+ * @brief シャード
+ */
+struct Shard {
+    int id;                      /**< シャード番号 */
+    NetBackend* nb;              /**< I/O バックエンド */
+    int max_conns;               /**< 接続の記述子の上限 */
+    int max_matches;             /**< 試合数の上限 */
+    SlabPool* pool;              /**< 試合のプール */
+    SlabCache cache;             /**< 試合のプールのキャッシュ (シャードのスレッド用) */
+    ShardConn* conns;            /**< 接続表 */
+    ShardMatch** matches;        /**< 試合の一覧 */
+    ShardHot hot;                /**< 試合一覧と同じ位置の走査用フィールド */
+    int match_count;             /**< 試合数 */
+    TimerWheel timers;           /**< 試合の進行の期限 */
+    ShardMessage request;        /**< 負荷分散の指示用 */
+    _Alignas(64) _Atomic(ShardMessage*) inbox; /**< 受信箱 (新しい順) */
+    _Atomic int request_busy;    /**< 負荷分散の指示が処理待ち */
+    _Alignas(64) _Atomic uint32_t load_us; /**< 平滑化したティック時間 */
+    _Atomic int published_count; /**< 他スレッドから見る試合数 */
+    _Atomic int shed_level;      /**< 負荷制限の段階 */
+};
+
+/**
+ * @brief 受信箱に通知を積む (どのスレッドからでもよい)
+ */
+static void inbox_push(Shard *shard, ShardMessage *msg) {
+    ShardMessage *head = atomic_load_explicit(&shard->inbox, memory_order_relaxed);
+    do {
+        msg->next = head;
+    } while (!atomic_compare_exchange_weak_explicit(&shard->inbox, &head, msg,
+                                                    memory_order_release, memory_order_relaxed));
+}
+
+/**
+ * @brief 盤面の参照を試合自身の領域に向ける
+ */
+static void bind_boards(ShardMatch *sm) {
+    for (int i = 0; i < MATCH_MAX_PLAYERS; i++) {
+        sm->boards[i].width = BOARD_WIDTH;
+        sm->boards[i].height = BOARD_HEIGHT;
+        sm->boards[i].grid = sm->grids[i];
+        sm->gameplay[i].board = &sm->boards[i];
+    }
+}
+
+/**
+ * @brief 重力レベルの落下間隔を取得する (ティック)
+ */
+static uint32_t gravity_ticks(int level) {
+    int delay_ms = INITIAL_FALL_DELAY - (level - INITIAL_LEVEL) * LEVEL_SPEED_REDUCTION;
+    if (delay_ms < MIN_FALL_DELAY) {
+        delay_ms = MIN_FALL_DELAY;
+    }
+    uint32_t ticks = (uint32_t)delay_ms * 1000 / SHARD_TICK_BUDGET_US;
+    return ticks > 0 ? ticks : 1;
+}
+
+/**
+ * @brief 生存中の参加者の最も高いレベルを求める
+ */
+static uint8_t match_gravity(const ShardMatch *sm) {
+    int level = INITIAL_LEVEL;
+    for (int i = 0; i < sm->match.player_count; i++) {
+        if (sm->match.players[i].alive && sm->gameplay[i].score.level > level) {
+            level = sm->gameplay[i].score.level;
+        }
+    }
+    return (uint8_t)(level < UINT8_MAX ? level : UINT8_MAX);
+}
+
+static uint8_t hot_state(const ShardMatch *sm) {
+    return sm->migrating ? SHARD_HOT_MIGRATING : sm->flow.phase;
+}
+
+/**
+ * @brief 進行段階の変化を走査用のフィールドに反映する (プレイ開始時に落下期限を設定)
+ */
+static void hot_sync(Shard *shard, const ShardMatch *sm) {
+    uint8_t state = hot_state(sm);
+    if (state == MATCH_PHASE_PLAYING && shard->hot.state[sm->slot] != MATCH_PHASE_PLAYING) {
+        shard->hot.deadline[sm->slot] = shard->timers.now + gravity_ticks(shard->hot.gravity[sm->slot]);
+    }
+    shard->hot.state[sm->slot] = state;
+}
+
+static void list_add(Shard *shard, ShardMatch *sm) {
+    int slot = shard->match_count++;
+    sm->slot = slot;
+    shard->matches[slot] = sm;
+    shard->hot.state[slot] = SHARD_HOT_MIGRATING;
+    shard->hot.pending[slot] = (uint16_t)sm->match.input_count; // 移動してきた試合はチェックポイント後の入力を再生する
+    shard->hot.gravity[slot] = match_gravity(sm);
+    shard->hot.deadline[slot] = shard->timers.now;
+    hot_sync(shard, sm);
+    atomic_store_explicit(&shard->published_count, shard->match_count, memory_order_relaxed);
+}
+
+static void list_remove(Shard *shard, ShardMatch *sm) {
+    int last_slot = --shard->match_count;
+    ShardMatch *last = shard->matches[last_slot];
+    shard->matches[sm->slot] = last;
+    shard->hot.state[sm->slot] = shard->hot.state[last_slot];
+    shard->hot.deadline[sm->slot] = shard->hot.deadline[last_slot];
+    shard->hot.pending[sm->slot] = shard->hot.pending[last_slot];
+    shard->hot.gravity[sm->slot] = shard->hot.gravity[last_slot];
+    last->slot = sm->slot;
+    atomic_store_explicit(&shard->published_count, shard->match_count, memory_order_relaxed);
+}
+
+static void* hot_alloc(size_t n, size_t size) {
+    return aligned_alloc(64, (n * size + 63) & ~(size_t)63);
+}
+
+static void hot_free(ShardHot *hot) {
+    free(hot->state);
+    free(hot->deadline);
+    free(hot->pending);
+    free(hot->gravity);
+}
+
+static void free_pending(ShardMatch *sm) {
+    for (int i = 0; i < MATCH_MAX_PLAYERS; i++) {
+        free(sm->pending[i]);
+        sm->pending[i] = NULL;
+        sm->pending_len[i] = 0;
+    }
+}
+
+/**
+ * @brief シャードを作成する
+ */
+Shard* shard_create(int id, NetBackend *nb, int max_conns, uint32_t max_matches, int node, uint32_t now) {
+    if (!nb || max_conns <= 0 || max_matches == 0) {
+        return NULL;
+    }
+    Shard *shard = (Shard*)aligned_alloc(64, (sizeof(Shard) + 63) & ~(size_t)63);
+    if (!shard) {
+        return NULL;
+    }
+    memset(shard, 0, sizeof(*shard));
+    shard->id = id;
+    shard->nb = nb;
+    shard->max_conns = max_conns;
+    shard->max_matches = (int)max_matches;
+    shard->pool = slab_pool_create(sizeof(ShardMatch), max_matches,
+                                   ARENA_HUGETLB | ARENA_THP | ARENA_PREFAULT, node);
+    shard->conns = (ShardConn*)calloc((size_t)max_conns, sizeof(ShardConn));
+    shard->matches = (ShardMatch**)malloc(sizeof(ShardMatch*) * max_matches);
+    shard->hot.state = (uint8_t*)hot_alloc(max_matches, sizeof(uint8_t));
+    shard->hot.deadline = (uint32_t*)hot_alloc(max_matches, sizeof(uint32_t));
+    shard->hot.pending = (uint16_t*)hot_alloc(max_matches, sizeof(uint16_t));
+    shard->hot.gravity = (uint8_t*)hot_alloc(max_matches, sizeof(uint8_t));
+    if (!shard->pool || !shard->conns || !shard->matches || !shard->hot.state ||
+        !shard->hot.deadline || !shard->hot.pending || !shard->hot.gravity) {
+        slab_pool_destroy(shard->pool);
+        free(shard->conns);
+        free(shard->matches);
+        hot_free(&shard->hot);
+        free(shard);
+        return NULL;
+    }
+    slab_cache_init(&shard->cache, shard->pool);
+    timer_wheel_init(&shard->timers, now);
+    atomic_init(&shard->inbox, NULL);
+    atomic_init(&shard->request_busy, 0);
+    atomic_init(&shard->load_us, 0);
+    atomic_init(&shard->published_count, 0);
+    atomic_init(&shard->shed_level, SHARD_SHED_NONE);
+    return shard;
+}
+
+/**
+ * @brief シャードを解放する
+ */
+void shard_destroy(Shard *shard) {
+    if (!shard) {
+        return;
+    }
+    while (shard->match_count > 0) {
+        shard_match_destroy(shard, shard->matches[shard->match_count - 1]);
+    }
+    slab_cache_flush(&shard->cache);
+    slab_pool_destroy(shard->pool);
+    free(shard->conns);
+    free(shard->matches);
+    hot_free(&shard->hot);
+    free(shard);
+}
+
+/**
+ * @brief 試合を作成する
+ */
+ShardMatch* shard_match_create(Shard *shard, uint64_t match_id, GameMode mode, uint64_t seed) {
+    if (shard->match_count >= shard->max_matches || !shard_admits(shard)) {
+        return NULL;
+    }
+    ShardMatch *sm = (ShardMatch*)slab_alloc(&shard->cache);
+    if (!sm) {
+        return NULL;
+    }
+    memset(sm, 0, sizeof(*sm));
+    match_init(&sm->match, match_id, mode, seed);
+    bind_boards(sm);
+    match_flow_init(&sm->flow, &sm->match);
+    match_flow_resume(&sm->flow, &sm->match, &shard->timers, shard->timers.now, MATCH_EVENT_START, -1);
+    list_add(shard, sm);
+    return sm;
+}
+
+/**
+ * @brief 試合に参加者を追加する
+ */
+int shard_match_add_player(Shard *shard, ShardMatch *sm, uint32_t player_id, int conn, NetTransport transport) {
+    if (conn < 0 || conn >= shard->max_conns || shard->conns[conn].match) {
+        return -1;
+    }
+    int player = match_add_player(&sm->match, player_id, conn, transport);
+    if (player >= 0) {
+        shard->conns[conn].match = sm;
+        shard->conns[conn].player = player;
+    }
+    return player;
+}
+
+/**
+ * @brief 進行が終了した試合の接続を閉じて解放する
+ */
+static void finish_match(Shard *shard, ShardMatch *sm) {
+    for (int i = 0; i < sm->match.player_count; i++) {
+        int conn = sm->match.players[i].conn;
+        if (conn >= 0 && conn < shard->max_conns && shard->conns[conn].match == sm) {
+            net_backend_close(shard->nb, conn);
+        }
+    }
+    shard_match_destroy(shard, sm);
+}
+
+/**
+ * @brief 試合の進行にイベントを伝える
+ */
+MatchPhase shard_match_event(Shard *shard, ShardMatch *sm, MatchEventType type, int player) {
+    if (sm->migrating) {
+        return (MatchPhase)sm->flow.phase;
+    }
+    MatchPhase phase = match_flow_resume(&sm->flow, &sm->match, &shard->timers, shard->timers.now, type, player);
+    if (phase == MATCH_PHASE_FINISHED) {
+        finish_match(shard, sm);
+    } else {
+        if (type == MATCH_EVENT_TOPOUT || type == MATCH_EVENT_RECONNECT) {
+            shard->hot.gravity[sm->slot] = match_gravity(sm);
+        }
+        hot_sync(shard, sm);
+    }
+    return phase;
+}
+
+/**
+ * @brief 試合のシミュレーションを進めてよいか判定する
+ */
+int shard_match_simulating(const ShardMatch *sm) {
+    return sm->flow.phase == MATCH_PHASE_PLAYING && !sm->migrating;
+}
+
+/**
+ * @brief 入力を試合の入力ログに追加する
+ */
+int shard_match_log_input(Shard *shard, ShardMatch *sm, const MatchInput *input) {
+    if (!match_log_input(&sm->match, input)) {
+        return 0;
+    }
+    if (shard->hot.pending[sm->slot] < UINT16_MAX) {
+        shard->hot.pending[sm->slot]++;
+    }
+    return 1;
+}
+
+/**
+ * @brief 参加者のレベルの変化を重力レベルに反映する
+ */
+void shard_match_update_gravity(Shard *shard, ShardMatch *sm) {
+    shard->hot.gravity[sm->slot] = match_gravity(sm);
+}
+
+/**
+ * @brief このティックに処理が必要な試合を集める
+ */
+int shard_collect_due(Shard *shard, ShardMatch **out, int max) {
+    const uint8_t *state = shard->hot.state;
+    const uint32_t *deadline = shard->hot.deadline;
+    const uint16_t *pending = shard->hot.pending;
+    uint32_t now = shard->timers.now;
+    int count = 0;
+    for (int i = 0; i < shard->match_count && count < max; i++) {
+        if (state[i] == MATCH_PHASE_PLAYING && (pending[i] != 0 || (int32_t)(now - deadline[i]) >= 0)) {
+            out[count++] = shard->matches[i];
+        }
+    }
+    return count;
+}
+
+/**
+ * @brief 試合のこのティックの処理を始める
+ */
+int shard_match_begin_tick(Shard *shard, ShardMatch *sm) {
+    int slot = sm->slot;
+    int gravity_due = (int32_t)(shard->timers.now - shard->hot.deadline[slot]) >= 0;
+    shard->hot.pending[slot] = 0;
+    if (gravity_due) {
+        shard->hot.deadline[slot] = shard->timers.now + gravity_ticks(shard->hot.gravity[slot]);
+    }
+    return gravity_due;
+}
+
+/**
+ * @brief 期限に達した試合の進行を再開する
+ */
+static void on_flow_timer(TimerNode *node, void *user) {
+    Shard *shard = (Shard*)user;
+    ShardMatch *sm = (ShardMatch*)((uint8_t*)node - offsetof(ShardMatch, flow.timer));
+    shard_match_event(shard, sm, MATCH_EVENT_TIMER, -1);
+}
+
+/**
+ * @brief 時刻を進めて期限に達した試合の進行を再開する
+ */
+int shard_advance(Shard *shard, uint32_t now) {
+    return timer_wheel_advance(&shard->timers, now, on_flow_timer, shard);
+}
+
+/**
+ * @brief 試合を解放する
+ */
+void shard_match_destroy(Shard *shard, ShardMatch *sm) {
+    match_flow_detach_timer(&sm->flow, &shard->timers);
+    for (int i = 0; i < sm->match.player_count; i++) {
+        int conn = sm->match.players[i].conn;
+        if (conn >= 0 && conn < shard->max_conns && shard->conns[conn].match == sm) {
+            shard->conns[conn].match = NULL;
+        }
+    }
+    free_pending(sm);
+    list_remove(shard, sm);
+    slab_free(&shard->cache, sm);
+}
+
+/**
+ * @brief 接続の持ち主の試合を引く
+ */
+ShardMatch* shard_conn_owner(const Shard *shard, int conn, int *player) {
+    if (conn < 0 || conn >= shard->max_conns || !shard->conns[conn].match) {
+        return NULL;
+    }
+    if (player) {
+        *player = shard->conns[conn].player;
+    }
+    return shard->conns[conn].match;
+}
+
+/**
+ * @brief 試合の一覧を取得する
+ */
+ShardMatch* const* shard_matches(const Shard *shard, int *count) {
+    *count = shard->match_count;
+    return shard->matches;
+}
+
+/**
+ * @brief 接続をバックエンドに取り込み、接続表に登録する
+ * @return 取り込めずに切断として扱ったプレイヤーのビット集合
+ */
+static uint32_t adopt_conns(Shard *shard, ShardMatch *sm, const ShardMatch *from) {
+    uint32_t dropped = 0;
+    for (int i = 0; i < sm->match.player_count; i++) {
+        int conn = sm->match.players[i].conn;
+        if (conn < 0) {
+            continue;
+        }
+        if (conn < shard->max_conns &&
+            net_backend_adopt(shard->nb, conn, from->pending[i], from->pending_len[i])) {
+            shard->conns[conn].match = sm;
+            shard->conns[conn].player = i;
+        } else {
+            // 取り込めない接続は切断として扱う (クライアントの再接続を待つ)
+            close(conn);
+            sm->match.players[i].conn = -1;
+            dropped |= 1u << i;
+        }
+    }
+    return dropped;
+}
+
+/**
+ * @brief 取り込めなかった接続の切断を試合の進行に伝える
+ */
+static void report_dropped(Shard *shard, ShardMatch *sm, uint32_t dropped) {
+    for (int i = 0; dropped; i++, dropped >>= 1) {
+        if (dropped & 1) {
+            shard_match_event(shard, sm, MATCH_EVENT_DISCONNECT, i);
+        }
+    }
+}
+
+/**
+ * @brief 全接続の切り離しが済んだ試合のチェックポイントを取って移動先へ送る
+ */
+static void finish_detach(Shard *shard, ShardMatch *sm) {
+    const GamePlayContext *gameplays[MATCH_MAX_PLAYERS];
+    for (int i = 0; i < MATCH_MAX_PLAYERS; i++) {
+        gameplays[i] = &sm->gameplay[i];
+    }
+    match_checkpoint(&sm->match, gameplays, sm->match.rng_state);
+    sm->message.type = SHARD_MSG_MIGRATE_IN;
+    sm->message.match = sm;
+    sm->message.peer = shard;
+    inbox_push(sm->target, &sm->message);
+}
+
+/**
+ * @brief 移動してきた試合を自シャードのプールに復元する
+ */
+static void accept_migration(Shard *shard, ShardMessage *msg) {
+    ShardMatch *from = msg->match;
+    Shard *source = msg->peer;
+    ShardMatch *sm = shard->match_count < shard->max_matches && shard_admits(shard) ?
+                     (ShardMatch*)slab_alloc(&shard->cache) : NULL;
+    if (!sm) {
+        msg->type = SHARD_MSG_MIGRATE_ABORT;
+        msg->peer = shard;
+        inbox_push(source, msg);
+        return;
+    }
+
+    memset(sm, 0, sizeof(*sm));
+    sm->match = from->match;
+    sm->flow = from->flow;
+    match_flow_attach_timer(&sm->flow, &shard->timers);
+    for (int i = 0; i < MATCH_MAX_PLAYERS; i++) {
+        sm->gameplay[i] = from->gameplay[i]; // 統計、タイマーなどスナップショット外の状態
+    }
+    bind_boards(sm);
+    GamePlayContext *gameplays[MATCH_MAX_PLAYERS];
+    for (int i = 0; i < MATCH_MAX_PLAYERS; i++) {
+        gameplays[i] = &sm->gameplay[i];
+    }
+    match_restore(&sm->match, gameplays);
+    uint32_t dropped = adopt_conns(shard, sm, from) | from->detach_dropped;
+    list_add(shard, sm);
+
+    msg->type = SHARD_MSG_MIGRATE_DONE;
+    msg->peer = shard;
+    inbox_push(source, msg);
+    report_dropped(shard, sm, dropped);
+}
+
+/**
+ * @brief 移動先が受け入れられなかった試合を再開する
+ */
+static void resume_aborted(Shard *shard, ShardMatch *sm) {
+    uint32_t dropped = adopt_conns(shard, sm, sm) | sm->detach_dropped;
+    free_pending(sm);
+    sm->migrating = 0;
+    sm->target = NULL;
+    sm->detach_dropped = 0;
+    match_flow_attach_timer(&sm->flow, &shard->timers);
+    hot_sync(shard, sm);
+    report_dropped(shard, sm, dropped);
+}
+
+/**
+ * @brief 負荷分散の指示に従い、移動中でない試合を1つ送り出す
+ */
+static void handle_request(Shard *shard, Shard *target) {
+    for (int i = shard->match_count - 1; i >= 0; i--) {
+        if (!shard->matches[i]->migrating && shard_migrate(shard, shard->matches[i], target)) {
+            return;
+        }
+    }
+}
+
+/**
+ * @brief 受信箱の通知を処理する
+ */
+int shard_poll_inbox(Shard *shard) {
+    ShardMessage *list = atomic_exchange_explicit(&shard->inbox, NULL, memory_order_acquire);
+    // 新しい順に積まれているため、届いた順に戻す
+    ShardMessage *ordered = NULL;
+    while (list) {
+        ShardMessage *next = list->next;
+        list->next = ordered;
+        ordered = list;
+        list = next;
+    }
+
+    int handled = 0;
+    while (ordered) {
+        ShardMessage *msg = ordered;
+        ordered = msg->next;
+        switch (msg->type) {
+            case SHARD_MSG_MIGRATE_REQUEST: {
+                Shard *target = msg->peer;
+                atomic_store_explicit(&shard->request_busy, 0, memory_order_release);
+                handle_request(shard, target);
+                break;
+            }
+            case SHARD_MSG_MIGRATE_IN:
+                accept_migration(shard, msg);
+                break;
+            case SHARD_MSG_MIGRATE_DONE:
+                shard_match_destroy(shard, msg->match);
+                break;
+            case SHARD_MSG_MIGRATE_ABORT:
+                resume_aborted(shard, msg->match);
+                break;
+        }
+        handled++;
+    }
+    return handled;
+}
+
+/**
+ * @brief 接続の切り離し完了を伝える
+ */
+void shard_on_detached(Shard *shard, int conn, const uint8_t *data, size_t len) {
+    int player;
+    ShardMatch *sm = shard_conn_owner(shard, conn, &player);
+    if (!sm || !sm->migrating) {
+        return;
+    }
+    shard->conns[conn].match = NULL;
+    // 未送信データは移動の開始時に確保したバッファに移す (len は NET_BACKEND_OUT_SIZE 以下)
+    if (len > 0) {
+        memcpy(sm->pending[player], data, len);
+        sm->pending_len[player] = (uint32_t)len;
+    }
+    if (--sm->detach_left == 0) {
+        finish_detach(shard, sm);
+    }
+}
+
+/**
+ * @brief 試合の移動を始める
+ */
+int shard_migrate(Shard *shard, ShardMatch *sm, Shard *target) {
+    if (sm->migrating || !target || target == shard) {
+        return 0;
+    }
+    // 未送信データの受け皿を先に確保する (確保できなければ何も変えずに移動しない)
+    for (int i = 0; i < sm->match.player_count; i++) {
+        if (sm->match.players[i].conn >= 0) {
+            sm->pending[i] = (uint8_t*)malloc(NET_BACKEND_OUT_SIZE);
+            if (!sm->pending[i]) {
+                free_pending(sm);
+                return 0;
+            }
+        }
+    }
+    sm->migrating = 1;
+    sm->target = target;
+    sm->detach_left = 0;
+    sm->detach_dropped = 0;
+    match_flow_detach_timer(&sm->flow, &shard->timers);
+    hot_sync(shard, sm);
+    for (int i = 0; i < sm->match.player_count; i++) {
+        int conn = sm->match.players[i].conn;
+        if (conn < 0) {
+            continue;
+        }
+        if (net_backend_detach(shard->nb, conn)) {
+            sm->detach_left++;
+        } else {
+            // 切り離せない接続は閉じ、移動後に切断として伝える (クライアントの再接続を待つ)
+            net_backend_close(shard->nb, conn);
+            shard->conns[conn].match = NULL;
+            sm->match.players[i].conn = -1;
+            sm->detach_dropped |= (uint8_t)(1u << i);
+        }
+    }
+    if (sm->detach_left == 0) {
+        finish_detach(shard, sm);
+    }
+    return 1;
+}
+
+/**
+ * @brief 段階に入る予算の使用率を取得する
+ */
+static uint32_t shed_threshold_pct(int level) {
+    static const uint32_t pct[] = {0, SHARD_SHED_ADMIT_PCT, SHARD_SHED_SUMMARY_PCT, SHARD_SHED_AI_PCT};
+    return pct[level];
+}
+
+/**
+ * @brief 平滑化したティック時間から負荷制限の段階を決める
+ */
+static int next_shed_level(int level, uint32_t load_us) {
+    uint32_t used_pct = (uint32_t)((uint64_t)load_us * 100 / SHARD_TICK_BUDGET_US);
+    // 上げるときは閾値で、下げるときは閾値から余裕を引いた値で判定し、境界での振動を防ぐ
+    while (level < SHARD_SHED_AI && used_pct >= shed_threshold_pct(level + 1)) {
+        level++;
+    }
+    while (level > SHARD_SHED_NONE && used_pct + SHARD_SHED_RECOVER_PCT < shed_threshold_pct(level)) {
+        level--;
+    }
+    return level;
+}
+
+/**
+ * @brief ティック時間を記録する
+ */
+void shard_record_tick(Shard *shard, uint32_t tick_us) {
+    uint32_t load = atomic_load_explicit(&shard->load_us, memory_order_relaxed);
+    load = (uint32_t)((int32_t)load + (((int32_t)tick_us - (int32_t)load) >> SHARD_LOAD_SHIFT));
+    atomic_store_explicit(&shard->load_us, load, memory_order_relaxed);
+
+    int level = atomic_load_explicit(&shard->shed_level, memory_order_relaxed);
+    atomic_store_explicit(&shard->shed_level, next_shed_level(level, load), memory_order_relaxed);
+}
+
+/**
+ * @brief 平滑化したティック時間を取得する
+ */
+uint32_t shard_load(const Shard *shard) {
+    return atomic_load_explicit(&((Shard*)shard)->load_us, memory_order_relaxed);
+}
+
+/**
+ * @brief 負荷制限の段階を取得する
+ */
+ShardShedLevel shard_shed_level(const Shard *shard) {
+    return (ShardShedLevel)atomic_load_explicit(&((Shard*)shard)->shed_level, memory_order_relaxed);
+}
+
+/**
+ * @brief 新しい試合を受け入れられるか判定する
+ */
+int shard_admits(const Shard *shard) {
+    return shard_shed_level(shard) < SHARD_SHED_ADMISSION;
+}
+
+/**
+ * @brief 要約の更新の最短間隔を取得する
+ */
+uint32_t shard_summary_interval(const Shard *shard) {
+    uint32_t ticks = INTEREST_MIN_SUMMARY_TICKS;
+    return shard_shed_level(shard) >= SHARD_SHED_SUMMARY ? ticks * SHARD_SHED_SUMMARY_SCALE : ticks;
+}
+
+/**
+ * @brief 負荷制限を反映した AI の計算予算を取得する
+ */
+uint32_t shard_ai_budget(const Shard *shard, uint32_t base) {
+    if (shard_shed_level(shard) < SHARD_SHED_AI) {
+        return base;
+    }
+    // AI 段階の閾値を超えた分に反比例して削る
+    uint64_t limit = (uint64_t)SHARD_TICK_BUDGET_US * SHARD_SHED_AI_PCT / 100;
+    uint64_t load = shard_load(shard);
+    uint64_t scaled = load > limit ? (uint64_t)base * limit / load : base;
+    uint32_t floor = base / SHARD_SHED_AI_MIN_DIV;
+    return scaled > floor ? (uint32_t)scaled : floor;
+}
+
+/**
+ * @brief 最も重いシャードから最も軽いシャードへの移動を指示する
+ */
+int shard_balance(Shard *const shards[], int count) {
+    if (count < 2) {
+        return 0;
+    }
+    Shard *hot = shards[0];
+    Shard *cold = shards[0];
+    for (int i = 1; i < count; i++) {
+        if (shard_load(shards[i]) > shard_load(hot)) hot = shards[i];
+        if (shard_load(shards[i]) < shard_load(cold)) cold = shards[i];
+    }
+    uint32_t hot_load = shard_load(hot);
+    uint32_t cold_load = shard_load(cold);
+    int hot_count = atomic_load_explicit(&hot->published_count, memory_order_relaxed);
+    if (hot == cold || hot_count < 2 || hot_load - cold_load < SHARD_BALANCE_SLACK_US || !shard_admits(cold)) {
+        return 0;
+    }
+    // 1試合分の負荷を移しても逆転するだけなら動かさない
+    uint32_t per_match = hot_load / (uint32_t)hot_count;
+    if (cold_load + per_match >= hot_load - per_match) {
+        return 0;
+    }
+
+    int expected = 0;
+    if (!atomic_compare_exchange_strong_explicit(&hot->request_busy, &expected, 1,
+                                                 memory_order_acquire, memory_order_relaxed)) {
+        return 0;
+    }
+    hot->request.type = SHARD_MSG_MIGRATE_REQUEST;
+    hot->request.match = NULL;
+    hot->request.peer = cold;
+    inbox_push(hot, &hot->request);
+    return 1;
+}
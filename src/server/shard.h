@@ -0,0 +1,312 @@
+/**
+ * @file shard.h
+ * @brief サーバーのシャード (イベントループ1本分の試合の集合) の宣言
+ *
+ * このファイルは1つのイベントループスレッドが受け持つ試合の管理と、
+ * 負荷の偏りを解消するためのシャード間の試合の移動を宣言します。
+ * 主な機能:
+ *   - シャードごとのプール (NUMA ノードに配置) からの試合の確保と解放
+ *   - 接続から試合と参加者を引く接続表
+ *   - 試合ごとの進行 (match_flow) の駆動と、期限を扱うシャードのタイマーホイール
+ *   - 毎ティックの走査を連続したメモリで行うための試合のフィールドの SoA 配置
+ *   - 他スレッドからの通知を受ける受信箱 (ロックなしの複数生産者/単一消費者)
+ *   - ティック時間の平滑化と、最も重いシャードから最も軽いシャードへの移動の指示
+ *   - 進行中の試合の移動 (接続の切り離し → チェックポイント → 移動先での復元と取り込み)
+ *   - ティック予算の使用率に応じた段階的な負荷制限 (新規試合の拒否 → 要約の間引き → AI の計算削減)
+ *
+ * 設計思想:
+ *   - 試合と接続に触れるのは所有シャードのスレッドのみで、他スレッドとは受信箱でのみやり取りする
+ *   - 移動の通知は試合とシャードに埋め込んだ要素を使い、通知のための動的確保をしない
+ *   - 移動先は自ノードのプールに試合を作り直し、元の試合は元のシャードが解放する
+ *   - 移動先が受け入れられない場合は元のシャードが接続を取り戻して続行する
+ *   - ティック処理は shard_collect_due で処理の要る試合だけを選び、大きな試合の本体を順に読まない
+ *   - 過負荷時は進行中の試合の入力処理とシミュレーションを守り、優先度の低い処理から削る
+ */
+
+#ifndef SHARD_H
+#define SHARD_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "arena.h"
+#include "match.h"
+#include "match_flow.h"
+#include "net_backend.h"
+#include "timer_wheel.h"
+
+#define SHARD_LOAD_SHIFT        3   /**< ティック時間の平滑化係数 (1/8) */
+#define SHARD_BALANCE_SLACK_US  500 /**< 移動を指示する最小の負荷差 (us) */
+#define SHARD_TICK_BUDGET_US    16667 /**< 1ティックの時間予算 (60Hz) */
+#define SHARD_SHED_ADMIT_PCT    70  /**< 新しい試合を断り始める予算の使用率 (%) */
+#define SHARD_SHED_SUMMARY_PCT  80  /**< 要約の更新を間引き始める使用率 (%) */
+#define SHARD_SHED_AI_PCT       90  /**< AI の計算予算を削り始める使用率 (%) */
+#define SHARD_SHED_RECOVER_PCT  10  /**< 段階を戻すのに必要な使用率の余裕 (%) */
+#define SHARD_SHED_SUMMARY_SCALE 4  /**< 間引き時の要約の間隔の倍率 */
+#define SHARD_SHED_AI_MIN_DIV   8   /**< AI の計算予算を削る下限 (元の 1/8) */
+
+/* 負荷制限の段階 (上の段階は下の段階の制限をすべて含む) */
+typedef enum {
+    SHARD_SHED_NONE,             /**< 制限なし */
+    SHARD_SHED_ADMISSION,        /**< 新しい試合と移動の受け入れを断る */
+    SHARD_SHED_SUMMARY,          /**< 関係の薄い相手の要約の更新を間引く */
+    SHARD_SHED_AI                /**< AI 対戦相手の計算予算を削る */
+} ShardShedLevel;
+
+typedef struct Shard Shard;
+typedef struct ShardMatch ShardMatch;
+
+/* 受信箱の通知種別 */
+typedef enum {
+    SHARD_MSG_MIGRATE_REQUEST,   /**< 試合を1つ移動先へ送るよう求める (負荷分散から) */
+    SHARD_MSG_MIGRATE_IN,        /**< 移動してきた試合を受け入れる */
+    SHARD_MSG_MIGRATE_DONE,      /**< 移動が完了したので元の試合を解放する */
+    SHARD_MSG_MIGRATE_ABORT      /**< 移動先が受け入れられなかったので試合を再開する */
+} ShardMessageType;
+
+/**
+ * @brief 受信箱の要素
+ */
+typedef struct ShardMessage {
+    struct ShardMessage* next;   /**< 次の要素 */
+    ShardMessageType type;       /**< 通知種別 */
+    ShardMatch* match;           /**< 対象の試合 */
+    Shard* peer;                 /**< 相手のシャード */
+} ShardMessage;
+
+/**
+ * @brief シャード上の試合
+ */
+struct ShardMatch {
+    ServerMatch match;           /**< 試合の記録 */
+    MatchFlow flow;              /**< 試合の進行 */
+    GamePlayContext gameplay[MATCH_MAX_PLAYERS]; /**< 参加者ごとのゲーム状態 */
+    Board boards[MATCH_MAX_PLAYERS]; /**< 参加者ごとの盤面 */
+    uint8_t grids[MATCH_MAX_PLAYERS][BOARD_SIZE]; /**< 盤面の本体 */
+    int slot;                    /**< シャードの試合一覧での位置 */
+    uint8_t migrating;           /**< 移動中 (シミュレーションしない) */
+    uint8_t detach_left;         /**< 切り離しの完了待ちの接続数 */
+    Shard* target;               /**< 移動先 */
+    uint8_t detach_dropped;      /**< 切り離せずに閉じたプレイヤーのビット集合 (移動後に切断として伝える) */
+    uint8_t* pending[MATCH_MAX_PLAYERS]; /**< 切り離し時の未送信データ (移動の開始時に確保) */
+    uint32_t pending_len[MATCH_MAX_PLAYERS]; /**< 未送信データの長さ */
+    ShardMessage message;        /**< 移動の通知用 */
+};
+
+/**
+ * @brief シャードを作成する (シャードのスレッドから)
+ * @param id シャード番号
+ * @param nb シャードの I/O バックエンド (シャードのスレッドで作成したもの)
+ * @param max_conns 接続の記述子の上限 (バックエンドと同じ値)
+ * @param max_matches 試合数の上限
+ * @param node 試合のプールを置く NUMA ノード (ARENA_NODE_ANY で指定なし)
+ * @param now 現在のティック (全シャード共通の時計)
+ * @return 作成したシャード (失敗時はNULL)
+ */
+Shard* shard_create(int id, NetBackend *nb, int max_conns, uint32_t max_matches, int node, uint32_t now);
+
+/**
+ * @brief シャードを解放する (残っている試合も解放する)
+ * @param shard 解放するシャード (NULL可)
+ */
+void shard_destroy(Shard *shard);
+
+/**
+ * @brief 試合を作成する (シャードのスレッドから)
+ *
+ * 試合の進行は待機室から始まります。参加者を追加したら準備完了を
+ * shard_match_event で伝えてください。
+ *
+ * @param shard 対象のシャード
+ * @param match_id 試合ID
+ * @param mode ゲームモード
+ * @param seed テトリミノ生成の乱数の種
+ * @return 作成した試合 (上限に達した場合や新しい試合を断っている場合はNULL)
+ */
+ShardMatch* shard_match_create(Shard *shard, uint64_t match_id, GameMode mode, uint64_t seed);
+
+/**
+ * @brief 試合に参加者を追加する (シャードのスレッドから)
+ * @param shard 対象のシャード
+ * @param sm 対象の試合
+ * @param player_id プレイヤーID
+ * @param conn 接続 (バックエンドに登録済み)
+ * @param transport 接続のトランスポート
+ * @return プレイヤー番号 (満員または接続が登録済みの場合-1)
+ */
+int shard_match_add_player(Shard *shard, ShardMatch *sm, uint32_t player_id, int conn, NetTransport transport);
+
+/**
+ * @brief 試合の進行にイベントを伝える (シャードのスレッドから)
+ *
+ * 進行が終了した試合は参加者の接続を閉じて解放します (戻り値が
+ * MATCH_PHASE_FINISHED の場合 sm は無効)。移動中の試合へのイベントは無視します。
+ *
+ * @param shard 対象のシャード
+ * @param sm 対象の試合
+ * @param type イベント種別
+ * @param player イベントのプレイヤー番号
+ * @return 進行段階
+ */
+MatchPhase shard_match_event(Shard *shard, ShardMatch *sm, MatchEventType type, int player);
+
+/**
+ * @brief 試合のシミュレーションを進めてよいか判定する
+ * @param sm 対象の試合
+ * @return プレイ中で移動中でない場合1
+ */
+int shard_match_simulating(const ShardMatch *sm);
+
+/**
+ * @brief 入力を試合の入力ログに追加する (未処理の入力数も数える)
+ * @param shard 対象のシャード
+ * @param sm 対象の試合
+ * @param input 追加する入力
+ * @return 成功時1、ログが満杯または不正な入力の場合0
+ */
+int shard_match_log_input(Shard *shard, ShardMatch *sm, const MatchInput *input);
+
+/**
+ * @brief 参加者のレベルの変化を重力レベルに反映する (レベルアップ時に呼び出す)
+ * @param shard 対象のシャード
+ * @param sm 対象の試合
+ */
+void shard_match_update_gravity(Shard *shard, ShardMatch *sm);
+
+/**
+ * @brief このティックに処理が必要な試合を集める (shard_advance の後に呼び出す)
+ *
+ * プレイ中で未処理の入力があるか、落下期限に達した試合を選びます。落下期限は
+ * 生存中の参加者の最も高いレベルの間隔で設定し、各参加者の落下の判定は呼び出し側で行います。
+ *
+ * @param shard 対象のシャード
+ * @param out 試合の出力先
+ * @param max 出力先の要素数
+ * @return 試合数
+ */
+int shard_collect_due(Shard *shard, ShardMatch **out, int max);
+
+/**
+ * @brief 試合のこのティックの処理を始める (未処理の入力数を0にし、落下期限を進める)
+ * @param shard 対象のシャード
+ * @param sm shard_collect_due で選ばれた試合
+ * @return 落下期限に達していた場合1
+ */
+int shard_match_begin_tick(Shard *shard, ShardMatch *sm);
+
+/**
+ * @brief 時刻を進めて期限に達した試合の進行を再開する (各ティックの先頭で呼び出す)
+ * @param shard 対象のシャード
+ * @param now 現在のティック
+ * @return 期限に達した試合数
+ */
+int shard_advance(Shard *shard, uint32_t now);
+
+/**
+ * @brief 試合を解放する (接続は閉じない)
+ * @param shard 対象のシャード
+ * @param sm 解放する試合
+ */
+void shard_match_destroy(Shard *shard, ShardMatch *sm);
+
+/**
+ * @brief 接続の持ち主の試合を引く
+ * @param shard 対象のシャード
+ * @param conn 接続
+ * @param player プレイヤー番号の出力先 (NULL可)
+ * @return 試合 (どの試合にも属さない場合はNULL)
+ */
+ShardMatch* shard_conn_owner(const Shard *shard, int conn, int *player);
+
+/**
+ * @brief 試合の一覧を取得する
+ * @param shard 対象のシャード
+ * @param count 試合数の出力先
+ * @return 試合の配列 (次の作成/解放/移動まで有効)
+ */
+ShardMatch* const* shard_matches(const Shard *shard, int *count);
+
+/**
+ * @brief 受信箱の通知を処理する (各ティックの先頭で呼び出す)
+ * @param shard 対象のシャード
+ * @return 処理した通知数
+ */
+int shard_poll_inbox(Shard *shard);
+
+/**
+ * @brief 接続の切り離し完了を伝える (NET_EVENT_DETACHED を受けたら呼び出す)
+ * @param shard 対象のシャード
+ * @param conn 接続
+ * @param data 未送信データ
+ * @param len 未送信データ長
+ */
+void shard_on_detached(Shard *shard, int conn, const uint8_t *data, size_t len);
+
+/**
+ * @brief 試合の移動を始める (シャードのスレッドから)
+ *
+ * 試合は移動が終わるまでシミュレーションを止めます。移動中に届いた入力は
+ * 通常どおり入力ログに追加してください (移動先へ引き継がれます)。
+ * 切り離せなかった接続は閉じ、移動の後に切断として試合の進行に伝えます。
+ *
+ * @param shard 試合の所有シャード
+ * @param sm 移動する試合
+ * @param target 移動先
+ * @return 開始した場合1、既に移動中または未送信データの受け皿を確保できない場合0
+ */
+int shard_migrate(Shard *shard, ShardMatch *sm, Shard *target);
+
+/**
+ * @brief ティック時間を記録する (各ティックの終わりに呼び出す)
+ *
+ * 平滑化したティック時間から負荷制限の段階も更新します。
+ *
+ * @param shard 対象のシャード
+ * @param tick_us ティックの処理時間 (us)
+ */
+void shard_record_tick(Shard *shard, uint32_t tick_us);
+
+/**
+ * @brief 平滑化したティック時間を取得する (どのスレッドからでもよい)
+ * @param shard 対象のシャード
+ * @return ティック時間 (us)
+ */
+uint32_t shard_load(const Shard *shard);
+
+/**
+ * @brief 負荷制限の段階を取得する (どのスレッドからでもよい)
+ * @param shard 対象のシャード
+ * @return 負荷制限の段階
+ */
+ShardShedLevel shard_shed_level(const Shard *shard);
+
+/**
+ * @brief 新しい試合を受け入れられるか判定する (マッチメーカーの割り当て前に)
+ * @param shard 対象のシャード
+ * @return 受け入れられる場合1
+ */
+int shard_admits(const Shard *shard);
+
+/**
+ * @brief 要約の更新の最短間隔を取得する (interest_set_summary_interval に渡す)
+ * @param shard 対象のシャード
+ * @return 最短間隔 (ティック)
+ */
+uint32_t shard_summary_interval(const Shard *shard);
+
+/**
+ * @brief 負荷制限を反映した AI の計算予算を取得する
+ * @param shard 対象のシャード
+ * @param base 制限なしの計算予算 (探索ノード数など)
+ * @return 計算予算 (超過分に比例して削り、base の 1/SHARD_SHED_AI_MIN_DIV を下限とする)
+ */
+uint32_t shard_ai_budget(const Shard *shard, uint32_t base);
+
+/**
+ * @brief 最も重いシャードから最も軽いシャードへの移動を指示する (監視スレッドから)
+ * @param shards シャード
+ * @param count シャード数
+ * @return 指示した場合1、偏りが小さい、移動先が受け入れを断っている、または前の指示が処理中の場合0
+ */
+int shard_balance(Shard *const shards[], int count);
+
+#endif /* SHARD_H */
@@ -0,0 +1,228 @@
+/**
+ * @file slab.c
+ * @brief 固定サイズオブジェクトのスラブプールの実装
+ *
+ * 主な機能:
+ *   - 上限分の仮想領域の予約 (arena によるヒュージページ/事前フォルトの選択)
+ *   - 世代タグ付き Treiber スタックへの連結リストの一括プッシュと1件ずつのポップ
+ *   - キャッシュの補充 (空きリスト → 未切り出し領域の順) と半分の返却
+ *
+ * 設計思想:
+ *   - 空きオブジェクトの先頭4バイトに次の番号を置き、管理領域を別に持たない
+ *   - スタックの先頭は (タグ << 32) | (番号 + 1)。0 は空を表す
+ *   - ポップ中に他スレッドが同じオブジェクトを再利用しても、タグの不一致で CAS が失敗する
+ */
+
+#include "slab.h"
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define SLAB_EMPTY 0u /**< 空きリストの終端 (番号 + 1 で格納するため) */
+
+/**
+ * @brief スラブプール
+ */
+struct SlabPool {
+    uint8_t* base;               /**< 予約領域の先頭 (arena.base) */
+    Arena arena;                 /**< 予約領域 */
+    size_t object_size;          /**< オブジェクトの大きさ (整列後) */
+    uint32_t capacity;           /**< オブジェクト数の上限 */
+    _Alignas(64) _Atomic uint64_t head; /**< 空きリストの先頭 (タグ付き) */
+    _Alignas(64) _Atomic uint32_t carved; /**< 切り出し済みの数 */
+    _Atomic uint32_t outstanding; /**< 空きリストの外にある数 */
+};
+
+static inline uint8_t* object_at(const SlabPool *pool, uint32_t index) {
+    return pool->base + (size_t)index * pool->object_size;
+}
+
+/* 次の番号はポップ中の他スレッドと競合して読まれうるため、アトミックに読み書きする */
+static inline uint32_t next_of(const SlabPool *pool, uint32_t index) {
+    return __atomic_load_n((uint32_t*)object_at(pool, index), __ATOMIC_RELAXED);
+}
+
+static inline void set_next(SlabPool *pool, uint32_t index, uint32_t next) {
+    __atomic_store_n((uint32_t*)object_at(pool, index), next, __ATOMIC_RELAXED);
+}
+
+/**
+ * @brief プールを作成する
+ */
+SlabPool* slab_pool_create(size_t object_size, uint32_t max_objects, int arena_flags, int node) {
+    if (object_size == 0 || max_objects == 0 || max_objects == UINT32_MAX) {
+        return NULL;
+    }
+    size_t align = object_size >= 64 ? 64 : 16;
+    object_size = (object_size + align - 1) & ~(align - 1);
+
+    SlabPool *pool = (SlabPool*)aligned_alloc(64, (sizeof(SlabPool) + 63) & ~(size_t)63);
+    if (!pool) {
+        return NULL;
+    }
+    memset(pool, 0, sizeof(*pool));
+    pool->object_size = object_size;
+    pool->capacity = max_objects;
+    if (!arena_map(&pool->arena, object_size * max_objects, arena_flags, node)) {
+        free(pool);
+        return NULL;
+    }
+    pool->base = (uint8_t*)pool->arena.base;
+    atomic_init(&pool->head, SLAB_EMPTY);
+    atomic_init(&pool->carved, 0);
+    atomic_init(&pool->outstanding, 0);
+    return pool;
+}
+
+/**
+ * @brief プールを解放する
+ */
+void slab_pool_destroy(SlabPool *pool) {
+    if (!pool) {
+        return;
+    }
+    arena_unmap(&pool->arena);
+    free(pool);
+}
+
+/**
+ * @brief プールの使用状況を取得する
+ */
+void slab_pool_stats(const SlabPool *pool, SlabStats *out) {
+    SlabPool *p = (SlabPool*)pool;
+    out->object_size = pool->object_size;
+    out->capacity = pool->capacity;
+    out->carved = atomic_load_explicit(&p->carved, memory_order_relaxed);
+    out->outstanding = atomic_load_explicit(&p->outstanding, memory_order_relaxed);
+    out->page_kind = pool->arena.kind;
+    out->prefaulted = pool->arena.prefaulted;
+    out->node = pool->arena.node;
+}
+
+/**
+ * @brief 連結済みのオブジェクト列を空きリストへまとめてプッシュする
+ */
+static void push_chain(SlabPool *pool, uint32_t first, uint32_t last, uint32_t count) {
+    uint64_t old = atomic_load_explicit(&pool->head, memory_order_relaxed);
+    uint64_t desired;
+    do {
+        set_next(pool, last, (uint32_t)old);
+        desired = ((old >> 32) + 1) << 32 | (uint64_t)(first + 1);
+    } while (!atomic_compare_exchange_weak_explicit(&pool->head, &old, desired,
+                                                    memory_order_release, memory_order_relaxed));
+    atomic_fetch_sub_explicit(&pool->outstanding, count, memory_order_relaxed);
+}
+
+/**
+ * @brief 空きリストから1件ポップする
+ * @return オブジェクト番号 + 1 (空の場合0)
+ */
+static uint32_t pop_one(SlabPool *pool) {
+    uint64_t old = atomic_load_explicit(&pool->head, memory_order_acquire);
+    for (;;) {
+        uint32_t top = (uint32_t)old;
+        if (top == SLAB_EMPTY) {
+            return SLAB_EMPTY;
+        }
+        // 他スレッドが既に取り出して書き換えていても、タグの不一致で CAS が失敗する
+        uint32_t next = next_of(pool, top - 1);
+        uint64_t desired = ((old >> 32) + 1) << 32 | next;
+        if (atomic_compare_exchange_weak_explicit(&pool->head, &old, desired,
+                                                  memory_order_acquire, memory_order_acquire)) {
+            return top;
+        }
+    }
+}
+
+/**
+ * @brief キャッシュを補充する (空きリスト、次に未切り出し領域から)
+ */
+static void refill(SlabCache *cache) {
+    SlabPool *pool = cache->pool;
+    uint32_t got = 0;
+    while (got < SLAB_CACHE_BATCH) {
+        uint32_t top = pop_one(pool);
+        if (top == SLAB_EMPTY) {
+            break;
+        }
+        cache->items[cache->count++] = top - 1;
+        got++;
+    }
+    if (got < SLAB_CACHE_BATCH) {
+        // 切り出し済みの数は容量で頭打ちにする (枯渇後の失敗で増え続けて一周しないように)
+        uint32_t start = atomic_load_explicit(&pool->carved, memory_order_relaxed);
+        uint32_t take;
+        do {
+            uint32_t left = pool->capacity - start;
+            take = SLAB_CACHE_BATCH - got;
+            if (take > left) {
+                take = left;
+            }
+        } while (take > 0 &&
+                 !atomic_compare_exchange_weak_explicit(&pool->carved, &start, start + take,
+                                                        memory_order_relaxed, memory_order_relaxed));
+        for (uint32_t i = 0; i < take; i++) {
+            cache->items[cache->count++] = start + i;
+        }
+        got += take;
+    }
+    atomic_fetch_add_explicit(&pool->outstanding, got, memory_order_relaxed);
+}
+
+/**
+ * @brief キャッシュの末尾 count 件を連結して空きリストへ返す
+ */
+static void release(SlabCache *cache, uint32_t count) {
+    SlabPool *pool = cache->pool;
+    uint32_t end = cache->count;
+    uint32_t begin = end - count;
+    for (uint32_t i = begin; i + 1 < end; i++) {
+        set_next(pool, cache->items[i], cache->items[i + 1] + 1);
+    }
+    push_chain(pool, cache->items[begin], cache->items[end - 1], count);
+    cache->count = begin;
+}
+
+/**
+ * @brief スレッドごとのキャッシュを初期化する
+ */
+void slab_cache_init(SlabCache *cache, SlabPool *pool) {
+    cache->pool = pool;
+    cache->count = 0;
+}
+
+/**
+ * @brief キャッシュ中のオブジェクトをすべてプールへ返す
+ */
+void slab_cache_flush(SlabCache *cache) {
+    if (cache->count > 0) {
+        release(cache, cache->count);
+    }
+}
+
+/**
+ * @brief オブジェクトを確保する
+ */
+void* slab_alloc(SlabCache *cache) {
+    if (cache->count == 0) {
+        refill(cache);
+        if (cache->count == 0) {
+            return NULL;
+        }
+    }
+    return object_at(cache->pool, cache->items[--cache->count]);
+}
+
+/**
+ * @brief オブジェクトを解放する
+ */
+void slab_free(SlabCache *cache, void *object) {
+    if (!object) {
+        return;
+    }
+    SlabPool *pool = cache->pool;
+    if (cache->count == SLAB_CACHE_SIZE) {
+        release(cache, SLAB_CACHE_SIZE - SLAB_CACHE_BATCH);
+    }
+    cache->items[cache->count++] = (uint32_t)(((uint8_t*)object - pool->base) / pool->object_size);
+}
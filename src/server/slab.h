@@ -0,0 +1,110 @@
+/**
+ * @file slab.h
+ * @brief 固定サイズオブジェクトのスラブプールの宣言
+ *
+ * このファイルは受信/送信バッファ、接続オブジェクト、試合コンテキストなど
+ * 同じ大きさのオブジェクトを大量に確保・解放するためのプールを宣言します。
+ * 主な機能:
+ *   - 固定サイズオブジェクトのプール (作成時に上限分の仮想領域を予約)
+ *   - ヒュージページ、起動時の事前フォルト、NUMA ノードの選択 (arena)
+ *   - スレッドごとのキャッシュからのロックなしの確保と解放
+ *   - キャッシュとプール間のまとめての受け渡し
+ *   - 使用状況の取得
+ *
+ * 設計思想:
+ *   - オブジェクトは予約領域の番号で管理し、ポインタと番号の変換は除算1回
+ *   - プールの空きリストは世代タグ付きの番号による Treiber スタックで、ABA 問題を防ぐ
+ *   - 未使用の領域は切り出し位置の fetch_add のみで拡張し、拡張にもロックを使わない
+ *   - 同じ大きさのオブジェクトのみを並べるため、長時間稼働でも断片化しない
+ *   - キャッシュは所有スレッドのみが操作する (スレッドごとに slab_cache_init する)
+ */
+
+#ifndef SLAB_H
+#define SLAB_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "arena.h"
+
+#define SLAB_CACHE_SIZE  64 /**< スレッドごとのキャッシュの容量 */
+#define SLAB_CACHE_BATCH 32 /**< キャッシュとプール間で一度に受け渡す数 */
+
+typedef struct SlabPool SlabPool;
+
+/**
+ * @brief スレッドごとのキャッシュ
+ */
+typedef struct {
+    SlabPool* pool;              /**< 対象のプール */
+    uint32_t count;              /**< キャッシュ中の数 */
+    uint32_t items[SLAB_CACHE_SIZE]; /**< キャッシュ中のオブジェクト番号 */
+} SlabCache;
+
+/**
+ * @brief プールの使用状況
+ */
+typedef struct {
+    size_t object_size;          /**< オブジェクトの大きさ (整列後) */
+    uint32_t capacity;           /**< オブジェクト数の上限 */
+    uint32_t carved;             /**< 切り出し済みのオブジェクト数 */
+    uint32_t outstanding;        /**< プールの空きリストの外にある数 (使用中 + キャッシュ中) */
+    ArenaPageKind page_kind;     /**< 領域に使われたページ種別 */
+    int prefaulted;              /**< 領域が事前フォルト済み */
+    int node;                    /**< 領域を配置した NUMA ノード (ARENA_NODE_ANY: 指定なし) */
+} SlabStats;
+
+/**
+ * @brief プールを作成する
+ * @param object_size オブジェクトの大きさ (16バイト、64バイト以上は64バイト単位に切り上げ)
+ * @param max_objects オブジェクト数の上限
+ * @param arena_flags 領域の確保方法 (ARENA_* の組み合わせ、0で通常ページを必要時に割り当て)
+ * @param node 領域を優先配置する NUMA ノード (ARENA_NODE_ANY で指定なし)
+ * @return 作成したプール (失敗時はNULL)
+ *
+ * ARENA_PREFAULT を指定すると上限分の物理メモリを作成時に確保します。
+ * 試合中のページフォルトを避けたいプールにのみ指定してください。
+ * シャードのプールにはシャードのスレッドを固定したノードを指定します (affinity_shard_node)。
+ */
+SlabPool* slab_pool_create(size_t object_size, uint32_t max_objects, int arena_flags, int node);
+
+/**
+ * @brief プールを解放する (すべてのキャッシュを破棄した後に呼び出す)
+ * @param pool 解放するプール (NULL可)
+ */
+void slab_pool_destroy(SlabPool *pool);
+
+/**
+ * @brief プールの使用状況を取得する
+ * @param pool 対象のプール
+ * @param out 出力先
+ */
+void slab_pool_stats(const SlabPool *pool, SlabStats *out);
+
+/**
+ * @brief スレッドごとのキャッシュを初期化する
+ * @param cache 初期化するキャッシュ
+ * @param pool 対象のプール
+ */
+void slab_cache_init(SlabCache *cache, SlabPool *pool);
+
+/**
+ * @brief キャッシュ中のオブジェクトをすべてプールへ返す (スレッド終了時など)
+ * @param cache 対象のキャッシュ
+ */
+void slab_cache_flush(SlabCache *cache);
+
+/**
+ * @brief オブジェクトを確保する (内容は不定)
+ * @param cache 呼び出しスレッドのキャッシュ
+ * @return 確保したオブジェクト (上限に達した場合はNULL)
+ */
+void* slab_alloc(SlabCache *cache);
+
+/**
+ * @brief オブジェクトを解放する (どのスレッドで確保したものでもよい)
+ * @param cache 呼び出しスレッドのキャッシュ
+ * @param object 解放するオブジェクト (NULL可)
+ */
+void slab_free(SlabCache *cache, void *object);
+
+#endif /* SLAB_H */
@@ -0,0 +1,127 @@
+/**
+ * @file timer_wheel.c
+ * @brief ティック単位のタイマーホイールの実装
+ *
+ * 主な機能:
+ *   - 番兵付き双方向循環リストによるスロット
+ *   - 進めたティック数分 (最大1周) のスロットの走査
+ *
+ * 設計思想:
+ *   - 走査中のスロットは一旦切り離してから処理し、コールバック中の再登録が走査に混ざらない
+ */
+
+#include "timer_wheel.h"
+#include <stddef.h>
+
+#define TIMER_WHEEL_MASK (TIMER_WHEEL_SLOTS - 1)
+
+static void slot_insert(TimerNode *head, TimerNode *node) {
+    node->prev = head->prev;
+    node->next = head;
+    head->prev->next = node;
+    head->prev = node;
+}
+
+static void node_unlink(TimerNode *node) {
+    node->prev->next = node->next;
+    node->next->prev = node->prev;
+    node->next = NULL;
+    node->prev = NULL;
+}
+
+/**
+ * @brief タイマーホイールを初期化する
+ */
+void timer_wheel_init(TimerWheel *wheel, uint32_t now) {
+    for (int i = 0; i < TIMER_WHEEL_SLOTS; i++) {
+        wheel->slots[i].next = &wheel->slots[i];
+        wheel->slots[i].prev = &wheel->slots[i];
+    }
+    wheel->now = now;
+    wheel->count = 0;
+}
+
+/**
+ * @brief タイマーの要素を未登録の状態に初期化する
+ */
+void timer_node_init(TimerNode *node) {
+    node->next = NULL;
+    node->prev = NULL;
+    node->deadline = 0;
+}
+
+/**
+ * @brief タイマーを登録する
+ */
+void timer_wheel_schedule(TimerWheel *wheel, TimerNode *node, uint32_t deadline) {
+    if (node->next) {
+        node_unlink(node);
+        wheel->count--;
+    }
+    node->deadline = deadline;
+    // 過去の期限は次に走査するスロットへ
+    uint32_t slot = (int32_t)(deadline - wheel->now) > 0 ? deadline : wheel->now + 1;
+    slot_insert(&wheel->slots[slot & TIMER_WHEEL_MASK], node);
+    wheel->count++;
+}
+
+/**
+ * @brief タイマーを取り消す
+ */
+void timer_wheel_cancel(TimerWheel *wheel, TimerNode *node) {
+    if (node->next) {
+        node_unlink(node);
+        wheel->count--;
+    }
+}
+
+/**
+ * @brief タイマーが登録中か判定する
+ */
+int timer_node_pending(const TimerNode *node) {
+    return node->next != NULL;
+}
+
+/**
+ * @brief 時刻を進めて期限に達したタイマーのコールバックを呼び出す
+ */
+int timer_wheel_advance(TimerWheel *wheel, uint32_t now, TimerCallback callback, void *user) {
+    uint32_t steps = now - wheel->now;
+    if ((int32_t)steps <= 0) {
+        return 0;
+    }
+    if (steps > TIMER_WHEEL_SLOTS) {
+        steps = TIMER_WHEEL_SLOTS; // 1周以上進んだ場合も各スロットは1回の走査で足りる
+    }
+    uint32_t first = wheel->now + 1;
+    wheel->now = now;
+
+    int fired = 0;
+    for (uint32_t k = 0; k < steps && wheel->count > 0; k++) {
+        TimerNode *head = &wheel->slots[(first + k) & TIMER_WHEEL_MASK];
+        if (head->next == head) {
+            continue;
+        }
+        // スロットを切り離した一時リストに移す
+        TimerNode local;
+        local.next = head->next;
+        local.prev = head->prev;
+        local.next->prev = &local;
+        local.prev->next = &local;
+        head->next = head;
+        head->prev = head;
+
+        while (local.next != &local) {
+            TimerNode *node = local.next;
+            node_unlink(node);
+            if ((int32_t)(node->deadline - now) > 0) {
+                slot_insert(&wheel->slots[node->deadline & TIMER_WHEEL_MASK], node); // 次の周以降
+                continue;
+            }
+            wheel->count--;
+            fired++;
+            callback(node, user);
+        }
+    }
+    return fired;
+}
@@ -0,0 +1,94 @@
+/**
+ * @file timer_wheel.h
+ * @brief ティック単位のタイマーホイールの宣言
+ *
+ * このファイルはシャードのイベントループで多数の試合の期限 (カウントダウン、
+ * 再接続の待機、結果表示など) を扱うためのタイマーホイールを宣言します。
+ * 主な機能:
+ *   - 期限ティックでのタイマーの登録、再登録、取り消し (いずれも O(1))
+ *   - 時刻を進めて期限に達したタイマーのコールバックを呼び出す
+ *
+ * 設計思想:
+ *   - タイマーの要素は呼び出し側の構造体に埋め込み、登録時の動的確保をしない
+ *   - スロットは期限ティックの下位ビットで選び、1周より先の期限はスロットに残して次の周で判定する
+ *   - コールバック中の再登録や他のタイマーの取り消しを許す
+ */
+
+#ifndef TIMER_WHEEL_H
+#define TIMER_WHEEL_H
+
+#include <stdint.h>
+
+#define TIMER_WHEEL_SLOTS 256 /**< スロット数 (2の累乗、60Hz で約4秒分) */
+
+/**
+ * @brief タイマーの要素 (呼び出し側の構造体に埋め込む)
+ */
+typedef struct TimerNode {
+    struct TimerNode* next;      /**< スロット内の次の要素 (NULL: 未登録) */
+    struct TimerNode* prev;      /**< スロット内の前の要素 */
+    uint32_t deadline;           /**< 期限 (ティック) */
+} TimerNode;
+
+/**
+ * @brief タイマーホイール
+ */
+typedef struct {
+    TimerNode slots[TIMER_WHEEL_SLOTS]; /**< スロットごとの循環リストの番兵 */
+    uint32_t now;                /**< 現在のティック */
+    int count;                   /**< 登録中のタイマー数 */
+} TimerWheel;
+
+/**
+ * @brief 期限に達したタイマーのコールバック
+ * @param node 期限に達したタイマー (登録は解除済み)
+ * @param user 呼び出し側のデータ
+ */
+typedef void (*TimerCallback)(TimerNode *node, void *user);
+
+/**
+ * @brief タイマーホイールを初期化する
+ * @param wheel 対象のタイマーホイール
+ * @param now 現在のティック
+ */
+void timer_wheel_init(TimerWheel *wheel, uint32_t now);
+
+/**
+ * @brief タイマーの要素を未登録の状態に初期化する
+ * @param node 対象のタイマー
+ */
+void timer_node_init(TimerNode *node);
+
+/**
+ * @brief タイマーを登録する (登録中の場合は期限を変更する)
+ * @param wheel 対象のタイマーホイール
+ * @param node 登録するタイマー
+ * @param deadline 期限 (ティック、過去の場合は次の進行で期限に達する)
+ */
+void timer_wheel_schedule(TimerWheel *wheel, TimerNode *node, uint32_t deadline);
+
+/**
+ * @brief タイマーを取り消す (未登録の場合は何もしない)
+ * @param wheel 対象のタイマーホイール
+ * @param node 取り消すタイマー
+ */
+void timer_wheel_cancel(TimerWheel *wheel, TimerNode *node);
+
+/**
+ * @brief タイマーが登録中か判定する
+ * @param node 対象のタイマー
+ * @return 登録中の場合1
+ */
+int timer_node_pending(const TimerNode *node);
+
+/**
+ * @brief 時刻を進めて期限に達したタイマーのコールバックを呼び出す
+ * @param wheel 対象のタイマーホイール
+ * @param now 新しい現在のティック
+ * @param callback コールバック
+ * @param user コールバックに渡すデータ
+ * @return 期限に達したタイマー数
+ */
+int timer_wheel_advance(TimerWheel *wheel, uint32_t now, TimerCallback callback, void *user);
+
+#endif /* TIMER_WHEEL_H */
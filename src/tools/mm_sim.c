@@ -0,0 +1,231 @@
+/**
+ * @file mm_sim.c
+ * @brief マッチメーカーのローカル代替クライアント (到着シミュレーター)
+ *
+ * 主な機能:
+ *   - ポアソン到着によるプレイヤーの待ち行列登録
+ *   - 一定割合の取り消し (待ちきれずに離脱するプレイヤー)
+ *   - 試合時間の経過によるシャード負荷の解放
+ *   - 待ち時間の分布と1操作あたりの処理時間の計測
+ *
+ * 設計思想:
+ *   - 仮想時刻で進めるため、ピーク時の到着率を実時間に依存せず再現できる
+ *   - 待ち時間はヒストグラムで集計し、プレイヤーごとの記録は持たない
+ *
+ * 使い方:
+ *   mm_sim [-r 到着数/秒] [-t 秒数] [-s シャード数] [-c 取り消し率%] [-S シード]
+ */
+
+#define _GNU_SOURCE // getopt
+
+#include "../server/matchmaker.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#define SIM_TICK_MS        10      /**< 仮想時刻の刻み (ms) */
+#define SIM_MAX_PLAYERS    200000  /**< 同時待機数の上限 */
+#define SIM_MAX_SHARDS     64      /**< シャード数の上限 */
+#define SIM_HIST_BUCKETS   121     /**< 待ち時間ヒストグラムの区間数 (0.5秒刻み + 超過) */
+#define SIM_HIST_STEP_MS   500     /**< ヒストグラムの区間幅 (ms) */
+#define SIM_MATCH_MS       120000  /**< 平均試合時間 (ms) */
+#define SIM_POLL_CHECKS    256     /**< 1刻みあたりに調べる待機者数 */
+#define SIM_MAX_ACTIVE     65536   /**< 追跡する進行中の試合数の上限 */
+
+/**
+ * @brief 進行中の試合 (シャード負荷の解放用)
+ */
+typedef struct {
+    uint32_t end_ms;             /**< 終了時刻 */
+    int shard_id;                /**< 割り当てられたシャード */
+} SimMatch;
+
+/**
+ * @brief シミュレーション状態
+ */
+typedef struct {
+    Matchmaker* mm;              /**< 対象のマッチメーカー */
+    uint32_t now_ms;             /**< 仮想時刻 */
+    uint64_t rng;                /**< 乱数状態 */
+    long matches;                /**< 成立した試合数 */
+    long histogram[SIM_HIST_BUCKETS]; /**< 待ち時間の分布 */
+    long rating_gap_total;       /**< 組み合わせのレーティング差の合計 */
+    int shard_load[SIM_MAX_SHARDS]; /**< シャードごとの進行中試合数 */
+    SimMatch* active;            /**< 進行中の試合 */
+    int active_count;            /**< 進行中の試合数 */
+} SimState;
+
+static double sim_uniform(SimState *sim) {
+    uint64_t x = sim->rng;
+    x ^= x >> 12;
+    x ^= x << 25;
+    x ^= x >> 27;
+    sim->rng = x;
+    return ((x * 2685821657736338717ull) >> 11) * (1.0 / 9007199254740992.0);
+}
+
+static double sim_normal(SimState *sim) {
+    double u1 = sim_uniform(sim);
+    double u2 = sim_uniform(sim);
+    if (u1 < 1e-12) {
+        u1 = 1e-12;
+    }
+    return sqrt(-2.0 * log(u1)) * cos(6.283185307179586 * u2);
+}
+
+/**
+ * @brief 組み合わせ成立時の集計
+ */
+static void on_match(const MatchmakerTicket *a, const MatchmakerTicket *b, int shard_id, void *user) {
+    SimState *sim = (SimState*)user;
+    sim->matches++;
+    sim->rating_gap_total += abs(a->rating - b->rating);
+
+    const MatchmakerTicket *t[2] = {a, b};
+    for (int i = 0; i < 2; i++) {
+        uint32_t waited = sim->now_ms - t[i]->enqueue_ms;
+        int bucket = (int)(waited / SIM_HIST_STEP_MS);
+        sim->histogram[bucket < SIM_HIST_BUCKETS ? bucket : SIM_HIST_BUCKETS - 1]++;
+    }
+
+    if (shard_id >= 0 && sim->active_count < SIM_MAX_ACTIVE) {
+        SimMatch *m = &sim->active[sim->active_count++];
+        m->shard_id = shard_id;
+        m->end_ms = sim->now_ms + (uint32_t)(SIM_MATCH_MS * (0.25 + 1.5 * sim_uniform(sim)));
+        sim->shard_load[shard_id]++;
+    }
+}
+
+/**
+ * @brief 終了した試合のシャード負荷を解放する
+ */
+static void release_finished(SimState *sim) {
+    for (int i = 0; i < sim->active_count;) {
+        SimMatch *m = &sim->active[i];
+        if ((int32_t)(sim->now_ms - m->end_ms) < 0) {
+            i++;
+            continue;
+        }
+        int shard = m->shard_id;
+        matchmaker_set_shard_load(sim->mm, shard, --sim->shard_load[shard]);
+        *m = sim->active[--sim->active_count];
+    }
+}
+
+/**
+ * @brief ヒストグラムから百分位の待ち時間を求める
+ */
+static double percentile_sec(const SimState *sim, long total, double p) {
+    long want = (long)(total * p);
+    long seen = 0;
+    for (int i = 0; i < SIM_HIST_BUCKETS; i++) {
+        seen += sim->histogram[i];
+        if (seen > want) {
+            return (i + 1) * SIM_HIST_STEP_MS / 1000.0;
+        }
+    }
+    return SIM_HIST_BUCKETS * SIM_HIST_STEP_MS / 1000.0;
+}
+
+int main(int argc, char **argv) {
+    double rate = 500.0;
+    int seconds = 600;
+    int shards = 8;
+    int cancel_pct = 5;
+    uint64_t seed = (uint64_t)time(NULL);
+
+    int opt;
+    while ((opt = getopt(argc, argv, "r:t:s:c:S:")) != -1) {
+        switch (opt) {
+            case 'r': rate = atof(optarg); break;
+            case 't': seconds = atoi(optarg); break;
+            case 's': shards = atoi(optarg); break;
+            case 'c': cancel_pct = atoi(optarg); break;
+            case 'S': seed = strtoull(optarg, NULL, 0); break;
+            default:
+                fprintf(stderr, "usage: %s [-r rate] [-t seconds] [-s shards] [-c cancel%%] [-S seed]\n", argv[0]);
+                return 1;
+        }
+    }
+    if (rate <= 0 || seconds <= 0 || shards < 1 || shards > SIM_MAX_SHARDS) {
+        fprintf(stderr, "invalid arguments\n");
+        return 1;
+    }
+
+    SimState sim;
+    memset(&sim, 0, sizeof(sim));
+    sim.rng = seed ? seed : 1;
+    sim.active = (SimMatch*)malloc(sizeof(SimMatch) * SIM_MAX_ACTIVE);
+    sim.mm = matchmaker_create(SIM_MAX_PLAYERS, shards, on_match, &sim);
+    if (!sim.active || !sim.mm) {
+        fprintf(stderr, "initialization failed\n");
+        return 1;
+    }
+    for (int i = 0; i < shards; i++) {
+        matchmaker_add_shard(sim.mm, i, 0);
+    }
+
+    // 取り消し用に直近のハンドルを保持する
+    enum { RECENT = 4096 };
+    static int recent[RECENT];
+    int recent_pos = 0;
+
+    long enqueued = 0, cancelled = 0, operations = 0;
+    uint64_t next_id = 1;
+    double next_arrival = 0.0;
+    double mm_sec = 0.0; // マッチメーカー呼び出しに費やした実時間
+
+    for (sim.now_ms = 0; sim.now_ms < (uint32_t)seconds * 1000u; sim.now_ms += SIM_TICK_MS) {
+        struct timespec t0, t1;
+        clock_gettime(CLOCK_MONOTONIC, &t0);
+        while (next_arrival < sim.now_ms) {
+            MatchmakerTicket t;
+            t.player_id = next_id++;
+            t.rating = (int)(1500.0 + 350.0 * sim_normal(&sim));
+            t.ping_ms = (int)(20.0 + 120.0 * sim_uniform(&sim) * sim_uniform(&sim));
+            t.enqueue_ms = sim.now_ms;
+            int handle = matchmaker_enqueue(sim.mm, &t);
+            operations++;
+            if (handle > 0) {
+                enqueued++;
+                recent[recent_pos++ % RECENT] = handle;
+            }
+            next_arrival += -log(1.0 - sim_uniform(&sim)) * 1000.0 / rate;
+        }
+
+        if ((int)(sim_uniform(&sim) * 100.0) < cancel_pct && recent_pos > 0) {
+            int handle = recent[(int)(sim_uniform(&sim) * (recent_pos < RECENT ? recent_pos : RECENT))];
+            cancelled += matchmaker_cancel(sim.mm, handle);
+            operations++;
+        }
+
+        matchmaker_poll(sim.mm, sim.now_ms, SIM_POLL_CHECKS);
+        operations++;
+        clock_gettime(CLOCK_MONOTONIC, &t1);
+        mm_sec += (t1.tv_sec - t0.tv_sec) + (t1.tv_nsec - t0.tv_nsec) / 1e9;
+
+        release_finished(&sim);
+    }
+
+    long paired = sim.matches * 2;
+
+    printf("arrivals/s      : %.1f over %d s (%d shards)\n", rate, seconds, shards);
+    printf("matches         : %ld (queued at end %d, cancelled %ld)\n",
+           sim.matches, matchmaker_queue_length(sim.mm), cancelled);
+    printf("wait p50/p90/p99: %.1f / %.1f / %.1f s\n",
+           percentile_sec(&sim, paired, 0.50), percentile_sec(&sim, paired, 0.90),
+           percentile_sec(&sim, paired, 0.99));
+    printf("avg rating gap  : %.1f\n", sim.matches ? (double)sim.rating_gap_total / sim.matches : 0.0);
+    printf("matchmaker time : %.3f s (%.0f ns/op, %ld ops, %ld enqueued)\n",
+           mm_sec, operations ? mm_sec * 1e9 / operations : 0.0, operations, enqueued);
+    for (int i = 0; i < shards; i++) {
+        printf("shard %2d load   : %d\n", i, sim.shard_load[i]);
+    }
+
+    matchmaker_destroy(sim.mm);
+    free(sim.active);
+    return 0;
+}
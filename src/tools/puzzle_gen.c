@@ -0,0 +1,350 @@
+/**
+ * @file puzzle_gen.c
+ * @brief 練習用パズル (指定テトリミノでの全消し) の一括生成ツール
+ *
+ * 主な機能:
+ *   - ランダムな盤面合成による候補パズルの生成
+ *   - ソルバーによる可解性と唯一解の検証
+ *   - 全コアを使った並列検証
+ *   - パズルパックファイルの出力
+ *
+ * 設計思想:
+ *   - 候補は「埋まった領域からテトリミノ形状を抜き取る」方式で合成し、
+ *     セル数の条件を最初から満たすようにする
+ *   - ワーカーは独立した乱数状態を持ち、結果はアトミックに予約した枠へ書き込む
+ *   - ロックはスレッド起動と終了時の join のみ
+ *
+ * 使い方:
+ *   puzzle_gen -o pack.tpz [-n 個数] [-j スレッド数] [-p 最大テトリミノ数] [-s シード]
+ *
+ * パックファイル形式 (リトルエンディアン):
+ *   ヘッダ: "TPZP" | uint32 バージョン | uint32 パズル数
+ *   レコード (PUZZLE_RECORD_SIZE バイト):
+ *     uint8 高さ | uint8 テトリミノ数 | uint8 テトリミノ列[SOLVER_MAX_PIECES]
+ *     | uint16 行データ[PUZZLE_MAX_HEIGHT] (下段から) | 解の配置[SOLVER_MAX_PIECES] x 4バイト
+ */
+
+#define _GNU_SOURCE // getopt
+
+#include "../ai/bitboard.h"
+#include "../ai/solver.h"
+#include "../game/piece.h"
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#define PUZZLE_PACK_VERSION   1  /**< パックファイルのバージョン */
+#define PUZZLE_MAX_HEIGHT     4  /**< パズル領域の最大高さ */
+#define PUZZLE_MAX_THREADS    256 /**< ワーカースレッド数の上限 */
+#define PUZZLE_CARVE_ATTEMPTS 64 /**< テトリミノ1つを抜き取る試行回数 */
+#define PUZZLE_RECORD_SIZE    (2 + SOLVER_MAX_PIECES + PUZZLE_MAX_HEIGHT * 2 + SOLVER_MAX_PIECES * 4)
+
+/**
+ * @brief 検証済みパズル
+ */
+typedef struct {
+    BitBoard board;              /**< 初期盤面 */
+    int height;                  /**< パズル領域の高さ */
+    int piece_count;             /**< テトリミノ数 */
+    TetrominoType pieces[SOLVER_MAX_PIECES];  /**< テトリミノ列 */
+    BitPlacement solution[SOLVER_MAX_PIECES]; /**< 唯一解 */
+} Puzzle;
+
+/**
+ * @brief ワーカー間で共有する生成ジョブ
+ */
+typedef struct {
+    Puzzle* puzzles;             /**< 結果の格納先 */
+    int target;                  /**< 生成するパズル数 */
+    int max_pieces;              /**< テトリミノ数の上限 */
+    uint64_t seed;               /**< 乱数シード */
+    atomic_int produced;         /**< 予約済みの格納枠数 */
+    atomic_long candidates;      /**< 検証した候補数 */
+} PuzzleJob;
+
+/**
+ * @brief ワーカースレッドの引数
+ */
+typedef struct {
+    PuzzleJob* job;              /**< 共有ジョブ */
+    int index;                   /**< ワーカー番号 */
+} PuzzleWorker;
+
+/**
+ * @brief xorshift64* 乱数
+ */
+static uint32_t rng_next(uint64_t *state) {
+    uint64_t x = *state;
+    x ^= x >> 12;
+    x ^= x << 25;
+    x ^= x >> 27;
+    *state = x;
+    return (uint32_t)((x * 2685821657736338717ull) >> 32);
+}
+
+/**
+ * @brief 0以上 n 未満の乱数を返す
+ */
+static int rng_range(uint64_t *state, int n) {
+    return (int)(rng_next(state) % (uint32_t)n);
+}
+
+/**
+ * @brief 埋まった領域からテトリミノ形状を1つ抜き取る
+ */
+static int carve_piece(BitBoard *board, int height, TetrominoType type, uint64_t *rng) {
+    for (int attempt = 0; attempt < PUZZLE_CARVE_ATTEMPTS; attempt++) {
+        int rot = rng_range(rng, 4);
+        int x = rng_range(rng, BOARD_WIDTH + 3) - 3;
+        int y = BOARD_HEIGHT - height - 3 + rng_range(rng, height + 3);
+
+        // 抜き取る4セルが全て埋まっていれば形状どおりに空ける
+        uint16_t masks[TETROMINO_SIZE];
+        int ok = 1;
+        int cells = 0;
+        for (int r = 0; r < TETROMINO_SIZE && ok; r++) {
+            masks[r] = 0;
+            for (int c = 0; c < TETROMINO_SIZE; c++) {
+                if (!TETROMINO_SHAPES[type][rot][r][c]) {
+                    continue;
+                }
+                int bx = x + c;
+                int by = y + r;
+                if (bx < 0 || bx >= BOARD_WIDTH || by < BOARD_HEIGHT - height || by >= BOARD_HEIGHT ||
+                    !(board->rows[by] & (1u << bx))) {
+                    ok = 0;
+                    break;
+                }
+                masks[r] |= (uint16_t)(1u << bx);
+                cells++;
+            }
+        }
+        if (!ok || cells != 4) {
+            continue;
+        }
+        for (int r = 0; r < TETROMINO_SIZE; r++) {
+            if (masks[r]) {
+                board->rows[y + r] &= (uint16_t)~masks[r];
+            }
+        }
+        return 1;
+    }
+    return 0;
+}
+
+/**
+ * @brief 候補パズルを1つ合成する
+ */
+static int synthesize(Puzzle *puzzle, int max_pieces, uint64_t *rng) {
+    int height = 2 + rng_range(rng, PUZZLE_MAX_HEIGHT - 1);
+    int limit = (height * BOARD_WIDTH - 1) / 4;
+    if (limit > max_pieces) {
+        limit = max_pieces;
+    }
+    if (limit < 2) {
+        return 0;
+    }
+    int count = 2 + rng_range(rng, limit - 1);
+
+    memset(&puzzle->board, 0, sizeof(puzzle->board));
+    for (int y = BOARD_HEIGHT - height; y < BOARD_HEIGHT; y++) {
+        puzzle->board.rows[y] = BITBOARD_FULL_ROW;
+    }
+    for (int i = 0; i < count; i++) {
+        TetrominoType type = (TetrominoType)rng_range(rng, TETROMINO_COUNT);
+        if (!carve_piece(&puzzle->board, height, type, rng)) {
+            return 0;
+        }
+        puzzle->pieces[i] = type;
+    }
+
+    // 揃ったままの行が残る盤面は問題として成立しない
+    for (int y = BOARD_HEIGHT - height; y < BOARD_HEIGHT; y++) {
+        if (puzzle->board.rows[y] == BITBOARD_FULL_ROW) {
+            return 0;
+        }
+    }
+
+    // 抜き取り順が答えにならないようテトリミノ列を並べ替える
+    for (int i = count - 1; i > 0; i--) {
+        int j = rng_range(rng, i + 1);
+        TetrominoType t = puzzle->pieces[i];
+        puzzle->pieces[i] = puzzle->pieces[j];
+        puzzle->pieces[j] = t;
+    }
+    puzzle->height = height;
+    puzzle->piece_count = count;
+    return 1;
+}
+
+/**
+ * @brief ワーカースレッド: 目標数に達するまで合成と検証を繰り返す
+ */
+static void* puzzle_worker(void *arg) {
+    PuzzleWorker *worker = (PuzzleWorker*)arg;
+    PuzzleJob *job = worker->job;
+    uint64_t rng = job->seed ^ (0x9E3779B97F4A7C15ull * (uint64_t)(worker->index + 1));
+    if (rng == 0) {
+        rng = 1;
+    }
+
+    while (atomic_load_explicit(&job->produced, memory_order_relaxed) < job->target) {
+        Puzzle candidate;
+        if (!synthesize(&candidate, job->max_pieces, &rng)) {
+            continue;
+        }
+        atomic_fetch_add_explicit(&job->candidates, 1, memory_order_relaxed);
+
+        int found = solver_count_perfect_clears(&candidate.board, candidate.pieces,
+                                                candidate.piece_count, 2, candidate.solution);
+        if (found != 1) {
+            continue;
+        }
+        int slot = atomic_fetch_add_explicit(&job->produced, 1, memory_order_relaxed);
+        if (slot < job->target) {
+            job->puzzles[slot] = candidate;
+        }
+    }
+    return NULL;
+}
+
+/**
+ * @brief 32ビット値をリトルエンディアンで書き込む
+ */
+static void put_u32(uint8_t *p, uint32_t v) {
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+    p[2] = (uint8_t)(v >> 16);
+    p[3] = (uint8_t)(v >> 24);
+}
+
+/**
+ * @brief パズルパックを書き出す
+ */
+static int write_pack(const char *path, const Puzzle *puzzles, int count) {
+    FILE *fp = fopen(path, "wb");
+    if (!fp) {
+        perror(path);
+        return 0;
+    }
+
+    uint8_t header[12];
+    memcpy(header, "TPZP", 4);
+    put_u32(header + 4, PUZZLE_PACK_VERSION);
+    put_u32(header + 8, (uint32_t)count);
+    int ok = fwrite(header, sizeof(header), 1, fp) == 1;
+
+    for (int i = 0; i < count && ok; i++) {
+        const Puzzle *pz = &puzzles[i];
+        uint8_t rec[PUZZLE_RECORD_SIZE];
+        uint8_t *p = rec;
+        memset(rec, 0, sizeof(rec));
+
+        *p++ = (uint8_t)pz->height;
+        *p++ = (uint8_t)pz->piece_count;
+        for (int j = 0; j < SOLVER_MAX_PIECES; j++) {
+            *p++ = (uint8_t)(j < pz->piece_count ? pz->pieces[j] : 0xFF);
+        }
+        for (int r = 0; r < PUZZLE_MAX_HEIGHT; r++) {
+            uint16_t row = r < pz->height ? pz->board.rows[BOARD_HEIGHT - 1 - r] : 0;
+            *p++ = (uint8_t)row;
+            *p++ = (uint8_t)(row >> 8);
+        }
+        for (int j = 0; j < pz->piece_count; j++) {
+            *p++ = pz->solution[j].type;
+            *p++ = pz->solution[j].rotation;
+            *p++ = (uint8_t)pz->solution[j].x;
+            *p++ = (uint8_t)pz->solution[j].y;
+        }
+        ok = fwrite(rec, sizeof(rec), 1, fp) == 1;
+    }
+
+    if (fclose(fp) != 0) {
+        ok = 0;
+    }
+    if (!ok) {
+        fprintf(stderr, "%s: 書き込みに失敗しました\n", path);
+    }
+    return ok;
+}
+
+/**
+ * @brief 使い方を表示する
+ */
+static void usage(const char *prog) {
+    fprintf(stderr,
+            "usage: %s -o pack.tpz [-n count] [-j threads] [-p max_pieces] [-s seed]\n",
+            prog);
+}
+
+int main(int argc, char **argv) {
+    const char *output = NULL;
+    int target = 1000;
+    int threads = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    int max_pieces = 6;
+    uint64_t seed = (uint64_t)time(NULL);
+
+    int opt;
+    while ((opt = getopt(argc, argv, "o:n:j:p:s:")) != -1) {
+        switch (opt) {
+            case 'o': output = optarg; break;
+            case 'n': target = atoi(optarg); break;
+            case 'j': threads = atoi(optarg); break;
+            case 'p': max_pieces = atoi(optarg); break;
+            case 's': seed = strtoull(optarg, NULL, 0); break;
+            default: usage(argv[0]); return 1;
+        }
+    }
+    if (!output || target <= 0 || max_pieces < 2 || max_pieces > SOLVER_MAX_PIECES) {
+        usage(argv[0]);
+        return 1;
+    }
+    if (threads < 1) {
+        threads = 1;
+    }
+    if (threads > PUZZLE_MAX_THREADS) {
+        threads = PUZZLE_MAX_THREADS;
+    }
+
+    bitboard_init();
+
+    PuzzleJob job;
+    job.puzzles = (Puzzle*)malloc(sizeof(Puzzle) * (size_t)target);
+    if (!job.puzzles) {
+        fprintf(stderr, "メモリ確保に失敗しました\n");
+        return 1;
+    }
+    job.target = target;
+    job.max_pieces = max_pieces;
+    job.seed = seed;
+    atomic_init(&job.produced, 0);
+    atomic_init(&job.candidates, 0);
+
+    pthread_t tids[PUZZLE_MAX_THREADS];
+    PuzzleWorker workers[PUZZLE_MAX_THREADS];
+    int started = 0;
+    for (int i = 0; i < threads; i++) {
+        workers[i].job = &job;
+        workers[i].index = i;
+        if (pthread_create(&tids[i], NULL, puzzle_worker, &workers[i]) != 0) {
+            break;
+        }
+        started++;
+    }
+    if (started == 0) {
+        puzzle_worker(&workers[0]); // スレッドを作れない環境では単独で実行
+    }
+    for (int i = 0; i < started; i++) {
+        pthread_join(tids[i], NULL);
+    }
+
+    int ok = write_pack(output, job.puzzles, target);
+    fprintf(stderr, "%d puzzles (%ld candidates, %d threads) -> %s\n",
+            target, atomic_load(&job.candidates), started ? started : 1, output);
+    free(job.puzzles);
+    return ok ? 0 : 1;
+}